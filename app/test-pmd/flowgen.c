@@ -89,16 +89,6 @@ static struct ether_addr cfg_ether_dst	=
 #define IP_HDRLEN  0x05 /* default IP header length == five 32-bits words. */
 #define IP_VHL_DEF (IP_VERSION | IP_HDRLEN)
 
-static inline struct rte_mbuf *
-tx_mbuf_alloc(struct rte_mempool *mp)
-{
-	struct rte_mbuf *m;
-
-	m = __rte_mbuf_raw_alloc(mp);
-	__rte_mbuf_sanity_check_raw(m, 0);
-	return (m);
-}
-
 
 static inline uint16_t
 ip_sum(const uint16_t *hdr, int hdr_len)
@@ -141,7 +131,7 @@ pkt_burst_flow_gen(struct fwd_stream *fs)
 	uint16_t nb_rx;
 	uint16_t nb_tx;
 	uint16_t nb_pkt;
-	uint16_t i;
+	uint16_t nb_alloc;
 #ifdef RTE_TEST_PMD_RECORD_CORE_CYCLES
 	uint64_t start_tsc;
 	uint64_t end_tsc;
@@ -158,20 +148,20 @@ pkt_burst_flow_gen(struct fwd_stream *fs)
 				 nb_pkt_per_burst);
 	fs->rx_packets += nb_rx;
 
-	for (i = 0; i < nb_rx; i++)
-		rte_pktmbuf_free(pkts_burst[i]);
+	rte_pktmbuf_free_bulk(pkts_burst, nb_rx);
 
 	mbp = current_fwd_lcore()->mbp;
 	vlan_tci = ports[fs->tx_port].tx_vlan_id;
 	ol_flags = ports[fs->tx_port].tx_ol_flags;
 
-	for (nb_pkt = 0; nb_pkt < nb_pkt_per_burst; nb_pkt++) {
-		pkt = tx_mbuf_alloc(mbp);
-		if (!pkt)
-			break;
+	/* Allocate the whole burst at once if possible. */
+	nb_alloc = pkt_burst_alloc(mbp, pkts_burst, nb_pkt_per_burst);
+	if (nb_alloc == 0)
+		return;
 
+	for (nb_pkt = 0; nb_pkt < nb_alloc; nb_pkt++) {
+		pkt = pkts_burst[nb_pkt];
 		pkt->data_len = pkt_size;
-		pkt->next = NULL;
 
 		/* Initialize Ethernet header. */
 		eth_hdr = rte_pktmbuf_mtod(pkt, struct ether_hdr *);
@@ -210,7 +200,6 @@ pkt_burst_flow_gen(struct fwd_stream *fs)
 		pkt->vlan_tci		= vlan_tci;
 		pkt->l2_len		= sizeof(struct ether_hdr);
 		pkt->l3_len		= sizeof(struct ipv4_hdr);
-		pkts_burst[nb_pkt]	= pkt;
 
 		next_flow = (next_flow + 1) % cfg_n_flows;
 	}
@@ -227,9 +216,7 @@ pkt_burst_flow_gen(struct fwd_stream *fs)
 		while (next_flow < 0)
 			next_flow += cfg_n_flows;
 
-		do {
-			rte_pktmbuf_free(pkts_burst[nb_tx]);
-		} while (++nb_tx < nb_pkt);
+		rte_pktmbuf_free_bulk(&pkts_burst[nb_tx], nb_pkt - nb_tx);
 	}
 #ifdef RTE_TEST_PMD_RECORD_CORE_CYCLES
 	end_tsc = rte_rdtsc();
@@ -428,6 +428,28 @@ mbuf_pool_find(unsigned int sock_id)
 	return (rte_mempool_lookup((const char *)pool_name));
 }
 
+/*
+ * Allocate a burst of packets with a single bulk allocation or, when the
+ * pool has not enough free mbufs for the whole burst, as many packets as
+ * possible one by one. Returns the number of packets allocated.
+ */
+static inline uint16_t
+pkt_burst_alloc(struct rte_mempool *mp, struct rte_mbuf **pkts,
+		uint16_t nb_pkts)
+{
+	uint16_t nb_alloc;
+
+	if (likely(rte_pktmbuf_alloc_bulk(mp, pkts, nb_pkts) == 0))
+		return nb_pkts;
+
+	for (nb_alloc = 0; nb_alloc < nb_pkts; nb_alloc++) {
+		pkts[nb_alloc] = rte_pktmbuf_alloc(mp);
+		if (pkts[nb_alloc] == NULL)
+			break;
+	}
+	return nb_alloc;
+}
+
 /**
  * Read/Write operations on a PCI register of a port.
  */
@@ -86,16 +86,6 @@
 static struct ipv4_hdr  pkt_ip_hdr;  /**< IP header of transmitted packets. */
 static struct udp_hdr pkt_udp_hdr; /**< UDP header of transmitted packets. */
 
-static inline struct rte_mbuf *
-tx_mbuf_alloc(struct rte_mempool *mp)
-{
-	struct rte_mbuf *m;
-
-	m = __rte_mbuf_raw_alloc(mp);
-	__rte_mbuf_sanity_check_raw(m, 0);
-	return (m);
-}
-
 static void
 copy_buf_to_pkt_segs(void* buf, unsigned len, struct rte_mbuf *pkt,
 		     unsigned offset)
@@ -195,6 +185,7 @@ static void
 pkt_burst_transmit(struct fwd_stream *fs)
 {
 	struct rte_mbuf *pkts_burst[MAX_PKT_BURST];
+	struct rte_mbuf *pkt_segs[RTE_MAX_SEGS_PER_PKT];
 	struct rte_port *txp;
 	struct rte_mbuf *pkt;
 	struct rte_mbuf *pkt_seg;
@@ -202,6 +193,7 @@ pkt_burst_transmit(struct fwd_stream *fs)
 	struct ether_hdr eth_hdr;
 	uint16_t nb_tx;
 	uint16_t nb_pkt;
+	uint16_t nb_alloc;
 	uint16_t vlan_tci;
 	uint64_t ol_flags = 0;
 	uint8_t  i;
@@ -220,23 +212,25 @@ pkt_burst_transmit(struct fwd_stream *fs)
 	vlan_tci = txp->tx_vlan_id;
 	if (txp->tx_ol_flags & TESTPMD_TX_OFFLOAD_INSERT_VLAN)
 		ol_flags = PKT_TX_VLAN_PKT;
-	for (nb_pkt = 0; nb_pkt < nb_pkt_per_burst; nb_pkt++) {
-		pkt = tx_mbuf_alloc(mbp);
-		if (pkt == NULL) {
-		nomore_mbuf:
+	/* Allocate the first segments of the burst at once if possible. */
+	nb_alloc = pkt_burst_alloc(mbp, pkts_burst, nb_pkt_per_burst);
+	if (nb_alloc == 0)
+		return;
+	for (nb_pkt = 0; nb_pkt < nb_alloc; nb_pkt++) {
+		pkt = pkts_burst[nb_pkt];
+		pkt->data_len = tx_pkt_seg_lengths[0];
+		if (tx_pkt_nb_segs > 1 &&
+		    rte_pktmbuf_alloc_bulk(mbp, pkt_segs,
+					   tx_pkt_nb_segs - 1) != 0) {
+			rte_pktmbuf_free_bulk(&pkts_burst[nb_pkt],
+					      nb_alloc - nb_pkt);
 			if (nb_pkt == 0)
 				return;
 			break;
 		}
-		pkt->data_len = tx_pkt_seg_lengths[0];
 		pkt_seg = pkt;
 		for (i = 1; i < tx_pkt_nb_segs; i++) {
-			pkt_seg->next = tx_mbuf_alloc(mbp);
-			if (pkt_seg->next == NULL) {
-				pkt->nb_segs = i;
-				rte_pktmbuf_free(pkt);
-				goto nomore_mbuf;
-			}
+			pkt_seg->next = pkt_segs[i - 1];
 			pkt_seg = pkt_seg->next;
 			pkt_seg->data_len = tx_pkt_seg_lengths[i];
 		}
@@ -260,8 +254,7 @@ pkt_burst_transmit(struct fwd_stream *fs)
 				sizeof(struct ipv4_hdr));
 
 		/*
-		 * Complete first mbuf of packet and append it to the
-		 * burst of packets to be transmitted.
+		 * Complete first mbuf of packet.
 		 */
 		pkt->nb_segs = tx_pkt_nb_segs;
 		pkt->pkt_len = tx_pkt_length;
@@ -269,7 +262,6 @@ pkt_burst_transmit(struct fwd_stream *fs)
 		pkt->vlan_tci  = vlan_tci;
 		pkt->l2_len = sizeof(struct ether_hdr);
 		pkt->l3_len = sizeof(struct ipv4_hdr);
-		pkts_burst[nb_pkt] = pkt;
 	}
 	nb_tx = rte_eth_tx_burst(fs->tx_port, fs->tx_queue, pkts_burst, nb_pkt);
 	fs->tx_packets += nb_tx;
@@ -285,9 +277,7 @@ pkt_burst_transmit(struct fwd_stream *fs)
 			       (unsigned) nb_pkt, (unsigned) nb_tx,
 			       (unsigned) (nb_pkt - nb_tx));
 		fs->fwd_dropped += (nb_pkt - nb_tx);
-		do {
-			rte_pktmbuf_free(pkts_burst[nb_tx]);
-		} while (++nb_tx < nb_pkt);
+		rte_pktmbuf_free_bulk(&pkts_burst[nb_tx], nb_pkt - nb_tx);
 	}
 
 #ifdef RTE_TEST_PMD_RECORD_CORE_CYCLES
@@ -241,6 +241,12 @@ parallel_test_group_list = [
 		 "Func" :	default_autotest,
 		 "Report" :	None,
 		},
+		{
+		 "Name" :	"Service cores autotest",
+		 "Command" : 	"service_autotest",
+		 "Func" :	default_autotest,
+		 "Report" :	None,
+		},
 		{
 		 "Name" :	"Ring autotest",
 		 "Command" : 	"ring_autotest",
@@ -303,6 +309,12 @@ parallel_test_group_list = [
 		 "Func" :	default_autotest,
 		 "Report" :	None,
 		},
+		{
+		 "Name" :	"External memory autotest",
+		 "Command" : 	"extmem_autotest",
+		 "Func" :	default_autotest,
+		 "Report" :	None,
+		},
 		{
 		 "Name" :	"Atomics autotest",
 		 "Command" : 	"atomic_autotest",
@@ -334,6 +346,12 @@ parallel_test_group_list = [
 		 "Func" :	default_autotest,
 		 "Report" :	None,
 		},
+		{
+		 "Name" :	"vhost-user autotest",
+		 "Command" :	"vhost_user_autotest",
+		 "Func" :	default_autotest,
+		 "Report" :	None,
+		},
 		{
 		 "Name" :	"Access list control autotest",
 		 "Command" : 	"acl_autotest",
@@ -385,6 +403,19 @@ non_parallel_test_group_list = [
 		},
 	]
 },
+{
+	"Prefix":	"eal_init_perf",
+	"Memory" :	all_sockets(64),
+	"Tests" :	
+	[
+		{
+		 "Name" :	"EAL init performance autotest",
+		 "Command" : 	"eal_init_perf_autotest",
+		 "Func" :	default_autotest,
+		 "Report" :	None,
+		},
+	]
+},
 {
 	"Prefix":	"memcpy_perf",
 	"Memory" :	all_sockets(512),
@@ -463,6 +494,32 @@ non_parallel_test_group_list = [
                 },
 	]
 },
+{
+	"Prefix" :	"lpm6_perf",
+	"Memory" :	"512",
+	"Tests" :
+	[
+		{
+                 "Name" :       "LPM6 performance autotest",
+                 "Command" :    "lpm6_perf_autotest",
+                 "Func" :       default_autotest,
+                 "Report" :     None,
+                },
+	]
+},
+{
+	"Prefix" :	"vhost_perf",
+	"Memory" :	"512",
+	"Tests" :
+	[
+		{
+		 "Name" :	"vhost performance autotest",
+		 "Command" :	"vhost_perf_autotest",
+		 "Func" :	default_autotest,
+		 "Report" :	None,
+		},
+	]
+},
 {
 	"Prefix":	"timer_perf",
 	"Memory" :	all_sockets(512),
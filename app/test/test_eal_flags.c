@@ -668,6 +668,53 @@ test_master_lcore_flag(void)
 	return 0;
 }
 
+/*
+ * Test --service-lcores option with matching coremask
+ */
+static int
+test_service_lcores_flag(void)
+{
+#ifdef RTE_EXEC_ENV_BSDAPP
+	/* BSD target doesn't support prefixes at this point */
+	const char *prefix = "";
+#else
+	char prefix[PATH_MAX], tmp[PATH_MAX];
+	if (get_current_prefix(tmp, sizeof(tmp)) == NULL) {
+		printf("Error - unable to get current prefix!\n");
+		return -1;
+	}
+	snprintf(prefix, sizeof(prefix), "--file-prefix=%s", tmp);
+#endif
+
+	/* --service-lcores flag but no value */
+	const char *argv1[] = { prgname, prefix, mp_flag, "-n", "1", "-c", "7", "--service-lcores"};
+	/* --service-lcores flag with invalid value */
+	const char *argv2[] = { prgname, prefix, mp_flag, "-n", "1", "-c", "7", "--service-lcores", "1-"};
+	const char *argv3[] = { prgname, prefix, mp_flag, "-n", "1", "-c", "7", "--service-lcores", "X"};
+	/* service lcore not in coremask */
+	const char *argv4[] = { prgname, prefix, mp_flag, "-n", "1", "-c", "7", "--service-lcores", "3"};
+	/* service lcore is the master lcore */
+	const char *argv5[] = { prgname, prefix, mp_flag, "-n", "1", "-c", "7", "--service-lcores", "0"};
+	/* valid values */
+	const char *argv6[] = { prgname, prefix, mp_flag, "-n", "1", "-c", "7", "--service-lcores", "2"};
+	const char *argv7[] = { prgname, prefix, mp_flag, "-n", "1", "--service-lcores", "1-2", "-c", "7"};
+
+	if (launch_proc(argv1) == 0
+			|| launch_proc(argv2) == 0
+			|| launch_proc(argv3) == 0
+			|| launch_proc(argv4) == 0
+			|| launch_proc(argv5) == 0) {
+		printf("Error - process ran without error with wrong --service-lcores\n");
+		return -1;
+	}
+	if (launch_proc(argv6) != 0
+			|| launch_proc(argv7) != 0) {
+		printf("Error - process did not run ok with valid --service-lcores\n");
+		return -1;
+	}
+	return 0;
+}
+
 /*
  * Test that the app doesn't run without the -n flag. In all cases
  * should give an error and fail to run.
@@ -1363,6 +1410,12 @@ test_eal_flags(void)
 		return ret;
 	}
 
+	ret = test_service_lcores_flag();
+	if (ret < 0) {
+		printf("Error in test_service_lcores_flag()\n");
+		return ret;
+	}
+
 	ret = test_missing_n_flag();
 	if (ret < 0) {
 		printf("Error in test_missing_n_flag()\n");
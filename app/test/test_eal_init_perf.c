@@ -0,0 +1,120 @@
+/*-
+ *   BSD LICENSE
+ *
+ *   Copyright(c) 2010-2014 Intel Corporation. All rights reserved.
+ *   All rights reserved.
+ *
+ *   Redistribution and use in source and binary forms, with or without
+ *   modification, are permitted provided that the following conditions
+ *   are met:
+ *
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in
+ *       the documentation and/or other materials provided with the
+ *       distribution.
+ *     * Neither the name of Intel Corporation nor the names of its
+ *       contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ *   THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *   "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *   LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ *   A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ *   OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ *   SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ *   LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ *   DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ *   THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ *   (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ *   OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/wait.h>
+
+#include <rte_common.h>
+#include <rte_cycles.h>
+#include <rte_debug.h>
+
+#include "test.h"
+#include "process.h"
+
+/*
+ * EAL initialization performance test
+ * ===================================
+ *
+ * Launch copies of the test application with an increasing amount of
+ * hugepage memory, with the default memory initialization and with
+ * --single-file-segments, and report the time taken by each of them to
+ * initialize the EAL and exit. The test stops at the first amount of memory
+ * that cannot be allocated.
+ */
+
+#define MIN_MEM_MB 64
+#define MAX_MEM_MB (64 * 1024)
+
+/* returns the time taken by the process in ms, or -1 on failure */
+static int
+time_eal_init(unsigned mem_mb, int single_file)
+{
+	char mem[16];
+	const char *argv[] = {prgname, "-c", "1", "-n", "2", "-m", mem,
+			"--no-pci", "--file-prefix=eal_init_perf",
+			"--single-file-segments"};
+	unsigned argc = RTE_DIM(argv);
+	uint64_t start, end;
+
+	snprintf(mem, sizeof(mem), "%u", mem_mb);
+	if (!single_file)
+		argc--;
+
+	start = rte_get_timer_cycles();
+	if (process_dup(argv, argc, __func__) != 0)
+		return -1;
+	end = rte_get_timer_cycles();
+
+	return (int)((end - start) * 1000 / rte_get_timer_hz());
+}
+
+static int
+test_eal_init_perf(void)
+{
+	int ms_default, ms_single_file;
+	unsigned mem_mb;
+
+#ifdef RTE_LIBRTE_XEN_DOM0
+	printf("Hugepage memory is not used on Xen dom0, skipping\n");
+	return 0;
+#endif
+
+	for (mem_mb = MIN_MEM_MB; mem_mb <= MAX_MEM_MB; mem_mb *= 2) {
+		ms_default = time_eal_init(mem_mb, 0);
+		ms_single_file = time_eal_init(mem_mb, 1);
+		if (ms_default < 0 || ms_single_file < 0) {
+			if (mem_mb == MIN_MEM_MB) {
+				printf("Cannot initialize the EAL with %u MB\n",
+					mem_mb);
+				return -1;
+			}
+			break;
+		}
+
+		printf("\n### EAL init with %u MB ###\n", mem_mb);
+		printf("default: %d ms\n", ms_default);
+		printf("single-file-segments: %d ms\n", ms_single_file);
+	}
+
+	return 0;
+}
+
+static struct test_command eal_init_perf_cmd = {
+	.command = "eal_init_perf_autotest",
+	.callback = test_eal_init_perf,
+};
+REGISTER_TEST_COMMAND(eal_init_perf_cmd);
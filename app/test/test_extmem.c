@@ -0,0 +1,468 @@
+/*-
+ *   BSD LICENSE
+ *
+ *   Copyright(c) 2010-2014 Intel Corporation. All rights reserved.
+ *   All rights reserved.
+ *
+ *   Redistribution and use in source and binary forms, with or without
+ *   modification, are permitted provided that the following conditions
+ *   are met:
+ *
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in
+ *       the documentation and/or other materials provided with the
+ *       distribution.
+ *     * Neither the name of Intel Corporation nor the names of its
+ *       contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ *   THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *   "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *   LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ *   A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ *   OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ *   SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ *   LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ *   DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ *   THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ *   (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ *   OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <stdio.h>
+#include <stdint.h>
+#include <string.h>
+#include <errno.h>
+#include <sys/mman.h>
+
+#include <rte_common.h>
+#include <rte_errno.h>
+#include <rte_memory.h>
+#include <rte_mempool.h>
+#include <rte_mbuf.h>
+#include <rte_ring.h>
+#include <rte_lcore.h>
+#include <rte_ethdev.h>
+#include <rte_eth_ring.h>
+
+#include "test.h"
+
+/*
+ * External memory
+ * ===============
+ *
+ * - Map an area of memory outside of the EAL and register it with a
+ *   table of fake I/O addresses, where consecutive pages are not
+ *   contiguous, and check the translation of its addresses.
+ *
+ * - Check that invalid and overlapping registrations are refused.
+ *
+ * - Create a packet mbuf pool in the area without giving the physical
+ *   addresses of its pages, and check the address of each mbuf buffer.
+ *
+ * - Transmit mbufs of the pool on a ring PMD port, and on a pcap PMD port
+ *   if it is enabled.
+ *
+ * - Unregister the area and check that its addresses are not translated
+ *   anymore.
+ */
+
+#define EXTMEM_PG_SHIFT 16
+#define EXTMEM_PG_SZ (1UL << EXTMEM_PG_SHIFT)
+#define EXTMEM_IOVA_BASE 0x100000000ULL
+
+#define NB_MBUF 512
+#define MBUF_DATA_SIZE (2048 + RTE_PKTMBUF_HEADROOM)
+#define MBUF_SIZE (sizeof(struct rte_mbuf) + MBUF_DATA_SIZE)
+#define MBUF_CACHE_SIZE 32
+#define RING_SIZE 256
+#define BURST_SIZE 32
+#define PKT_LEN 64
+
+static char *extmem_map;
+static size_t extmem_map_len;
+static char *extmem_va;
+static size_t extmem_len;
+static phys_addr_t extmem_iova[NB_MBUF];
+static unsigned extmem_n_pages;
+
+/* fake I/O address of a page: the pages are in reverse order */
+static phys_addr_t
+extmem_page_iova(unsigned page)
+{
+	return EXTMEM_IOVA_BASE + (extmem_n_pages - 1 - page) * EXTMEM_PG_SZ;
+}
+
+/* expected I/O address of an address of the area */
+static phys_addr_t
+extmem_addr_iova(const void *addr)
+{
+	size_t off = (const char *)addr - extmem_va;
+
+	return extmem_page_iova(off >> EXTMEM_PG_SHIFT) +
+		(off & (EXTMEM_PG_SZ - 1));
+}
+
+static int
+test_extmem_register(void)
+{
+	unsigned i;
+	char *addr;
+
+	for (i = 0; i < extmem_n_pages; i++)
+		extmem_iova[i] = extmem_page_iova(i);
+
+	/* invalid parameters */
+	if (rte_extmem_register(NULL, extmem_len, extmem_iova,
+			extmem_n_pages, EXTMEM_PG_SZ) != -EINVAL ||
+			rte_extmem_register(extmem_va, extmem_len, NULL,
+			extmem_n_pages, EXTMEM_PG_SZ) != -EINVAL ||
+			rte_extmem_register(extmem_va + 1, extmem_len,
+			extmem_iova, extmem_n_pages, EXTMEM_PG_SZ) != -EINVAL ||
+			rte_extmem_register(extmem_va, extmem_len, extmem_iova,
+			extmem_n_pages - 1, EXTMEM_PG_SZ) != -EINVAL ||
+			rte_extmem_register(extmem_va, extmem_len, extmem_iova,
+			extmem_n_pages, EXTMEM_PG_SZ + 1) != -EINVAL) {
+		printf("invalid registration not refused\n");
+		return -1;
+	}
+
+	if (rte_extmem_register(extmem_va, extmem_len, extmem_iova,
+			extmem_n_pages, EXTMEM_PG_SZ) != 0) {
+		printf("cannot register external memory\n");
+		return -1;
+	}
+
+	/* the second half of the area is already registered */
+	if (rte_extmem_register(extmem_va +
+			(extmem_n_pages / 2) * EXTMEM_PG_SZ, extmem_len,
+			extmem_iova, extmem_n_pages, EXTMEM_PG_SZ) != -EEXIST) {
+		printf("overlapping registration not refused\n");
+		return -1;
+	}
+
+	for (i = 0; i < extmem_n_pages; i++) {
+		addr = extmem_va + i * EXTMEM_PG_SZ + 123;
+		if (rte_mem_virt2phy(addr) != extmem_addr_iova(addr)) {
+			printf("wrong address 0x%"PRIx64" for page %u\n",
+				rte_mem_virt2phy(addr), i);
+			return -1;
+		}
+	}
+	if (rte_extmem_virt2iova(extmem_va + extmem_len) !=
+			RTE_BAD_PHYS_ADDR) {
+		printf("address after the area is translated\n");
+		return -1;
+	}
+
+	return 0;
+}
+
+static struct rte_mempool *
+test_extmem_pool_create(void)
+{
+	struct rte_pktmbuf_pool_private mbp_priv;
+	struct rte_mempool *mp;
+	int dummy;
+
+	/* memory which is not registered needs its physical addresses */
+	mp = rte_mempool_xmem_create("test_extmem_bad", NB_MBUF, MBUF_SIZE,
+		MBUF_CACHE_SIZE, sizeof(struct rte_pktmbuf_pool_private),
+		rte_pktmbuf_pool_init, NULL, rte_pktmbuf_init, NULL,
+		SOCKET_ID_ANY, 0, &dummy, NULL, 1, EXTMEM_PG_SHIFT);
+	if (mp != NULL || rte_errno != EINVAL) {
+		printf("pool created on unregistered memory\n");
+		return NULL;
+	}
+
+	memset(&mbp_priv, 0, sizeof(mbp_priv));
+	mbp_priv.mbuf_data_room_size = MBUF_DATA_SIZE;
+	mp = rte_mempool_xmem_create("test_extmem", NB_MBUF, MBUF_SIZE,
+		MBUF_CACHE_SIZE, sizeof(struct rte_pktmbuf_pool_private),
+		rte_pktmbuf_pool_init, &mbp_priv, rte_pktmbuf_init, NULL,
+		SOCKET_ID_ANY, 0, extmem_va, NULL, extmem_n_pages,
+		EXTMEM_PG_SHIFT);
+	if (mp == NULL) {
+		printf("cannot create pool on external memory\n");
+		return NULL;
+	}
+	if (mp->size != NB_MBUF) {
+		printf("pool has %u mbufs instead of %u\n", mp->size, NB_MBUF);
+		rte_mempool_free(mp);
+		return NULL;
+	}
+
+	return mp;
+}
+
+/* allocate a burst of packets in external memory */
+static int
+test_extmem_alloc_burst(struct rte_mempool *mp, struct rte_mbuf **pkts)
+{
+	char *addr;
+	unsigned i;
+
+	if (rte_pktmbuf_alloc_bulk(mp, pkts, BURST_SIZE) != 0) {
+		printf("cannot allocate mbufs\n");
+		return -1;
+	}
+
+	for (i = 0; i < BURST_SIZE; i++) {
+		addr = pkts[i]->buf_addr;
+		if (addr < extmem_va || addr >= extmem_va + extmem_len ||
+				pkts[i]->buf_physaddr !=
+				extmem_addr_iova(addr)) {
+			printf("wrong buffer %p (0x%"PRIx64") for mbuf %u\n",
+				addr, pkts[i]->buf_physaddr, i);
+			goto fail;
+		}
+
+		addr = rte_pktmbuf_append(pkts[i], PKT_LEN);
+		if (addr == NULL) {
+			printf("cannot append data to mbuf %u\n", i);
+			goto fail;
+		}
+		memset(addr, i, PKT_LEN);
+	}
+
+	return 0;
+
+fail:
+	for (i = 0; i < BURST_SIZE; i++)
+		rte_pktmbuf_free(pkts[i]);
+	return -1;
+}
+
+static int
+test_extmem_port_start(uint8_t port, struct rte_mempool *mp)
+{
+	struct rte_eth_conf null_conf;
+
+	memset(&null_conf, 0, sizeof(null_conf));
+
+	if (rte_eth_dev_configure(port, 1, 1, &null_conf) < 0) {
+		printf("cannot configure port %u\n", port);
+		return -1;
+	}
+	if (rte_eth_rx_queue_setup(port, 0, RING_SIZE, SOCKET_ID_ANY,
+			NULL, mp) < 0) {
+		printf("cannot setup RX queue of port %u\n", port);
+		return -1;
+	}
+	if (rte_eth_tx_queue_setup(port, 0, RING_SIZE, SOCKET_ID_ANY,
+			NULL) < 0) {
+		printf("cannot setup TX queue of port %u\n", port);
+		return -1;
+	}
+	if (rte_eth_dev_start(port) < 0) {
+		printf("cannot start port %u\n", port);
+		return -1;
+	}
+
+	return 0;
+}
+
+static int
+test_extmem_ring_pmd(struct rte_mempool *mp)
+{
+	struct rte_mbuf *pkts[BURST_SIZE];
+	struct rte_mbuf *txed[BURST_SIZE];
+	struct rte_ring *rxr, *txr;
+	unsigned i, j;
+	uint8_t port;
+	int ret = -1;
+
+	rxr = rte_ring_create("test_extmem_rx", RING_SIZE, SOCKET_ID_ANY,
+		RING_F_SP_ENQ | RING_F_SC_DEQ);
+	txr = rte_ring_create("test_extmem_tx", RING_SIZE, SOCKET_ID_ANY,
+		RING_F_SP_ENQ | RING_F_SC_DEQ);
+	if (rxr == NULL || txr == NULL) {
+		printf("cannot create rings\n");
+		goto out;
+	}
+
+	/* the new port takes the first free port id */
+	port = rte_eth_dev_count();
+	if (rte_eth_from_rings("test_extmem_ring", &rxr, 1, &txr, 1,
+			rte_socket_id()) < 0) {
+		printf("cannot create ring port\n");
+		goto out;
+	}
+	if (test_extmem_port_start(port, mp) < 0)
+		goto close;
+
+	if (test_extmem_alloc_burst(mp, pkts) < 0)
+		goto stop;
+
+	if (rte_eth_tx_burst(port, 0, pkts, BURST_SIZE) != BURST_SIZE) {
+		printf("cannot transmit on ring port\n");
+		for (i = 0; i < BURST_SIZE; i++)
+			rte_pktmbuf_free(pkts[i]);
+		goto stop;
+	}
+
+	if (rte_ring_dequeue_bulk(txr, (void **)txed, BURST_SIZE) != 0) {
+		printf("transmitted mbufs not found in ring\n");
+		goto stop;
+	}
+
+	ret = 0;
+	for (i = 0; i < BURST_SIZE; i++) {
+		if (txed[i] != pkts[i] || txed[i]->data_len != PKT_LEN)
+			ret = -1;
+		for (j = 0; j < PKT_LEN; j++) {
+			if (rte_pktmbuf_mtod(txed[i], uint8_t *)[j] !=
+					(uint8_t)i)
+				ret = -1;
+		}
+		rte_pktmbuf_free(txed[i]);
+	}
+	if (ret < 0)
+		printf("wrong mbufs transmitted on ring port\n");
+
+stop:
+	rte_eth_dev_stop(port);
+close:
+	/* a port made of rings cannot be detached, release it before them */
+	rte_eth_dev_close(port);
+	rte_eth_dev_release_port(&rte_eth_devices[port]);
+out:
+	rte_ring_free(rxr);
+	rte_ring_free(txr);
+	return ret;
+}
+
+#ifdef RTE_LIBRTE_PMD_PCAP
+#define EXTMEM_PCAP_FILE "/tmp/test_extmem.pcap"
+
+static int
+test_extmem_pcap_pmd(struct rte_mempool *mp)
+{
+	struct rte_mbuf *pkts[BURST_SIZE];
+	struct rte_eth_stats stats;
+	char name[RTE_ETH_NAME_MAX_LEN];
+	uint8_t port;
+	unsigned i;
+	int ret = -1;
+
+	if (rte_eth_dev_attach("eth_pcap_extmem,tx_pcap=" EXTMEM_PCAP_FILE,
+			&port) < 0) {
+		printf("cannot attach pcap port\n");
+		return -1;
+	}
+	if (test_extmem_port_start(port, mp) < 0)
+		goto close;
+
+	if (test_extmem_alloc_burst(mp, pkts) < 0)
+		goto stop;
+
+	if (rte_eth_tx_burst(port, 0, pkts, BURST_SIZE) != BURST_SIZE) {
+		printf("cannot transmit on pcap port\n");
+		for (i = 0; i < BURST_SIZE; i++)
+			rte_pktmbuf_free(pkts[i]);
+		goto stop;
+	}
+
+	rte_eth_stats_get(port, &stats);
+	if (stats.opackets != BURST_SIZE) {
+		printf("%"PRIu64" packets transmitted on pcap port\n",
+			stats.opackets);
+		goto stop;
+	}
+
+	ret = 0;
+
+stop:
+	rte_eth_dev_stop(port);
+out:
+	rte_eth_dev_close(port);
+	rte_eth_dev_detach(port, name);
+	remove(EXTMEM_PCAP_FILE);
+	return ret;
+}
+#endif
+
+static int
+test_extmem_unregister(void)
+{
+	if (rte_extmem_unregister(extmem_va, extmem_len / 2) != -ENOENT) {
+		printf("unregistration of part of the area not refused\n");
+		return -1;
+	}
+	if (rte_extmem_unregister(extmem_va, extmem_len) != 0) {
+		printf("cannot unregister external memory\n");
+		return -1;
+	}
+	if (rte_extmem_unregister(extmem_va, extmem_len) != -ENOENT) {
+		printf("external memory unregistered twice\n");
+		return -1;
+	}
+	if (rte_extmem_virt2iova(extmem_va) != RTE_BAD_PHYS_ADDR ||
+			rte_mem_virt2phy(extmem_va) ==
+			extmem_addr_iova(extmem_va)) {
+		printf("unregistered memory is still translated\n");
+		return -1;
+	}
+
+	return 0;
+}
+
+static int
+test_extmem(void)
+{
+	struct rte_mempool *mp = NULL;
+	size_t total_size;
+	int ret = -1;
+
+	/* map an area aligned on the page size, with room for the pool */
+	total_size = rte_mempool_calc_obj_size(MBUF_SIZE, 0, NULL);
+	extmem_len = rte_mempool_xmem_size(NB_MBUF, total_size,
+		EXTMEM_PG_SHIFT);
+	extmem_n_pages = extmem_len >> EXTMEM_PG_SHIFT;
+	if (extmem_n_pages > RTE_DIM(extmem_iova)) {
+		printf("too many pages in the area\n");
+		return -1;
+	}
+
+	extmem_map_len = extmem_len + EXTMEM_PG_SZ;
+	extmem_map = mmap(NULL, extmem_map_len, PROT_READ | PROT_WRITE,
+		MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+	if (extmem_map == MAP_FAILED) {
+		printf("cannot map %zu bytes\n", extmem_map_len);
+		return -1;
+	}
+	extmem_va = RTE_PTR_ALIGN_CEIL(extmem_map, EXTMEM_PG_SZ);
+
+	if (test_extmem_register() < 0)
+		goto out;
+
+	mp = test_extmem_pool_create();
+	if (mp == NULL)
+		goto unregister;
+
+	if (test_extmem_ring_pmd(mp) < 0)
+		goto unregister;
+
+#ifdef RTE_LIBRTE_PMD_PCAP
+	if (test_extmem_pcap_pmd(mp) < 0)
+		goto unregister;
+#endif
+
+	ret = 0;
+
+unregister:
+	rte_mempool_free(mp);
+	if (test_extmem_unregister() < 0)
+		ret = -1;
+out:
+	munmap(extmem_map, extmem_map_len);
+	return ret;
+}
+
+static struct test_command extmem_cmd = {
+	.command = "extmem_autotest",
+	.callback = test_extmem,
+};
+REGISTER_TEST_COMMAND(extmem_cmd);
@@ -33,6 +33,7 @@
 
 #include <stdio.h>
 #include <stdint.h>
+#include <inttypes.h>
 #include <string.h>
 #include <stdlib.h>
 #include <stdarg.h>
@@ -524,6 +525,106 @@ static int test_five_keys(void)
 	return 0;
 }
 
+/*
+ * Store user data with keys and iterate over the table.
+ *	- add 5 keys with data, look them up: data must match
+ *	- add the 5 keys again with new data: data must be replaced
+ *	- bulk lookup of the 5 keys and a missing one: 5 hits with new data
+ *	- iterate: each key returned once, with its data
+ *	- delete the 5 keys, lookup: 5 misses, iterate: no key
+ */
+static int test_data_iterate(void)
+{
+	struct rte_hash *handle;
+	struct flow_key missing_key;
+	const void *key_array[6];
+	const void *next_key;
+	void *data[6];
+	void *next_data;
+	uint64_t hit_mask;
+	uint32_t iter = 0;
+	unsigned found = 0;
+	unsigned i;
+	int32_t pos;
+	int ret;
+
+	ut_params.name = "test_data";
+	handle = rte_hash_create(&ut_params);
+	RETURN_IF_ERROR(handle == NULL, "hash creation failed");
+
+	/* Add with data, then lookup */
+	for (i = 0; i < 5; i++) {
+		ret = rte_hash_add_key_data(handle, &keys[i],
+					    (void *)((uintptr_t) i));
+		RETURN_IF_ERROR(ret != 0, "failed to add key %u (ret=%d)",
+				i, ret);
+	}
+	for (i = 0; i < 5; i++) {
+		pos = rte_hash_lookup_data(handle, &keys[i], &data[0]);
+		RETURN_IF_ERROR(pos < 0 || pos != rte_hash_lookup(handle,
+								   &keys[i]),
+				"failed to find key %u (pos=%d)", i, pos);
+		RETURN_IF_ERROR(data[0] != (void *)((uintptr_t) i),
+				"wrong data for key %u", i);
+	}
+
+	/* Add - update data */
+	for (i = 0; i < 5; i++) {
+		ret = rte_hash_add_key_with_hash_data(handle, &keys[i],
+				rte_hash_hash(handle, &keys[i]),
+				(void *)((uintptr_t) i + 100));
+		RETURN_IF_ERROR(ret != 0, "failed to update key %u (ret=%d)",
+				i, ret);
+	}
+
+	/* Bulk lookup, with a missing key last */
+	memcpy(&missing_key, &keys[0], sizeof(missing_key));
+	missing_key.port_src ^= 0xffff;
+	for (i = 0; i < 5; i++)
+		key_array[i] = &keys[i];
+	key_array[5] = &missing_key;
+	ret = rte_hash_lookup_bulk_data(handle, key_array, 6, &hit_mask, data);
+	RETURN_IF_ERROR(ret != 5 || hit_mask != 0x1f,
+			"wrong bulk lookup result (ret=%d, hit_mask=%"PRIx64")",
+			ret, hit_mask);
+	for (i = 0; i < 5; i++)
+		RETURN_IF_ERROR(data[i] != (void *)((uintptr_t) i + 100),
+				"wrong data for key %u after update", i);
+
+	/* Iterate */
+	while ((pos = rte_hash_iterate(handle, &next_key, &next_data,
+				       &iter)) >= 0) {
+		i = (uintptr_t) next_data - 100;
+		RETURN_IF_ERROR(i >= 5 || (found & (1 << i)),
+				"iterate returned unexpected data %p",
+				next_data);
+		RETURN_IF_ERROR(memcmp(next_key, &keys[i], sizeof(keys[i])) ||
+				pos != rte_hash_lookup(handle, &keys[i]),
+				"iterate returned wrong key for data %p",
+				next_data);
+		found |= 1 << i;
+	}
+	RETURN_IF_ERROR(pos != -ENOENT || found != 0x1f,
+			"iterate did not return all keys (found=%#x)", found);
+
+	/* Delete, then lookup and iterate */
+	for (i = 0; i < 5; i++) {
+		pos = rte_hash_del_key(handle, &keys[i]);
+		RETURN_IF_ERROR(pos < 0, "failed to delete key %u", i);
+		pos = rte_hash_lookup_data(handle, &keys[i], &data[0]);
+		RETURN_IF_ERROR(pos != -ENOENT,
+				"fail: found key %u after deleting", i);
+	}
+	iter = 0;
+	pos = rte_hash_iterate(handle, &next_key, &next_data, &iter);
+	RETURN_IF_ERROR(pos != -ENOENT,
+			"iterate returned a key from an empty table");
+
+	rte_hash_free(handle);
+
+	return 0;
+}
+
 /*
  * Add keys to the same bucket until bucket full.
  *	- add 5 keys to the same bucket (hash created with 4 keys per bucket):
@@ -659,6 +760,99 @@ static int test_full_bucket(void)
 	return 0;
 }
 
+/*
+ * Fill a cuckoo hash table with random keys until the first insertion fails.
+ *	- the table must be at least 90% full before the first failure
+ *	- all added keys must be found at the position returned by add
+ *	- all keys must be deleted at that same position
+ *	- lookup of every key must then miss
+ */
+#define CUCKOO_FILL_ENTRIES 1024
+#define CUCKOO_FILL_KEY_LEN 16
+#define CUCKOO_FILL_MIN_LOAD 0.9
+
+static uint8_t cuckoo_fill_keys[CUCKOO_FILL_ENTRIES][CUCKOO_FILL_KEY_LEN];
+static int32_t cuckoo_fill_pos[CUCKOO_FILL_ENTRIES];
+
+static int test_cuckoo_fill(void)
+{
+	struct rte_hash_parameters params = {
+		.name = "test_cuckoo_fill",
+		.entries = CUCKOO_FILL_ENTRIES,
+		.key_len = CUCKOO_FILL_KEY_LEN,
+		.hash_func = rte_jhash,
+		.hash_func_init_val = 0,
+		.socket_id = 0,
+		.extra_flag = RTE_HASH_EXTRA_FLAGS_CUCKOO,
+	};
+	struct rte_hash *handle;
+	unsigned added, i, j;
+	int32_t pos;
+
+	handle = rte_hash_create(&params);
+	RETURN_IF_ERROR(handle == NULL, "hash creation failed");
+
+	for (added = 0; added < CUCKOO_FILL_ENTRIES; added++) {
+		for (j = 0; j < CUCKOO_FILL_KEY_LEN; j++)
+			cuckoo_fill_keys[added][j] = (uint8_t) rte_rand();
+		pos = rte_hash_add_key(handle, cuckoo_fill_keys[added]);
+		if (pos < 0)
+			break;
+		cuckoo_fill_pos[added] = pos;
+	}
+	printf("Cuckoo hash load factor at first failure: %.2f%%\n",
+		100.0 * added / CUCKOO_FILL_ENTRIES);
+	RETURN_IF_ERROR(added < CUCKOO_FILL_MIN_LOAD * CUCKOO_FILL_ENTRIES,
+			"only %u keys added before first failure", added);
+
+	for (i = 0; i < added; i++) {
+		pos = rte_hash_lookup(handle, cuckoo_fill_keys[i]);
+		RETURN_IF_ERROR(pos != cuckoo_fill_pos[i],
+				"failed to find key %u (pos=%d)", i, pos);
+	}
+
+	for (i = 0; i < added; i++) {
+		pos = rte_hash_del_key(handle, cuckoo_fill_keys[i]);
+		RETURN_IF_ERROR(pos != cuckoo_fill_pos[i],
+				"failed to delete key %u (pos=%d)", i, pos);
+	}
+
+	for (i = 0; i < added; i++) {
+		pos = rte_hash_lookup(handle, cuckoo_fill_keys[i]);
+		RETURN_IF_ERROR(pos != -ENOENT,
+				"fail: found key %u after deleting (pos=%d)",
+				i, pos);
+	}
+
+	rte_hash_free(handle);
+	return 0;
+}
+
+/*
+ * Run the basic single and multiple key sequences with the cuckoo engine.
+ */
+static int test_cuckoo_engine(void)
+{
+	int ret = -1;
+
+	ut_params.extra_flag = RTE_HASH_EXTRA_FLAGS_CUCKOO;
+	if (test_add_delete() < 0)
+		goto exit;
+	if (test_add_update_delete() < 0)
+		goto exit;
+	if (test_five_keys() < 0)
+		goto exit;
+	if (test_data_iterate() < 0)
+		goto exit;
+	ret = 0;
+exit:
+	ut_params.extra_flag = 0;
+	if (ret < 0)
+		return ret;
+
+	return test_cuckoo_fill();
+}
+
 /******************************************************************************/
 static int
 fbk_hash_unit_test(void)
@@ -1398,8 +1592,12 @@ test_hash(void)
 		return -1;
 	if (test_five_keys() < 0)
 		return -1;
+	if (test_data_iterate() < 0)
+		return -1;
 	if (test_full_bucket() < 0)
 		return -1;
+	if (test_cuckoo_engine() < 0)
+		return -1;
 
 	if (test_fbk_hash_find_existing() < 0)
 		return -1;
@@ -33,6 +33,7 @@
 
 #include <stdio.h>
 #include <stdint.h>
+#include <inttypes.h>
 #include <string.h>
 #include <stdlib.h>
 #include <stdarg.h>
@@ -49,6 +50,9 @@
 #include <rte_eal.h>
 #include <rte_ip.h>
 #include <rte_string_fns.h>
+#include <rte_launch.h>
+#include <rte_per_lcore.h>
+#include <rte_rwlock.h>
 
 #include "test.h"
 
@@ -617,6 +621,457 @@ static int run_all_tbl_perf_tests(void)
 	return 0;
 }
 
+/*******************************************************************************
+ * Hash engine comparison configuration section. Each table is filled with
+ * random keys until the first insertion fails, then looked up in bursts of
+ * RTE_HASH_LOOKUP_BULK_MAX keys ENGINE_LOOKUP_ITERATIONS times, with and
+ * without returning the data stored with the keys, and iterated once.
+ */
+#define ENGINE_LOOKUP_ITERATIONS 100000
+#define ENGINE_KEY_LEN 16
+
+struct engine_test_params {
+	const char *name;
+	uint32_t bucket_entries;
+	uint8_t extra_flag;
+};
+
+static struct engine_test_params engine_test_params[] = {
+	{ "bucket/4",  4,  0 },
+	{ "bucket/16", 16, 0 },
+	{ "cuckoo",    0,  RTE_HASH_EXTRA_FLAGS_CUCKOO },
+};
+static uint32_t engine_test_entries[] = {1 << 12, 1 << 16, 1 << 20};
+/******************************************************************************/
+
+static const char *
+get_sig_cmp_name(enum rte_hash_sig_compare_function fn)
+{
+	switch (fn) {
+	case RTE_HASH_COMPARE_SCALAR: return "scalar";
+	case RTE_HASH_COMPARE_SSE: return "sse";
+	case RTE_HASH_COMPARE_AVX2: return "avx2";
+	default: return "UNKNOWN";
+	}
+}
+
+/*
+ * Time bulk lookups of random keys among the first num_keys of keys, either
+ * returning positions or the data stored with the keys.
+ */
+static double
+time_bulk_lookups(const struct rte_hash *h, const uint8_t *keys,
+		  uint32_t num_keys, int with_data)
+{
+	const void *key_burst[RTE_HASH_LOOKUP_BULK_MAX];
+	int32_t positions[RTE_HASH_LOOKUP_BULK_MAX];
+	void *data[RTE_HASH_LOOKUP_BULK_MAX];
+	uint64_t begin, hit_mask, ticks = 0;
+	uint32_t i, j;
+
+	for (i = 0; i < ENGINE_LOOKUP_ITERATIONS && num_keys > 0; i++) {
+		for (j = 0; j < RTE_HASH_LOOKUP_BULK_MAX; j++)
+			key_burst[j] = &keys[(rte_rand() % num_keys) *
+					     ENGINE_KEY_LEN];
+
+		begin = rte_rdtsc();
+		if (with_data)
+			rte_hash_lookup_bulk_data(h, key_burst,
+					RTE_HASH_LOOKUP_BULK_MAX, &hit_mask,
+					data);
+		else
+			rte_hash_lookup_bulk(h, key_burst,
+					RTE_HASH_LOOKUP_BULK_MAX, positions);
+		ticks += rte_rdtsc() - begin;
+	}
+
+	return (double)ticks /
+		((double)ENGINE_LOOKUP_ITERATIONS * RTE_HASH_LOOKUP_BULK_MAX);
+}
+
+/*
+ * Time a full iteration over the table, per key returned.
+ */
+static double
+time_iterate(const struct rte_hash *h)
+{
+	const void *key;
+	void *data;
+	uint64_t begin, ticks;
+	uint32_t next = 0, count = 0;
+
+	begin = rte_rdtsc();
+	while (rte_hash_iterate(h, &key, &data, &next) >= 0)
+		count++;
+	ticks = rte_rdtsc() - begin;
+
+	return count == 0 ? 0.0 : (double)ticks / count;
+}
+
+static void
+print_engine_result(const char *name, uint32_t entries, uint32_t added,
+		    const struct rte_hash *h, const uint8_t *keys)
+{
+	printf("%-13s, %-8u, %-16u, %-25.2f, %-19.2f, %-24.2f, %.2f\n",
+		name, (unsigned) entries, (unsigned) ENGINE_KEY_LEN,
+		100.0 * added / entries,
+		time_bulk_lookups(h, keys, added, 0),
+		time_bulk_lookups(h, keys, added, 1),
+		time_iterate(h));
+}
+
+/*
+ * Fill a table until the first failed insertion and time bulk lookups of the
+ * keys that made it in. Cuckoo tables are timed with every signature compare
+ * implementation the CPU supports.
+ */
+static int
+run_engine_test(const struct engine_test_params *engine, uint32_t entries)
+{
+	static unsigned calledCount;
+	struct rte_hash_parameters hash_params = {
+		.entries = entries,
+		.bucket_entries = engine->bucket_entries,
+		.key_len = ENGINE_KEY_LEN,
+		.hash_func = rte_hash_crc,
+		.hash_func_init_val = 0,
+		.socket_id = rte_socket_id(),
+		.extra_flag = engine->extra_flag,
+	};
+	struct rte_hash *handle = NULL;
+	uint8_t *keys = NULL;
+	enum rte_hash_sig_compare_function fn, best_fn;
+	uint32_t added, j;
+	char name[RTE_HASH_NAMESIZE];
+	char engine_name[32];
+
+	snprintf(name, sizeof(name), "engine%u", calledCount++);
+	hash_params.name = name;
+
+	handle = rte_hash_create(&hash_params);
+	RETURN_IF_ERROR(handle == NULL, "hash creation failed");
+
+	keys = rte_malloc(NULL, (size_t)entries * ENGINE_KEY_LEN, 0);
+	if (keys == NULL) {
+		printf("ERROR line %d: memory allocation for keys failed\n",
+		       __LINE__);
+		rte_hash_free(handle);
+		return -1;
+	}
+
+	for (added = 0; added < entries; added++) {
+		for (j = 0; j < ENGINE_KEY_LEN; j++)
+			keys[added * ENGINE_KEY_LEN + j] = (uint8_t) rte_rand();
+		if (rte_hash_add_key_data(handle, &keys[added * ENGINE_KEY_LEN],
+				&keys[added * ENGINE_KEY_LEN]) < 0)
+			break;
+	}
+
+	if (!(handle->extra_flag & RTE_HASH_EXTRA_FLAGS_CUCKOO)) {
+		print_engine_result(engine->name, entries, added, handle, keys);
+	} else {
+		best_fn = handle->sig_cmp_fn;
+		for (fn = RTE_HASH_COMPARE_SCALAR; fn <= best_fn; fn++) {
+			handle->sig_cmp_fn = fn;
+			snprintf(engine_name, sizeof(engine_name), "%s/%s",
+				 engine->name, get_sig_cmp_name(fn));
+			print_engine_result(engine_name, entries, added,
+					    handle, keys);
+		}
+	}
+
+	rte_free(keys);
+	rte_hash_free(handle);
+	return 0;
+}
+
+/*
+ * Compare load factor and lookup cost of the bucket and cuckoo engines.
+ */
+static int run_engine_tests(void)
+{
+	unsigned i, j;
+
+	printf("\n\n *** Hash engine comparison results ***\n");
+	printf("Engine       , Entries , Key size (bytes), "
+	       "Load at first failure (%%), Ticks/Lookup (bulk), "
+	       "Ticks/Lookup (bulk+data), Ticks/Key (iterate)\n");
+
+	for (i = 0; i < RTE_DIM(engine_test_params); i++) {
+		for (j = 0; j < RTE_DIM(engine_test_entries); j++) {
+			if (run_engine_test(&engine_test_params[i],
+					engine_test_entries[j]) < 0)
+				return -1;
+		}
+	}
+	return 0;
+}
+
+/*******************************************************************************
+ * Concurrent reader/writer test configuration section. Reader lcores look up
+ * keys that stay in the table while writer lcores add and delete churn keys,
+ * filling the table enough for inserts to displace entries.
+ */
+#define RW_TEST_ENTRIES (1 << 16)
+#define RW_TEST_STABLE_KEYS (RW_TEST_ENTRIES * 6 / 10)
+#define RW_TEST_CHURN_KEYS (RW_TEST_ENTRIES * 3 / 10)
+#define RW_TEST_WRITE_ROUNDS 20
+#define RW_TEST_KEY_LEN 16
+
+enum rw_test_mode {
+	RW_TEST_RWLOCK,		/*< Readers and writer serialized by a rwlock */
+	RW_TEST_LOCK_FREE,	/*< Lock-free readers, one writer */
+	RW_TEST_MULTI_WRITER,	/*< Lock-free readers, two writers */
+};
+
+struct rw_test_lcore_stats {
+	uint64_t ops;
+	uint64_t ticks;
+	uint64_t errors;
+} __rte_cache_aligned;
+
+static struct {
+	struct rte_hash *h;
+	enum rw_test_mode mode;
+	rte_rwlock_t lock;
+	volatile int stop;
+	unsigned writer_lcore;		/* Second writer, multi-writer only */
+	uint8_t (*stable_keys)[RW_TEST_KEY_LEN];
+	int32_t *stable_pos;
+	uint8_t (*churn_keys)[RW_TEST_KEY_LEN];
+	struct rw_test_lcore_stats stats[RTE_MAX_LCORE];
+} rw_test;
+
+static const char *
+get_rw_test_desc(enum rw_test_mode mode)
+{
+	switch (mode) {
+	case RW_TEST_RWLOCK: return "rwlock";
+	case RW_TEST_LOCK_FREE: return "lock-free";
+	case RW_TEST_MULTI_WRITER: return "multi-writer";
+	default: return "UNKNOWN";
+	}
+}
+
+/*
+ * Add then delete every churn key in [first, first + n), counting the time
+ * spent in the hash operations.
+ */
+static void
+rw_test_write(unsigned first, unsigned n, struct rw_test_lcore_stats *stats)
+{
+	uint64_t begin;
+	unsigned round, i;
+
+	for (round = 0; round < RW_TEST_WRITE_ROUNDS; round++) {
+		for (i = first; i < first + n; i++) {
+			begin = rte_rdtsc();
+			if (rw_test.mode == RW_TEST_RWLOCK)
+				rte_rwlock_write_lock(&rw_test.lock);
+			rte_hash_add_key(rw_test.h, rw_test.churn_keys[i]);
+			if (rw_test.mode == RW_TEST_RWLOCK)
+				rte_rwlock_write_unlock(&rw_test.lock);
+			stats->ticks += rte_rdtsc() - begin;
+		}
+		for (i = first; i < first + n; i++) {
+			begin = rte_rdtsc();
+			if (rw_test.mode == RW_TEST_RWLOCK)
+				rte_rwlock_write_lock(&rw_test.lock);
+			rte_hash_del_key(rw_test.h, rw_test.churn_keys[i]);
+			if (rw_test.mode == RW_TEST_RWLOCK)
+				rte_rwlock_write_unlock(&rw_test.lock);
+			stats->ticks += rte_rdtsc() - begin;
+		}
+		stats->ops += 2 * n;
+	}
+}
+
+/*
+ * Look up stable keys in bursts until told to stop. Every lookup must hit at
+ * the position returned when the key was added.
+ */
+static int
+rw_test_lcore(__attribute__((unused)) void *arg)
+{
+	struct rw_test_lcore_stats *stats = &rw_test.stats[rte_lcore_id()];
+	const void *key_burst[RTE_HASH_LOOKUP_BULK_MAX];
+	int32_t positions[RTE_HASH_LOOKUP_BULK_MAX];
+	unsigned idx[RTE_HASH_LOOKUP_BULK_MAX];
+	uint64_t begin;
+	unsigned i;
+
+	if (rte_lcore_id() == rw_test.writer_lcore) {
+		rw_test_write(RW_TEST_CHURN_KEYS / 2, RW_TEST_CHURN_KEYS / 2,
+			      stats);
+		return 0;
+	}
+
+	while (!rw_test.stop) {
+		for (i = 0; i < RTE_HASH_LOOKUP_BULK_MAX; i++) {
+			idx[i] = rte_rand() % RW_TEST_STABLE_KEYS;
+			key_burst[i] = rw_test.stable_keys[idx[i]];
+		}
+
+		begin = rte_rdtsc();
+		if (rw_test.mode == RW_TEST_RWLOCK)
+			rte_rwlock_read_lock(&rw_test.lock);
+		rte_hash_lookup_bulk(rw_test.h, key_burst,
+				     RTE_HASH_LOOKUP_BULK_MAX, positions);
+		if (rw_test.mode == RW_TEST_RWLOCK)
+			rte_rwlock_read_unlock(&rw_test.lock);
+		stats->ticks += rte_rdtsc() - begin;
+		stats->ops += RTE_HASH_LOOKUP_BULK_MAX;
+
+		for (i = 0; i < RTE_HASH_LOOKUP_BULK_MAX; i++)
+			if (positions[i] != rw_test.stable_pos[idx[i]])
+				stats->errors++;
+	}
+	return 0;
+}
+
+/*
+ * Run readers on all slave lcores (but one in multi-writer mode) while the
+ * master lcore writes.
+ */
+static int
+run_rw_test(enum rw_test_mode mode)
+{
+	struct rte_hash_parameters hash_params = {
+		.entries = RW_TEST_ENTRIES,
+		.key_len = RW_TEST_KEY_LEN,
+		.hash_func = rte_hash_crc,
+		.hash_func_init_val = 0,
+		.socket_id = rte_socket_id(),
+	};
+	struct rte_hash *handle = NULL;
+	struct rw_test_lcore_stats *stats;
+	uint64_t read_ops = 0, read_ticks = 0, errors = 0;
+	uint64_t write_ops = 0, write_ticks = 0;
+	unsigned lcore_id, num_writers = 1, i;
+	char name[RTE_HASH_NAMESIZE];
+
+	switch (mode) {
+	case RW_TEST_RWLOCK:
+		hash_params.extra_flag = RTE_HASH_EXTRA_FLAGS_CUCKOO;
+		break;
+	case RW_TEST_LOCK_FREE:
+		hash_params.extra_flag = RTE_HASH_EXTRA_FLAGS_RW_CONCURRENCY;
+		break;
+	case RW_TEST_MULTI_WRITER:
+		hash_params.extra_flag = RTE_HASH_EXTRA_FLAGS_MULTI_WRITER_ADD;
+		num_writers = 2;
+		break;
+	}
+	if (rte_lcore_count() < num_writers + 1) {
+		printf("%-12s, not enough lcores\n", get_rw_test_desc(mode));
+		return 0;
+	}
+
+	snprintf(name, sizeof(name), "rw_test_%u", (unsigned) mode);
+	hash_params.name = name;
+	handle = rte_hash_create(&hash_params);
+	RETURN_IF_ERROR(handle == NULL, "hash creation failed");
+
+	rw_test.h = handle;
+	rw_test.mode = mode;
+	rw_test.stop = 0;
+	rw_test.writer_lcore = RTE_MAX_LCORE;
+	if (mode == RW_TEST_MULTI_WRITER)
+		rw_test.writer_lcore = rte_get_next_lcore(-1, 1, 0);
+	rte_rwlock_init(&rw_test.lock);
+	memset(rw_test.stats, 0, sizeof(rw_test.stats));
+
+	for (i = 0; i < RW_TEST_STABLE_KEYS; i++) {
+		rw_test.stable_pos[i] = rte_hash_add_key(handle,
+							 rw_test.stable_keys[i]);
+		RETURN_IF_ERROR(rw_test.stable_pos[i] < 0,
+				"failed to add stable key %u", i);
+	}
+
+	rte_eal_mp_remote_launch(rw_test_lcore, NULL, SKIP_MASTER);
+	rw_test_write(0, RW_TEST_CHURN_KEYS / num_writers,
+		      &rw_test.stats[rte_lcore_id()]);
+	if (mode == RW_TEST_MULTI_WRITER)
+		rte_eal_wait_lcore(rw_test.writer_lcore);
+	rw_test.stop = 1;
+	rte_eal_mp_wait_lcore();
+
+	RTE_LCORE_FOREACH(lcore_id) {
+		stats = &rw_test.stats[lcore_id];
+		if (lcore_id == rte_get_master_lcore() ||
+				lcore_id == rw_test.writer_lcore) {
+			write_ops += stats->ops;
+			write_ticks += stats->ticks;
+		} else {
+			read_ops += stats->ops;
+			read_ticks += stats->ticks;
+			errors += stats->errors;
+		}
+	}
+
+	printf("%-12s, %-7u, %-7u, %-18.2f, %-17.2f, %"PRIu64"\n",
+		get_rw_test_desc(mode),
+		rte_lcore_count() - num_writers, num_writers,
+		read_ops ? (double)read_ticks / read_ops : 0,
+		write_ops ? (double)write_ticks / write_ops : 0,
+		errors);
+
+	rte_hash_free(handle);
+	handle = NULL;
+	RETURN_IF_ERROR(errors != 0, "%"PRIu64" lookups of stable keys failed",
+			errors);
+	return 0;
+}
+
+/*
+ * Compare reader and writer cost of lock-free and rwlock protected tables.
+ */
+static int run_rw_tests(void)
+{
+	unsigned i, j;
+	int ret = 0;
+
+	printf("\n\n *** Concurrent reader/writer hash test results ***\n");
+	if (rte_lcore_count() < 2) {
+		printf("Need at least 2 lcores, skipped\n");
+		return 0;
+	}
+
+	rw_test.stable_keys = rte_malloc(NULL, RW_TEST_STABLE_KEYS *
+					 RW_TEST_KEY_LEN, 0);
+	rw_test.stable_pos = rte_malloc(NULL, RW_TEST_STABLE_KEYS *
+					sizeof(int32_t), 0);
+	rw_test.churn_keys = rte_malloc(NULL, RW_TEST_CHURN_KEYS *
+					RW_TEST_KEY_LEN, 0);
+	if (rw_test.stable_keys == NULL || rw_test.stable_pos == NULL ||
+			rw_test.churn_keys == NULL) {
+		ret = -1;
+		goto exit;
+	}
+
+	for (i = 0; i < RW_TEST_STABLE_KEYS; i++)
+		for (j = 0; j < RW_TEST_KEY_LEN; j++)
+			rw_test.stable_keys[i][j] = (uint8_t) rte_rand();
+	for (i = 0; i < RW_TEST_CHURN_KEYS; i++)
+		for (j = 0; j < RW_TEST_KEY_LEN; j++)
+			rw_test.churn_keys[i][j] = (uint8_t) rte_rand();
+
+	printf("Mode        , Readers, Writers, Ticks/Lookup (bulk), "
+	       "Ticks/Add or Del, Lookup errors\n");
+	if (run_rw_test(RW_TEST_RWLOCK) < 0 ||
+			run_rw_test(RW_TEST_LOCK_FREE) < 0 ||
+			run_rw_test(RW_TEST_MULTI_WRITER) < 0)
+		ret = -1;
+
+exit:
+	if (ret < 0)
+		printf("ERROR: concurrent reader/writer test failed\n");
+	rte_free(rw_test.stable_keys);
+	rte_free(rw_test.stable_pos);
+	rte_free(rw_test.churn_keys);
+	return ret;
+}
+
 /*
  * Test a hash function.
  */
@@ -757,6 +1212,10 @@ test_hash_perf(void)
 {
 	if (run_all_tbl_perf_tests() < 0)
 		return -1;
+	if (run_engine_tests() < 0)
+		return -1;
+	if (run_rw_tests() < 0)
+		return -1;
 	run_hash_func_tests();
 
 	if (fbk_hash_perf_test() < 0)
@@ -32,6 +32,8 @@
  */
 
 #include <stdio.h>
+#include <string.h>
+#include <inttypes.h>
 #include <stdint.h>
 #include <stdlib.h>
 #include <errno.h>
@@ -43,11 +45,14 @@
 #include <rte_random.h>
 #include <rte_branch_prediction.h>
 #include <rte_ip.h>
+#include <rte_launch.h>
+#include <rte_lcore.h>
 #include <time.h>
 
 #include "test.h"
 
 #include "rte_lpm.h"
+#include "rte_lpm_ext.h"
 #include "test_lpm_routes.h"
 
 #define TEST_LPM_ASSERT(cond) do {                                            \
@@ -77,7 +82,15 @@ static int32_t test14(void);
 static int32_t test15(void);
 static int32_t test16(void);
 static int32_t test17(void);
+static int32_t test18(void);
+static int32_t test19(void);
+static int32_t test20(void);
+static int32_t test21(void);
+static int32_t test22(void);
+static int32_t test23(void);
 static int32_t perf_test(void);
+static int32_t perf_test_ext(void);
+static int32_t perf_test_churn(void);
 
 rte_lpm_test tests[] = {
 /* Test Cases */
@@ -99,7 +112,15 @@ rte_lpm_test tests[] = {
 	test15,
 	test16,
 	test17,
+	test18,
+	test19,
+	test20,
+	test21,
+	test22,
+	test23,
 	perf_test,
+	perf_test_ext,
+	perf_test_churn,
 };
 
 #define NUM_LPM_TESTS (sizeof(tests)/sizeof(tests[0]))
@@ -1137,6 +1158,372 @@ test17(void)
 	return PASS;
 }
 
+/*
+ * Check that rte_lpm_ext_create fails gracefully for incorrect user input
+ * arguments, and that next hops wider than 24 bits are rejected.
+ */
+int32_t
+test18(void)
+{
+	struct rte_lpm_ext *lpm = NULL;
+	struct rte_lpm_ext_config config = {
+		.max_rules = MAX_RULES,
+		.number_tbl8s = 1024,
+		.flags = 0,
+	};
+
+	/* rte_lpm_ext_create: lpm name == NULL */
+	lpm = rte_lpm_ext_create(NULL, SOCKET_ID_ANY, &config);
+	TEST_LPM_ASSERT(lpm == NULL);
+
+	/* rte_lpm_ext_create: config == NULL */
+	lpm = rte_lpm_ext_create(__func__, SOCKET_ID_ANY, NULL);
+	TEST_LPM_ASSERT(lpm == NULL);
+
+	/* socket_id < -1 is invalid */
+	lpm = rte_lpm_ext_create(__func__, -2, &config);
+	TEST_LPM_ASSERT(lpm == NULL);
+
+	/* rte_lpm_ext_create: max_rules = 0 */
+	config.max_rules = 0;
+	lpm = rte_lpm_ext_create(__func__, SOCKET_ID_ANY, &config);
+	TEST_LPM_ASSERT(lpm == NULL);
+	config.max_rules = MAX_RULES;
+
+	/* rte_lpm_ext_create: number_tbl8s = 0 or too large */
+	config.number_tbl8s = 0;
+	lpm = rte_lpm_ext_create(__func__, SOCKET_ID_ANY, &config);
+	TEST_LPM_ASSERT(lpm == NULL);
+	config.number_tbl8s = RTE_LPM_EXT_MAX_TBL8_NUM_GROUPS + 1;
+	lpm = rte_lpm_ext_create(__func__, SOCKET_ID_ANY, &config);
+	TEST_LPM_ASSERT(lpm == NULL);
+	config.number_tbl8s = 1024;
+
+	lpm = rte_lpm_ext_create(__func__, SOCKET_ID_ANY, &config);
+	TEST_LPM_ASSERT(lpm != NULL);
+	TEST_LPM_ASSERT(rte_lpm_ext_find_existing(__func__) == lpm);
+
+	/* rte_lpm_ext_add: next hop wider than 24 bits */
+	TEST_LPM_ASSERT(rte_lpm_ext_add(lpm, IPv4(10, 0, 0, 0), 8,
+			RTE_LPM_EXT_MAX_NEXT_HOP + 1) < 0);
+
+	rte_lpm_ext_free(lpm);
+
+	return PASS;
+}
+
+/*
+ * Add, lookup and delete 24-bit next hops in an extended LPM table, with
+ * single, bulk and four address lookups, for rules both shorter and longer
+ * than 24 bits.
+ */
+int32_t
+test19(void)
+{
+	struct rte_lpm_ext *lpm = NULL;
+	struct rte_lpm_ext_config config = {
+		.max_rules = MAX_RULES,
+		.number_tbl8s = 256,
+		.flags = 0,
+	};
+	const uint32_t ip_16 = IPv4(10, 20, 0, 0), ip_28 = IPv4(10, 20, 30, 32);
+	const uint32_t nh_16 = 0xabcdef, nh_28 = RTE_LPM_EXT_MAX_NEXT_HOP;
+	uint32_t ips[4] = {
+		IPv4(10, 20, 1, 1),	/* /16 */
+		IPv4(10, 20, 30, 40),	/* /28 */
+		IPv4(10, 20, 30, 1),	/* /16, through tbl8 */
+		IPv4(11, 0, 0, 1),	/* miss */
+	};
+	uint32_t next_hop_return = 0;
+	uint32_t hop[4];
+	__m128i ipx4;
+	int32_t status;
+
+	lpm = rte_lpm_ext_create(__func__, SOCKET_ID_ANY, &config);
+	TEST_LPM_ASSERT(lpm != NULL);
+
+	status = rte_lpm_ext_add(lpm, ip_16, 16, nh_16);
+	TEST_LPM_ASSERT(status == 0);
+	status = rte_lpm_ext_add(lpm, ip_28, 28, nh_28);
+	TEST_LPM_ASSERT(status == 0);
+
+	status = rte_lpm_ext_is_rule_present(lpm, ip_28, 28, &next_hop_return);
+	TEST_LPM_ASSERT(status == 1 && next_hop_return == nh_28);
+
+	status = rte_lpm_ext_lookup(lpm, ips[0], &next_hop_return);
+	TEST_LPM_ASSERT(status == 0 && next_hop_return == nh_16);
+	status = rte_lpm_ext_lookup(lpm, ips[1], &next_hop_return);
+	TEST_LPM_ASSERT(status == 0 && next_hop_return == nh_28);
+	status = rte_lpm_ext_lookup(lpm, ips[2], &next_hop_return);
+	TEST_LPM_ASSERT(status == 0 && next_hop_return == nh_16);
+	status = rte_lpm_ext_lookup(lpm, ips[3], &next_hop_return);
+	TEST_LPM_ASSERT(status == -ENOENT);
+
+	rte_lpm_ext_lookup_bulk(lpm, ips, hop, 4);
+	TEST_LPM_ASSERT((hop[0] & RTE_LPM_EXT_LOOKUP_SUCCESS) &&
+			(hop[0] & RTE_LPM_EXT_NEXT_HOP_MASK) == nh_16);
+	TEST_LPM_ASSERT((hop[1] & RTE_LPM_EXT_LOOKUP_SUCCESS) &&
+			(hop[1] & RTE_LPM_EXT_NEXT_HOP_MASK) == nh_28);
+	TEST_LPM_ASSERT((hop[2] & RTE_LPM_EXT_LOOKUP_SUCCESS) &&
+			(hop[2] & RTE_LPM_EXT_NEXT_HOP_MASK) == nh_16);
+	TEST_LPM_ASSERT(!(hop[3] & RTE_LPM_EXT_LOOKUP_SUCCESS));
+
+	ipx4 = _mm_loadu_si128((const __m128i *)ips);
+	rte_lpm_ext_lookupx4(lpm, ipx4, hop, UINT32_MAX);
+	TEST_LPM_ASSERT(hop[0] == nh_16);
+	TEST_LPM_ASSERT(hop[1] == nh_28);
+	TEST_LPM_ASSERT(hop[2] == nh_16);
+	TEST_LPM_ASSERT(hop[3] == UINT32_MAX);
+
+	/* All four addresses hit in tbl24 */
+	ips[1] = ips[2] = ips[3] = ips[0];
+	ipx4 = _mm_loadu_si128((const __m128i *)ips);
+	rte_lpm_ext_lookupx4(lpm, ipx4, hop, UINT32_MAX);
+	TEST_LPM_ASSERT(hop[0] == nh_16 && hop[1] == nh_16 &&
+			hop[2] == nh_16 && hop[3] == nh_16);
+
+	/* Deleting the /28 falls back to the /16, deleting the /16 misses */
+	status = rte_lpm_ext_delete(lpm, ip_28, 28);
+	TEST_LPM_ASSERT(status == 0);
+	status = rte_lpm_ext_lookup(lpm, ip_28, &next_hop_return);
+	TEST_LPM_ASSERT(status == 0 && next_hop_return == nh_16);
+	status = rte_lpm_ext_delete(lpm, ip_16, 16);
+	TEST_LPM_ASSERT(status == 0);
+	status = rte_lpm_ext_lookup(lpm, ip_28, &next_hop_return);
+	TEST_LPM_ASSERT(status == -ENOENT);
+
+	rte_lpm_ext_free(lpm);
+
+	return PASS;
+}
+
+/*
+ * Use more tbl8 groups than the 256 of the basic LPM table, then exhaust the
+ * configured number of groups and check that deleting rules frees them.
+ */
+#define TEST20_NUM_TBL8S 1000
+
+int32_t
+test20(void)
+{
+	struct rte_lpm_ext *lpm = NULL;
+	struct rte_lpm_ext_config config = {
+		.max_rules = 2 * TEST20_NUM_TBL8S,
+		.number_tbl8s = TEST20_NUM_TBL8S,
+		.flags = 0,
+	};
+	uint32_t next_hop_return = 0;
+	uint32_t i;
+	int32_t status;
+
+	lpm = rte_lpm_ext_create(__func__, SOCKET_ID_ANY, &config);
+	TEST_LPM_ASSERT(lpm != NULL);
+
+	/* Each /32 in a different /24 uses one tbl8 group */
+	for (i = 0; i < TEST20_NUM_TBL8S; i++) {
+		status = rte_lpm_ext_add(lpm, IPv4(10, i >> 8, i & 0xff, 1), 32,
+				i + 0x10000);
+		TEST_LPM_ASSERT(status == 0);
+	}
+
+	/* All groups are used */
+	status = rte_lpm_ext_add(lpm, IPv4(11, 0, 0, 1), 32, 1);
+	TEST_LPM_ASSERT(status == -ENOSPC);
+
+	for (i = 0; i < TEST20_NUM_TBL8S; i++) {
+		status = rte_lpm_ext_lookup(lpm, IPv4(10, i >> 8, i & 0xff, 1),
+				&next_hop_return);
+		TEST_LPM_ASSERT(status == 0 && next_hop_return == i + 0x10000);
+		status = rte_lpm_ext_lookup(lpm, IPv4(10, i >> 8, i & 0xff, 2),
+				&next_hop_return);
+		TEST_LPM_ASSERT(status == -ENOENT);
+	}
+
+	/* Deleting a rule frees its group */
+	status = rte_lpm_ext_delete(lpm, IPv4(10, 0, 0, 1), 32);
+	TEST_LPM_ASSERT(status == 0);
+	status = rte_lpm_ext_add(lpm, IPv4(11, 0, 0, 1), 32, 1);
+	TEST_LPM_ASSERT(status == 0);
+	status = rte_lpm_ext_lookup(lpm, IPv4(11, 0, 0, 1), &next_hop_return);
+	TEST_LPM_ASSERT(status == 0 && next_hop_return == 1);
+
+	rte_lpm_ext_delete_all(lpm);
+	status = rte_lpm_ext_lookup(lpm, IPv4(11, 0, 0, 1), &next_hop_return);
+	TEST_LPM_ASSERT(status == -ENOENT);
+
+	rte_lpm_ext_free(lpm);
+
+	return PASS;
+}
+
+/*
+ * With RTE_LPM_EXT_F_RW_CONCURRENCY, check that a freed tbl8 group is only
+ * reused once the registered readers have reported a quiescent state.
+ */
+int32_t
+test21(void)
+{
+	struct rte_lpm_ext *lpm = NULL;
+	struct rte_lpm_ext_config config = {
+		.max_rules = MAX_RULES,
+		.number_tbl8s = 1,
+		.flags = RTE_LPM_EXT_F_RW_CONCURRENCY,
+	};
+	unsigned lcore_id = rte_lcore_id();
+	uint32_t next_hop_return = 0;
+	int32_t status;
+
+	lpm = rte_lpm_ext_create(__func__, SOCKET_ID_ANY, &config);
+	TEST_LPM_ASSERT(lpm != NULL);
+
+	TEST_LPM_ASSERT(rte_lpm_ext_reader_register(NULL, lcore_id) < 0);
+	TEST_LPM_ASSERT(rte_lpm_ext_reader_register(lpm, RTE_MAX_LCORE) < 0);
+	TEST_LPM_ASSERT(rte_lpm_ext_reader_register(lpm, lcore_id) == 0);
+
+	status = rte_lpm_ext_add(lpm, IPv4(10, 0, 0, 1), 32, 100);
+	TEST_LPM_ASSERT(status == 0);
+	status = rte_lpm_ext_delete(lpm, IPv4(10, 0, 0, 1), 32);
+	TEST_LPM_ASSERT(status == 0);
+	status = rte_lpm_ext_lookup(lpm, IPv4(10, 0, 0, 1), &next_hop_return);
+	TEST_LPM_ASSERT(status == -ENOENT);
+
+	/* The reader may still be reading the only group */
+	status = rte_lpm_ext_add(lpm, IPv4(10, 0, 1, 1), 32, 101);
+	TEST_LPM_ASSERT(status == -ENOSPC);
+
+	rte_lpm_ext_reader_quiescent(lpm, lcore_id);
+	status = rte_lpm_ext_add(lpm, IPv4(10, 0, 1, 1), 32, 101);
+	TEST_LPM_ASSERT(status == 0);
+	status = rte_lpm_ext_lookup(lpm, IPv4(10, 0, 1, 1), &next_hop_return);
+	TEST_LPM_ASSERT(status == 0 && next_hop_return == 101);
+
+	/* Groups are reused right away once no reader is registered */
+	TEST_LPM_ASSERT(rte_lpm_ext_reader_unregister(lpm, lcore_id) == 0);
+	status = rte_lpm_ext_delete(lpm, IPv4(10, 0, 1, 1), 32);
+	TEST_LPM_ASSERT(status == 0);
+	status = rte_lpm_ext_add(lpm, IPv4(10, 0, 2, 1), 32, 102);
+	TEST_LPM_ASSERT(status == 0);
+
+	rte_lpm_ext_free(lpm);
+
+	return PASS;
+}
+
+/*
+ * Delete a rule of 24 bits or less, with and without a replacement rule, and
+ * check that the more specific rules it covers are kept, and that the tbl8
+ * groups of other rules are not modified.
+ */
+int32_t
+test22(void)
+{
+	struct rte_lpm_ext *lpm = NULL;
+	struct rte_lpm_ext_config config = {
+		.max_rules = MAX_RULES,
+		.number_tbl8s = 16,
+		.flags = 0,
+	};
+	uint32_t next_hop_return = 0;
+	int32_t status;
+
+	lpm = rte_lpm_ext_create(__func__, SOCKET_ID_ANY, &config);
+	TEST_LPM_ASSERT(lpm != NULL);
+
+	/* The /28 uses the tbl8 group 0, which is also the next hop of the /16 */
+	status = rte_lpm_ext_add(lpm, IPv4(12, 0, 0, 16), 28, 3);
+	TEST_LPM_ASSERT(status == 0);
+	status = rte_lpm_ext_add(lpm, IPv4(10, 0, 0, 0), 8, 1);
+	TEST_LPM_ASSERT(status == 0);
+	status = rte_lpm_ext_add(lpm, IPv4(10, 1, 0, 0), 16, 0);
+	TEST_LPM_ASSERT(status == 0);
+
+	/* No replacement rule */
+	status = rte_lpm_ext_delete(lpm, IPv4(10, 0, 0, 0), 8);
+	TEST_LPM_ASSERT(status == 0);
+	status = rte_lpm_ext_lookup(lpm, IPv4(10, 1, 2, 3), &next_hop_return);
+	TEST_LPM_ASSERT(status == 0 && next_hop_return == 0);
+	status = rte_lpm_ext_lookup(lpm, IPv4(10, 3, 0, 1), &next_hop_return);
+	TEST_LPM_ASSERT(status == -ENOENT);
+	status = rte_lpm_ext_lookup(lpm, IPv4(12, 0, 0, 17), &next_hop_return);
+	TEST_LPM_ASSERT(status == 0 && next_hop_return == 3);
+	status = rte_lpm_ext_lookup(lpm, IPv4(12, 0, 0, 1), &next_hop_return);
+	TEST_LPM_ASSERT(status == -ENOENT);
+
+	/* Replacement rule */
+	status = rte_lpm_ext_add(lpm, IPv4(10, 0, 0, 0), 7, 4);
+	TEST_LPM_ASSERT(status == 0);
+	status = rte_lpm_ext_add(lpm, IPv4(10, 0, 0, 0), 8, 1);
+	TEST_LPM_ASSERT(status == 0);
+	status = rte_lpm_ext_delete(lpm, IPv4(10, 0, 0, 0), 8);
+	TEST_LPM_ASSERT(status == 0);
+	status = rte_lpm_ext_lookup(lpm, IPv4(10, 1, 2, 3), &next_hop_return);
+	TEST_LPM_ASSERT(status == 0 && next_hop_return == 0);
+	status = rte_lpm_ext_lookup(lpm, IPv4(10, 3, 0, 1), &next_hop_return);
+	TEST_LPM_ASSERT(status == 0 && next_hop_return == 4);
+	status = rte_lpm_ext_lookup(lpm, IPv4(12, 0, 0, 17), &next_hop_return);
+	TEST_LPM_ASSERT(status == 0 && next_hop_return == 3);
+	status = rte_lpm_ext_lookup(lpm, IPv4(12, 0, 0, 1), &next_hop_return);
+	TEST_LPM_ASSERT(status == -ENOENT);
+
+	rte_lpm_ext_free(lpm);
+
+	return PASS;
+}
+
+/*
+ * Same as test22, with the basic LPM table.
+ */
+int32_t
+test23(void)
+{
+	struct rte_lpm *lpm = NULL;
+	uint8_t next_hop_return = 0;
+	int32_t status;
+
+	lpm = rte_lpm_create(__func__, SOCKET_ID_ANY, MAX_RULES, 0);
+	TEST_LPM_ASSERT(lpm != NULL);
+
+	/* The /28 uses the tbl8 group 0, which is also the next hop of the /16 */
+	status = rte_lpm_add(lpm, IPv4(12, 0, 0, 16), 28, 3);
+	TEST_LPM_ASSERT(status == 0);
+	status = rte_lpm_add(lpm, IPv4(10, 0, 0, 0), 8, 1);
+	TEST_LPM_ASSERT(status == 0);
+	status = rte_lpm_add(lpm, IPv4(10, 1, 0, 0), 16, 0);
+	TEST_LPM_ASSERT(status == 0);
+
+	/* No replacement rule */
+	status = rte_lpm_delete(lpm, IPv4(10, 0, 0, 0), 8);
+	TEST_LPM_ASSERT(status == 0);
+	status = rte_lpm_lookup(lpm, IPv4(10, 1, 2, 3), &next_hop_return);
+	TEST_LPM_ASSERT(status == 0 && next_hop_return == 0);
+	status = rte_lpm_lookup(lpm, IPv4(10, 3, 0, 1), &next_hop_return);
+	TEST_LPM_ASSERT(status == -ENOENT);
+	status = rte_lpm_lookup(lpm, IPv4(12, 0, 0, 17), &next_hop_return);
+	TEST_LPM_ASSERT(status == 0 && next_hop_return == 3);
+	status = rte_lpm_lookup(lpm, IPv4(12, 0, 0, 1), &next_hop_return);
+	TEST_LPM_ASSERT(status == -ENOENT);
+
+	/* Replacement rule */
+	status = rte_lpm_add(lpm, IPv4(10, 0, 0, 0), 7, 4);
+	TEST_LPM_ASSERT(status == 0);
+	status = rte_lpm_add(lpm, IPv4(10, 0, 0, 0), 8, 1);
+	TEST_LPM_ASSERT(status == 0);
+	status = rte_lpm_delete(lpm, IPv4(10, 0, 0, 0), 8);
+	TEST_LPM_ASSERT(status == 0);
+	status = rte_lpm_lookup(lpm, IPv4(10, 1, 2, 3), &next_hop_return);
+	TEST_LPM_ASSERT(status == 0 && next_hop_return == 0);
+	status = rte_lpm_lookup(lpm, IPv4(10, 3, 0, 1), &next_hop_return);
+	TEST_LPM_ASSERT(status == 0 && next_hop_return == 4);
+	status = rte_lpm_lookup(lpm, IPv4(12, 0, 0, 17), &next_hop_return);
+	TEST_LPM_ASSERT(status == 0 && next_hop_return == 3);
+	status = rte_lpm_lookup(lpm, IPv4(12, 0, 0, 1), &next_hop_return);
+	TEST_LPM_ASSERT(status == -ENOENT);
+
+	rte_lpm_free(lpm);
+
+	return PASS;
+}
+
 /*
  * Lookup performance test
  */
@@ -1326,6 +1713,301 @@ perf_test(void)
 	return PASS;
 }
 
+/*
+ * Measure the extended LPM table with the large route table, each route
+ * using its own 24-bit next hop.
+ */
+#define PERF_TEST_EXT_NUM_TBL8S (1 << 16)
+
+int32_t
+perf_test_ext(void)
+{
+	struct rte_lpm_ext *lpm = NULL;
+	struct rte_lpm_ext_config config = {
+		.max_rules = 1000000,
+		.number_tbl8s = PERF_TEST_EXT_NUM_TBL8S,
+		.flags = 0,
+	};
+	uint64_t begin, total_time;
+	unsigned i, j;
+	uint32_t next_hop_return = 0, tbl8_used = 0;
+	int status = 0;
+	int64_t count = 0;
+
+	rte_srand(rte_rdtsc());
+
+	lpm = rte_lpm_ext_create(__func__, SOCKET_ID_ANY, &config);
+	TEST_LPM_ASSERT(lpm != NULL);
+
+	/* Measure add. */
+	begin = rte_rdtsc();
+
+	for (i = 0; i < NUM_ROUTE_ENTRIES; i++) {
+		if (rte_lpm_ext_add(lpm, large_route_table[i].ip,
+				large_route_table[i].depth, i) == 0)
+			status++;
+	}
+	/* End Timer. */
+	total_time = rte_rdtsc() - begin;
+
+	for (i = 0; i < PERF_TEST_EXT_NUM_TBL8S; i++)
+		if (lpm->tbl8[i * RTE_LPM_TBL8_GROUP_NUM_ENTRIES].valid_group)
+			tbl8_used++;
+
+	printf("Extended LPM: unique added entries = %d, "
+			"used tbl8 groups = %u\n", status, (unsigned) tbl8_used);
+	printf("Average extended LPM Add: %g cycles\n",
+			(double)total_time / NUM_ROUTE_ENTRIES);
+
+	/* Measure single Lookup */
+	total_time = 0;
+	count = 0;
+
+	for (i = 0; i < ITERATIONS; i++) {
+		static uint32_t ip_batch[BATCH_SIZE];
+
+		for (j = 0; j < BATCH_SIZE; j++)
+			ip_batch[j] = rte_rand();
+
+		/* Lookup per batch */
+		begin = rte_rdtsc();
+
+		for (j = 0; j < BATCH_SIZE; j++) {
+			if (rte_lpm_ext_lookup(lpm, ip_batch[j],
+					&next_hop_return) != 0)
+				count++;
+		}
+
+		total_time += rte_rdtsc() - begin;
+
+	}
+	printf("Average extended LPM Lookup: %.1f cycles (fails = %.1f%%)\n",
+			(double)total_time / ((double)ITERATIONS * BATCH_SIZE),
+			(count * 100.0) / (double)(ITERATIONS * BATCH_SIZE));
+
+	/* Measure bulk Lookup */
+	total_time = 0;
+	count = 0;
+	for (i = 0; i < ITERATIONS; i++) {
+		static uint32_t ip_batch[BATCH_SIZE];
+		uint32_t next_hops[BULK_SIZE];
+
+		/* Create array of random IP addresses */
+		for (j = 0; j < BATCH_SIZE; j++)
+			ip_batch[j] = rte_rand();
+
+		/* Lookup per batch */
+		begin = rte_rdtsc();
+		for (j = 0; j < BATCH_SIZE; j += BULK_SIZE) {
+			unsigned k;
+			rte_lpm_ext_lookup_bulk(lpm, &ip_batch[j], next_hops,
+					BULK_SIZE);
+			for (k = 0; k < BULK_SIZE; k++)
+				if (unlikely(!(next_hops[k] &
+						RTE_LPM_EXT_LOOKUP_SUCCESS)))
+					count++;
+		}
+
+		total_time += rte_rdtsc() - begin;
+	}
+	printf("BULK extended LPM Lookup: %.1f cycles (fails = %.1f%%)\n",
+			(double)total_time / ((double)ITERATIONS * BATCH_SIZE),
+			(count * 100.0) / (double)(ITERATIONS * BATCH_SIZE));
+
+	/* Measure LookupX4 */
+	total_time = 0;
+	count = 0;
+	for (i = 0; i < ITERATIONS; i++) {
+		static uint32_t ip_batch[BATCH_SIZE];
+		uint32_t next_hops[4];
+
+		/* Create array of random IP addresses */
+		for (j = 0; j < BATCH_SIZE; j++)
+			ip_batch[j] = rte_rand();
+
+		/* Lookup per batch */
+		begin = rte_rdtsc();
+		for (j = 0; j < BATCH_SIZE; j += RTE_DIM(next_hops)) {
+			unsigned k;
+			__m128i ipx4;
+
+			ipx4 = _mm_loadu_si128((__m128i *)(ip_batch + j));
+			rte_lpm_ext_lookupx4(lpm, ipx4, next_hops, UINT32_MAX);
+			for (k = 0; k < RTE_DIM(next_hops); k++)
+				if (unlikely(next_hops[k] == UINT32_MAX))
+					count++;
+		}
+
+		total_time += rte_rdtsc() - begin;
+	}
+	printf("Extended LPM LookupX4: %.1f cycles (fails = %.1f%%)\n",
+			(double)total_time / ((double)ITERATIONS * BATCH_SIZE),
+			(count * 100.0) / (double)(ITERATIONS * BATCH_SIZE));
+
+	/* Delete */
+	status = 0;
+	begin = rte_rdtsc();
+
+	for (i = 0; i < NUM_ROUTE_ENTRIES; i++)
+		status += rte_lpm_ext_delete(lpm, large_route_table[i].ip,
+				large_route_table[i].depth);
+
+	total_time = rte_rdtsc() - begin;
+
+	printf("Average extended LPM Delete: %g cycles\n",
+			(double)total_time / NUM_ROUTE_ENTRIES);
+
+	rte_lpm_ext_delete_all(lpm);
+	rte_lpm_ext_free(lpm);
+
+	return PASS;
+}
+
+/*
+ * Measure the rate of route updates while other lcores keep looking up the
+ * updated prefixes. A /8 covers a window of /32 routes, each in its own /24
+ * and so in its own tbl8 group, which is added and deleted as the window
+ * moves. A lookup of an address of the window must give either the covering
+ * route or the /32 route, whose next hop is the /24 of the address.
+ */
+#define CHURN_NUM_TBL8S (1 << 16)
+#define CHURN_WINDOW 1024
+#define CHURN_SPAN (1 << 16)
+#define CHURN_UPDATES (1 << 17)
+#define CHURN_QUIESCENT_PERIOD 64
+#define CHURN_COVER RTE_LPM_EXT_MAX_NEXT_HOP
+
+static struct {
+	struct rte_lpm_ext *lpm;
+	int flags;
+	volatile int stop;
+	uint64_t lookups[RTE_MAX_LCORE];
+	uint64_t errors[RTE_MAX_LCORE];
+} churn;
+
+static inline uint32_t
+churn_ip(uint32_t route)
+{
+	return IPv4(10, 0, 0, 1) + ((route % CHURN_SPAN) << 8);
+}
+
+static int
+churn_reader(__attribute__((unused)) void *arg)
+{
+	unsigned lcore_id = rte_lcore_id();
+	uint64_t lookups = 0, errors = 0;
+	uint32_t ip, next_hop;
+	unsigned i;
+
+	if (churn.flags & RTE_LPM_EXT_F_RW_CONCURRENCY)
+		rte_lpm_ext_reader_register(churn.lpm, lcore_id);
+
+	while (!churn.stop) {
+		for (i = 0; i < CHURN_QUIESCENT_PERIOD; i++) {
+			ip = churn_ip((uint32_t)rte_rand());
+			if (rte_lpm_ext_lookup(churn.lpm, ip, &next_hop) != 0 ||
+					(next_hop != CHURN_COVER &&
+					 next_hop != (ip >> 8)))
+				errors++;
+		}
+		lookups += CHURN_QUIESCENT_PERIOD;
+
+		if (churn.flags & RTE_LPM_EXT_F_RW_CONCURRENCY)
+			rte_lpm_ext_reader_quiescent(churn.lpm, lcore_id);
+	}
+
+	if (churn.flags & RTE_LPM_EXT_F_RW_CONCURRENCY)
+		rte_lpm_ext_reader_unregister(churn.lpm, lcore_id);
+
+	churn.lookups[lcore_id] = lookups;
+	churn.errors[lcore_id] = errors;
+	return 0;
+}
+
+static int32_t
+perf_test_churn_mode(int flags)
+{
+	struct rte_lpm_ext_config config = {
+		.max_rules = 2 * CHURN_WINDOW,
+		.number_tbl8s = CHURN_NUM_TBL8S,
+		.flags = flags,
+	};
+	uint64_t begin, total_time, lookups = 0, errors = 0, retries = 0;
+	unsigned lcore_id;
+	uint32_t route, updates = 0;
+	int status;
+
+	memset(&churn, 0, sizeof(churn));
+	churn.flags = flags;
+	churn.lpm = rte_lpm_ext_create(__func__, SOCKET_ID_ANY, &config);
+	TEST_LPM_ASSERT(churn.lpm != NULL);
+
+	status = rte_lpm_ext_add(churn.lpm, IPv4(10, 0, 0, 0), 8, CHURN_COVER);
+	TEST_LPM_ASSERT(status == 0);
+
+	rte_eal_mp_remote_launch(churn_reader, NULL, SKIP_MASTER);
+
+	begin = rte_rdtsc();
+	for (route = 0; updates < CHURN_UPDATES; route++) {
+		while ((status = rte_lpm_ext_add(churn.lpm, churn_ip(route), 32,
+				churn_ip(route) >> 8)) == -ENOSPC) {
+			/* Freed groups wait for the readers */
+			retries++;
+			rte_pause();
+		}
+		if (status != 0)
+			break;
+		updates++;
+
+		if (route >= CHURN_WINDOW) {
+			status = rte_lpm_ext_delete(churn.lpm,
+					churn_ip(route - CHURN_WINDOW), 32);
+			if (status != 0)
+				break;
+			updates++;
+		}
+	}
+	total_time = rte_rdtsc() - begin;
+
+	churn.stop = 1;
+	rte_eal_mp_wait_lcore();
+
+	RTE_LCORE_FOREACH_SLAVE(lcore_id) {
+		lookups += churn.lookups[lcore_id];
+		errors += churn.errors[lcore_id];
+	}
+
+	rte_lpm_ext_free(churn.lpm);
+	TEST_LPM_ASSERT(status == 0);
+
+	printf("Extended LPM churn (%s): %.0f updates/s, %u reader lcores, "
+			"%"PRIu64" lookups, %"PRIu64" wrong next hops, "
+			"%"PRIu64" allocation retries\n",
+			(flags & RTE_LPM_EXT_F_RW_CONCURRENCY) ?
+			"RW concurrency" : "default",
+			(double)updates * rte_get_tsc_hz() / total_time,
+			rte_lcore_count() - 1, lookups, errors, retries);
+
+	/* Only the concurrency mode guarantees consistent lookups */
+	if (flags & RTE_LPM_EXT_F_RW_CONCURRENCY)
+		TEST_LPM_ASSERT(errors == 0);
+
+	return PASS;
+}
+
+int32_t
+perf_test_churn(void)
+{
+	if (rte_lcore_count() < 2)
+		printf("Extended LPM churn: no reader lcore, "
+				"measuring updates only\n");
+
+	if (perf_test_churn_mode(0) < 0)
+		return -1;
+
+	return perf_test_churn_mode(RTE_LPM_EXT_F_RW_CONCURRENCY);
+}
+
 /*
  * Do all unit and performance tests.
  */
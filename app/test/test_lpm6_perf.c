@@ -0,0 +1,272 @@
+/*-
+ *   BSD LICENSE
+ *
+ *   Copyright(c) 2010-2015 Intel Corporation. All rights reserved.
+ *   All rights reserved.
+ *
+ *   Redistribution and use in source and binary forms, with or without
+ *   modification, are permitted provided that the following conditions
+ *   are met:
+ *
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in
+ *       the documentation and/or other materials provided with the
+ *       distribution.
+ *     * Neither the name of Intel Corporation nor the names of its
+ *       contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ *   THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *   "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *   LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ *   A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ *   OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ *   SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ *   LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ *   DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ *   THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ *   (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ *   OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+
+#include <rte_common.h>
+#include <rte_cycles.h>
+#include <rte_memory.h>
+#include <rte_random.h>
+#include <rte_branch_prediction.h>
+#include <rte_lpm6.h>
+
+#include "test.h"
+
+#define TEST_LPM_ASSERT(cond) do {                                            \
+	if (!(cond)) {                                                        \
+		printf("Error at line %d: \n", __LINE__);                     \
+		return -1;                                                    \
+	}                                                                     \
+} while(0)
+
+#define NUM_ROUTES      10000
+#define NUM_IPS         (1 << 16)
+#define NUMBER_TBL8S    (1 << 16)
+#define ITERATIONS      (1 << 6)
+#define BULK_SIZE       32
+
+/*
+ * Share of each prefix length in the synthetic route table, in per mille,
+ * following the distribution of the prefixes announced in the global IPv6
+ * routing table: mostly /48 and /32, then the other nibble boundaries.
+ */
+static const struct {
+	uint8_t depth;
+	uint16_t weight;
+} route_distribution[] = {
+	{ 19, 1 }, { 20, 4 }, { 24, 5 }, { 28, 20 }, { 29, 40 },
+	{ 30, 5 }, { 32, 220 }, { 33, 10 }, { 34, 10 }, { 35, 10 },
+	{ 36, 40 }, { 38, 10 }, { 40, 60 }, { 42, 10 }, { 44, 70 },
+	{ 45, 10 }, { 46, 20 }, { 47, 20 }, { 48, 410 }, { 56, 5 },
+	{ 64, 5 }, { 128, 5 },
+};
+
+struct perf_route {
+	uint8_t ip[RTE_LPM6_IPV6_ADDR_SIZE];
+	uint8_t depth;
+	uint8_t next_hop;
+};
+
+static struct perf_route routes[NUM_ROUTES];
+static uint8_t ips[NUM_IPS][RTE_LPM6_IPV6_ADDR_SIZE];
+
+static uint8_t
+random_depth(void)
+{
+	unsigned total = 0, i, r;
+
+	for (i = 0; i < RTE_DIM(route_distribution); i++)
+		total += route_distribution[i].weight;
+
+	r = rte_rand() % total;
+	for (i = 0; r >= route_distribution[i].weight; i++)
+		r -= route_distribution[i].weight;
+
+	return route_distribution[i].depth;
+}
+
+/* Copy the first bits of a prefix and fill the next ones randomly. */
+static void
+random_ip(uint8_t *ip, const uint8_t *prefix, unsigned prefix_depth)
+{
+	unsigned i;
+
+	for (i = 0; i < RTE_LPM6_IPV6_ADDR_SIZE; i++)
+		ip[i] = (uint8_t)rte_rand();
+
+	for (i = 0; i < prefix_depth / 8; i++)
+		ip[i] = prefix[i];
+
+	if (prefix_depth % 8) {
+		uint8_t mask = (uint8_t)(0xff << (8 - prefix_depth % 8));
+
+		ip[i] = (uint8_t)((prefix[i] & mask) | (ip[i] & ~mask));
+	}
+}
+
+/*
+ * Generate the route table: all the prefixes are in 2000::/3, and most of
+ * the long prefixes are more specifics of a shorter prefix already in the
+ * table, as for provider aggregates, so that they share their first tbl8s.
+ */
+static void
+generate_routes(void)
+{
+	static const uint8_t global_unicast[RTE_LPM6_IPV6_ADDR_SIZE] = { 0x20 };
+	unsigned i, parent;
+
+	for (i = 0; i < NUM_ROUTES; i++) {
+		struct perf_route *route = &routes[i];
+
+		route->depth = random_depth();
+		route->next_hop = (uint8_t)(i + 1);
+
+		parent = (unsigned)(rte_rand() % (i + 1));
+		if (parent < i && route->depth > 32 && (rte_rand() & 3) != 0 &&
+				routes[parent].depth <= 32)
+			random_ip(route->ip, routes[parent].ip,
+					routes[parent].depth);
+		else
+			random_ip(route->ip, global_unicast, 3);
+	}
+
+	/* Destination addresses are spread over all the routes. */
+	for (i = 0; i < NUM_IPS; i++) {
+		const struct perf_route *route = &routes[rte_rand() % NUM_ROUTES];
+
+		random_ip(ips[i], route->ip, route->depth);
+	}
+}
+
+static void
+print_route_distribution(void)
+{
+	unsigned i, j, count;
+
+	printf("Route distribution per prefix width:\n");
+	printf("DEPTH    QUANTITY (PERCENT)\n");
+	printf("---------------------------\n");
+
+	for (i = 0; i < RTE_DIM(route_distribution); i++) {
+		count = 0;
+		for (j = 0; j < NUM_ROUTES; j++)
+			if (routes[j].depth == route_distribution[i].depth)
+				count++;
+		printf("%.3u%15u (%.2f)\n", route_distribution[i].depth, count,
+				count * 100.0 / NUM_ROUTES);
+	}
+	printf("\n");
+}
+
+static int
+test_lpm6_perf(void)
+{
+	struct rte_lpm6 *lpm = NULL;
+	struct rte_lpm6_config config = {
+		.max_rules = NUM_ROUTES,
+		.number_tbl8s = NUMBER_TBL8S,
+		.flags = 0,
+	};
+	static int16_t next_hops[NUM_IPS];
+	uint64_t begin, total_time;
+	unsigned i, j, added = 0;
+	uint8_t next_hop;
+	int64_t count = 0;
+
+	/* Use the same route table at each run. */
+	rte_srand(0x1eaf);
+	generate_routes();
+
+	printf("No. routes = %u\n", NUM_ROUTES);
+	print_route_distribution();
+
+	lpm = rte_lpm6_create(__func__, SOCKET_ID_ANY, &config);
+	TEST_LPM_ASSERT(lpm != NULL);
+
+	/* Measure add. */
+	begin = rte_rdtsc();
+	for (i = 0; i < NUM_ROUTES; i++) {
+		if (rte_lpm6_add(lpm, routes[i].ip, routes[i].depth,
+				routes[i].next_hop) == 0)
+			added++;
+	}
+	total_time = rte_rdtsc() - begin;
+
+	printf("Unique added entries = %u\n", added);
+	printf("Average LPM Add: %g cycles\n",
+			(double)total_time / NUM_ROUTES);
+
+	/* Measure single lookup. */
+	total_time = 0;
+	count = 0;
+	for (i = 0; i < ITERATIONS; i++) {
+		begin = rte_rdtsc();
+		for (j = 0; j < NUM_IPS; j++) {
+			if (rte_lpm6_lookup(lpm, ips[j], &next_hop) != 0)
+				count++;
+		}
+		total_time += rte_rdtsc() - begin;
+	}
+	printf("Average LPM Lookup: %.1f cycles (fails = %.1f%%)\n",
+			(double)total_time / ((double)ITERATIONS * NUM_IPS),
+			(count * 100.0) / (double)(ITERATIONS * NUM_IPS));
+
+	/* Measure bulk lookup. */
+	total_time = 0;
+	count = 0;
+	for (i = 0; i < ITERATIONS; i++) {
+		begin = rte_rdtsc();
+		for (j = 0; j < NUM_IPS; j += BULK_SIZE)
+			rte_lpm6_lookup_bulk_func(lpm, &ips[j], &next_hops[j],
+					BULK_SIZE);
+		total_time += rte_rdtsc() - begin;
+
+		for (j = 0; j < NUM_IPS; j++)
+			if (next_hops[j] < 0)
+				count++;
+	}
+	printf("BULK LPM Lookup: %.1f cycles (fails = %.1f%%)\n",
+			(double)total_time / ((double)ITERATIONS * NUM_IPS),
+			(count * 100.0) / (double)(ITERATIONS * NUM_IPS));
+
+	/* Bulk and single lookups must agree. */
+	for (j = 0; j < NUM_IPS; j++) {
+		int status = rte_lpm6_lookup(lpm, ips[j], &next_hop);
+
+		TEST_LPM_ASSERT(status == 0 ? next_hops[j] == next_hop :
+				next_hops[j] == -1);
+	}
+
+	/* Measure delete of a few routes, as each one rebuilds the table. */
+	begin = rte_rdtsc();
+	for (i = 0; i < 10; i++)
+		rte_lpm6_delete(lpm, routes[i].ip, routes[i].depth);
+	total_time = rte_rdtsc() - begin;
+
+	printf("Average LPM Delete: %g cycles\n", (double)total_time / 10);
+
+	rte_lpm6_delete_all(lpm);
+	rte_lpm6_free(lpm);
+
+	return 0;
+}
+
+static struct test_command lpm6_perf_cmd = {
+	.command = "lpm6_perf_autotest",
+	.callback = test_lpm6_perf,
+};
+REGISTER_TEST_COMMAND(lpm6_perf_cmd);
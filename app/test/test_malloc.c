@@ -33,11 +33,14 @@
 
 #include <stdio.h>
 #include <stdint.h>
+#include <inttypes.h>
 #include <string.h>
 #include <stdarg.h>
 #include <errno.h>
 #include <stdlib.h>
 #include <sys/queue.h>
+#include <sys/wait.h>
+#include <unistd.h>
 
 #include <rte_common.h>
 #include <rte_memory.h>
@@ -923,6 +926,132 @@ test_alloc_socket(void)
 	return 0;
 }
 
+/*
+ * Small allocation throughput
+ * ===========================
+ *
+ * Each lcore allocates bursts of blocks of 64 to 512 bytes and frees them,
+ * first on the master lcore alone, then on all lcores at the same time.
+ * The number of allocations and frees per second is reported.
+ */
+#define SMALL_ALLOC_ITER  20000
+#define SMALL_ALLOC_BURST 32
+
+static uint64_t small_alloc_cycles[RTE_MAX_LCORE];
+static volatile unsigned small_alloc_start;
+
+static int
+small_alloc_perf_per_lcore(__attribute__((unused)) void *arg)
+{
+	void *ptrs[SMALL_ALLOC_BURST];
+	unsigned lcore_id = rte_lcore_id();
+	uint64_t start;
+	unsigned i, j;
+
+	while (small_alloc_start == 0)
+		rte_pause();
+
+	start = rte_rdtsc();
+	for (i = 0; i < SMALL_ALLOC_ITER; i++) {
+		for (j = 0; j < SMALL_ALLOC_BURST; j++) {
+			ptrs[j] = rte_malloc(NULL, RTE_CACHE_LINE_SIZE << (j % 4),
+					0);
+			if (ptrs[j] == NULL)
+				return -1;
+		}
+		for (j = 0; j < SMALL_ALLOC_BURST; j++)
+			rte_free(ptrs[j]);
+	}
+	small_alloc_cycles[lcore_id] = rte_rdtsc() - start;
+	return 0;
+}
+
+static int
+test_small_alloc_perf(void)
+{
+	unsigned lcore_id, nb_lcores;
+	uint64_t max_cycles;
+	int ret = 0;
+
+	/* master lcore alone */
+	small_alloc_start = 1;
+	if (small_alloc_perf_per_lcore(NULL) < 0)
+		return -1;
+	printf("small alloc/free on 1 lcore: %"PRIu64" Mops/s\n",
+		(uint64_t)2 * SMALL_ALLOC_ITER * SMALL_ALLOC_BURST * rte_get_tsc_hz() /
+		small_alloc_cycles[rte_lcore_id()] / 1000000);
+
+	/* all lcores */
+	small_alloc_start = 0;
+	nb_lcores = 0;
+	RTE_LCORE_FOREACH_SLAVE(lcore_id) {
+		rte_eal_remote_launch(small_alloc_perf_per_lcore, NULL,
+			lcore_id);
+	}
+	small_alloc_start = 1;
+	if (small_alloc_perf_per_lcore(NULL) < 0)
+		ret = -1;
+	RTE_LCORE_FOREACH_SLAVE(lcore_id) {
+		if (rte_eal_wait_lcore(lcore_id) < 0)
+			ret = -1;
+	}
+	if (ret < 0)
+		return ret;
+
+	max_cycles = 0;
+	RTE_LCORE_FOREACH(lcore_id) {
+		nb_lcores++;
+		if (small_alloc_cycles[lcore_id] > max_cycles)
+			max_cycles = small_alloc_cycles[lcore_id];
+	}
+	printf("small alloc/free on %u lcores: %"PRIu64" Mops/s\n", nb_lcores,
+		(uint64_t)2 * SMALL_ALLOC_ITER * SMALL_ALLOC_BURST * nb_lcores *
+		rte_get_tsc_hz() / max_cycles / 1000000);
+
+	return 0;
+}
+
+/*
+ * Use fork() to check that freeing a block twice is fatal, including when
+ * the block went to the cache of the lcore on the first free.
+ * The memory is shared with the child: the block freed before the fork is
+ * the first one given by the cache of the master lcore in both processes,
+ * so the child only puts it back in the state the parent expects.
+ */
+static int
+test_double_free(void)
+{
+	void *ptr;
+	int pid;
+	int status;
+
+	ptr = rte_malloc(NULL, RTE_CACHE_LINE_SIZE, 0);
+	if (ptr == NULL) {
+		printf("rte_malloc() failed\n");
+		return -1;
+	}
+	rte_free(ptr);
+
+	pid = fork();
+
+	if (pid == 0) {
+		ptr = rte_malloc(NULL, RTE_CACHE_LINE_SIZE, 0);
+		rte_free(ptr);
+		rte_free(ptr);
+		exit(0);
+	} else if (pid < 0) {
+		printf("Fork Failed\n");
+		return -1;
+	}
+	wait(&status);
+	if (status == 0) {
+		printf("Double free was not detected\n");
+		return -1;
+	}
+
+	return 0;
+}
+
 static int
 test_malloc(void)
 {
@@ -965,6 +1094,12 @@ test_malloc(void)
 	}
 	else printf("test_realloc() passed\n");
 
+	if (test_double_free() < 0){
+		printf("test_double_free() failed\n");
+		return -1;
+	}
+	else printf("test_double_free() passed\n");
+
 	/*----------------------------*/
 	RTE_LCORE_FOREACH_SLAVE(lcore_id) {
 		rte_eal_remote_launch(test_align_overlap_per_lcore, NULL, lcore_id);
@@ -1042,6 +1177,14 @@ test_malloc(void)
 	else
 		printf("test_multi_alloc_statistics() passed\n");
 
+	ret = test_small_alloc_perf();
+	if (ret < 0) {
+		printf("test_small_alloc_perf() failed\n");
+		return ret;
+	}
+	else
+		printf("test_small_alloc_perf() passed\n");
+
 	return 0;
 }
 
@@ -56,6 +56,7 @@
 #include <rte_ring.h>
 #include <rte_mempool.h>
 #include <rte_mbuf.h>
+#include <rte_malloc.h>
 #include <rte_random.h>
 #include <rte_cycles.h>
 
@@ -132,6 +133,13 @@ static unsigned refcnt_lcore[RTE_MAX_LCORE];
  *    - Clone a mbuf and verify the data
  *    - Clone the cloned mbuf and verify the data
  *    - Attach a mbuf to another that does not have the same priv_size.
+ *
+ * #. Test bulk allocation and free of mbufs.
+ *    - Modify the fields of mbufs and free them.
+ *    - Allocate them back in bulks, and check that they are reset.
+ *    - Check that a bulk bigger than the pool fails without allocating.
+ *    - Free them in one bulk, mixed with multi-segment packets, mbufs
+ *      from another pool and NULL entries, and check that no mbuf is lost.
  */
 
 #define GOTO_FAIL(str, ...) do {					\
@@ -532,6 +540,314 @@ fail:
 		rte_pktmbuf_free(clone2);
 	return -1;
 }
+
+/*
+ * test attachment of an external buffer to mbufs
+ */
+#define EXT_BUF_SIZE 4096
+#define EXT_BUF_NB_MBUF 3
+
+static unsigned ext_buf_freed;
+
+static void
+ext_buf_free_cb(void *addr, void *opaque)
+{
+	if (opaque == &ext_buf_freed)
+		ext_buf_freed++;
+	rte_free(addr);
+}
+
+static int
+test_pktmbuf_ext_buffer(void)
+{
+	struct rte_mbuf_ext_shared_info shinfo;
+	struct rte_mbuf *m[EXT_BUF_NB_MBUF] = { NULL };
+	struct rte_mbuf *clone = NULL;
+	phys_addr_t buf_physaddr;
+	unsigned i, count;
+	char *buf, *data;
+
+	count = rte_mempool_count(pktmbuf_pool);
+	ext_buf_freed = 0;
+
+	buf = rte_malloc(NULL, EXT_BUF_SIZE, 0);
+	if (buf == NULL)
+		GOTO_FAIL("cannot allocate external buffer");
+	memset(buf, 0x5a, EXT_BUF_SIZE);
+	buf_physaddr = rte_malloc_virt2phy(buf);
+	rte_mbuf_ext_shinfo_init(&shinfo, ext_buf_free_cb, &ext_buf_freed);
+
+	/* attach the same buffer to several mbufs */
+	for (i = 0; i < EXT_BUF_NB_MBUF; i++) {
+		m[i] = rte_pktmbuf_alloc(pktmbuf_pool);
+		if (m[i] == NULL)
+			GOTO_FAIL("cannot allocate mbuf");
+		rte_pktmbuf_attach_extbuf(m[i], buf, buf_physaddr,
+			EXT_BUF_SIZE, &shinfo);
+		if (!RTE_MBUF_HAS_EXTBUF(m[i]) || RTE_MBUF_DIRECT(m[i]) ||
+				RTE_MBUF_INDIRECT(m[i]))
+			GOTO_FAIL("bad flags of attached mbuf");
+		if (rte_pktmbuf_mtod(m[i], char *) != buf ||
+				m[i]->buf_physaddr != buf_physaddr ||
+				m[i]->buf_len != EXT_BUF_SIZE)
+			GOTO_FAIL("external buffer not attached");
+		data = rte_pktmbuf_append(m[i], EXT_BUF_SIZE);
+		if (data != buf)
+			GOTO_FAIL("cannot append external buffer data");
+	}
+	if (rte_mbuf_ext_refcnt_read(&shinfo) != EXT_BUF_NB_MBUF + 1)
+		GOTO_FAIL("bad refcnt of external buffer");
+
+	/* a clone shares the external buffer */
+	clone = rte_pktmbuf_clone(m[0], pktmbuf_pool);
+	if (clone == NULL)
+		GOTO_FAIL("cannot clone mbuf");
+	if (!RTE_MBUF_HAS_EXTBUF(clone) || RTE_MBUF_INDIRECT(clone) ||
+			rte_pktmbuf_mtod(clone, char *) != buf ||
+			rte_pktmbuf_pkt_len(clone) != EXT_BUF_SIZE)
+		GOTO_FAIL("clone not attached to external buffer");
+	if (rte_mbuf_ext_refcnt_read(&shinfo) != EXT_BUF_NB_MBUF + 2 ||
+			rte_mbuf_refcnt_read(m[0]) != 1)
+		GOTO_FAIL("bad refcnt after clone");
+
+	/* detach, then free the mbufs: the buffer is kept by its owner */
+	rte_pktmbuf_detach(m[0]);
+	if (RTE_MBUF_HAS_EXTBUF(m[0]) ||
+			rte_pktmbuf_mtod(m[0], char *) !=
+			(char *)m[0] + sizeof(*m[0]) + RTE_PKTMBUF_HEADROOM)
+		GOTO_FAIL("mbuf not detached from external buffer");
+	rte_pktmbuf_free(clone);
+	clone = NULL;
+	rte_pktmbuf_free_bulk(m, 2);
+	m[0] = m[1] = NULL;
+	if (rte_mbuf_ext_refcnt_read(&shinfo) != 2 || ext_buf_freed != 0)
+		GOTO_FAIL("external buffer released too early");
+
+	/* the owner releases its reference, the last mbuf frees the buffer */
+	rte_mbuf_ext_shinfo_release(&shinfo, buf);
+	if (ext_buf_freed != 0)
+		GOTO_FAIL("external buffer freed while attached");
+	rte_pktmbuf_free(m[2]);
+	m[2] = NULL;
+	if (ext_buf_freed != 1)
+		GOTO_FAIL("external buffer not freed");
+
+	if (rte_mempool_count(pktmbuf_pool) != count)
+		GOTO_FAIL("mbufs not returned to the pool");
+
+	printf("%s ok\n", __func__);
+	return 0;
+
+fail:
+	if (clone)
+		rte_pktmbuf_free(clone);
+	for (i = 0; i < EXT_BUF_NB_MBUF; i++)
+		if (m[i])
+			rte_pktmbuf_free(m[i]);
+	return -1;
+}
+
+/*
+ * test registration and use of dynamic fields and flags
+ */
+static int
+test_mbuf_dyn(void)
+{
+	struct rte_mbuf_dynfield field, field2;
+	struct rte_mbuf_dynflag flag;
+	struct rte_mbuf *m = NULL;
+	int ts_offset, offset, offset2, bitnum;
+	uint64_t ts_flag;
+
+	/*
+	 * the timestamp is the first field registered, so it goes in the
+	 * free space of the first cache line if it is aligned for it
+	 */
+	if (rte_mbuf_dyn_rx_timestamp_register(&ts_offset, &ts_flag) != 0)
+		GOTO_FAIL("cannot register timestamp");
+	if (offsetof(struct rte_mbuf, dynfield0) %
+			__alignof__(rte_mbuf_timestamp_t) == 0 &&
+			(size_t)ts_offset >= offsetof(struct rte_mbuf, cacheline1))
+		GOTO_FAIL("timestamp not in the first cache line");
+	if (ts_offset % sizeof(rte_mbuf_timestamp_t) != 0 ||
+			(ts_flag & ~(PKT_LAST_FREE | (PKT_LAST_FREE - 1))) != 0 ||
+			(ts_flag & (PKT_FIRST_FREE - 1)) != 0)
+		GOTO_FAIL("bad timestamp placement");
+	if (rte_mbuf_dynfield_lookup(RTE_MBUF_DYNFIELD_TIMESTAMP_NAME,
+			&field) != ts_offset ||
+			field.size != sizeof(rte_mbuf_timestamp_t))
+		GOTO_FAIL("cannot look up timestamp field");
+
+	/* invalid registrations */
+	memset(&field, 0, sizeof(field));
+	snprintf(field.name, sizeof(field.name), "test_dynfield");
+	field.size = 4;
+	field.align = 3;
+	if (rte_mbuf_dynfield_register(&field) != -EINVAL)
+		GOTO_FAIL("bad alignment not refused");
+	field.align = 4;
+	field.flags = 1;
+	if (rte_mbuf_dynfield_register(&field) != -EINVAL)
+		GOTO_FAIL("bad flags not refused");
+	field.flags = 0;
+	memset(field.name, 'a', sizeof(field.name));
+	if (rte_mbuf_dynfield_register(&field) != -EINVAL)
+		GOTO_FAIL("name too long not refused");
+	snprintf(field.name, sizeof(field.name), "test_dynfield");
+
+	/* a field registered twice gets the same offset */
+	offset = rte_mbuf_dynfield_register(&field);
+	if (offset < 0 || offset % 4 != 0)
+		GOTO_FAIL("cannot register dynamic field");
+	if (rte_mbuf_dynfield_register(&field) != offset)
+		GOTO_FAIL("field registered twice at different offsets");
+	field.size = 2;
+	if (rte_mbuf_dynfield_register(&field) != -EEXIST)
+		GOTO_FAIL("field registered with different parameters");
+	if (rte_mbuf_dynfield_lookup("test_dynfield_none", NULL) != -ENOENT)
+		GOTO_FAIL("lookup of unknown field succeeded");
+
+	memset(&field2, 0, sizeof(field2));
+	snprintf(field2.name, sizeof(field2.name), "test_dynfield2");
+	field2.size = 8;
+	field2.align = 8;
+	offset2 = rte_mbuf_dynfield_register(&field2);
+	if (offset2 < 0 || offset2 % 8 != 0 ||
+			(offset2 < offset + 4 && offset < offset2 + 8) ||
+			(offset2 < ts_offset + 8 && ts_offset < offset2 + 8))
+		GOTO_FAIL("overlapping dynamic fields");
+
+	memset(&flag, 0, sizeof(flag));
+	snprintf(flag.name, sizeof(flag.name), "test_dynflag");
+	bitnum = rte_mbuf_dynflag_register(&flag);
+	if (bitnum < 0 || (1ULL << bitnum) == ts_flag ||
+			(1ULL << bitnum) < PKT_FIRST_FREE ||
+			(1ULL << bitnum) > PKT_LAST_FREE)
+		GOTO_FAIL("bad dynamic flag");
+	if (rte_mbuf_dynflag_register(&flag) != bitnum ||
+			rte_mbuf_dynflag_lookup("test_dynflag", NULL) != bitnum)
+		GOTO_FAIL("dynamic flag registered twice");
+
+	/* the dynamic fields do not overwrite the static ones */
+	m = rte_pktmbuf_alloc(pktmbuf_pool);
+	if (m == NULL)
+		GOTO_FAIL("cannot allocate mbuf");
+	m->seqn = 0x12345678;
+	m->udata64 = 0x1122334455667788ULL;
+	m->tx_offload = UINT64_MAX;
+	*RTE_MBUF_DYNFIELD(m, ts_offset, rte_mbuf_timestamp_t *) = UINT64_MAX;
+	*RTE_MBUF_DYNFIELD(m, offset, uint32_t *) = UINT32_MAX;
+	*RTE_MBUF_DYNFIELD(m, offset2, uint64_t *) = UINT64_MAX;
+	m->ol_flags |= ts_flag | (1ULL << bitnum);
+	if (m->seqn != 0x12345678 || m->udata64 != 0x1122334455667788ULL ||
+			m->pool != pktmbuf_pool || m->next != NULL ||
+			m->priv_size != 0 || m->buf_len == 0 ||
+			rte_mbuf_refcnt_read(m) != 1 || RTE_MBUF_INDIRECT(m) ||
+			RTE_MBUF_HAS_EXTBUF(m) || m->pkt_len != 0)
+		GOTO_FAIL("dynamic fields overwrote static fields");
+	rte_pktmbuf_free(m);
+
+	rte_mbuf_dyn_dump(stdout);
+	printf("%s ok\n", __func__);
+	return 0;
+
+fail:
+	if (m)
+		rte_pktmbuf_free(m);
+	return -1;
+}
+
+/*
+ * test bulk allocation and free of mbufs
+ */
+static int
+test_pktmbuf_alloc_free_bulk(void)
+{
+	struct rte_mbuf *m[NB_MBUF];
+	struct rte_mbuf *m2[3];
+	struct rte_mbuf *f[NB_MBUF + RTE_DIM(m2) + 1];
+	struct rte_mbuf *mb;
+	unsigned i, n = 0, nb = 0;
+
+	memset(m, 0, sizeof(m));
+	memset(m2, 0, sizeof(m2));
+
+	/* alloc all mbufs and dirty them */
+	for (i = 0; i < NB_MBUF; i++) {
+		m[i] = rte_pktmbuf_alloc(pktmbuf_pool);
+		if (m[i] == NULL)
+			GOTO_FAIL("rte_pktmbuf_alloc() failed (%u)", i);
+		m[i]->data_off += 64;
+		m[i]->data_len = 10;
+		m[i]->pkt_len = 10;
+		m[i]->port = 3;
+		m[i]->vlan_tci = 5;
+		m[i]->ol_flags = PKT_TX_VLAN_PKT;
+		m[i]->l2_len = 14;
+	}
+	for (i = 0; i < NB_MBUF; i++) {
+		rte_pktmbuf_free(m[i]);
+		m[i] = NULL;
+	}
+
+	/* a bulk bigger than the pool must fail without allocating */
+	if (rte_pktmbuf_alloc_bulk(pktmbuf_pool, f, NB_MBUF + 1) == 0)
+		GOTO_FAIL("bulk bigger than the pool allocated");
+	if (rte_mempool_count(pktmbuf_pool) != NB_MBUF)
+		GOTO_FAIL("failed bulk allocation lost mbufs");
+
+	/* alloc by bulks of 8, until the pool is empty */
+	while (n + 8 <= NB_MBUF &&
+	       rte_pktmbuf_alloc_bulk(pktmbuf_pool, &m[n], 8) == 0)
+		n += 8;
+	if (n < NB_MBUF / 2)
+		GOTO_FAIL("only %u mbufs allocated in bulks", n);
+
+	for (i = 0; i < n; i++) {
+		mb = m[i];
+		if (mb->data_off != RTE_PKTMBUF_HEADROOM ||
+		    rte_mbuf_refcnt_read(mb) != 1 || mb->nb_segs != 1 ||
+		    mb->port != 0xff || mb->ol_flags != 0 ||
+		    mb->next != NULL || mb->data_len != 0 ||
+		    mb->pkt_len != 0 || mb->vlan_tci != 0 ||
+		    mb->tx_offload != 0 || mb->pool != pktmbuf_pool)
+			GOTO_FAIL("mbuf %u not reset by bulk allocation", i);
+	}
+
+	if (rte_pktmbuf_alloc_bulk(pktmbuf_pool2, m2, RTE_DIM(m2)) != 0)
+		GOTO_FAIL("cannot allocate mbufs from the second pool");
+
+	/*
+	 * free all of them in one bulk: a packet of two segments, a NULL
+	 * entry, and mbufs of both pools
+	 */
+	m[0]->next = m[1];
+	m[0]->nb_segs = 2;
+	m[0]->pkt_len = 0;
+	f[nb++] = m[0];
+	f[nb++] = NULL;
+	f[nb++] = m2[0];
+	for (i = 2; i < n; i++) {
+		f[nb++] = m[i];
+		if (i == n / 2)
+			f[nb++] = m2[1];
+	}
+	f[nb++] = m2[2];
+	rte_pktmbuf_free_bulk(f, nb);
+	memset(m, 0, sizeof(m));
+	memset(m2, 0, sizeof(m2));
+
+	if (rte_mempool_count(pktmbuf_pool) != NB_MBUF ||
+	    rte_mempool_count(pktmbuf_pool2) != NB_MBUF)
+		GOTO_FAIL("mbufs lost by bulk free");
+
+	return 0;
+
+fail:
+	rte_pktmbuf_free_bulk(m, RTE_DIM(m));
+	rte_pktmbuf_free_bulk(m2, RTE_DIM(m2));
+	return -1;
+}
 #undef GOTO_FAIL
 
 /*
@@ -998,6 +1314,12 @@ test_mbuf(void)
 		return -1;
 	}
 
+	/* test bulk allocation and free of mbufs */
+	if (test_pktmbuf_alloc_free_bulk() < 0) {
+		printf("test_pktmbuf_alloc_free_bulk() failed\n");
+		return -1;
+	}
+
 	if (testclone_testupdate_testdetach()<0){
 		printf("testclone_and_testupdate() failed \n");
 		return -1;
@@ -1008,6 +1330,16 @@ test_mbuf(void)
 		return -1;
 	}
 
+	if (test_pktmbuf_ext_buffer() < 0) {
+		printf("test_pktmbuf_ext_buffer() failed\n");
+		return -1;
+	}
+
+	if (test_mbuf_dyn() < 0) {
+		printf("test_mbuf_dyn() failed\n");
+		return -1;
+	}
+
 	if (test_refcnt_mbuf()<0){
 		printf("test_refcnt_mbuf() failed \n");
 		return -1;
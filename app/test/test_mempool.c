@@ -56,6 +56,7 @@
 #include <rte_mempool.h>
 #include <rte_spinlock.h>
 #include <rte_malloc.h>
+#include <rte_errno.h>
 
 #include "test.h"
 
@@ -69,6 +70,12 @@
  *    - Get two objects, put two objects
  *    - Get all objects, test that their content is not modified and
  *      put them back in the pool.
+ *
+ * Handler tests: the basic tests are done on pools using the stack
+ * and bucket handlers.
+ *
+ * Cache resizing tests: the cache of a core only getting objects
+ * grows, and is shrunk when its bounds change.
  */
 
 #define N 65536
@@ -427,6 +434,217 @@ test_mempool_same_name_twice_creation(void)
 	return 0;
 }
 
+/*
+ * Check that the cache of the master lcore is resized within its bounds.
+ */
+static int
+test_mempool_cache_adapt(void)
+{
+	struct rte_mempool *mp_adapt;
+	struct rte_mempool_cache_stats stats;
+	unsigned lcore_id = rte_lcore_id();
+	void **objtable;
+	unsigned i, n;
+	int ret = -1;
+
+	mp_adapt = rte_mempool_lookup("test_cache_adapt");
+	if (mp_adapt == NULL)
+		mp_adapt = rte_mempool_create("test_cache_adapt", MEMPOOL_SIZE,
+					      MEMPOOL_ELT_SIZE, 32, 0,
+					      NULL, NULL,
+					      my_obj_init, NULL,
+					      SOCKET_ID_ANY, 0);
+	if (mp_adapt == NULL)
+		return -1;
+
+	if (rte_mempool_cache_set_bounds(mp_adapt, 0, 32) != -EINVAL ||
+	    rte_mempool_cache_set_bounds(mp_adapt, 64, 32) != -EINVAL ||
+	    rte_mempool_cache_set_bounds(mp_adapt, 8,
+			RTE_MEMPOOL_CACHE_MAX_SIZE + 1) != -EINVAL) {
+		printf("invalid cache bounds accepted\n");
+		return -1;
+	}
+	if (rte_mempool_cache_stats_get(mp_adapt, RTE_MAX_LCORE,
+			&stats) != -EINVAL) {
+		printf("stats of an invalid lcore returned\n");
+		return -1;
+	}
+	if (rte_mempool_cache_set_bounds(mp_adapt, 8,
+			RTE_MEMPOOL_CACHE_MAX_SIZE) < 0)
+		return -1;
+
+	objtable = malloc(MEMPOOL_SIZE * sizeof(void *));
+	if (objtable == NULL)
+		goto out;
+
+	/* only get objects: the cache keeps refilling and must grow */
+	for (n = 0; n + 32 <= MEMPOOL_SIZE / 2; n += 32) {
+		if (rte_mempool_get_bulk(mp_adapt, &objtable[n], 32) < 0) {
+			printf("cannot get objects\n");
+			goto out;
+		}
+	}
+	if (rte_mempool_cache_stats_get(mp_adapt, lcore_id, &stats) < 0)
+		goto out;
+	printf("cache after gets: size=%u len=%u refills=%"PRIu64
+	       " flushes=%"PRIu64"\n",
+	       stats.size, stats.len, stats.refills, stats.flushes);
+	if (stats.size <= 32 || stats.refills == 0) {
+		printf("cache did not grow\n");
+		goto out;
+	}
+	rte_mempool_dump(stdout, mp_adapt);
+
+	/*
+	 * reduce the bounds: a get bigger than the cache shrinks it, the
+	 * objects above its new size must go back to the common pool
+	 */
+	if (rte_mempool_cache_set_bounds(mp_adapt, 8, 16) < 0)
+		goto out;
+	if (rte_mempool_get_bulk(mp_adapt, &objtable[n], stats.size) < 0) {
+		printf("cannot get objects\n");
+		goto out;
+	}
+	n += stats.size;
+	if (rte_mempool_cache_stats_get(mp_adapt, lcore_id, &stats) < 0)
+		goto out;
+	printf("cache after a big get: size=%u len=%u refills=%"PRIu64
+	       " flushes=%"PRIu64"\n",
+	       stats.size, stats.len, stats.refills, stats.flushes);
+	if (stats.size > 16 || stats.len > stats.size) {
+		printf("cache was not shrunk by a get\n");
+		goto out;
+	}
+	rte_mempool_audit(mp_adapt);
+
+	/* the cache is shrunk at its next flush */
+	for (i = 0; i < n; i += 32)
+		rte_mempool_put_bulk(mp_adapt, &objtable[i],
+				     RTE_MIN(32U, n - i));
+	n = 0;
+	if (rte_mempool_cache_stats_get(mp_adapt, lcore_id, &stats) < 0)
+		goto out;
+	printf("cache after puts: size=%u len=%u refills=%"PRIu64
+	       " flushes=%"PRIu64"\n",
+	       stats.size, stats.len, stats.refills, stats.flushes);
+	if (stats.size > 16 || stats.len > 16 + 16 / 2 || stats.flushes == 0) {
+		printf("cache was not shrunk\n");
+		goto out;
+	}
+
+	if (rte_mempool_count(mp_adapt) != MEMPOOL_SIZE) {
+		printf("objects were lost\n");
+		goto out;
+	}
+	ret = 0;
+
+out:
+	if (objtable != NULL) {
+		for (i = 0; i < n; i++)
+			rte_mempool_put(mp_adapt, objtable[i]);
+		free(objtable);
+	}
+	rte_mempool_cache_set_bounds(mp_adapt, 32, 32);
+	return ret;
+}
+
+/*
+ * Basic tests on pools using other handlers than the default ring.
+ */
+static int
+test_mempool_handlers(void)
+{
+	static const char * const handlers[] = { "stack", "bucket" };
+	char name[RTE_MEMPOOL_NAMESIZE];
+	struct rte_mempool *mp_ops;
+	unsigned i;
+
+	/* an unknown handler is refused */
+	mp_ops = rte_mempool_create_with_ops("test_unknown_ops", MEMPOOL_SIZE,
+					     MEMPOOL_ELT_SIZE, 0, 0,
+					     NULL, NULL,
+					     NULL, NULL,
+					     SOCKET_ID_ANY, 0, "unknown");
+	if (mp_ops != NULL || rte_errno != ENOENT) {
+		printf("mempool created with an unknown handler\n");
+		return -1;
+	}
+
+	for (i = 0; i < RTE_DIM(handlers); i++) {
+		snprintf(name, sizeof(name), "test_%s", handlers[i]);
+		mp_ops = rte_mempool_lookup(name);
+		if (mp_ops == NULL)
+			mp_ops = rte_mempool_create_with_ops(name, MEMPOOL_SIZE,
+						MEMPOOL_ELT_SIZE,
+						RTE_MEMPOOL_CACHE_MAX_SIZE, 0,
+						NULL, NULL,
+						my_obj_init, NULL,
+						SOCKET_ID_ANY, 0, handlers[i]);
+		if (mp_ops == NULL) {
+			printf("cannot create mempool with handler %s\n",
+			       handlers[i]);
+			return -1;
+		}
+		if (strcmp(rte_mempool_ops_get(mp_ops->ops_index)->name,
+			   handlers[i]) != 0) {
+			printf("bad handler for mempool %s\n", name);
+			return -1;
+		}
+
+		mp = mp_ops;
+		if (test_mempool_basic() < 0)
+			return -1;
+
+		if (test_mempool_basic_ex(mp_ops) < 0)
+			return -1;
+
+		rte_mempool_free(mp_ops);
+		if (rte_mempool_lookup(name) != NULL) {
+			printf("freed mempool %s still found\n", name);
+			return -1;
+		}
+	}
+
+	return 0;
+}
+
+/*
+ * Free a mempool with the default ring handler: the mempool, its ring
+ * and their memzones must be gone, and the name can be used again.
+ */
+static int
+test_mempool_free(void)
+{
+	struct rte_mempool *mp_free;
+	unsigned i;
+
+	for (i = 0; i < 2; i++) {
+		mp_free = rte_mempool_create("test_free", MEMPOOL_SIZE,
+					     MEMPOOL_ELT_SIZE,
+					     RTE_MEMPOOL_CACHE_MAX_SIZE, 0,
+					     NULL, NULL,
+					     my_obj_init, NULL,
+					     SOCKET_ID_ANY, 0);
+		if (mp_free == NULL) {
+			printf("cannot create mempool to free\n");
+			return -1;
+		}
+
+		rte_mempool_free(mp_free);
+		if (rte_mempool_lookup("test_free") != NULL ||
+				rte_ring_lookup("MP_test_free") != NULL ||
+				rte_memzone_lookup("MP_test_free") != NULL) {
+			printf("freed mempool still found\n");
+			return -1;
+		}
+	}
+
+	/* freeing NULL does nothing */
+	rte_mempool_free(NULL);
+
+	return 0;
+}
+
 /*
  * BAsic test for mempool_xmem functions.
  */
@@ -516,6 +734,15 @@ test_mempool(void)
 	if (test_mempool_xmem_misc() < 0)
 		return -1;
 
+	if (test_mempool_handlers() < 0)
+		return -1;
+
+	if (test_mempool_cache_adapt() < 0)
+		return -1;
+
+	if (test_mempool_free() < 0)
+		return -1;
+
 	rte_mempool_list_dump(stdout);
 
 	return 0;
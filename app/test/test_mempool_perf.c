@@ -88,6 +88,13 @@
  *
  *      - 32
  *      - 128
+ *
+ *    The mempool handlers ("ring_mp_mc", "stack" and "bucket") are then
+ *    compared on pools without cache, on one core and on all cores,
+ *    with bulks of 32 objects. In this test, the first cache line of
+ *    each object is written once it is allocated, so that the rate
+ *    includes the cache misses caused by the order in which the
+ *    handler returns the objects.
  */
 
 #define N 65536
@@ -108,6 +115,9 @@ static unsigned n_put_bulk;
 /* number of objects retrived from mempool before putting them back */
 static unsigned n_keep;
 
+/* write to the objects once they are retrieved */
+static int touch_objs;
+
 /* number of enqueues / dequeues */
 struct mempool_test_stats {
 	unsigned enq_count;
@@ -161,13 +171,18 @@ per_lcore_mempool_test(__attribute__((unused)) void *arg)
 							   n_get_bulk);
 				if (unlikely(ret < 0)) {
 					rte_mempool_dump(stdout, mp);
-					rte_ring_dump(stdout, mp->ring);
 					/* in this case, objects are lost... */
 					return -1;
 				}
 				idx += n_get_bulk;
 			}
 
+			/* use the objects */
+			if (touch_objs) {
+				for (idx = 0; idx < n_keep; idx++)
+					((uint32_t *)obj_table[idx])[1] = idx;
+			}
+
 			/* put the objects back */
 			idx = 0;
 			while (idx < n_keep) {
@@ -198,8 +213,9 @@ launch_cores(unsigned cores)
 	/* reset stats */
 	memset(stats, 0, sizeof(stats));
 
-	printf("mempool_autotest cache=%u cores=%u n_get_bulk=%u "
+	printf("mempool_autotest ops=%s cache=%u cores=%u n_get_bulk=%u "
 	       "n_put_bulk=%u n_keep=%u ",
+	       rte_mempool_ops_get(mp->ops_index)->name,
 	       (unsigned) mp->cache_size, cores, n_get_bulk, n_put_bulk, n_keep);
 
 	if (rte_mempool_count(mp) != MEMPOOL_SIZE) {
@@ -272,9 +288,36 @@ do_one_mempool_test(unsigned cores)
 	return 0;
 }
 
+/* for a given number of core, compare the handlers using the objects */
+static int
+do_one_handler_test(unsigned cores)
+{
+	unsigned keep_tab[] = { 32, 128, 0 };
+	unsigned *keep_ptr;
+	int ret = 0;
+
+	n_get_bulk = 32;
+	n_put_bulk = 32;
+	touch_objs = 1;
+	for (keep_ptr = keep_tab; *keep_ptr; keep_ptr++) {
+		n_keep = *keep_ptr;
+		ret = launch_cores(cores);
+		if (ret < 0)
+			break;
+	}
+	touch_objs = 0;
+
+	return ret;
+}
+
 static int
 test_mempool_perf(void)
 {
+	static const char * const handlers[] = { "ring_mp_mc", "stack", "bucket" };
+	static struct rte_mempool *mp_ops[RTE_DIM(handlers)];
+	char name[RTE_MEMPOOL_NAMESIZE];
+	unsigned i;
+
 	rte_atomic32_init(&synchro);
 
 	/* create a mempool (without cache) */
@@ -324,6 +367,28 @@ test_mempool_perf(void)
 	if (do_one_mempool_test(rte_lcore_count()) < 0)
 		return -1;
 
+	/* compare the handlers, with 1 and max cores */
+	printf("start performance test (mempool handlers)\n");
+	for (i = 0; i < RTE_DIM(handlers); i++) {
+		snprintf(name, sizeof(name), "perf_test_%s", handlers[i]);
+		if (mp_ops[i] == NULL)
+			mp_ops[i] = rte_mempool_create_with_ops(name,
+					MEMPOOL_SIZE, MEMPOOL_ELT_SIZE, 0, 0,
+					NULL, NULL,
+					my_obj_init, NULL,
+					SOCKET_ID_ANY, 0, handlers[i]);
+		if (mp_ops[i] == NULL)
+			return -1;
+
+		mp = mp_ops[i];
+
+		if (do_one_handler_test(1) < 0)
+			return -1;
+
+		if (do_one_handler_test(rte_lcore_count()) < 0)
+			return -1;
+	}
+
 	rte_mempool_list_dump(stdout);
 
 	return 0;
@@ -34,6 +34,8 @@
 #include <stdio.h>
 #include <stdint.h>
 #include <inttypes.h>
+#include <string.h>
+#include <errno.h>
 #include <sys/queue.h>
 
 #include <rte_random.h>
@@ -71,6 +73,10 @@
  *   same name as an existing zone.
  *
  * - Check flags for specific huge page size reservation
+ *
+ * - Check that the memory of a freed zone is reserved again, that its
+ *   name can be reused, and that freeing all zones gives back all of their
+ *   memory, also when more than RTE_MAX_MEMZONE zones are reserved.
  */
 
 /* Test if memory overlaps: return 1 if true, or 0 if false. */
@@ -408,14 +414,14 @@ test_memzone_reserve_max(void)
 		/* cycle through all memzones */
 		for (memzone_idx = 0; memzone_idx < RTE_MAX_MEMZONE; memzone_idx++) {
 
-			/* stop when reaching last allocated memzone */
-			if (config->mem_config->memzone[memzone_idx].addr == NULL)
-				break;
+			/* skip the unused entries */
+			if (config->mem_config->memzone[memzone_idx].mz.addr == NULL)
+				continue;
 
 			/* check if the memzone is in our memseg and subtract length */
-			if ((config->mem_config->memzone[memzone_idx].addr >=
+			if ((config->mem_config->memzone[memzone_idx].mz.addr >=
 			     ms[memseg_idx].addr) &&
-			    (config->mem_config->memzone[memzone_idx].addr <
+			    (config->mem_config->memzone[memzone_idx].mz.addr <
 			     (RTE_PTR_ADD(ms[memseg_idx].addr, ms[memseg_idx].len)))) {
 				/* since the zones can now be aligned and occasionally skip
 				 * some space, we should calculate the length based on
@@ -424,11 +430,11 @@ test_memzone_reserve_max(void)
 				 * them being in the right order.
 				 */
 				len -= RTE_PTR_DIFF(
-						    config->mem_config->memzone[memzone_idx].addr,
+						    config->mem_config->memzone[memzone_idx].mz.addr,
 						    last_addr);
-				len -= config->mem_config->memzone[memzone_idx].len;
-				last_addr = RTE_PTR_ADD(config->mem_config->memzone[memzone_idx].addr,
-							(size_t) config->mem_config->memzone[memzone_idx].len);
+				len -= config->mem_config->memzone[memzone_idx].mz.len;
+				last_addr = RTE_PTR_ADD(config->mem_config->memzone[memzone_idx].mz.addr,
+							(size_t) config->mem_config->memzone[memzone_idx].mz.len);
 			}
 		}
 
@@ -501,26 +507,26 @@ test_memzone_reserve_max_aligned(void)
 		/* cycle through all memzones */
 		for (memzone_idx = 0; memzone_idx < RTE_MAX_MEMZONE; memzone_idx++) {
 
-			/* stop when reaching last allocated memzone */
-			if (config->mem_config->memzone[memzone_idx].addr == NULL)
-				break;
+			/* skip the unused entries */
+			if (config->mem_config->memzone[memzone_idx].mz.addr == NULL)
+				continue;
 
 			/* check if the memzone is in our memseg and subtract length */
-			if ((config->mem_config->memzone[memzone_idx].addr >=
+			if ((config->mem_config->memzone[memzone_idx].mz.addr >=
 					ms[memseg_idx].addr) &&
-					(config->mem_config->memzone[memzone_idx].addr <
+					(config->mem_config->memzone[memzone_idx].mz.addr <
 					(RTE_PTR_ADD(ms[memseg_idx].addr, ms[memseg_idx].len)))) {
 				/* since the zones can now be aligned and occasionally skip
 				 * some space, we should calculate the length based on
 				 * reported length and start addresses difference.
 				 */
 				len -= (uintptr_t) RTE_PTR_SUB(
-						config->mem_config->memzone[memzone_idx].addr,
+						config->mem_config->memzone[memzone_idx].mz.addr,
 						(uintptr_t) last_addr);
-				len -= config->mem_config->memzone[memzone_idx].len;
+				len -= config->mem_config->memzone[memzone_idx].mz.len;
 				last_addr =
-						RTE_PTR_ADD(config->mem_config->memzone[memzone_idx].addr,
-						(size_t) config->mem_config->memzone[memzone_idx].len);
+						RTE_PTR_ADD(config->mem_config->memzone[memzone_idx].mz.addr,
+						(size_t) config->mem_config->memzone[memzone_idx].mz.len);
 			}
 		}
 
@@ -801,6 +807,11 @@ test_memzone_reserve_memory_in_smallest_segment(void)
 			prev_min_ms = ms;
 	}
 
+	/* one segment per socket with --single-file-segments */
+	if (min_ms != NULL && prev_min_ms == NULL) {
+		printf("Only one memory segment, skipping\n");
+		return 0;
+	}
 	if (min_ms == NULL || prev_min_ms == NULL) {
 		printf("Smallest segments not found!\n");
 		return -1;
@@ -881,6 +892,11 @@ test_memzone_reserve_memory_with_smallest_offset(void)
 		}
 	}
 
+	/* one segment per socket with --single-file-segments */
+	if (min_ms != NULL && prev_min_ms == NULL) {
+		printf("Only one memory segment, skipping\n");
+		return 0;
+	}
 	if (min_ms == NULL || prev_min_ms == NULL) {
 		printf("Smallest segments not found!\n");
 		return -1;
@@ -976,7 +992,7 @@ test_memzone_reserve_remainder(void)
 	const struct rte_memseg *ms, *min_ms = NULL;
 	size_t min_len;
 	const struct rte_config *config;
-	int i, align;
+	int i, align, nb_segs = 0;
 
 	min_len = 0;
 	align = RTE_CACHE_LINE_SIZE;
@@ -991,6 +1007,7 @@ test_memzone_reserve_remainder(void)
 			break;
 		if (ms->len == 0)
 			continue;
+		nb_segs++;
 
 		if (min_len == 0 || ms->len < min_len) {
 			min_len = ms->len;
@@ -1009,6 +1026,12 @@ test_memzone_reserve_remainder(void)
 		return -1;
 	}
 
+	/* the first reservation must be taken from another segment */
+	if (nb_segs < 2) {
+		printf("Only one free memory segment, skipping\n");
+		return 0;
+	}
+
 	/* try reserving min_len bytes with alignment - this should not affect our
 	 * memseg, the memory will be taken from a different one.
 	 */
@@ -1041,6 +1064,132 @@ test_memzone_reserve_remainder(void)
 	return 0;
 }
 
+/* total length of the free memory segments */
+static size_t
+get_free_memseg_len(void)
+{
+	const struct rte_config *config;
+	size_t len = 0;
+	int i;
+
+	config = rte_eal_get_configuration();
+
+	for (i = 0; i < RTE_MAX_MEMSEG; i++) {
+		if (config->mem_config->free_memseg[i].addr == NULL)
+			break;
+		len += config->mem_config->free_memseg[i].len;
+	}
+
+	return len;
+}
+
+static const struct rte_memzone *grow_mz[RTE_MAX_MEMZONE];
+
+static int
+test_memzone_free(void)
+{
+	const struct rte_mem_config *mcfg;
+	const struct rte_memzone *mz[3];
+	struct rte_memzone fake_mz;
+	char name[RTE_MEMZONE_NAMESIZE];
+	size_t free_len, tbl_len;
+	uint32_t nb_tbl;
+	void *addr;
+	unsigned i;
+
+	mcfg = rte_eal_get_configuration()->mem_config;
+	free_len = get_free_memseg_len();
+
+	mz[0] = rte_memzone_reserve("tzone_free_0", 2000, SOCKET_ID_ANY, 0);
+	mz[1] = rte_memzone_reserve("tzone_free_1", 4000, SOCKET_ID_ANY, 0);
+	mz[2] = rte_memzone_reserve("tzone_free_2", 2000, SOCKET_ID_ANY, 0);
+	if (mz[0] == NULL || mz[1] == NULL || mz[2] == NULL) {
+		printf("Fail memzone reserve\n");
+		return -1;
+	}
+
+	/* free the zone in the middle and reserve it again */
+	addr = mz[1]->addr;
+	if (rte_memzone_free(mz[1]) != 0) {
+		printf("Fail memzone free\n");
+		return -1;
+	}
+	if (rte_memzone_lookup("tzone_free_1") != NULL) {
+		printf("Freed memzone still found\n");
+		return -1;
+	}
+	if (rte_memzone_free(mz[1]) != -EINVAL) {
+		printf("Memzone freed twice\n");
+		return -1;
+	}
+	mz[1] = rte_memzone_reserve("tzone_free_1", 4000, SOCKET_ID_ANY, 0);
+	if (mz[1] == NULL || mz[1]->addr != addr) {
+		printf("Memory of the freed memzone not reused\n");
+		return -1;
+	}
+
+	/* invalid descriptors */
+	memset(&fake_mz, 0, sizeof(fake_mz));
+	if (rte_memzone_free(NULL) != -EINVAL ||
+			rte_memzone_free(&fake_mz) != -EINVAL) {
+		printf("Invalid memzone freed\n");
+		return -1;
+	}
+
+	for (i = 0; i < RTE_DIM(mz); i++) {
+		if (rte_memzone_free(mz[i]) != 0) {
+			printf("Fail memzone free\n");
+			return -1;
+		}
+	}
+	if (get_free_memseg_len() != free_len) {
+		printf("Memory of the freed memzones not given back\n");
+		rte_memzone_dump(stdout);
+		return -1;
+	}
+
+	/* reserve more zones than the first table of descriptors can hold */
+	nb_tbl = mcfg->memzone_nb_tbl;
+	for (i = 0; i < RTE_DIM(grow_mz); i++) {
+		snprintf(name, sizeof(name), "tzone_grow_%u", i);
+		grow_mz[i] = rte_memzone_reserve(name, RTE_CACHE_LINE_SIZE,
+				SOCKET_ID_ANY, 0);
+		if (grow_mz[i] == NULL) {
+			printf("Fail memzone reserve %u\n", i);
+			return -1;
+		}
+	}
+	if (mcfg->memzone_nb_tbl == 1) {
+		printf("Memzone registry did not grow\n");
+		return -1;
+	}
+	for (i = 0; i < RTE_DIM(grow_mz); i++) {
+		snprintf(name, sizeof(name), "tzone_grow_%u", i);
+		if (rte_memzone_lookup(name) != grow_mz[i]) {
+			printf("Fail memzone lookup %u\n", i);
+			return -1;
+		}
+	}
+	for (i = 0; i < RTE_DIM(grow_mz); i++) {
+		if (rte_memzone_free(grow_mz[i]) != 0) {
+			printf("Fail memzone free %u\n", i);
+			return -1;
+		}
+	}
+
+	/* only the new tables of descriptors are kept */
+	tbl_len = RTE_ALIGN_CEIL(sizeof(struct rte_memzone_entry) *
+		RTE_MAX_MEMZONE, RTE_CACHE_LINE_SIZE);
+	if (get_free_memseg_len() !=
+			free_len - (mcfg->memzone_nb_tbl - nb_tbl) * tbl_len) {
+		printf("Memory of the freed memzones not given back\n");
+		rte_memzone_dump(stdout);
+		return -1;
+	}
+
+	return 0;
+}
+
 static int
 test_memzone(void)
 {
@@ -1153,6 +1302,10 @@ test_memzone(void)
 	if (test_memzone_reserve_remainder() < 0)
 		return -1;
 
+	printf("test freeing memzones\n");
+	if (test_memzone_free() < 0)
+		return -1;
+
 	printf("test reserving the largest size memzone possible\n");
 	if (test_memzone_reserve_max() < 0)
 		return -1;
@@ -53,6 +53,7 @@
 #include <rte_branch_prediction.h>
 #include <rte_malloc.h>
 #include <rte_ring.h>
+#include <rte_ring_elem.h>
 #include <rte_random.h>
 #include <rte_common.h>
 #include <rte_errno.h>
@@ -93,6 +94,14 @@
  *    - At the same time, change the watermark on the master lcore.
  *    - The slave lcore will check that watermark changes from 16 to 32.
  *
+ * #. Relaxed tail synchronization
+ *
+ *    - Enqueue and dequeue objects on all lcores, with multi producers
+ *      and multi consumers functions, in a ring created with
+ *      RING_F_MP_RTS_ENQ and RING_F_MC_RTS_DEQ.
+ *    - Check that all objects are dequeued once, and that the heads and
+ *      tails are equal once all lcores are done.
+ *
  * #. Performance tests.
  *
  * Tests done in test_ring_perf.c
@@ -1220,6 +1229,42 @@ test_ring_creation_with_an_used_name(void)
 	return 0;
 }
 
+/*
+ * it tests that a freed ring cannot be found anymore, and that its name
+ * and memory can be used by a new ring
+ */
+static int
+test_ring_free(void)
+{
+	struct rte_ring *rp;
+	void *addr;
+
+	rp = rte_ring_create("test_ring_free", RING_SIZE, SOCKET_ID_ANY, 0);
+	if (rp == NULL) {
+		printf("Cannot create ring to free\n");
+		return -1;
+	}
+	addr = rp;
+
+	rte_ring_free(rp);
+	if (rte_ring_lookup("test_ring_free") != NULL) {
+		printf("Freed ring still found\n");
+		return -1;
+	}
+
+	rp = rte_ring_create("test_ring_free", RING_SIZE, SOCKET_ID_ANY, 0);
+	if (rp == NULL || (void *)rp != addr) {
+		printf("Memory of the freed ring not reused\n");
+		return -1;
+	}
+	rte_ring_free(rp);
+
+	/* freeing NULL does nothing */
+	rte_ring_free(NULL);
+
+	return 0;
+}
+
 /*
  * Test to if a non-power of 2 count causes the create
  * function to fail correctly
@@ -1321,6 +1366,330 @@ fail_test:
 	return ret;
 }
 
+/*
+ * Check the zero-copy dequeue: the reserved objects are in place in the
+ * ring, wrapping around its end, and a partial commit leaves the others at
+ * the head of the ring.
+ */
+static int
+test_ring_peek(const char *name, unsigned flags)
+{
+	struct rte_ring_zc_data zcd;
+	struct rte_ring *rp;
+	void *objs[MAX_BULK];
+	uintptr_t expected = 0;
+	unsigned i, n;
+	int ret = -1;
+
+	rp = rte_ring_create(name, 64, SOCKET_ID_ANY, flags);
+	if (rp == NULL) {
+		printf("test_ring_peek fail to create ring\n");
+		return -1;
+	}
+
+	/* empty ring */
+	if (rte_ring_dequeue_peek_burst(rp, MAX_BULK, &zcd) != 0) {
+		printf("test_ring_peek: reserved objects from an empty ring\n");
+		goto fail_test;
+	}
+	rte_ring_dequeue_commit(rp, 0);
+
+	/* move the head close to the end of the ring */
+	for (i = 0; i < 60; i++) {
+		rte_ring_enqueue(rp, (void *)(uintptr_t)i);
+		rte_ring_dequeue(rp, &objs[0]);
+	}
+
+	for (i = 0; i < MAX_BULK; i++)
+		objs[i] = (void *)(uintptr_t)i;
+	if (rte_ring_enqueue_bulk(rp, objs, MAX_BULK) != 0) {
+		printf("test_ring_peek: enqueue failed\n");
+		goto fail_test;
+	}
+
+	/* inspect the head only */
+	n = rte_ring_dequeue_peek_burst(rp, 1, &zcd);
+	if (n != 1 || zcd.n1 != 1 || zcd.ptr2 != NULL ||
+			zcd.ptr1[0] != (void *)0) {
+		printf("test_ring_peek: wrong head of ring\n");
+		goto fail_test;
+	}
+	rte_ring_dequeue_commit(rp, 0);
+	if (rte_ring_count(rp) != MAX_BULK) {
+		printf("test_ring_peek: peek removed objects\n");
+		goto fail_test;
+	}
+
+	/* reserve all the objects, which wrap around the end of the ring */
+	n = rte_ring_dequeue_peek_burst(rp, 2 * MAX_BULK, &zcd);
+	if (n != MAX_BULK || zcd.n1 != 4 || zcd.ptr2 == NULL) {
+		printf("test_ring_peek: wrong reservation %u/%u\n", n, zcd.n1);
+		goto fail_test;
+	}
+	for (i = 0; i < n; i++) {
+		void *obj = i < zcd.n1 ? zcd.ptr1[i] : zcd.ptr2[i - zcd.n1];
+
+		if (obj != (void *)expected++) {
+			printf("test_ring_peek: wrong object %u\n", i);
+			goto fail_test;
+		}
+	}
+
+	/* another reservation must wait for the commit with multi-consumers */
+	if (!(flags & RING_F_SC_DEQ) &&
+			rte_ring_mc_dequeue_peek_burst(rp, 1, &zcd) != 0) {
+		printf("test_ring_peek: concurrent reservations\n");
+		goto fail_test;
+	}
+
+	/* dequeue half of them */
+	rte_ring_dequeue_commit(rp, MAX_BULK / 2);
+	if (rte_ring_count(rp) != MAX_BULK / 2) {
+		printf("test_ring_peek: wrong count after commit\n");
+		goto fail_test;
+	}
+
+	/* the other half is still there, in order */
+	if (rte_ring_dequeue_bulk(rp, objs, MAX_BULK / 2) != 0) {
+		printf("test_ring_peek: dequeue failed\n");
+		goto fail_test;
+	}
+	for (i = 0; i < MAX_BULK / 2; i++) {
+		if (objs[i] != (void *)(uintptr_t)(MAX_BULK / 2 + i)) {
+			printf("test_ring_peek: wrong object after commit\n");
+			goto fail_test;
+		}
+	}
+	if (rte_ring_empty(rp) != 1) {
+		printf("test_ring_peek: ring is not empty but it should be\n");
+		goto fail_test;
+	}
+
+	ret = 0;
+fail_test:
+	if (ret != 0)
+		rte_ring_dump(stdout, rp);
+	return ret;
+}
+
+#define RTS_TEST_ITERATIONS 100000
+
+static rte_atomic64_t rts_enq_sum;
+static rte_atomic64_t rts_deq_sum;
+
+/* enqueue and dequeue tagged objects from all lcores, summing them */
+static int
+test_ring_rts_loop(void *arg)
+{
+	struct rte_ring *rp = arg;
+	void *objs[MAX_BULK];
+	uint64_t enq_sum = 0, deq_sum = 0;
+	uintptr_t val = (uintptr_t)rte_lcore_id() << 24;
+	unsigned i, j, n;
+
+	for (i = 0; i < RTS_TEST_ITERATIONS; i++) {
+		n = (i % MAX_BULK) + 1;
+		for (j = 0; j < n; j++)
+			objs[j] = (void *)++val;
+		n = rte_ring_mp_enqueue_burst(rp, objs, n);
+		for (j = 0; j < n; j++)
+			enq_sum += (uintptr_t)objs[j];
+
+		n = rte_ring_mc_dequeue_burst(rp, objs, MAX_BULK);
+		for (j = 0; j < n; j++)
+			deq_sum += (uintptr_t)objs[j];
+	}
+
+	rte_atomic64_add(&rts_enq_sum, enq_sum);
+	rte_atomic64_add(&rts_deq_sum, deq_sum);
+	return 0;
+}
+
+/*
+ * Check the relaxed tail synchronization of producers and consumers: all
+ * the objects enqueued concurrently are dequeued once, and the tails
+ * catch up with the heads when no operation is in progress.
+ */
+static int
+test_ring_rts(void)
+{
+	struct rte_ring *rp;
+	void *objs[MAX_BULK];
+	unsigned i, n;
+
+	rp = rte_ring_create("test_ring_rts", 1024, SOCKET_ID_ANY,
+			RING_F_MP_RTS_ENQ | RING_F_MC_RTS_DEQ);
+	if (rp == NULL) {
+		printf("test_ring_rts: fail to create ring\n");
+		return -1;
+	}
+
+	/* objects keep their order with a single lcore */
+	for (i = 0; i < MAX_BULK; i++)
+		objs[i] = (void *)(uintptr_t)i;
+	if (rte_ring_enqueue_bulk(rp, objs, MAX_BULK) != 0 ||
+	    rte_ring_dequeue_bulk(rp, objs, MAX_BULK) != 0)
+		goto fail;
+	for (i = 0; i < MAX_BULK; i++) {
+		if (objs[i] != (void *)(uintptr_t)i) {
+			printf("test_ring_rts: wrong object %u\n", i);
+			goto fail;
+		}
+	}
+
+	rte_atomic64_init(&rts_enq_sum);
+	rte_atomic64_init(&rts_deq_sum);
+	rte_eal_mp_remote_launch(test_ring_rts_loop, rp, CALL_MASTER);
+	rte_eal_mp_wait_lcore();
+
+	/* dequeue what is left */
+	while ((n = rte_ring_mc_dequeue_burst(rp, objs, MAX_BULK)) != 0) {
+		for (i = 0; i < n; i++)
+			rte_atomic64_add(&rts_deq_sum, (uintptr_t)objs[i]);
+	}
+
+	if (rte_atomic64_read(&rts_enq_sum) !=
+			rte_atomic64_read(&rts_deq_sum)) {
+		printf("test_ring_rts: enqueued and dequeued objects differ\n");
+		goto fail;
+	}
+	if (rp->prod.rts_head.raw != rp->prod.rts_tail.raw ||
+	    rp->cons.rts_head.raw != rp->cons.rts_tail.raw ||
+	    rte_ring_empty(rp) != 1) {
+		printf("test_ring_rts: heads and tails differ\n");
+		goto fail;
+	}
+
+	return 0;
+fail:
+	rte_ring_dump(stdout, rp);
+	return -1;
+}
+
+#define ELEM_TEST_MAX_SIZE 20
+#define ELEM_TEST_BULK 23
+
+/* fill the 32-bit words of n elements of esize bytes with a known pattern */
+static void
+test_ring_elem_fill(uint32_t *objs, unsigned esize, unsigned n, uint32_t seq)
+{
+	unsigned i;
+
+	for (i = 0; i < n * esize / sizeof(uint32_t); i++)
+		objs[i] = (seq << 16) + i;
+}
+
+/*
+ * Check a ring of esize bytes elements: bulk, burst and single object
+ * operations keep the content and the order of the elements, including
+ * when they wrap around the end of the ring.
+ */
+static int
+test_ring_elem(const char *name, unsigned esize)
+{
+	uint32_t src[ELEM_TEST_BULK * ELEM_TEST_MAX_SIZE / sizeof(uint32_t)];
+	uint32_t dst[ELEM_TEST_BULK * ELEM_TEST_MAX_SIZE / sizeof(uint32_t)];
+	struct rte_ring *re;
+	unsigned i, n;
+
+	re = rte_ring_create_elem(name, esize, 64, SOCKET_ID_ANY, 0);
+	if (re == NULL) {
+		printf("test_ring_elem: fail to create ring of %u bytes "
+		       "elements\n", esize);
+		return -1;
+	}
+
+	/* bulk operations, alternating single and multi producer/consumer */
+	for (i = 0; i < 8; i++) {
+		test_ring_elem_fill(src, esize, ELEM_TEST_BULK, i);
+		memset(dst, 0, sizeof(dst));
+		if (i & 1) {
+			if (rte_ring_mp_enqueue_bulk_elem(re, src, esize,
+					ELEM_TEST_BULK) != 0 ||
+			    rte_ring_mc_dequeue_bulk_elem(re, dst, esize,
+					ELEM_TEST_BULK) != 0)
+				goto fail;
+		} else {
+			if (rte_ring_sp_enqueue_bulk_elem(re, src, esize,
+					ELEM_TEST_BULK) != 0 ||
+			    rte_ring_sc_dequeue_bulk_elem(re, dst, esize,
+					ELEM_TEST_BULK) != 0)
+				goto fail;
+		}
+		if (memcmp(src, dst, ELEM_TEST_BULK * esize) != 0) {
+			printf("test_ring_elem: wrong elements after bulk "
+			       "dequeue\n");
+			goto fail;
+		}
+	}
+
+	/* fill the ring with bursts, 63 elements fit in it */
+	test_ring_elem_fill(src, esize, ELEM_TEST_BULK, 0x100);
+	n = 0;
+	for (i = 0; i < 3; i++)
+		n += rte_ring_enqueue_burst_elem(re, src, esize,
+				ELEM_TEST_BULK);
+	if (n != 63 || rte_ring_full(re) != 1) {
+		printf("test_ring_elem: wrong burst enqueue count %u\n", n);
+		goto fail;
+	}
+	if (rte_ring_enqueue_elem(re, src, esize) != -ENOBUFS) {
+		printf("test_ring_elem: enqueued in a full ring\n");
+		goto fail;
+	}
+
+	/* the head of the ring is the first element of the first burst */
+	if (rte_ring_dequeue_elem(re, dst, esize) != 0 ||
+	    memcmp(src, dst, esize) != 0) {
+		printf("test_ring_elem: wrong single element dequeued\n");
+		goto fail;
+	}
+	n = rte_ring_dequeue_burst_elem(re, dst, esize, ELEM_TEST_BULK);
+	if (n != ELEM_TEST_BULK ||
+	    memcmp((const uint8_t *)src + esize, dst,
+		   (ELEM_TEST_BULK - 1) * esize) != 0 ||
+	    memcmp(src, (const uint8_t *)dst + (ELEM_TEST_BULK - 1) * esize,
+		   esize) != 0) {
+		printf("test_ring_elem: wrong elements after burst dequeue\n");
+		goto fail;
+	}
+	n = 0;
+	for (i = 0; i < 3; i++)
+		n += rte_ring_dequeue_burst_elem(re, dst, esize,
+				ELEM_TEST_BULK);
+	if (n != 63 - 1 - ELEM_TEST_BULK || rte_ring_empty(re) != 1) {
+		printf("test_ring_elem: wrong burst dequeue count %u\n", n);
+		goto fail;
+	}
+
+	return 0;
+fail:
+	rte_ring_dump(stdout, re);
+	return -1;
+}
+
+static int
+test_ring_elem_sizes(void)
+{
+	static const unsigned esizes[] = { 4, 8, 12, 16, 20 };
+	char name[RTE_RING_NAMESIZE];
+	unsigned i;
+
+	/* the element size must be a multiple of 4 */
+	if (rte_ring_create_elem("test_ring_elem_inval", 6, 64,
+			SOCKET_ID_ANY, 0) != NULL) {
+		printf("test_ring_elem: created a ring of 6 bytes elements\n");
+		return -1;
+	}
+
+	for (i = 0; i < RTE_DIM(esizes); i++) {
+		snprintf(name, sizeof(name), "test_ring_elem_%u", esizes[i]);
+		if (test_ring_elem(name, esizes[i]) < 0)
+			return -1;
+	}
+	return 0;
+}
+
 static int
 test_ring(void)
 {
@@ -1378,6 +1747,21 @@ test_ring(void)
 			else
 				printf ( "Test detected NULL ring lookup \n");
 
+	/* zero-copy dequeue */
+	if (test_ring_peek("test_ring_peek_sc",
+			RING_F_SP_ENQ | RING_F_SC_DEQ) < 0)
+		return -1;
+	if (test_ring_peek("test_ring_peek_mc", 0) < 0)
+		return -1;
+
+	/* relaxed tail synchronization */
+	if (test_ring_rts() < 0)
+		return -1;
+
+	/* rings of elements other than pointers */
+	if (test_ring_elem_sizes() < 0)
+		return -1;
+
 	/* test of creating ring with wrong size */
 	if (test_ring_creation_with_wrong_size() < 0)
 		return -1;
@@ -1386,6 +1770,10 @@ test_ring(void)
 	if (test_ring_creation_with_an_used_name() < 0)
 		return -1;
 
+	/* test of freeing a ring */
+	if (test_ring_free() < 0)
+		return -1;
+
 	/* dump the ring status */
 	rte_ring_list_dump(stdout);
 
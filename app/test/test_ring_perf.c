@@ -35,6 +35,7 @@
 #include <stdio.h>
 #include <inttypes.h>
 #include <rte_ring.h>
+#include <rte_ring_elem.h>
 #include <rte_cycles.h>
 #include <rte_launch.h>
 
@@ -48,11 +49,16 @@
  *  * Empty ring dequeue
  *  * Enqueue/dequeue of bursts in 1 threads
  *  * Enqueue/dequeue of bursts in 2 threads
+ *  * Zero-copy (peek/commit) dequeue against copy dequeue
+ *  * Enqueue/dequeue of bursts of 4 to 32 bytes elements in 1 thread
+ *  * MP/MC enqueue/dequeue on 2 or more threads, with the default and the
+ *    relaxed tail synchronization
  */
 
 #define RING_NAME "RING_PERF"
 #define RING_SIZE 4096
 #define MAX_BURST 32
+#define MAX_ELEM_SIZE 32
 
 /*
  * the sizes to enqueue and dequeue in testing
@@ -245,13 +251,72 @@ dequeue_bulk(void *p)
 	return 0;
 }
 
+/* Read the objects reserved by a zero-copy dequeue, as a pipeline stage would */
+static inline uintptr_t
+read_peeked_objs(const struct rte_ring_zc_data *zcd, unsigned n)
+{
+	uintptr_t sum = 0;
+	unsigned i;
+
+	if (n == 0)
+		return 0;
+	for (i = 0; i < zcd->n1; i++)
+		sum += (uintptr_t)zcd->ptr1[i];
+	for (; i < n; i++)
+		sum += (uintptr_t)zcd->ptr2[i - zcd->n1];
+	return sum;
+}
+
+/*
+ * Function that uses rdtsc to measure timing for zero-copy ring dequeue.
+ * Needs pair thread running enqueue_bulk function
+ */
+static int
+dequeue_peek(void *p)
+{
+	const unsigned iter_shift = 23;
+	const unsigned iterations = 1<<iter_shift;
+	struct thread_params *params = p;
+	const unsigned size = params->size;
+	struct rte_ring_zc_data zcd = { NULL, NULL, 0 };
+	volatile uintptr_t sink;
+	uintptr_t sum = 0;
+	unsigned i, n;
+
+	if ( __sync_add_and_fetch(&lcore_count, 1) != 2 )
+		while(lcore_count != 2)
+			rte_pause();
+
+	const uint64_t sc_start = rte_rdtsc();
+	for (i = 0; i < iterations * size; i += n) {
+		n = rte_ring_sc_dequeue_peek_burst(r, size, &zcd);
+		sum += read_peeked_objs(&zcd, n);
+		rte_ring_dequeue_commit(r, n);
+	}
+	const uint64_t sc_end = rte_rdtsc();
+
+	const uint64_t mc_start = rte_rdtsc();
+	for (i = 0; i < iterations * size; i += n) {
+		n = rte_ring_mc_dequeue_peek_burst(r, size, &zcd);
+		sum += read_peeked_objs(&zcd, n);
+		rte_ring_dequeue_commit(r, n);
+	}
+	const uint64_t mc_end = rte_rdtsc();
+
+	sink = sum;
+	RTE_SET_USED(sink);
+	params->spsc = ((double)(sc_end - sc_start))/(iterations*size);
+	params->mpmc = ((double)(mc_end - mc_start))/(iterations*size);
+	return 0;
+}
+
 /*
  * Function that calls the enqueue and dequeue bulk functions on pairs of cores.
  * used to measure ring perf between hyperthreads, cores and sockets.
  */
 static void
 run_on_core_pair(struct lcore_pair *cores,
-		lcore_function_t f1, lcore_function_t f2)
+		lcore_function_t f1, lcore_function_t f2, const char *mode)
 {
 	struct thread_params param1 = {0}, param2 = {0};
 	unsigned i;
@@ -268,10 +333,10 @@ run_on_core_pair(struct lcore_pair *cores,
 			rte_eal_wait_lcore(cores->c1);
 			rte_eal_wait_lcore(cores->c2);
 		}
-		printf("SP/SC bulk enq/dequeue (size: %u): %.2F\n", bulk_sizes[i],
-				param1.spsc + param2.spsc);
-		printf("MP/MC bulk enq/dequeue (size: %u): %.2F\n", bulk_sizes[i],
-				param1.mpmc + param2.mpmc);
+		printf("SP/SC %s enq/dequeue (size: %u): %.2F\n", mode,
+				bulk_sizes[i], param1.spsc + param2.spsc);
+		printf("MP/MC %s enq/dequeue (size: %u): %.2F\n", mode,
+				bulk_sizes[i], param1.mpmc + param2.mpmc);
 	}
 }
 
@@ -381,6 +446,218 @@ test_bulk_enqueue_dequeue(void)
 	}
 }
 
+#define MT_ITERATIONS (1 << 16)
+
+static volatile unsigned mt_nb_lcores;
+static uint64_t mt_cycles[RTE_MAX_LCORE];
+
+/*
+ * Function that enqueues and dequeues bursts on the ring given as
+ * parameter, concurrently with the other lcores of the test.
+ */
+static int
+enqueue_dequeue_mt(void *p)
+{
+	const unsigned size = bulk_sizes[0];
+	struct rte_ring *rm = p;
+	void *burst[MAX_BURST] = {0};
+	unsigned i;
+
+	if (__sync_add_and_fetch(&lcore_count, 1) != mt_nb_lcores)
+		while (lcore_count != mt_nb_lcores)
+			rte_pause();
+
+	const uint64_t start = rte_rdtsc();
+	for (i = 0; i < MT_ITERATIONS; i++) {
+		while (rte_ring_mp_enqueue_bulk(rm, burst, size) != 0)
+			rte_pause();
+		while (rte_ring_mc_dequeue_bulk(rm, burst, size) != 0)
+			rte_pause();
+	}
+	const uint64_t end = rte_rdtsc();
+
+	mt_cycles[rte_lcore_id()] = end - start;
+	return 0;
+}
+
+/*
+ * Runs enqueue_dequeue_mt on the master lcore and nb_lcores-1 slaves, and
+ * returns the average number of cycles per object.
+ */
+static double
+run_on_n_cores(struct rte_ring *rm, unsigned nb_lcores)
+{
+	unsigned lcore_id, n = 1;
+	uint64_t cycles;
+
+	lcore_count = 0;
+	mt_nb_lcores = nb_lcores;
+	RTE_LCORE_FOREACH_SLAVE(lcore_id) {
+		if (n++ == nb_lcores)
+			break;
+		rte_eal_remote_launch(enqueue_dequeue_mt, rm, lcore_id);
+	}
+	enqueue_dequeue_mt(rm);
+	rte_eal_mp_wait_lcore();
+
+	cycles = mt_cycles[rte_get_master_lcore()];
+	n = 1;
+	RTE_LCORE_FOREACH_SLAVE(lcore_id) {
+		if (n++ == nb_lcores)
+			break;
+		cycles += mt_cycles[lcore_id];
+	}
+	return (double)cycles / ((double)nb_lcores * MT_ITERATIONS *
+			bulk_sizes[0]);
+}
+
+/*
+ * Compares the default and the relaxed tail synchronization of multiple
+ * producers and consumers, with 2, 4, 8... lcores using the same ring.
+ */
+static void
+test_mt_enqueue_dequeue(void)
+{
+	struct rte_ring *rts;
+	unsigned nb_lcores;
+
+	rts = rte_ring_create(RING_NAME "_RTS", RING_SIZE, rte_socket_id(),
+			RING_F_MP_RTS_ENQ | RING_F_MC_RTS_DEQ);
+	if (rts == NULL && (rts = rte_ring_lookup(RING_NAME "_RTS")) == NULL) {
+		printf("Cannot create ring with relaxed tail sync\n");
+		return;
+	}
+
+	for (nb_lcores = 2; nb_lcores <= rte_lcore_count(); nb_lcores *= 2) {
+		printf("MP/MC bulk enq/dequeue (lcores: %u, size: %u): %.2F\n",
+				nb_lcores, bulk_sizes[0],
+				run_on_n_cores(r, nb_lcores));
+		printf("MP/MC RTS bulk enq/dequeue (lcores: %u, size: %u): "
+				"%.2F\n", nb_lcores, bulk_sizes[0],
+				run_on_n_cores(rts, nb_lcores));
+	}
+}
+
+/*
+ * Times bulk enqueue and dequeue on a single lcore, for a ring of esize
+ * bytes elements. Always inlined so that esize is a constant in the copies.
+ */
+static inline void __attribute__((always_inline))
+test_bulk_enqueue_dequeue_esize(const unsigned esize)
+{
+	const unsigned iter_shift = 23;
+	const unsigned iterations = 1<<iter_shift;
+	char name[RTE_RING_NAMESIZE];
+	uint8_t burst[MAX_BURST * MAX_ELEM_SIZE] = {0};
+	struct rte_ring *re;
+	unsigned sz, i = 0;
+
+	snprintf(name, sizeof(name), "%s_E%u", RING_NAME, esize);
+	re = rte_ring_create_elem(name, esize, RING_SIZE, rte_socket_id(), 0);
+	if (re == NULL && (re = rte_ring_lookup(name)) == NULL) {
+		printf("Cannot create ring of %u bytes elements\n", esize);
+		return;
+	}
+
+	for (sz = 0; sz < sizeof(bulk_sizes)/sizeof(bulk_sizes[0]); sz++) {
+		const uint64_t sc_start = rte_rdtsc();
+		for (i = 0; i < iterations; i++) {
+			rte_ring_sp_enqueue_bulk_elem(re, burst, esize,
+					bulk_sizes[sz]);
+			rte_ring_sc_dequeue_bulk_elem(re, burst, esize,
+					bulk_sizes[sz]);
+		}
+		const uint64_t sc_end = rte_rdtsc();
+
+		const uint64_t mc_start = rte_rdtsc();
+		for (i = 0; i < iterations; i++) {
+			rte_ring_mp_enqueue_bulk_elem(re, burst, esize,
+					bulk_sizes[sz]);
+			rte_ring_mc_dequeue_bulk_elem(re, burst, esize,
+					bulk_sizes[sz]);
+		}
+		const uint64_t mc_end = rte_rdtsc();
+
+		double sc_avg = ((double)(sc_end-sc_start) /
+				(iterations * bulk_sizes[sz]));
+		double mc_avg = ((double)(mc_end-mc_start) /
+				(iterations * bulk_sizes[sz]));
+
+		printf("SP/SC bulk enq/dequeue (esize: %u, size: %u): %.2F\n",
+				esize, bulk_sizes[sz], sc_avg);
+		printf("MP/MC bulk enq/dequeue (esize: %u, size: %u): %.2F\n",
+				esize, bulk_sizes[sz], mc_avg);
+	}
+}
+
+static void
+test_bulk_enqueue_dequeue_elem(void)
+{
+	test_bulk_enqueue_dequeue_esize(4);
+	test_bulk_enqueue_dequeue_esize(8);
+	test_bulk_enqueue_dequeue_esize(12);
+	test_bulk_enqueue_dequeue_esize(16);
+	test_bulk_enqueue_dequeue_esize(32);
+}
+
+/*
+ * Times enqueue and dequeue on a single lcore, with the dequeued objects
+ * either copied out of the ring and then read, or read in place.
+ */
+static void
+test_peek_enqueue_dequeue(void)
+{
+	const unsigned iter_shift = 23;
+	const unsigned iterations = 1<<iter_shift;
+	unsigned sz, i, j, n;
+	void *burst[MAX_BURST] = {0};
+	void *objs[MAX_BURST];
+	struct rte_ring_zc_data zcd = { NULL, NULL, 0 };
+	volatile uintptr_t sink;
+	uintptr_t sum = 0;
+
+	for (sz = 0; sz < sizeof(bulk_sizes)/sizeof(bulk_sizes[0]); sz++) {
+		const unsigned size = bulk_sizes[sz];
+
+		const uint64_t copy_start = rte_rdtsc();
+		for (i = 0; i < iterations; i++) {
+			rte_ring_sp_enqueue_bulk(r, burst, size);
+			n = rte_ring_sc_dequeue_burst(r, objs, size);
+			for (j = 0; j < n; j++)
+				sum += (uintptr_t)objs[j];
+		}
+		const uint64_t copy_end = rte_rdtsc();
+
+		const uint64_t sc_start = rte_rdtsc();
+		for (i = 0; i < iterations; i++) {
+			rte_ring_sp_enqueue_bulk(r, burst, size);
+			n = rte_ring_sc_dequeue_peek_burst(r, size, &zcd);
+			sum += read_peeked_objs(&zcd, n);
+			rte_ring_dequeue_commit(r, n);
+		}
+		const uint64_t sc_end = rte_rdtsc();
+
+		const uint64_t mc_start = rte_rdtsc();
+		for (i = 0; i < iterations; i++) {
+			rte_ring_mp_enqueue_bulk(r, burst, size);
+			n = rte_ring_mc_dequeue_peek_burst(r, size, &zcd);
+			sum += read_peeked_objs(&zcd, n);
+			rte_ring_dequeue_commit(r, n);
+		}
+		const uint64_t mc_end = rte_rdtsc();
+
+		printf("SP/SC copy enq/dequeue (size: %u): %.2F\n", size,
+				(double)(copy_end - copy_start) / (iterations * size));
+		printf("SP/SC peek enq/dequeue (size: %u): %.2F\n", size,
+				(double)(sc_end - sc_start) / (iterations * size));
+		printf("MP/MC peek enq/dequeue (size: %u): %.2F\n", size,
+				(double)(mc_end - mc_start) / (iterations * size));
+	}
+
+	sink = sum;
+	RTE_SET_USED(sink);
+}
+
 static int
 test_ring_perf(void)
 {
@@ -399,17 +676,31 @@ test_ring_perf(void)
 	printf("\n### Testing using a single lcore ###\n");
 	test_bulk_enqueue_dequeue();
 
+	printf("\n### Testing zero-copy dequeue using a single lcore ###\n");
+	test_peek_enqueue_dequeue();
+
+	printf("\n### Testing element sizes using a single lcore ###\n");
+	test_bulk_enqueue_dequeue_elem();
+
+	if (rte_lcore_count() > 1) {
+		printf("\n### Testing MP/MC synchronization modes ###\n");
+		test_mt_enqueue_dequeue();
+	}
+
 	if (get_two_hyperthreads(&cores) == 0) {
 		printf("\n### Testing using two hyperthreads ###\n");
-		run_on_core_pair(&cores, enqueue_bulk, dequeue_bulk);
+		run_on_core_pair(&cores, enqueue_bulk, dequeue_bulk, "bulk");
+		run_on_core_pair(&cores, enqueue_bulk, dequeue_peek, "peek");
 	}
 	if (get_two_cores(&cores) == 0) {
 		printf("\n### Testing using two physical cores ###\n");
-		run_on_core_pair(&cores, enqueue_bulk, dequeue_bulk);
+		run_on_core_pair(&cores, enqueue_bulk, dequeue_bulk, "bulk");
+		run_on_core_pair(&cores, enqueue_bulk, dequeue_peek, "peek");
 	}
 	if (get_two_sockets(&cores) == 0) {
 		printf("\n### Testing using two NUMA nodes ###\n");
-		run_on_core_pair(&cores, enqueue_bulk, dequeue_bulk);
+		run_on_core_pair(&cores, enqueue_bulk, dequeue_bulk, "bulk");
+		run_on_core_pair(&cores, enqueue_bulk, dequeue_peek, "peek");
 	}
 	return 0;
 }
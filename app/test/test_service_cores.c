@@ -0,0 +1,456 @@
+/*-
+ *   BSD LICENSE
+ *
+ *   Copyright(c) 2010-2014 Intel Corporation. All rights reserved.
+ *   All rights reserved.
+ *
+ *   Redistribution and use in source and binary forms, with or without
+ *   modification, are permitted provided that the following conditions
+ *   are met:
+ *
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in
+ *       the documentation and/or other materials provided with the
+ *       distribution.
+ *     * Neither the name of Intel Corporation nor the names of its
+ *       contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ *   THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *   "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *   LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ *   A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ *   OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ *   SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ *   LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ *   DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ *   THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ *   (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ *   OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <stdio.h>
+#include <stdint.h>
+#include <inttypes.h>
+#include <string.h>
+#include <errno.h>
+
+#include <rte_common.h>
+#include <rte_cycles.h>
+#include <rte_atomic.h>
+#include <rte_lcore.h>
+#include <rte_launch.h>
+#include <rte_service.h>
+
+#include "test.h"
+
+/*
+ * Service cores
+ * =============
+ *
+ * - Check the registration and lookup of services, and that invalid or
+ *   duplicated registrations are refused.
+ *
+ * - Turn a slave lcore into a service lcore and check that it is hidden
+ *   from the application lcores.
+ *
+ * - Map a service to the service lcore, start both, and check that the
+ *   service is called, and that its calls and cycles are accounted.
+ *   Check that a stopped service is not called anymore.
+ *
+ * - Run a service from the application lcore.
+ *
+ * - Map a service that is not MT safe to one service lcore, run it from the
+ *   application lcore too, and check that it is never run by both at the
+ *   same time.
+ *
+ * - If there are enough lcores, map a service that is not MT safe to two
+ *   service lcores and check that it is never run by both at the same time.
+ */
+
+#define SERVICE_WAIT_MS 2000
+
+static rte_atomic32_t dummy_calls;
+static rte_atomic32_t mt_unsafe_inside;
+static volatile int mt_unsafe_error;
+
+static int32_t
+dummy_cb(void *args)
+{
+	RTE_SET_USED(args);
+	rte_atomic32_inc(&dummy_calls);
+	rte_delay_us(1);
+	return 0;
+}
+
+static int32_t
+mt_unsafe_cb(void *args)
+{
+	RTE_SET_USED(args);
+	if (rte_atomic32_add_return(&mt_unsafe_inside, 1) != 1)
+		mt_unsafe_error = 1;
+	rte_delay_us(10);
+	rte_atomic32_dec(&mt_unsafe_inside);
+	return 0;
+}
+
+/* wait until the dummy service was called more than n times */
+static int
+wait_dummy_calls(int32_t n)
+{
+	unsigned ms;
+
+	for (ms = 0; ms < SERVICE_WAIT_MS; ms++) {
+		if (rte_atomic32_read(&dummy_calls) > n)
+			return 0;
+		rte_delay_ms(1);
+	}
+	return -1;
+}
+
+static int
+test_service_register(uint32_t *id)
+{
+	struct rte_service_spec spec;
+	uint32_t count = rte_service_get_count();
+	uint32_t lookup_id;
+
+	memset(&spec, 0, sizeof(spec));
+	if (rte_service_register(NULL, id) != -EINVAL) {
+		printf("NULL spec was registered\n");
+		return -1;
+	}
+	snprintf(spec.name, sizeof(spec.name), "test_dummy");
+	if (rte_service_register(&spec, id) != -EINVAL) {
+		printf("service without callback was registered\n");
+		return -1;
+	}
+	spec.callback = dummy_cb;
+	if (rte_service_register(&spec, id) != 0) {
+		printf("cannot register service\n");
+		return -1;
+	}
+	if (rte_service_register(&spec, NULL) != -EEXIST) {
+		printf("service was registered twice\n");
+		return -1;
+	}
+	if (rte_service_get_count() != count + 1) {
+		printf("wrong number of services\n");
+		return -1;
+	}
+	if (rte_service_get_by_name("test_dummy", &lookup_id) != 0 ||
+			lookup_id != *id ||
+			strcmp(rte_service_get_name(*id), "test_dummy") != 0) {
+		printf("cannot look up the service\n");
+		return -1;
+	}
+	if (rte_service_get_by_name("test_none", &lookup_id) != -ENODEV) {
+		printf("found a service that does not exist\n");
+		return -1;
+	}
+	if (rte_service_runstate_get(*id) != 0) {
+		printf("new service is running\n");
+		return -1;
+	}
+	return 0;
+}
+
+static int
+test_service_lcore_add(uint32_t lcore)
+{
+	uint32_t list[RTE_MAX_LCORE];
+	unsigned lcore_count = rte_lcore_count();
+	int32_t service_count = rte_service_lcore_count();
+	int32_t i, n;
+
+	if (rte_service_lcore_add(rte_get_master_lcore()) != -EINVAL) {
+		printf("master lcore became a service lcore\n");
+		return -1;
+	}
+	if (rte_service_lcore_add(lcore) != 0) {
+		printf("cannot add service lcore %u\n", lcore);
+		return -1;
+	}
+	if (rte_service_lcore_add(lcore) != -EALREADY) {
+		printf("service lcore %u was added twice\n", lcore);
+		return -1;
+	}
+	if (rte_lcore_count() != lcore_count - 1) {
+		printf("service lcore is still counted\n");
+		return -1;
+	}
+	RTE_LCORE_FOREACH_SLAVE(i) {
+		if ((uint32_t)i == lcore) {
+			printf("service lcore is seen as a slave lcore\n");
+			return -1;
+		}
+	}
+	n = rte_service_lcore_list(list, RTE_DIM(list));
+	if (rte_service_lcore_count() != service_count + 1 ||
+			n != service_count + 1) {
+		printf("wrong number of service lcores\n");
+		return -1;
+	}
+	for (i = 0; i < n; i++)
+		if (list[i] == lcore)
+			return 0;
+	printf("service lcore %u is not listed\n", lcore);
+	return -1;
+}
+
+static int
+test_service_run(uint32_t id, uint32_t lcore)
+{
+	uint64_t calls, cycles;
+	int32_t n;
+
+	rte_atomic32_init(&dummy_calls);
+	if (rte_service_map_lcore_set(id, rte_get_master_lcore(), 1) !=
+			-EINVAL) {
+		printf("service was mapped to the master lcore\n");
+		return -1;
+	}
+	if (rte_service_map_lcore_set(id, lcore, 1) != 0 ||
+			rte_service_map_lcore_get(id, lcore) != 1) {
+		printf("cannot map service\n");
+		return -1;
+	}
+	if (rte_service_set_stats_enable(id, 1) != 0 ||
+			rte_service_stats_reset(id) != 0)
+		return -1;
+
+	/* a stopped service is not run, even by a running lcore */
+	if (rte_service_lcore_start(lcore) != 0) {
+		printf("cannot start service lcore\n");
+		return -1;
+	}
+	if (rte_service_lcore_start(lcore) != -EALREADY) {
+		printf("service lcore was started twice\n");
+		return -1;
+	}
+	if (rte_service_lcore_del(lcore) != -EBUSY) {
+		printf("running service lcore was deleted\n");
+		return -1;
+	}
+	rte_delay_ms(10);
+	if (rte_atomic32_read(&dummy_calls) != 0) {
+		printf("stopped service was called\n");
+		return -1;
+	}
+
+	if (rte_service_runstate_set(id, 1) != 0 ||
+			rte_service_runstate_get(id) != 1) {
+		printf("cannot start service\n");
+		return -1;
+	}
+	if (wait_dummy_calls(100) < 0) {
+		printf("service was not called by the service lcore\n");
+		return -1;
+	}
+
+	rte_service_runstate_set(id, 0);
+	rte_delay_ms(10);
+	n = rte_atomic32_read(&dummy_calls);
+	rte_delay_ms(10);
+	if (rte_atomic32_read(&dummy_calls) != n) {
+		printf("service is still called after being stopped\n");
+		return -1;
+	}
+
+	if (rte_service_lcore_stop(lcore) != 0 ||
+			rte_service_lcore_stop(lcore) != -EALREADY) {
+		printf("cannot stop service lcore\n");
+		return -1;
+	}
+
+	if (rte_service_stats_get(id, &calls, &cycles) != 0 ||
+			calls != (uint64_t)n || cycles == 0) {
+		printf("wrong statistics: %d calls, stats %"PRIu64
+			" calls %"PRIu64" cycles\n", n, calls, cycles);
+		return -1;
+	}
+	rte_service_dump(stdout, UINT32_MAX);
+
+	/* run it from this lcore */
+	if (rte_service_run_iter_on_app_lcore(id) != -ENOEXEC) {
+		printf("stopped service was run on the app lcore\n");
+		return -1;
+	}
+	rte_service_runstate_set(id, 1);
+	if (rte_service_run_iter_on_app_lcore(id) != 0 ||
+			rte_atomic32_read(&dummy_calls) != n + 1) {
+		printf("cannot run service on the app lcore\n");
+		return -1;
+	}
+	rte_service_runstate_set(id, 0);
+
+	rte_service_map_lcore_set(id, lcore, 0);
+	if (rte_service_map_lcore_get(id, lcore) != 0 ||
+			rte_service_runstate_get(id) != 0) {
+		printf("cannot unmap service\n");
+		return -1;
+	}
+	return 0;
+}
+
+static int
+test_service_mt_unsafe_app_lcore(uint32_t lcore)
+{
+	struct rte_service_spec spec;
+	uint64_t calls = 0, end;
+	uint32_t id;
+	int32_t ret;
+
+	memset(&spec, 0, sizeof(spec));
+	snprintf(spec.name, sizeof(spec.name), "test_mt_unsafe_app");
+	spec.callback = mt_unsafe_cb;
+	if (rte_service_register(&spec, &id) != 0) {
+		printf("cannot register service\n");
+		return -1;
+	}
+
+	rte_atomic32_init(&mt_unsafe_inside);
+	mt_unsafe_error = 0;
+	rte_service_map_lcore_set(id, lcore, 1);
+	rte_service_runstate_set(id, 1);
+	rte_service_lcore_start(lcore);
+
+	end = rte_get_timer_cycles() + rte_get_timer_hz() / 10;
+	while (rte_get_timer_cycles() < end) {
+		ret = rte_service_run_iter_on_app_lcore(id);
+		if (ret != 0 && ret != -EBUSY) {
+			printf("cannot run service on the application lcore\n");
+			mt_unsafe_error = 1;
+			break;
+		}
+	}
+
+	rte_service_runstate_set(id, 0);
+	rte_service_lcore_stop(lcore);
+	rte_service_stats_get(id, &calls, NULL);
+	rte_service_map_lcore_set(id, lcore, 0);
+	rte_service_unregister(id);
+
+	if (mt_unsafe_error) {
+		printf("service that is not MT safe ran on two lcores\n");
+		return -1;
+	}
+	if (calls == 0) {
+		printf("service was not called\n");
+		return -1;
+	}
+	return 0;
+}
+
+static int
+test_service_mt_unsafe(uint32_t lcore1, uint32_t lcore2)
+{
+	struct rte_service_spec spec;
+	uint64_t calls = 0;
+	uint32_t id;
+	int ret = -1;
+
+	memset(&spec, 0, sizeof(spec));
+	snprintf(spec.name, sizeof(spec.name), "test_mt_unsafe");
+	spec.callback = mt_unsafe_cb;
+	if (rte_service_register(&spec, &id) != 0) {
+		printf("cannot register service\n");
+		return -1;
+	}
+	if (rte_service_lcore_add(lcore2) != 0) {
+		printf("cannot add service lcore %u\n", lcore2);
+		goto unregister;
+	}
+
+	rte_atomic32_init(&mt_unsafe_inside);
+	mt_unsafe_error = 0;
+	rte_service_map_lcore_set(id, lcore1, 1);
+	rte_service_map_lcore_set(id, lcore2, 1);
+	rte_service_runstate_set(id, 1);
+	rte_service_lcore_start(lcore1);
+	rte_service_lcore_start(lcore2);
+
+	rte_delay_ms(100);
+
+	rte_service_runstate_set(id, 0);
+	rte_service_lcore_stop(lcore1);
+	rte_service_lcore_stop(lcore2);
+	rte_service_stats_get(id, &calls, NULL);
+
+	if (mt_unsafe_error) {
+		printf("service that is not MT safe ran on two lcores\n");
+		goto del;
+	}
+	if (calls == 0) {
+		printf("service was not called\n");
+		goto del;
+	}
+	ret = 0;
+
+del:
+	rte_service_map_lcore_set(id, lcore1, 0);
+	rte_service_lcore_del(lcore2);
+unregister:
+	rte_service_unregister(id);
+	return ret;
+}
+
+static int
+test_service_cores(void)
+{
+	uint32_t id, lcore1, lcore2;
+	int ret = -1;
+
+	if (rte_lcore_count() < 2) {
+		printf("ERROR: not enough cores to test service cores\n");
+		return -1;
+	}
+	lcore1 = rte_get_next_lcore(-1, 1, 0);
+	lcore2 = rte_get_next_lcore(lcore1, 1, 0);
+
+	if (test_service_register(&id) < 0)
+		return -1;
+
+	if (test_service_lcore_add(lcore1) < 0)
+		goto unregister;
+
+	if (test_service_run(id, lcore1) < 0)
+		goto del;
+
+	if (test_service_mt_unsafe_app_lcore(lcore1) < 0)
+		goto del;
+
+	if (lcore2 < RTE_MAX_LCORE) {
+		if (test_service_mt_unsafe(lcore1, lcore2) < 0)
+			goto del;
+	} else
+		printf("not enough cores to test a service on two lcores\n");
+
+	ret = 0;
+
+del:
+	rte_service_lcore_stop(lcore1);
+	if (rte_service_lcore_del(lcore1) != 0) {
+		printf("cannot delete service lcore\n");
+		ret = -1;
+	}
+	if (rte_lcore_is_enabled(lcore1) == 0) {
+		printf("lcore %u was not given back\n", lcore1);
+		ret = -1;
+	}
+unregister:
+	if (rte_service_unregister(id) != 0 ||
+			rte_service_get_by_name("test_dummy", &id) != -ENODEV) {
+		printf("cannot unregister service\n");
+		ret = -1;
+	}
+	return ret;
+}
+
+static struct test_command service_cmd = {
+	.command = "service_autotest",
+	.callback = test_service_cores,
+};
+REGISTER_TEST_COMMAND(service_cmd);
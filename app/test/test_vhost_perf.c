@@ -0,0 +1,326 @@
+/*-
+ *   BSD LICENSE
+ *
+ *   Copyright(c) 2010-2014 Intel Corporation. All rights reserved.
+ *   All rights reserved.
+ *
+ *   Redistribution and use in source and binary forms, with or without
+ *   modification, are permitted provided that the following conditions
+ *   are met:
+ *
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in
+ *       the documentation and/or other materials provided with the
+ *       distribution.
+ *     * Neither the name of Intel Corporation nor the names of its
+ *       contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ *   THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *   "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *   LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ *   A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ *   OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ *   SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ *   LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ *   DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ *   THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ *   (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ *   OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <inttypes.h>
+
+#include <rte_common.h>
+#include <rte_cycles.h>
+#include <rte_malloc.h>
+#include <rte_mempool.h>
+#include <rte_mbuf.h>
+#include <rte_virtio_net.h>
+
+#include "test.h"
+
+/*
+ * vhost enqueue/dequeue performance
+ * =================================
+ *
+ * Measure the cycles per packet of rte_vhost_enqueue_burst() and
+ * rte_vhost_dequeue_burst() on a device built by hand, so that no guest or
+ * vhost-user session is needed. The guest side only posts the buffers
+ * again, with the header and the data of each packet in two descriptors.
+ *
+ * The guest memory is made of one region, then of REGION_NB regions. The
+ * consecutive buffers of a queue are in different regions, which is the
+ * worst case of the address translation. The enqueue is measured with and
+ * without mergeable RX buffers.
+ */
+
+#define REGION_NB 8
+#define REGION_SZ (1 << 20)
+#define REGION_GPA_STRIDE (1ULL << 30)
+#define MEM_SZ (REGION_NB * REGION_SZ)
+
+#define VRING_SIZE 256
+#define VRING_AVAIL_OFF 4096
+#define VRING_USED_OFF 8192
+#define VRING_SLOT_SZ 16384
+#define BUF_BASE (1 << 16)
+#define BUF_SZ 2048
+#define BUF_DATA_OFF 64
+#define NB_BUFS (VRING_SIZE / 2)
+
+#define PKT_LEN 64
+#define BURST_SIZE 32
+#define ITERATIONS (1 << 16)
+
+#define NB_MBUF 512
+#define MBUF_DATA_SIZE (2048 + RTE_PKTMBUF_HEADROOM)
+
+static uint8_t *mem;
+static unsigned mem_nb_regions;
+
+/* Guest physical address of an address of the guest memory. */
+static uint64_t
+gpa_of(const uint8_t *addr)
+{
+	uint64_t off = addr - mem;
+
+	if (mem_nb_regions == 1)
+		return off;
+	/* The regions are mapped in the reverse order of the memory. */
+	return (REGION_NB - 1 - off / REGION_SZ) * REGION_GPA_STRIDE +
+		off % REGION_SZ;
+}
+
+/* Buffer of the slot i of a queue, in the region i % REGION_NB. */
+static uint8_t *
+buf_addr(uint16_t queue_id, unsigned i)
+{
+	return mem + (i % REGION_NB) * REGION_SZ + BUF_BASE +
+		(queue_id * NB_BUFS + i / REGION_NB) * BUF_SZ;
+}
+
+static struct virtio_memory *
+mem_table_create(unsigned nb_regions)
+{
+	struct virtio_memory *vmem;
+	struct virtio_memory_regions *region;
+	unsigned r;
+
+	vmem = calloc(1, sizeof(*vmem) + sizeof(*region) * nb_regions);
+	if (vmem == NULL)
+		return NULL;
+
+	mem_nb_regions = nb_regions;
+	vmem->nregions = nb_regions;
+	for (r = 0; r < nb_regions; r++) {
+		region = &vmem->regions[r];
+		if (nb_regions == 1) {
+			region->guest_phys_address = 0;
+			region->memory_size = MEM_SZ;
+			region->address_offset = (uintptr_t)mem;
+		} else {
+			region->guest_phys_address = r * REGION_GPA_STRIDE;
+			region->memory_size = REGION_SZ;
+			region->address_offset = (uintptr_t)mem +
+				(REGION_NB - 1 - r) * REGION_SZ -
+				region->guest_phys_address;
+		}
+		region->guest_phys_address_end =
+			region->guest_phys_address + region->memory_size;
+		region->userspace_address = region->guest_phys_address;
+	}
+	return vmem;
+}
+
+/* Set up the queue queue_id, with its rings in the first region. */
+static void
+test_vring_init(struct vhost_virtqueue *vq, uint16_t queue_id)
+{
+	uint8_t *base = mem + queue_id * VRING_SLOT_SZ;
+	struct vring_desc *desc = (struct vring_desc *)base;
+	uint16_t write = queue_id == VIRTIO_RXQ ? VRING_DESC_F_WRITE : 0;
+	unsigned i;
+
+	memset(vq, 0, sizeof(*vq));
+	vq->desc = desc;
+	vq->avail = (struct vring_avail *)(base + VRING_AVAIL_OFF);
+	vq->used = (struct vring_used *)(base + VRING_USED_OFF);
+	vq->size = VRING_SIZE;
+	vq->vhost_hlen = sizeof(struct virtio_net_hdr);
+	vq->callfd = (eventfd_t)-1;
+	vq->kickfd = (eventfd_t)-1;
+	vq->enabled = 1;
+
+	vq->avail->flags = VRING_AVAIL_F_NO_INTERRUPT;
+	vq->avail->idx = 0;
+	vq->used->idx = 0;
+
+	for (i = 0; i < NB_BUFS; i++) {
+		desc[2 * i].addr = gpa_of(buf_addr(queue_id, i));
+		desc[2 * i].len = sizeof(struct virtio_net_hdr);
+		desc[2 * i].flags = VRING_DESC_F_NEXT | write;
+		desc[2 * i].next = 2 * i + 1;
+		desc[2 * i + 1].addr = gpa_of(buf_addr(queue_id, i) +
+			BUF_DATA_OFF);
+		desc[2 * i + 1].len = queue_id == VIRTIO_RXQ ?
+			BUF_SZ - BUF_DATA_OFF : PKT_LEN;
+		desc[2 * i + 1].flags = write;
+	}
+	for (i = 0; i < VRING_SIZE; i++)
+		vq->avail->ring[i] = (2 * i) % VRING_SIZE;
+}
+
+static int
+test_vhost_perf_enqueue(struct virtio_net *dev, struct rte_mbuf **pkts,
+	unsigned nb_regions, int mergeable)
+{
+	struct vhost_virtqueue *vq = dev->virtqueue[VIRTIO_RXQ];
+	uint64_t start, end;
+	unsigned i, n;
+
+	test_vring_init(vq, VIRTIO_RXQ);
+	if (mergeable) {
+		dev->features = 1ULL << VIRTIO_NET_F_MRG_RXBUF;
+		vq->vhost_hlen = sizeof(struct virtio_net_hdr_mrg_rxbuf);
+	} else
+		dev->features = 0;
+
+	start = rte_rdtsc();
+	for (i = 0; i < ITERATIONS; i++) {
+		vq->avail->idx += BURST_SIZE;
+		n = rte_vhost_enqueue_burst(dev, VIRTIO_RXQ, pkts, BURST_SIZE);
+		if (n != BURST_SIZE) {
+			printf("%u packets enqueued\n", n);
+			return -1;
+		}
+	}
+	end = rte_rdtsc();
+	printf("%s (regions: %u): %.2F\n",
+		mergeable ? "mergeable enqueue" : "enqueue", nb_regions,
+		(double)(end - start) / (ITERATIONS * BURST_SIZE));
+	return 0;
+}
+
+static int
+test_vhost_perf_regions(struct virtio_net *dev, struct rte_mempool *mp,
+	struct rte_mbuf **pkts, unsigned nb_regions)
+{
+	struct rte_mbuf *rx_pkts[BURST_SIZE];
+	uint64_t start, end;
+	unsigned i, j, n;
+
+	dev->mem = mem_table_create(nb_regions);
+	if (dev->mem == NULL) {
+		printf("cannot allocate the memory table\n");
+		return -1;
+	}
+
+	if (test_vhost_perf_enqueue(dev, pkts, nb_regions, 0) < 0 ||
+			test_vhost_perf_enqueue(dev, pkts, nb_regions, 1) < 0)
+		goto fail;
+
+	dev->features = 0;
+	test_vring_init(dev->virtqueue[VIRTIO_TXQ], VIRTIO_TXQ);
+
+	start = rte_rdtsc();
+	for (i = 0; i < ITERATIONS; i++) {
+		dev->virtqueue[VIRTIO_TXQ]->avail->idx += BURST_SIZE;
+		n = rte_vhost_dequeue_burst(dev, VIRTIO_TXQ, mp, rx_pkts,
+			BURST_SIZE);
+		for (j = 0; j < n; j++)
+			rte_pktmbuf_free(rx_pkts[j]);
+		if (n != BURST_SIZE) {
+			printf("%u packets dequeued\n", n);
+			goto fail;
+		}
+	}
+	end = rte_rdtsc();
+	printf("dequeue (regions: %u): %.2F\n", nb_regions,
+		(double)(end - start) / (ITERATIONS * BURST_SIZE));
+
+	free(dev->mem);
+	dev->mem = NULL;
+	return 0;
+
+fail:
+	free(dev->mem);
+	dev->mem = NULL;
+	return -1;
+}
+
+static int
+test_vhost_perf(void)
+{
+	struct rte_mbuf *pkts[BURST_SIZE];
+	struct rte_mempool *mp;
+	struct virtio_net *dev;
+	unsigned i;
+	int ret = -1;
+
+	mp = rte_mempool_lookup("vhost_perf_pool");
+	if (mp == NULL)
+		mp = rte_pktmbuf_pool_create("vhost_perf_pool", NB_MBUF, 32,
+			0, MBUF_DATA_SIZE, SOCKET_ID_ANY);
+	if (mp == NULL) {
+		printf("cannot create mbuf pool\n");
+		return -1;
+	}
+
+	mem = rte_zmalloc("vhost_perf", MEM_SZ, RTE_CACHE_LINE_SIZE);
+	dev = rte_zmalloc("vhost_perf", sizeof(*dev), RTE_CACHE_LINE_SIZE);
+	if (mem == NULL || dev == NULL) {
+		printf("cannot allocate the device\n");
+		goto out;
+	}
+	dev->virt_qp_nb = 1;
+	for (i = 0; i < VIRTIO_QNUM; i++) {
+		dev->virtqueue[i] = rte_zmalloc("vhost_perf",
+			sizeof(struct vhost_virtqueue), RTE_CACHE_LINE_SIZE);
+		if (dev->virtqueue[i] == NULL) {
+			printf("cannot allocate the virtqueues\n");
+			goto out;
+		}
+	}
+
+	memset(pkts, 0, sizeof(pkts));
+	for (i = 0; i < BURST_SIZE; i++) {
+		pkts[i] = rte_pktmbuf_alloc(mp);
+		if (pkts[i] == NULL) {
+			printf("cannot allocate the packets\n");
+			goto out;
+		}
+		memset(rte_pktmbuf_mtod(pkts[i], void *), i, PKT_LEN);
+		pkts[i]->data_len = PKT_LEN;
+		pkts[i]->pkt_len = PKT_LEN;
+	}
+
+	if (test_vhost_perf_regions(dev, mp, pkts, 1) == 0 &&
+			test_vhost_perf_regions(dev, mp, pkts, REGION_NB) == 0)
+		ret = 0;
+
+out:
+	for (i = 0; i < BURST_SIZE; i++) {
+		if (pkts[i] != NULL)
+			rte_pktmbuf_free(pkts[i]);
+	}
+	if (dev != NULL) {
+		for (i = 0; i < VIRTIO_QNUM; i++)
+			rte_free(dev->virtqueue[i]);
+	}
+	rte_free(dev);
+	rte_free(mem);
+	return ret;
+}
+
+static struct test_command vhost_perf_cmd = {
+	.command = "vhost_perf_autotest",
+	.callback = test_vhost_perf,
+};
+REGISTER_TEST_COMMAND(vhost_perf_cmd);
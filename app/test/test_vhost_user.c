@@ -0,0 +1,1165 @@
+/*-
+ *   BSD LICENSE
+ *
+ *   Copyright(c) 2010-2014 Intel Corporation. All rights reserved.
+ *   All rights reserved.
+ *
+ *   Redistribution and use in source and binary forms, with or without
+ *   modification, are permitted provided that the following conditions
+ *   are met:
+ *
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in
+ *       the documentation and/or other materials provided with the
+ *       distribution.
+ *     * Neither the name of Intel Corporation nor the names of its
+ *       contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ *   THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *   "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *   LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ *   A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ *   OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ *   SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ *   LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ *   DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ *   THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ *   (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ *   OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <stdio.h>
+#include <stdint.h>
+#include <inttypes.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <limits.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <sys/eventfd.h>
+#include <linux/vhost.h>
+
+#include <rte_common.h>
+#include <rte_cycles.h>
+#include <rte_ethdev.h>
+#include <rte_lcore.h>
+#include <rte_launch.h>
+#include <rte_memory.h>
+#include <rte_mempool.h>
+#include <rte_mbuf.h>
+#include <rte_virtio_net.h>
+
+#include "test.h"
+
+/*
+ * vhost-user multiqueue
+ * =====================
+ *
+ * The test acts as the vhost-user master (the role of QEMU), so that no
+ * virtual machine is needed:
+ *
+ * - Register a vhost-user socket and connect to it.
+ *
+ * - Negotiate VIRTIO_NET_F_MQ, VIRTIO_RING_F_EVENT_IDX and the protocol
+ *   features, and get the maximum number of queue pairs.
+ *
+ * - Share a file mapping as guest memory, and set up the virtqueues of
+ *   TEST_NB_QP queue pairs in it. The guest physical addresses are the
+ *   offsets in the file.
+ *
+ * - Check that the device is reported with TEST_NB_QP queue pairs.
+ *
+ * - For each queue pair on a different lcore, dequeue the packets posted
+ *   on its TX virtqueue and enqueue them back on its RX virtqueue, then
+ *   check the packets received by the guest.
+ *
+ * - Check that the guest is only notified of the received packets once
+ *   the used index passes its used event index, and at most once per
+ *   coalescing window.
+ *
+ * - Close the connection and unregister the socket.
+ *
+ * - Connect again with zero copy dequeue enabled, and check that the large
+ *   packets are dequeued without copy when the guest memory has physical
+ *   addresses, and that their buffers are given back to the guest once
+ *   their mbufs are freed.
+ *
+ * - Create a virtio-user port, so that the virtio PMD is the guest, and
+ *   forward packets between the PMD and the vhost library. The cycles per
+ *   packet of both directions are reported. The port needs the memory of
+ *   the EAL to be mapped with --single-file-segments, else this step is
+ *   skipped.
+ */
+
+#define TEST_NB_QP 2
+#define TEST_NB_VQ (TEST_NB_QP * VIRTIO_QNUM)
+#define TEST_NB_PKTS 16
+#define TEST_PKT_LEN 64
+#define TEST_ZCOPY_LEN 512
+#define TEST_ZCOPY_PKT_LEN 1024
+
+#define VRING_SIZE 64
+#define VRING_SLOT_SZ 8192
+#define VRING_AVAIL_OFF 1024
+#define VRING_USED_OFF 4096
+#define BUF_BASE (VRING_SLOT_SZ * TEST_NB_VQ)
+#define BUF_SZ 2048
+#define MEM_SZ (BUF_BASE + TEST_NB_VQ * VRING_SIZE * BUF_SZ)
+
+#define NB_MBUF 256
+#define MBUF_DATA_SIZE (2048 + RTE_PKTMBUF_HEADROOM)
+
+#define TIMEOUT_MS 5000
+
+#define VIRTIO_USER_QUEUE_SIZE 256
+#define VIRTIO_USER_NB_MBUF 1024
+#define PERF_BURST 32
+#define PERF_ITER 10000
+
+/* vhost-user protocol, as sent by QEMU (hw/virtio/vhost-user.c) */
+enum {
+	VHOST_USER_GET_FEATURES = 1,
+	VHOST_USER_SET_FEATURES = 2,
+	VHOST_USER_SET_OWNER = 3,
+	VHOST_USER_SET_MEM_TABLE = 5,
+	VHOST_USER_SET_VRING_NUM = 8,
+	VHOST_USER_SET_VRING_ADDR = 9,
+	VHOST_USER_SET_VRING_BASE = 10,
+	VHOST_USER_SET_VRING_KICK = 12,
+	VHOST_USER_SET_VRING_CALL = 13,
+	VHOST_USER_GET_PROTOCOL_FEATURES = 15,
+	VHOST_USER_SET_PROTOCOL_FEATURES = 16,
+	VHOST_USER_GET_QUEUE_NUM = 17,
+};
+
+#define VHOST_USER_VERSION 0x1
+#define VHOST_USER_REPLY_MASK (0x1 << 2)
+#define VHOST_USER_MEMORY_MAX_NREGIONS 8
+#define VHOST_USER_F_PROTOCOL_FEATURES 30
+#define VHOST_USER_PROTOCOL_F_MQ 0
+#ifndef VIRTIO_NET_F_MQ
+#define VIRTIO_NET_F_MQ 22
+#endif
+
+struct vhost_user_memory_region {
+	uint64_t guest_phys_addr;
+	uint64_t memory_size;
+	uint64_t userspace_addr;
+	uint64_t mmap_offset;
+};
+
+struct vhost_user_memory {
+	uint32_t nregions;
+	uint32_t padding;
+	struct vhost_user_memory_region regions[VHOST_USER_MEMORY_MAX_NREGIONS];
+};
+
+struct vhost_user_msg {
+	uint32_t request;
+	uint32_t flags;
+	uint32_t size;
+	union {
+		uint64_t u64;
+		struct vhost_vring_state state;
+		struct vhost_vring_addr addr;
+		struct vhost_user_memory memory;
+	} payload;
+} __attribute__((packed));
+
+#define VHOST_USER_HDR_SIZE offsetof(struct vhost_user_msg, payload.u64)
+
+static char sock_path[64];
+static int sock_fd = -1;
+static int mem_fd = -1;
+static uint8_t *mem;
+static int kick_fds[TEST_NB_VQ];
+static int call_fds[TEST_NB_VQ];
+static struct rte_mempool *vhost_pool;
+
+static struct virtio_net *volatile test_dev;
+static volatile uint32_t test_dev_qp_nb;
+static volatile int test_dev_ready;
+static volatile int test_dev_destroyed;
+
+static int
+new_device(struct virtio_net *dev)
+{
+	test_dev_qp_nb = rte_vhost_get_queue_num(dev);
+	dev->flags |= VIRTIO_DEV_RUNNING;
+	test_dev = dev;
+	test_dev_ready = 1;
+	return 0;
+}
+
+static void
+destroy_device(volatile struct virtio_net *dev)
+{
+	dev->flags &= ~VIRTIO_DEV_RUNNING;
+	test_dev = NULL;
+	test_dev_destroyed = 1;
+}
+
+static const struct virtio_net_device_ops test_vhost_ops = {
+	.new_device = new_device,
+	.destroy_device = destroy_device,
+};
+
+static void *
+vhost_session(__attribute__((unused)) void *arg)
+{
+	rte_vhost_driver_session_start();
+	return NULL;
+}
+
+/* wait until a flag is set by the vhost session thread */
+static int
+wait_flag(volatile int *flag)
+{
+	unsigned i;
+
+	for (i = 0; i < TIMEOUT_MS && *flag == 0; i++)
+		rte_delay_ms(1);
+	return *flag ? 0 : -1;
+}
+
+static int
+send_msg(struct vhost_user_msg *msg, int fd)
+{
+	struct msghdr msgh;
+	struct iovec iov;
+	char control[CMSG_SPACE(sizeof(int))];
+	struct cmsghdr *cmsg;
+
+	msg->flags = VHOST_USER_VERSION;
+
+	memset(&msgh, 0, sizeof(msgh));
+	iov.iov_base = msg;
+	iov.iov_len = VHOST_USER_HDR_SIZE + msg->size;
+	msgh.msg_iov = &iov;
+	msgh.msg_iovlen = 1;
+
+	if (fd >= 0) {
+		msgh.msg_control = control;
+		msgh.msg_controllen = sizeof(control);
+		cmsg = CMSG_FIRSTHDR(&msgh);
+		cmsg->cmsg_len = CMSG_LEN(sizeof(int));
+		cmsg->cmsg_level = SOL_SOCKET;
+		cmsg->cmsg_type = SCM_RIGHTS;
+		memcpy(CMSG_DATA(cmsg), &fd, sizeof(int));
+	}
+
+	if (sendmsg(sock_fd, &msgh, 0) != (ssize_t)iov.iov_len) {
+		printf("cannot send vhost-user request %u\n", msg->request);
+		return -1;
+	}
+	return 0;
+}
+
+static int
+send_u64(uint32_t request, uint64_t u64, int fd)
+{
+	struct vhost_user_msg msg;
+
+	memset(&msg, 0, sizeof(msg));
+	msg.request = request;
+	msg.size = sizeof(msg.payload.u64);
+	msg.payload.u64 = u64;
+	return send_msg(&msg, fd);
+}
+
+static int
+send_state(uint32_t request, unsigned index, unsigned num)
+{
+	struct vhost_user_msg msg;
+
+	memset(&msg, 0, sizeof(msg));
+	msg.request = request;
+	msg.size = sizeof(msg.payload.state);
+	msg.payload.state.index = index;
+	msg.payload.state.num = num;
+	return send_msg(&msg, -1);
+}
+
+/* send a request without payload and read the u64 of its reply */
+static int
+get_u64(uint32_t request, uint64_t *u64)
+{
+	struct vhost_user_msg msg;
+
+	memset(&msg, 0, sizeof(msg));
+	msg.request = request;
+	if (send_msg(&msg, -1) < 0)
+		return -1;
+
+	if (recv(sock_fd, &msg, VHOST_USER_HDR_SIZE, MSG_WAITALL) !=
+			(ssize_t)VHOST_USER_HDR_SIZE ||
+			msg.request != request ||
+			(msg.flags & VHOST_USER_REPLY_MASK) == 0 ||
+			msg.size != sizeof(msg.payload.u64) ||
+			recv(sock_fd, &msg.payload.u64, msg.size, MSG_WAITALL) !=
+			(ssize_t)msg.size) {
+		printf("bad reply to vhost-user request %u\n", request);
+		return -1;
+	}
+	*u64 = msg.payload.u64;
+	return 0;
+}
+
+static struct vring_desc *
+vq_desc(unsigned q)
+{
+	return (struct vring_desc *)(mem + q * VRING_SLOT_SZ);
+}
+
+static struct vring_avail *
+vq_avail(unsigned q)
+{
+	return (struct vring_avail *)(mem + q * VRING_SLOT_SZ + VRING_AVAIL_OFF);
+}
+
+static struct vring_used *
+vq_used(unsigned q)
+{
+	return (struct vring_used *)(mem + q * VRING_SLOT_SZ + VRING_USED_OFF);
+}
+
+/* guest physical address of the buffer i of the virtqueue q */
+static uint64_t
+buf_gpa(unsigned q, unsigned i)
+{
+	return BUF_BASE + ((uint64_t)q * VRING_SIZE + i) * BUF_SZ;
+}
+
+static void
+pkt_fill(uint8_t *data, unsigned len, unsigned qp, unsigned i)
+{
+	unsigned j;
+
+	for (j = 0; j < len; j++)
+		data[j] = (uint8_t)(qp * 0x40 + i + j);
+}
+
+static int
+pkt_check(const uint8_t *data, unsigned len, unsigned qp, unsigned i)
+{
+	unsigned j;
+
+	for (j = 0; j < len; j++)
+		if (data[j] != (uint8_t)(qp * 0x40 + i + j))
+			return -1;
+	return 0;
+}
+
+/* length of the packet i, with large packets every other packet for zero copy */
+static unsigned
+pkt_len(int zcopy, unsigned i)
+{
+	return (zcopy && (i & 1)) ? TEST_ZCOPY_PKT_LEN : TEST_PKT_LEN;
+}
+
+/*
+ * Post the packets sent by the guest on the TX virtqueue of a queue pair,
+ * each with a header and a data descriptor, and the buffers to receive
+ * them on its RX virtqueue.
+ */
+static void
+guest_post_buffers(unsigned qp, int zcopy)
+{
+	unsigned rxq = qp * VIRTIO_QNUM + VIRTIO_RXQ;
+	unsigned txq = qp * VIRTIO_QNUM + VIRTIO_TXQ;
+	struct vring_desc *desc;
+	unsigned i;
+
+	desc = vq_desc(txq);
+	for (i = 0; i < TEST_NB_PKTS; i++) {
+		memset(mem + buf_gpa(txq, i), 0, sizeof(struct virtio_net_hdr));
+		desc[2 * i].addr = buf_gpa(txq, i);
+		desc[2 * i].len = sizeof(struct virtio_net_hdr);
+		desc[2 * i].flags = VRING_DESC_F_NEXT;
+		desc[2 * i].next = 2 * i + 1;
+		pkt_fill(mem + buf_gpa(txq, i) + 64, pkt_len(zcopy, i), qp, i);
+		desc[2 * i + 1].addr = buf_gpa(txq, i) + 64;
+		desc[2 * i + 1].len = pkt_len(zcopy, i);
+		desc[2 * i + 1].flags = 0;
+		vq_avail(txq)->ring[i] = 2 * i;
+	}
+
+	desc = vq_desc(rxq);
+	for (i = 0; i < TEST_NB_PKTS; i++) {
+		desc[i].addr = buf_gpa(rxq, i);
+		desc[i].len = BUF_SZ;
+		desc[i].flags = VRING_DESC_F_WRITE;
+		vq_avail(rxq)->ring[i] = i;
+	}
+
+	rte_wmb();
+	vq_avail(txq)->idx = TEST_NB_PKTS;
+	vq_avail(rxq)->idx = TEST_NB_PKTS;
+}
+
+/* check the packets received by the guest on the RX virtqueue of a queue pair */
+static int
+guest_check_rx(unsigned qp)
+{
+	unsigned rxq = qp * VIRTIO_QNUM + VIRTIO_RXQ;
+	unsigned txq = qp * VIRTIO_QNUM + VIRTIO_TXQ;
+	struct vring_used *used = vq_used(rxq);
+	unsigned i;
+
+	if (vq_used(txq)->idx != TEST_NB_PKTS || used->idx != TEST_NB_PKTS) {
+		printf("queue pair %u: %u packets sent, %u received\n",
+			qp, vq_used(txq)->idx, used->idx);
+		return -1;
+	}
+
+	for (i = 0; i < TEST_NB_PKTS; i++) {
+		if (used->ring[i].len !=
+				sizeof(struct virtio_net_hdr) + TEST_PKT_LEN ||
+				pkt_check(mem + buf_gpa(rxq, used->ring[i].id) +
+				sizeof(struct virtio_net_hdr), TEST_PKT_LEN,
+				qp, i) < 0) {
+			printf("queue pair %u: bad packet %u\n", qp, i);
+			return -1;
+		}
+	}
+	return 0;
+}
+
+/* forward the packets of a queue pair from its TX to its RX virtqueue */
+static int
+forward_qp(void *arg)
+{
+	unsigned qp = (uintptr_t)arg;
+	struct rte_mbuf *pkts[TEST_NB_PKTS];
+	uint16_t nb_rx, nb_tx, i;
+	int ret = 0;
+
+	nb_rx = rte_vhost_dequeue_burst(test_dev,
+		qp * VIRTIO_QNUM + VIRTIO_TXQ, vhost_pool, pkts, TEST_NB_PKTS);
+	if (nb_rx != TEST_NB_PKTS) {
+		printf("queue pair %u: %u packets dequeued\n", qp, nb_rx);
+		ret = -1;
+	}
+
+	for (i = 0; i < nb_rx; i++) {
+		if (rte_pktmbuf_pkt_len(pkts[i]) != TEST_PKT_LEN ||
+				pkt_check(rte_pktmbuf_mtod(pkts[i], uint8_t *),
+				TEST_PKT_LEN, qp, i) < 0) {
+			printf("queue pair %u: bad dequeued packet %u\n", qp, i);
+			ret = -1;
+		}
+	}
+
+	nb_tx = rte_vhost_enqueue_burst(test_dev,
+		qp * VIRTIO_QNUM + VIRTIO_RXQ, pkts, nb_rx);
+	if (nb_tx != nb_rx) {
+		printf("queue pair %u: %u packets enqueued\n", qp, nb_tx);
+		ret = -1;
+	}
+
+	for (i = 0; i < nb_rx; i++)
+		rte_pktmbuf_free(pkts[i]);
+	return ret;
+}
+
+static int
+test_vhost_user_connect(void)
+{
+	struct sockaddr_un un;
+	unsigned i;
+
+	sock_fd = socket(AF_UNIX, SOCK_STREAM, 0);
+	if (sock_fd < 0) {
+		printf("cannot create socket\n");
+		return -1;
+	}
+
+	memset(&un, 0, sizeof(un));
+	un.sun_family = AF_UNIX;
+	snprintf(un.sun_path, sizeof(un.sun_path), "%s", sock_path);
+	for (i = 0; i < TIMEOUT_MS; i++) {
+		if (connect(sock_fd, (struct sockaddr *)&un, sizeof(un)) == 0)
+			return 0;
+		rte_delay_ms(1);
+	}
+	printf("cannot connect to %s\n", sock_path);
+	return -1;
+}
+
+static int
+test_vhost_user_negotiate(void)
+{
+	uint64_t features, protocol_features, queue_num;
+
+	if (send_u64(VHOST_USER_SET_OWNER, 0, -1) < 0 ||
+			get_u64(VHOST_USER_GET_FEATURES, &features) < 0)
+		return -1;
+	if ((features & (1ULL << VIRTIO_NET_F_MQ)) == 0 ||
+			(features & (1ULL << VHOST_USER_F_PROTOCOL_FEATURES)) == 0) {
+		printf("multiqueue is not supported: features 0x%"PRIx64"\n",
+			features);
+		return -1;
+	}
+	if ((features & (1ULL << VIRTIO_RING_F_EVENT_IDX)) == 0) {
+		printf("event index is not supported: features 0x%"PRIx64"\n",
+			features);
+		return -1;
+	}
+
+	if (get_u64(VHOST_USER_GET_PROTOCOL_FEATURES, &protocol_features) < 0)
+		return -1;
+	if ((protocol_features & (1ULL << VHOST_USER_PROTOCOL_F_MQ)) == 0) {
+		printf("bad protocol features 0x%"PRIx64"\n", protocol_features);
+		return -1;
+	}
+	if (send_u64(VHOST_USER_SET_PROTOCOL_FEATURES,
+			1ULL << VHOST_USER_PROTOCOL_F_MQ, -1) < 0)
+		return -1;
+
+	if (get_u64(VHOST_USER_GET_QUEUE_NUM, &queue_num) < 0)
+		return -1;
+	if (queue_num < TEST_NB_QP) {
+		printf("only %"PRIu64" queue pairs are supported\n", queue_num);
+		return -1;
+	}
+
+	return send_u64(VHOST_USER_SET_FEATURES,
+		(1ULL << VIRTIO_NET_F_MQ) |
+		(1ULL << VIRTIO_RING_F_EVENT_IDX) |
+		(1ULL << VHOST_USER_F_PROTOCOL_FEATURES), -1);
+}
+
+static int
+test_vhost_user_setup_vrings(void)
+{
+	struct vhost_user_msg msg;
+	unsigned q;
+
+	memset(&msg, 0, sizeof(msg));
+	msg.request = VHOST_USER_SET_MEM_TABLE;
+	msg.size = sizeof(msg.payload.memory);
+	msg.payload.memory.nregions = 1;
+	msg.payload.memory.regions[0].guest_phys_addr = 0;
+	msg.payload.memory.regions[0].memory_size = MEM_SZ;
+	msg.payload.memory.regions[0].userspace_addr = (uintptr_t)mem;
+	msg.payload.memory.regions[0].mmap_offset = 0;
+	if (send_msg(&msg, mem_fd) < 0)
+		return -1;
+
+	/* As QEMU does, the call fds of all the queues are sent first. */
+	for (q = 0; q < TEST_NB_VQ; q++) {
+		if (send_u64(VHOST_USER_SET_VRING_CALL, q, call_fds[q]) < 0)
+			return -1;
+	}
+
+	for (q = 0; q < TEST_NB_VQ; q++) {
+		if (send_state(VHOST_USER_SET_VRING_NUM, q, VRING_SIZE) < 0 ||
+				send_state(VHOST_USER_SET_VRING_BASE, q, 0) < 0)
+			return -1;
+
+		memset(&msg, 0, sizeof(msg));
+		msg.request = VHOST_USER_SET_VRING_ADDR;
+		msg.size = sizeof(msg.payload.addr);
+		msg.payload.addr.index = q;
+		msg.payload.addr.desc_user_addr = (uintptr_t)vq_desc(q);
+		msg.payload.addr.avail_user_addr = (uintptr_t)vq_avail(q);
+		msg.payload.addr.used_user_addr = (uintptr_t)vq_used(q);
+		if (send_msg(&msg, -1) < 0)
+			return -1;
+
+		if (send_u64(VHOST_USER_SET_VRING_KICK, q, kick_fds[q]) < 0)
+			return -1;
+	}
+
+	return 0;
+}
+
+static int
+test_vhost_user_wait_ready(void)
+{
+	if (wait_flag(&test_dev_ready) < 0) {
+		printf("device is not ready\n");
+		return -1;
+	}
+	if (test_dev_qp_nb != TEST_NB_QP) {
+		printf("device has %u queue pairs instead of %u\n",
+			test_dev_qp_nb, TEST_NB_QP);
+		return -1;
+	}
+	return 0;
+}
+
+static int
+test_vhost_user_forward(void)
+{
+	unsigned qp_lcore[TEST_NB_QP];
+	unsigned qp, lcore_id;
+	int ret = 0;
+
+	for (qp = 0; qp < TEST_NB_QP; qp++)
+		guest_post_buffers(qp, 0);
+
+	/* serve each queue pair from its own lcore when possible */
+	lcore_id = rte_get_next_lcore(-1, 1, 0);
+	for (qp = 0; qp < TEST_NB_QP; qp++) {
+		qp_lcore[qp] = lcore_id;
+		if (lcore_id < RTE_MAX_LCORE) {
+			rte_eal_remote_launch(forward_qp,
+				(void *)(uintptr_t)qp, lcore_id);
+			lcore_id = rte_get_next_lcore(lcore_id, 1, 0);
+		} else if (forward_qp((void *)(uintptr_t)qp) < 0) {
+			ret = -1;
+		}
+	}
+	for (qp = 0; qp < TEST_NB_QP; qp++) {
+		if (qp_lcore[qp] < RTE_MAX_LCORE &&
+				rte_eal_wait_lcore(qp_lcore[qp]) < 0)
+			ret = -1;
+	}
+
+	for (qp = 0; qp < TEST_NB_QP; qp++) {
+		if (guest_check_rx(qp) < 0)
+			ret = -1;
+	}
+
+	return ret;
+}
+
+/*
+ * Enqueue nb_pkts packets on the RX virtqueue of the queue pair 0, and check
+ * whether the guest is notified.
+ */
+static int
+notify_enqueue(struct rte_mbuf **pkts, unsigned nb_pkts, int notified)
+{
+	eventfd_t val;
+	unsigned nb_tx;
+
+	nb_tx = rte_vhost_enqueue_burst(test_dev, VIRTIO_RXQ, pkts, nb_pkts);
+	if (nb_tx != nb_pkts) {
+		printf("%u packets enqueued instead of %u\n", nb_tx, nb_pkts);
+		return -1;
+	}
+	if ((eventfd_read(call_fds[VIRTIO_RXQ], &val) == 0) != notified) {
+		printf("the guest is %snotified after %u used buffers\n",
+			notified ? "not " : "", vq_used(VIRTIO_RXQ)->idx);
+		return -1;
+	}
+	return 0;
+}
+
+/*
+ * Check the notifications of the buffers received on the queue pair 0,
+ * with the used event index and the coalescing window.
+ */
+static int
+test_vhost_user_notify(void)
+{
+	struct vring_avail *avail = vq_avail(VIRTIO_RXQ);
+	struct vring_used *used = vq_used(VIRTIO_RXQ);
+	volatile uint16_t *used_event = &avail->ring[VRING_SIZE];
+	struct rte_mbuf *pkts[2] = { NULL, NULL };
+	eventfd_t val;
+	unsigned i;
+	int ret = -1;
+
+	for (i = 0; i < RTE_DIM(pkts); i++) {
+		pkts[i] = rte_pktmbuf_alloc(vhost_pool);
+		if (pkts[i] == NULL) {
+			printf("cannot allocate the packets\n");
+			goto free_pkts;
+		}
+		pkt_fill(rte_pktmbuf_mtod(pkts[i], uint8_t *), TEST_PKT_LEN,
+			0, i);
+		pkts[i]->data_len = TEST_PKT_LEN;
+		pkts[i]->pkt_len = TEST_PKT_LEN;
+	}
+
+	/* post the RX buffers again, and clear the notifications */
+	for (i = 0; i < TEST_NB_PKTS; i++)
+		avail->ring[(avail->idx + i) & (VRING_SIZE - 1)] = i;
+	rte_wmb();
+	avail->idx += TEST_NB_PKTS;
+	eventfd_read(call_fds[VIRTIO_RXQ], &val);
+
+	/* notified once the 4th buffer is used */
+	*used_event = used->idx + 3;
+	if (notify_enqueue(pkts, 2, 0) < 0 || notify_enqueue(pkts, 2, 1) < 0)
+		goto free_pkts;
+
+	/* not notified again within the window, but on a later call */
+	*used_event = used->idx;
+	rte_vhost_notify_window_set(test_dev, 1000000);
+	if (notify_enqueue(pkts, 2, 0) < 0)
+		goto reset_window;
+	rte_vhost_notify_window_set(test_dev, 1);
+	rte_delay_us(10);
+	if (notify_enqueue(pkts, 0, 1) < 0)
+		goto reset_window;
+
+	/* not notified before the used event index */
+	rte_vhost_notify_window_set(test_dev, 0);
+	*used_event = used->idx + 8;
+	if (notify_enqueue(pkts, 2, 0) < 0)
+		goto free_pkts;
+
+	ret = 0;
+	goto free_pkts;
+
+reset_window:
+	rte_vhost_notify_window_set(test_dev, 0);
+free_pkts:
+	for (i = 0; i < RTE_DIM(pkts); i++) {
+		if (pkts[i] != NULL)
+			rte_pktmbuf_free(pkts[i]);
+	}
+	return ret;
+}
+
+/*
+ * Dequeue the packets of the queue pair 0 with zero copy. The large packets
+ * are attached to the guest buffers, which are only given back to the guest
+ * when the mbufs are freed.
+ */
+static int
+test_vhost_user_zcopy(void)
+{
+	struct rte_mbuf *pkts[TEST_NB_PKTS];
+	struct vring_used *used = vq_used(VIRTIO_TXQ);
+	unsigned nb_rx, nb_zcopy = 0, i;
+	phys_addr_t physaddr;
+	int ret = 0;
+
+	guest_post_buffers(0, 1);
+
+	/* the large packets are copied if the memory has no physical address */
+	physaddr = rte_mem_virt2phy(mem);
+	if (physaddr == RTE_BAD_PHYS_ADDR || physaddr < (phys_addr_t)getpagesize())
+		printf("no physical address, the packets are copied\n");
+	else
+		nb_zcopy = TEST_NB_PKTS / 2;
+
+	nb_rx = rte_vhost_dequeue_burst(test_dev, VIRTIO_TXQ, vhost_pool,
+		pkts, TEST_NB_PKTS);
+	if (nb_rx != TEST_NB_PKTS) {
+		printf("%u packets dequeued\n", nb_rx);
+		ret = -1;
+	}
+
+	for (i = 0; i < nb_rx; i++) {
+		if (rte_pktmbuf_pkt_len(pkts[i]) != pkt_len(1, i) ||
+				pkt_check(rte_pktmbuf_mtod(pkts[i], uint8_t *),
+				pkt_len(1, i), 0, i) < 0) {
+			printf("bad dequeued packet %u\n", i);
+			ret = -1;
+		}
+		if ((RTE_MBUF_HAS_EXTBUF(pkts[i]) != 0) !=
+				(nb_zcopy != 0 && pkt_len(1, i) >= TEST_ZCOPY_LEN)) {
+			printf("packet %u is not dequeued as expected\n", i);
+			ret = -1;
+		}
+		if (RTE_MBUF_HAS_EXTBUF(pkts[i]) && pkts[i]->buf_physaddr !=
+				rte_mem_virt2phy(pkts[i]->buf_addr)) {
+			printf("bad physical address of packet %u\n", i);
+			ret = -1;
+		}
+	}
+
+	/* only the copied packets are given back to the guest */
+	if (used->idx != nb_rx - nb_zcopy) {
+		printf("%u buffers used instead of %u\n", used->idx,
+			nb_rx - nb_zcopy);
+		ret = -1;
+	}
+
+	/* the buffers of the freed mbufs are given back on the next dequeue */
+	for (i = 0; i < nb_rx; i++)
+		rte_pktmbuf_free(pkts[i]);
+	if (rte_vhost_dequeue_burst(test_dev, VIRTIO_TXQ, vhost_pool,
+			pkts, TEST_NB_PKTS) != 0) {
+		printf("packets dequeued from an empty queue\n");
+		ret = -1;
+	}
+	if (used->idx != nb_rx) {
+		printf("%u buffers used after free instead of %u\n",
+			used->idx, nb_rx);
+		ret = -1;
+	}
+
+	return ret;
+}
+
+/*
+ * Run a vhost-user session: connect a guest with TEST_NB_QP queue pairs,
+ * forward packets or check the zero copy dequeue, and disconnect it.
+ */
+static int
+test_vhost_user_session(int zcopy)
+{
+	char mem_path[] = "/tmp/vhost_user_autotest.XXXXXX";
+	unsigned q;
+	int ret = -1;
+
+	rte_vhost_dequeue_zero_copy_set(zcopy ? TEST_ZCOPY_LEN : 0);
+
+	test_dev = NULL;
+	test_dev_qp_nb = 0;
+	test_dev_ready = 0;
+	test_dev_destroyed = 0;
+	for (q = 0; q < TEST_NB_VQ; q++) {
+		kick_fds[q] = eventfd(0, EFD_NONBLOCK);
+		call_fds[q] = eventfd(0, EFD_NONBLOCK);
+	}
+
+	/* the guest memory is shared through a file descriptor */
+	mem_fd = mkstemp(mem_path);
+	if (mem_fd < 0) {
+		printf("cannot create %s\n", mem_path);
+		goto close_fds;
+	}
+	unlink(mem_path);
+	if (ftruncate(mem_fd, MEM_SZ) < 0) {
+		printf("cannot set the size of the guest memory\n");
+		goto close_mem;
+	}
+	mem = mmap(NULL, MEM_SZ, PROT_READ | PROT_WRITE, MAP_SHARED,
+		mem_fd, 0);
+	if (mem == MAP_FAILED) {
+		printf("cannot map the guest memory\n");
+		goto close_mem;
+	}
+
+	snprintf(sock_path, sizeof(sock_path), "/tmp/vhost_user_autotest.%d",
+		(int)getpid());
+	if (rte_vhost_driver_register(sock_path) < 0) {
+		printf("cannot register %s\n", sock_path);
+		goto unmap;
+	}
+
+	if (test_vhost_user_connect() == 0 &&
+			test_vhost_user_negotiate() == 0 &&
+			test_vhost_user_setup_vrings() == 0 &&
+			test_vhost_user_wait_ready() == 0) {
+		if (zcopy)
+			ret = test_vhost_user_zcopy();
+		else if (test_vhost_user_forward() == 0)
+			ret = test_vhost_user_notify();
+	}
+
+	if (sock_fd >= 0) {
+		close(sock_fd);
+		sock_fd = -1;
+	}
+	if (test_dev_ready && wait_flag(&test_dev_destroyed) < 0) {
+		printf("device is not destroyed\n");
+		ret = -1;
+	}
+
+	if (rte_vhost_driver_unregister(sock_path) < 0) {
+		printf("cannot unregister %s\n", sock_path);
+		ret = -1;
+	}
+	if (access(sock_path, F_OK) == 0) {
+		printf("%s is not removed\n", sock_path);
+		ret = -1;
+	}
+
+unmap:
+	munmap(mem, MEM_SZ);
+close_mem:
+	close(mem_fd);
+	mem_fd = -1;
+close_fds:
+	for (q = 0; q < TEST_NB_VQ; q++) {
+		close(kick_fds[q]);
+		close(call_fds[q]);
+	}
+	rte_vhost_dequeue_zero_copy_set(0);
+	return ret;
+}
+
+#ifdef RTE_VIRTIO_USER
+/* forward the packets sent by the PMD back to it, through the vhost library */
+static int
+virtio_user_forward(uint8_t port_id, struct rte_mempool *pmd_pool,
+		struct rte_mbuf **pkts, unsigned nb_pkts, uint64_t cycles[2],
+		int check)
+{
+	struct rte_mbuf *vhost_pkts[PERF_BURST];
+	unsigned nb, total, i, t;
+	uint64_t start;
+
+	for (i = 0; i < nb_pkts; i++) {
+		pkts[i] = rte_pktmbuf_alloc(pmd_pool);
+		if (pkts[i] == NULL) {
+			printf("cannot allocate the packets\n");
+			rte_pktmbuf_free_bulk(pkts, i);
+			return -1;
+		}
+		if (check)
+			pkt_fill(rte_pktmbuf_mtod(pkts[i], uint8_t *),
+				TEST_PKT_LEN, 0, i);
+		pkts[i]->data_len = TEST_PKT_LEN;
+		pkts[i]->pkt_len = TEST_PKT_LEN;
+	}
+
+	start = rte_rdtsc();
+	nb = rte_eth_tx_burst(port_id, 0, pkts, nb_pkts);
+	if (nb != nb_pkts) {
+		printf("%u packets sent by the PMD\n", nb);
+		rte_pktmbuf_free_bulk(pkts + nb, nb_pkts - nb);
+		return -1;
+	}
+	nb = rte_vhost_dequeue_burst(test_dev, VIRTIO_TXQ, vhost_pool,
+		vhost_pkts, nb_pkts);
+	cycles[0] += rte_rdtsc() - start;
+	if (nb != nb_pkts) {
+		printf("%u packets dequeued from the PMD\n", nb);
+		rte_pktmbuf_free_bulk(vhost_pkts, nb);
+		return -1;
+	}
+	for (i = 0; check && i < nb; i++) {
+		if (rte_pktmbuf_pkt_len(vhost_pkts[i]) != TEST_PKT_LEN ||
+				pkt_check(rte_pktmbuf_mtod(vhost_pkts[i],
+				uint8_t *), TEST_PKT_LEN, 0, i) < 0) {
+			printf("bad packet %u dequeued from the PMD\n", i);
+			rte_pktmbuf_free_bulk(vhost_pkts, nb);
+			return -1;
+		}
+	}
+
+	start = rte_rdtsc();
+	nb = rte_vhost_enqueue_burst(test_dev, VIRTIO_RXQ, vhost_pkts, nb);
+	for (total = 0, t = 0; total < nb && t < TIMEOUT_MS; t++) {
+		total += rte_eth_rx_burst(port_id, 0, pkts + total,
+			nb - total);
+		if (total < nb)
+			rte_delay_ms(1);
+	}
+	cycles[1] += rte_rdtsc() - start;
+	rte_pktmbuf_free_bulk(vhost_pkts, nb_pkts);
+	if (nb != nb_pkts || total != nb) {
+		printf("%u packets enqueued to the PMD, %u received\n",
+			nb, total);
+		rte_pktmbuf_free_bulk(pkts, total);
+		return -1;
+	}
+	for (i = 0; check && i < nb; i++) {
+		if (rte_pktmbuf_pkt_len(pkts[i]) != TEST_PKT_LEN ||
+				pkt_check(rte_pktmbuf_mtod(pkts[i], uint8_t *),
+				TEST_PKT_LEN, 0, i) < 0) {
+			printf("bad packet %u received by the PMD\n", i);
+			rte_pktmbuf_free_bulk(pkts, nb);
+			return -1;
+		}
+	}
+	rte_pktmbuf_free_bulk(pkts, nb);
+
+	return 0;
+}
+
+/*
+ * Check that each memory segment of the EAL is mapped from a single file,
+ * as virtio-user needs, which is the case with --single-file-segments.
+ */
+static int
+memsegs_mapped_from_files(void)
+{
+	const struct rte_memseg *ms = rte_eal_get_physmem_layout();
+	char line[PATH_MAX + 128];
+	uint64_t start, end;
+	unsigned i;
+	int found;
+	FILE *f;
+
+	for (i = 0; i < RTE_MAX_MEMSEG; i++) {
+		if (ms[i].addr == NULL)
+			continue;
+
+		f = fopen("/proc/self/maps", "r");
+		if (f == NULL)
+			return 0;
+		found = 0;
+		while (fgets(line, sizeof(line), f) != NULL) {
+			if (sscanf(line, "%"SCNx64"-%"SCNx64, &start,
+					&end) != 2)
+				continue;
+			if (ms[i].addr_64 >= start && ms[i].addr_64 < end) {
+				found = strchr(line, '/') != NULL &&
+					ms[i].addr_64 + ms[i].len <= end;
+				break;
+			}
+		}
+		fclose(f);
+		if (!found)
+			return 0;
+	}
+
+	return 1;
+}
+
+/*
+ * Drive the vhost library with the virtio PMD of a virtio-user port, and
+ * report the cycles per packet of both directions.
+ */
+static int
+test_vhost_user_virtio_user(void)
+{
+	struct rte_eth_conf port_conf;
+	struct rte_eth_dev_info dev_info;
+	struct rte_mempool *pmd_pool;
+	struct rte_mbuf *pkts[PERF_BURST];
+	uint64_t cycles[2] = { 0, 0 };
+	char devargs[128], name[RTE_ETH_NAME_MAX_LEN];
+	uint8_t port_id;
+	unsigned i;
+	int ret = -1;
+
+	pmd_pool = rte_mempool_lookup("virtio_user_pool");
+	if (pmd_pool == NULL)
+		pmd_pool = rte_pktmbuf_pool_create("virtio_user_pool",
+			VIRTIO_USER_NB_MBUF, 32, 0, MBUF_DATA_SIZE,
+			SOCKET_ID_ANY);
+	if (pmd_pool == NULL) {
+		printf("cannot create mbuf pool\n");
+		return -1;
+	}
+
+	if (!memsegs_mapped_from_files()) {
+		printf("the EAL memory is not mapped with "
+			"--single-file-segments: virtio-user skipped\n");
+		return 0;
+	}
+
+	test_dev = NULL;
+	test_dev_ready = 0;
+	test_dev_destroyed = 0;
+
+	snprintf(sock_path, sizeof(sock_path), "/tmp/vhost_user_autotest.%d",
+		(int)getpid());
+	if (rte_vhost_driver_register(sock_path) < 0) {
+		printf("cannot register %s\n", sock_path);
+		return -1;
+	}
+
+	snprintf(devargs, sizeof(devargs),
+		"eth_virtio_user0,path=%s,queue_size=%u", sock_path,
+		VIRTIO_USER_QUEUE_SIZE);
+	if (rte_eth_dev_attach(devargs, &port_id) < 0) {
+		printf("cannot attach virtio-user port\n");
+		goto unregister;
+	}
+
+	memset(&port_conf, 0, sizeof(port_conf));
+	rte_eth_dev_info_get(port_id, &dev_info);
+	if (rte_eth_dev_configure(port_id, 1, 1, &port_conf) < 0 ||
+			rte_eth_rx_queue_setup(port_id, 0,
+			VIRTIO_USER_QUEUE_SIZE, SOCKET_ID_ANY, NULL,
+			pmd_pool) < 0 ||
+			rte_eth_tx_queue_setup(port_id, 0,
+			VIRTIO_USER_QUEUE_SIZE, SOCKET_ID_ANY,
+			&dev_info.default_txconf) < 0) {
+		printf("cannot configure port %u\n", port_id);
+		goto detach;
+	}
+	if (rte_eth_dev_start(port_id) < 0) {
+		printf("cannot start port %u\n", port_id);
+		goto close;
+	}
+	if (wait_flag(&test_dev_ready) < 0) {
+		printf("device is not ready\n");
+		goto stop;
+	}
+
+	/* the vhost library polls the rings, the PMD does not need to kick */
+	rte_vhost_enable_guest_notification(test_dev, VIRTIO_TXQ, 0);
+
+	if (virtio_user_forward(port_id, pmd_pool, pkts, TEST_NB_PKTS,
+			cycles, 1) < 0)
+		goto stop;
+
+	cycles[0] = 0;
+	cycles[1] = 0;
+	for (i = 0; i < PERF_ITER; i++) {
+		if (virtio_user_forward(port_id, pmd_pool, pkts, PERF_BURST,
+				cycles, 0) < 0)
+			goto stop;
+	}
+	printf("virtio-user TX and vhost dequeue: %.2f cycles per packet\n",
+		(double)cycles[0] / (PERF_ITER * PERF_BURST));
+	printf("vhost enqueue and virtio-user RX: %.2f cycles per packet\n",
+		(double)cycles[1] / (PERF_ITER * PERF_BURST));
+	ret = 0;
+
+stop:
+	rte_eth_dev_stop(port_id);
+close:
+	/* resetting the device stops it in the vhost library */
+	rte_eth_dev_close(port_id);
+	if (test_dev_ready && wait_flag(&test_dev_destroyed) < 0) {
+		printf("device is not destroyed\n");
+		ret = -1;
+	}
+detach:
+	if (rte_eth_dev_detach(port_id, name) < 0) {
+		printf("cannot detach port %u\n", port_id);
+		ret = -1;
+	}
+unregister:
+	if (rte_vhost_driver_unregister(sock_path) < 0) {
+		printf("cannot unregister %s\n", sock_path);
+		ret = -1;
+	}
+	return ret;
+}
+#endif
+
+static int
+test_vhost_user(void)
+{
+	static int session_started;
+	pthread_t tid;
+
+	if (!session_started) {
+		rte_vhost_driver_callback_register(&test_vhost_ops);
+		if (pthread_create(&tid, NULL, vhost_session, NULL) != 0) {
+			printf("cannot start the vhost-user session\n");
+			return -1;
+		}
+		pthread_detach(tid);
+		session_started = 1;
+	}
+
+	vhost_pool = rte_mempool_lookup("vhost_user_pool");
+	if (vhost_pool == NULL)
+		vhost_pool = rte_pktmbuf_pool_create("vhost_user_pool",
+			NB_MBUF, 32, 0, MBUF_DATA_SIZE, SOCKET_ID_ANY);
+	if (vhost_pool == NULL) {
+		printf("cannot create mbuf pool\n");
+		return -1;
+	}
+
+	if (test_vhost_user_session(0) < 0)
+		return -1;
+	if (test_vhost_user_session(1) < 0)
+		return -1;
+#ifdef RTE_VIRTIO_USER
+	if (test_vhost_user_virtio_user() < 0)
+		return -1;
+#endif
+
+	return 0;
+}
+
+static struct test_command vhost_user_cmd = {
+	.command = "vhost_user_autotest",
+	.callback = test_vhost_user,
+};
+REGISTER_TEST_COMMAND(vhost_user_cmd);
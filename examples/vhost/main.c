@@ -1009,7 +1009,7 @@ unlink_vmdq(struct vhost_dev *vdev)
  * the packet on that devices RX queue. If not then return.
  */
 static inline int __attribute__((always_inline))
-virtio_tx_local(struct vhost_dev *vdev, struct rte_mbuf *m)
+virtio_tx_local(struct vhost_dev *vdev, uint16_t qp, struct rte_mbuf *m)
 {
 	struct virtio_net_data_ll *dev_ll;
 	struct ether_hdr *pkt_hdr;
@@ -1041,8 +1041,13 @@ virtio_tx_local(struct vhost_dev *vdev, struct rte_mbuf *m)
 				/*drop the packet if the device is marked for removal*/
 				LOG_DEBUG(VHOST_DATA, "(%"PRIu64") Device is marked for removal\n", tdev->device_fh);
 			} else {
-				/*send the packet to the local virtio device*/
-				ret = rte_vhost_enqueue_burst(tdev, VIRTIO_RXQ, &m, 1);
+				/*
+				 * Send the packet to the local virtio device, on the
+				 * queue pair matching the one it was received on.
+				 */
+				ret = rte_vhost_enqueue_burst(tdev,
+					(qp % dev_ll->vdev->nr_qp) * VIRTIO_QNUM + VIRTIO_RXQ,
+					&m, 1);
 				if (enable_stats) {
 					rte_atomic64_add(
 					&dev_statistics[tdev->device_fh].rx_total_atomic,
@@ -1119,7 +1124,8 @@ find_local_dest(struct virtio_net *dev, struct rte_mbuf *m,
  * or the physical port.
  */
 static inline void __attribute__((always_inline))
-virtio_tx_route(struct vhost_dev *vdev, struct rte_mbuf *m, uint16_t vlan_tag)
+virtio_tx_route(struct vhost_dev *vdev, uint16_t qp, struct rte_mbuf *m,
+	uint16_t vlan_tag)
 {
 	struct mbuf_table *tx_q;
 	struct rte_mbuf **m_table;
@@ -1129,7 +1135,7 @@ virtio_tx_route(struct vhost_dev *vdev, struct rte_mbuf *m, uint16_t vlan_tag)
 	struct ether_hdr *nh;
 
 	/*check if destination is local VM*/
-	if ((vm2vm_mode == VM2VM_SOFTWARE) && (virtio_tx_local(vdev, m) == 0)) {
+	if ((vm2vm_mode == VM2VM_SOFTWARE) && (virtio_tx_local(vdev, qp, m) == 0)) {
 		rte_pktmbuf_free(m);
 		return;
 	}
@@ -1225,6 +1231,7 @@ switch_worker(__attribute__((unused)) void *arg)
 	const uint16_t num_cores = (uint16_t)rte_lcore_count();
 	uint16_t rx_count = 0;
 	uint16_t tx_count;
+	uint16_t qp, rxq, txq;
 	uint32_t retry = 0;
 
 	RTE_LOG(INFO, VHOST_DATA, "Procesing on Core %u started\n", lcore_id);
@@ -1284,14 +1291,25 @@ switch_worker(__attribute__((unused)) void *arg)
 			/*get virtio device ID*/
 			vdev = dev_ll->vdev;
 			dev = vdev->dev;
+			qp = dev_ll->qp;
+			rxq = qp * VIRTIO_QNUM + VIRTIO_RXQ;
+			txq = qp * VIRTIO_QNUM + VIRTIO_TXQ;
 
 			if (unlikely(vdev->remove)) {
 				dev_ll = dev_ll->next;
-				unlink_vmdq(vdev);
-				vdev->ready = DEVICE_SAFE_REMOVE;
+				/*
+				 * The VMDQ queue and the MAC address belong to
+				 * queue pair 0, the other entries are just skipped
+				 * until destroy_device() removes them.
+				 */
+				if (qp == 0) {
+					unlink_vmdq(vdev);
+					vdev->ready = DEVICE_SAFE_REMOVE;
+				}
 				continue;
 			}
-			if (likely(vdev->ready == DEVICE_RX)) {
+			/* Packets from the NIC are only delivered to queue pair 0. */
+			if (likely(vdev->ready == DEVICE_RX) && qp == 0) {
 				/*Handle guest RX*/
 				rx_count = rte_eth_rx_burst(ports[0],
 					vdev->vmdq_rx_q, pkts_burst, MAX_PKT_BURST);
@@ -1301,14 +1319,14 @@ switch_worker(__attribute__((unused)) void *arg)
 					* Retry is enabled and the queue is full then we wait and retry to avoid packet loss
 					* Here MAX_PKT_BURST must be less than virtio queue size
 					*/
-					if (enable_retry && unlikely(rx_count > rte_vring_available_entries(dev, VIRTIO_RXQ))) {
+					if (enable_retry && unlikely(rx_count > rte_vring_available_entries(dev, rxq))) {
 						for (retry = 0; retry < burst_rx_retry_num; retry++) {
 							rte_delay_us(burst_rx_delay_time);
-							if (rx_count <= rte_vring_available_entries(dev, VIRTIO_RXQ))
+							if (rx_count <= rte_vring_available_entries(dev, rxq))
 								break;
 						}
 					}
-					ret_count = rte_vhost_enqueue_burst(dev, VIRTIO_RXQ, pkts_burst, rx_count);
+					ret_count = rte_vhost_enqueue_burst(dev, rxq, pkts_burst, rx_count);
 					if (enable_stats) {
 						rte_atomic64_add(
 						&dev_statistics[dev_ll->vdev->dev->device_fh].rx_total_atomic,
@@ -1324,9 +1342,14 @@ switch_worker(__attribute__((unused)) void *arg)
 				}
 			}
 
-			if (likely(!vdev->remove)) {
+			/*
+			 * Only queue pair 0 learns the MAC address, the other
+			 * queue pairs wait for the device to be ready.
+			 */
+			if (likely(!vdev->remove) &&
+					(qp == 0 || vdev->ready == DEVICE_RX)) {
 				/* Handle guest TX*/
-				tx_count = rte_vhost_dequeue_burst(dev, VIRTIO_TXQ, mbuf_pool, pkts_burst, MAX_PKT_BURST);
+				tx_count = rte_vhost_dequeue_burst(dev, txq, mbuf_pool, pkts_burst, MAX_PKT_BURST);
 				/* If this is the first received packet we need to learn the MAC and setup VMDQ */
 				if (unlikely(vdev->ready == DEVICE_MAC_LEARNING) && tx_count) {
 					if (vdev->remove || (link_vmdq(vdev, pkts_burst[0]) == -1)) {
@@ -1335,7 +1358,7 @@ switch_worker(__attribute__((unused)) void *arg)
 					}
 				}
 				while (tx_count)
-					virtio_tx_route(vdev, pkts_burst[--tx_count], (uint16_t)dev->device_fh);
+					virtio_tx_route(vdev, qp, pkts_burst[--tx_count], (uint16_t)dev->device_fh);
 			}
 
 			/*move to the next device in the list*/
@@ -2280,12 +2303,14 @@ alloc_data_ll(uint32_t size)
 
 /*
  * Create the main linked list along with each individual cores linked list. A used and a free list
- * are created to manage entries.
+ * are created to manage entries. The main linked list has an entry per device, the core linked
+ * lists have an entry per queue pair of a device.
  */
 static int
 init_data_ll (void)
 {
 	int lcore;
+	uint32_t num_entries = num_devices * VHOST_MAX_QUEUE_PAIRS;
 
 	RTE_LCORE_FOREACH_SLAVE(lcore) {
 		lcore_info[lcore].lcore_ll = malloc(sizeof(struct lcore_ll_info));
@@ -2297,10 +2322,10 @@ init_data_ll (void)
 		lcore_info[lcore].lcore_ll->device_num = 0;
 		lcore_info[lcore].lcore_ll->dev_removal_flag = ACK_DEV_REMOVAL;
 		lcore_info[lcore].lcore_ll->ll_root_used = NULL;
-		if (num_devices % num_switching_cores)
-			lcore_info[lcore].lcore_ll->ll_root_free = alloc_data_ll((num_devices / num_switching_cores) + 1);
+		if (num_entries % num_switching_cores)
+			lcore_info[lcore].lcore_ll->ll_root_free = alloc_data_ll((num_entries / num_switching_cores) + 1);
 		else
-			lcore_info[lcore].lcore_ll->ll_root_free = alloc_data_ll(num_devices / num_switching_cores);
+			lcore_info[lcore].lcore_ll->ll_root_free = alloc_data_ll(num_entries / num_switching_cores);
 	}
 
 	/* Allocate devices up to a maximum of MAX_DEVICES. */
@@ -2321,8 +2346,10 @@ destroy_device (volatile struct virtio_net *dev)
 	struct virtio_net_data_ll *ll_main_dev_cur;
 	struct virtio_net_data_ll *ll_lcore_dev_last = NULL;
 	struct virtio_net_data_ll *ll_main_dev_last = NULL;
+	struct virtio_net_data_ll *ll_lcore_devs[VHOST_MAX_QUEUE_PAIRS];
 	struct vhost_dev *vdev;
 	int lcore;
+	uint16_t qp;
 
 	dev->flags &= ~VIRTIO_DEV_RUNNING;
 
@@ -2333,22 +2360,30 @@ destroy_device (volatile struct virtio_net *dev)
 		rte_pause();
 	}
 
-	/* Search for entry to be removed from lcore ll */
-	ll_lcore_dev_cur = lcore_info[vdev->coreid].lcore_ll->ll_root_used;
-	while (ll_lcore_dev_cur != NULL) {
-		if (ll_lcore_dev_cur->vdev == vdev) {
-			break;
-		} else {
-			ll_lcore_dev_last = ll_lcore_dev_cur;
-			ll_lcore_dev_cur = ll_lcore_dev_cur->next;
+	/* Remove the entries of all queue pairs from the lcore lls. */
+	for (qp = 0; qp < vdev->nr_qp; qp++) {
+		ll_lcore_dev_last = NULL;
+		ll_lcore_dev_cur = lcore_info[vdev->coreid[qp]].lcore_ll->ll_root_used;
+		while (ll_lcore_dev_cur != NULL) {
+			if (ll_lcore_dev_cur->vdev == vdev &&
+					ll_lcore_dev_cur->qp == qp) {
+				break;
+			} else {
+				ll_lcore_dev_last = ll_lcore_dev_cur;
+				ll_lcore_dev_cur = ll_lcore_dev_cur->next;
+			}
 		}
-	}
 
-	if (ll_lcore_dev_cur == NULL) {
-		RTE_LOG(ERR, VHOST_CONFIG,
-			"(%"PRIu64") Failed to find the dev to be destroy.\n",
-			dev->device_fh);
-		return;
+		if (ll_lcore_dev_cur == NULL) {
+			RTE_LOG(ERR, VHOST_CONFIG,
+				"(%"PRIu64") Failed to find the dev to be destroy.\n",
+				dev->device_fh);
+			return;
+		}
+
+		rm_data_ll_entry(&lcore_info[vdev->coreid[qp]].lcore_ll->ll_root_used,
+			ll_lcore_dev_cur, ll_lcore_dev_last);
+		ll_lcore_devs[qp] = ll_lcore_dev_cur;
 	}
 
 	/* Search for entry to be removed from main ll */
@@ -2363,8 +2398,7 @@ destroy_device (volatile struct virtio_net *dev)
 		}
 	}
 
-	/* Remove entries from the lcore and main ll. */
-	rm_data_ll_entry(&lcore_info[vdev->coreid].lcore_ll->ll_root_used, ll_lcore_dev_cur, ll_lcore_dev_last);
+	/* Remove entry from the main ll. */
 	rm_data_ll_entry(&ll_root_used, ll_main_dev_cur, ll_main_dev_last);
 
 	/* Set the dev_removal_flag on each lcore. */
@@ -2384,11 +2418,14 @@ destroy_device (volatile struct virtio_net *dev)
 	}
 
 	/* Add the entries back to the lcore and main free ll.*/
-	put_data_ll_free_entry(&lcore_info[vdev->coreid].lcore_ll->ll_root_free, ll_lcore_dev_cur);
-	put_data_ll_free_entry(&ll_root_free, ll_main_dev_cur);
+	for (qp = 0; qp < vdev->nr_qp; qp++) {
+		put_data_ll_free_entry(&lcore_info[vdev->coreid[qp]].lcore_ll->ll_root_free,
+			ll_lcore_devs[qp]);
 
-	/* Decrement number of device on the lcore. */
-	lcore_info[vdev->coreid].lcore_ll->device_num--;
+		/* Decrement number of device on the lcore. */
+		lcore_info[vdev->coreid[qp]].lcore_ll->device_num--;
+	}
+	put_data_ll_free_entry(&ll_root_free, ll_main_dev_cur);
 
 	RTE_LOG(INFO, VHOST_DATA, "(%"PRIu64") Device has been removed from data core\n", dev->device_fh);
 
@@ -2589,10 +2626,11 @@ static int
 new_device (struct virtio_net *dev)
 {
 	struct virtio_net_data_ll *ll_dev;
-	int lcore, core_add = 0;
-	uint32_t device_num_min = num_devices;
+	int lcore, core_add;
+	uint32_t device_num_min;
 	struct vhost_dev *vdev;
 	uint32_t regionidx;
+	uint16_t qp, nr_qp;
 
 	vdev = rte_zmalloc("vhost device", sizeof(*vdev), RTE_CACHE_LINE_SIZE);
 	if (vdev == NULL) {
@@ -2733,39 +2771,62 @@ new_device (struct virtio_net *dev)
 	vdev->ready = DEVICE_MAC_LEARNING;
 	vdev->remove = 0;
 
-	/* Find a suitable lcore to add the device. */
-	RTE_LCORE_FOREACH_SLAVE(lcore) {
-		if (lcore_info[lcore].lcore_ll->device_num < device_num_min) {
-			device_num_min = lcore_info[lcore].lcore_ll->device_num;
-			core_add = lcore;
+	/*
+	 * Zero copy relies on a single VMDQ queue per device, so only the
+	 * first queue pair is served in that mode.
+	 */
+	nr_qp = zero_copy ? 1 : rte_vhost_get_queue_num(dev);
+	vdev->nr_qp = 0;
+
+	/*
+	 * Add each queue pair to the least loaded lcore, so that the queue
+	 * pairs of a device are spread over the data cores.
+	 */
+	for (qp = 0; qp < nr_qp; qp++) {
+		device_num_min = UINT32_MAX;
+		core_add = 0;
+		RTE_LCORE_FOREACH_SLAVE(lcore) {
+			if (lcore_info[lcore].lcore_ll->device_num < device_num_min) {
+				device_num_min = lcore_info[lcore].lcore_ll->device_num;
+				core_add = lcore;
+			}
 		}
+		/* Add queue pair to lcore ll */
+		ll_dev = get_data_ll_free_entry(&lcore_info[core_add].lcore_ll->ll_root_free);
+		if (ll_dev == NULL)
+			break;
+		ll_dev->vdev = vdev;
+		ll_dev->qp = qp;
+		vdev->coreid[qp] = core_add;
+		vdev->nr_qp++;
+
+		add_data_ll_entry(&lcore_info[core_add].lcore_ll->ll_root_used, ll_dev);
+		lcore_info[core_add].lcore_ll->device_num++;
+
+		RTE_LOG(INFO, VHOST_DATA, "(%"PRIu64") Queue pair %u has been added to data core %d\n",
+			dev->device_fh, qp, core_add);
 	}
-	/* Add device to lcore ll */
-	ll_dev = get_data_ll_free_entry(&lcore_info[core_add].lcore_ll->ll_root_free);
-	if (ll_dev == NULL) {
+
+	if (vdev->nr_qp == 0) {
 		RTE_LOG(INFO, VHOST_DATA, "(%"PRIu64") Failed to add device to data core\n", dev->device_fh);
 		vdev->ready = DEVICE_SAFE_REMOVE;
 		destroy_device(dev);
-		rte_free(vdev->regions_hpa);
-		rte_free(vdev);
 		return -1;
 	}
-	ll_dev->vdev = vdev;
-	vdev->coreid = core_add;
-
-	add_data_ll_entry(&lcore_info[vdev->coreid].lcore_ll->ll_root_used, ll_dev);
+	if (vdev->nr_qp < nr_qp)
+		RTE_LOG(INFO, VHOST_DATA, "(%"PRIu64") Only %u queue pairs out of %u are served\n",
+			dev->device_fh, vdev->nr_qp, nr_qp);
 
 	/* Initialize device stats */
 	memset(&dev_statistics[dev->device_fh], 0, sizeof(struct device_statistics));
 
 	/* Disable notifications. */
-	rte_vhost_enable_guest_notification(dev, VIRTIO_RXQ, 0);
-	rte_vhost_enable_guest_notification(dev, VIRTIO_TXQ, 0);
-	lcore_info[vdev->coreid].lcore_ll->device_num++;
+	for (qp = 0; qp < vdev->nr_qp; qp++) {
+		rte_vhost_enable_guest_notification(dev, qp * VIRTIO_QNUM + VIRTIO_RXQ, 0);
+		rte_vhost_enable_guest_notification(dev, qp * VIRTIO_QNUM + VIRTIO_TXQ, 0);
+	}
 	dev->flags |= VIRTIO_DEV_RUNNING;
 
-	RTE_LOG(INFO, VHOST_DATA, "(%"PRIu64") Device has been added to data core %d\n", dev->device_fh, vdev->coreid);
-
 	return 0;
 }
 
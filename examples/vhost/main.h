@@ -82,8 +82,10 @@ struct vhost_dev {
 	uint16_t vmdq_rx_q;
 	/**< Vlan tag assigned to the pool */
 	uint32_t vlan_tag;
-	/**< Data core that the device is added to. */
-	uint16_t coreid;
+	/**< Number of queue pairs of the device served by the data cores. */
+	uint16_t nr_qp;
+	/**< Data cores that the queue pairs of the device are added to. */
+	uint16_t coreid[VHOST_MAX_QUEUE_PAIRS];
 	/**< A device is set as ready if the MAC address has been set. */
 	volatile uint8_t ready;
 	/**< Device is marked for removal from the data core. */
@@ -94,6 +96,7 @@ struct virtio_net_data_ll
 {
 	struct vhost_dev		*vdev;	/* Pointer to device created by configuration core. */
 	struct virtio_net_data_ll	*next;  /* Pointer to next device in linked list. */
+	uint16_t			qp;	/* Queue pair of the device served by this entry. */
 };
 
 /*
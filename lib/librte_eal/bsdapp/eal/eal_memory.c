@@ -53,10 +53,10 @@
 phys_addr_t
 rte_mem_virt2phy(const void *virtaddr)
 {
-	/* XXX not implemented. This function is only used by
+	/* XXX only implemented for memory registered with
+	 * rte_extmem_register(). This function is only used by
 	 * rte_mempool_virt2phy() when hugepages are disabled. */
-	(void)virtaddr;
-	return RTE_BAD_PHYS_ADDR;
+	return rte_extmem_virt2iova(virtaddr);
 }
 
 static int
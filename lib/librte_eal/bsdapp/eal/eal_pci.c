@@ -490,6 +490,19 @@ rte_eal_pci_probe_one_driver(struct rte_pci_driver *dr, struct rte_pci_device *d
 	return 1;
 }
 
+/* no IOMMU is used on FreeBSD, the I/O addresses are the physical ones */
+int
+rte_eal_extmem_dma_map(const struct rte_extmem *ext __rte_unused)
+{
+	return 0;
+}
+
+int
+rte_eal_extmem_dma_unmap(const struct rte_extmem *ext __rte_unused)
+{
+	return 0;
+}
+
 /* Init the PCI EAL subsystem */
 int
 rte_eal_pci_init(void)
@@ -36,6 +36,8 @@
 #include <stdlib.h>
 #include <stdarg.h>
 #include <inttypes.h>
+#include <string.h>
+#include <errno.h>
 #include <sys/queue.h>
 
 #include <rte_memory.h>
@@ -43,6 +45,7 @@
 #include <rte_eal.h>
 #include <rte_eal_memconfig.h>
 #include <rte_log.h>
+#include <rte_atomic.h>
 
 #include "eal_private.h"
 
@@ -105,6 +108,14 @@ rte_dump_physmem_layout(FILE *f)
 		       mcfg->memseg[i].nchannel,
 		       mcfg->memseg[i].nrank);
 	}
+
+	for (i = 0; i < mcfg->nb_extmem; i++) {
+		fprintf(f, "External area %u: virt:%p, len:%"PRIu64", "
+		       "page_sz:%"PRIu64"\n", i,
+		       mcfg->extmem[i].addr,
+		       mcfg->extmem[i].len,
+		       mcfg->extmem[i].page_sz);
+	}
 }
 
 /* return the number of memory channels */
@@ -118,3 +129,158 @@ unsigned rte_memory_get_nrank(void)
 {
 	return rte_eal_get_configuration()->mem_config->nrank;
 }
+
+/* register an area of memory mapped by the application */
+int
+rte_extmem_register(void *va_addr, size_t len,
+		const phys_addr_t iova_addrs[], unsigned n_pages, size_t page_sz)
+{
+	struct rte_mem_config *mcfg;
+	const struct rte_memzone *mz;
+	struct rte_extmem *ext;
+	uintptr_t start = (uintptr_t)va_addr;
+	char mz_name[RTE_MEMZONE_NAMESIZE];
+	unsigned i;
+	int ret = 0;
+
+	if (va_addr == NULL || len == 0 || iova_addrs == NULL ||
+			page_sz == 0 || (page_sz & (page_sz - 1)) != 0 ||
+			(start & (page_sz - 1)) != 0 ||
+			(len & (page_sz - 1)) != 0 ||
+			len / page_sz != n_pages) {
+		RTE_LOG(ERR, EAL, "%s(): invalid parameters\n", __func__);
+		return -EINVAL;
+	}
+
+	/* get pointer to global configuration */
+	mcfg = rte_eal_get_configuration()->mem_config;
+
+	rte_rwlock_write_lock(&mcfg->extlock);
+
+	for (i = 0; i < mcfg->nb_extmem; i++) {
+		ext = &mcfg->extmem[i];
+		if (start < ext->addr_64 + ext->len &&
+				ext->addr_64 < start + len) {
+			RTE_LOG(ERR, EAL, "%s(): area %p overlaps area %p\n",
+				__func__, va_addr, ext->addr);
+			ret = -EEXIST;
+			goto out;
+		}
+	}
+
+	if (mcfg->nb_extmem == RTE_MAX_EXTMEM) {
+		RTE_LOG(ERR, EAL, "%s(): no more room for external memory, "
+			"increase RTE_MAX_EXTMEM\n", __func__);
+		ret = -ENOSPC;
+		goto out;
+	}
+
+	snprintf(mz_name, sizeof(mz_name), "EXTMEM_%p", va_addr);
+	mz = rte_memzone_reserve(mz_name, n_pages * sizeof(phys_addr_t),
+		SOCKET_ID_ANY, 0);
+	if (mz == NULL) {
+		RTE_LOG(ERR, EAL, "%s(): cannot allocate I/O address table of "
+			"%u pages\n", __func__, n_pages);
+		ret = -ENOMEM;
+		goto out;
+	}
+	memcpy(mz->addr, iova_addrs, n_pages * sizeof(phys_addr_t));
+
+	ext = &mcfg->extmem[mcfg->nb_extmem];
+	ext->addr = va_addr;
+	ext->len = len;
+	ext->page_sz = page_sz;
+	ext->iova_mz = mz;
+
+	/* devices behind an IOMMU can only reach the area once it is mapped */
+	if (rte_eal_extmem_dma_map(ext) < 0) {
+		RTE_LOG(ERR, EAL, "%s(): cannot map area %p for DMA\n",
+			__func__, va_addr);
+		memset(ext, 0, sizeof(*ext));
+		rte_memzone_free(mz);
+		ret = -EIO;
+		goto out;
+	}
+	rte_wmb();
+	mcfg->nb_extmem++;
+
+out:
+	rte_rwlock_write_unlock(&mcfg->extlock);
+	return ret;
+}
+
+/* unregister an area of memory mapped by the application */
+int
+rte_extmem_unregister(void *va_addr, size_t len)
+{
+	struct rte_mem_config *mcfg;
+	struct rte_extmem *ext;
+	unsigned i;
+	int ret = -ENOENT;
+
+	/* get pointer to global configuration */
+	mcfg = rte_eal_get_configuration()->mem_config;
+
+	rte_rwlock_write_lock(&mcfg->extlock);
+
+	for (i = 0; i < mcfg->nb_extmem; i++) {
+		ext = &mcfg->extmem[i];
+		if (ext->addr != va_addr || ext->len != len)
+			continue;
+
+		if (rte_eal_extmem_dma_unmap(ext) < 0) {
+			RTE_LOG(ERR, EAL, "%s(): cannot unmap area %p for "
+				"DMA\n", __func__, va_addr);
+			ret = -EIO;
+			break;
+		}
+		rte_memzone_free(ext->iova_mz);
+		/* keep the table compact, order does not matter */
+		mcfg->nb_extmem--;
+		if (i != mcfg->nb_extmem)
+			*ext = mcfg->extmem[mcfg->nb_extmem];
+		memset(&mcfg->extmem[mcfg->nb_extmem], 0, sizeof(*ext));
+		ret = 0;
+		break;
+	}
+
+	rte_rwlock_write_unlock(&mcfg->extlock);
+	return ret;
+}
+
+/* get the I/O address of a virtual address in external memory */
+phys_addr_t
+rte_extmem_virt2iova(const void *virt)
+{
+	struct rte_mem_config *mcfg;
+	const struct rte_extmem *ext;
+	const phys_addr_t *iova_tbl;
+	uintptr_t addr = (uintptr_t)virt;
+	phys_addr_t iova = RTE_BAD_PHYS_ADDR;
+	uint64_t off;
+	unsigned i;
+
+	/* get pointer to global configuration, it can be used by the memory
+	 * init before the configuration is set up */
+	mcfg = rte_eal_get_configuration()->mem_config;
+	if (mcfg == NULL || mcfg->nb_extmem == 0)
+		return RTE_BAD_PHYS_ADDR;
+
+	rte_rwlock_read_lock(&mcfg->extlock);
+
+	for (i = 0; i < mcfg->nb_extmem; i++) {
+		ext = &mcfg->extmem[i];
+		if (addr < ext->addr_64 || addr >= ext->addr_64 + ext->len)
+			continue;
+
+		off = addr - ext->addr_64;
+		iova_tbl = ext->iova_mz->addr;
+		iova = iova_tbl[off / ext->page_sz];
+		if (iova != RTE_BAD_PHYS_ADDR)
+			iova += off & (ext->page_sz - 1);
+		break;
+	}
+
+	rte_rwlock_read_unlock(&mcfg->extlock);
+	return iova;
+}
@@ -55,27 +55,289 @@
 /* internal copy of free memory segments */
 static struct rte_memseg *free_memseg = NULL;
 
+/*
+ * States of the entries of the memzone registry. The entries of reserved
+ * memzones are linked in the buckets of the name hash table, the other
+ * ones either in the unused list or in the list of free areas.
+ */
+#define MEMZONE_ENTRY_UNUSED 0 /**< Entry not describing anything. */
+#define MEMZONE_ENTRY_ZONE   1 /**< Reserved memzone. */
+#define MEMZONE_ENTRY_FIXED  2 /**< Memzone that cannot be freed. */
+#define MEMZONE_ENTRY_AREA   3 /**< Memory released by a freed memzone. */
+
+/* index terminating the lists of entries */
+#define MEMZONE_ENTRY_NONE UINT32_MAX
+
+/* get an entry of the registry from its index */
+static inline struct rte_memzone_entry *
+memzone_entry(struct rte_mem_config *mcfg, uint32_t idx)
+{
+	struct rte_memzone_entry *tbl;
+
+	/* the first table may be mapped at another address by secondaries */
+	if (idx < RTE_MAX_MEMZONE)
+		return &mcfg->memzone[idx];
+
+	tbl = (struct rte_memzone_entry *)(uintptr_t)
+		mcfg->memzone_tbl[idx / RTE_MAX_MEMZONE];
+	return &tbl[idx % RTE_MAX_MEMZONE];
+}
+
+/* get the index of an entry from the address of its descriptor */
+static uint32_t
+memzone_entry_idx(struct rte_mem_config *mcfg, const struct rte_memzone *mz)
+{
+	const size_t tbl_len = sizeof(struct rte_memzone_entry) *
+		RTE_MAX_MEMZONE;
+	uintptr_t addr = (uintptr_t)mz;
+	uintptr_t base;
+	uint32_t i;
+
+	for (i = 0; i < mcfg->memzone_nb_tbl; i++) {
+		if (i == 0)
+			base = (uintptr_t)mcfg->memzone;
+		else
+			base = (uintptr_t)mcfg->memzone_tbl[i];
+
+		if (addr < base || addr >= base + tbl_len)
+			continue;
+		if ((addr - base) % sizeof(struct rte_memzone_entry) != 0)
+			break;
+		return i * RTE_MAX_MEMZONE +
+			(addr - base) / sizeof(struct rte_memzone_entry);
+	}
+
+	return MEMZONE_ENTRY_NONE;
+}
+
+/*
+ * Add a table of entries to the registry. Tables are taken from the free
+ * memory segments and are never released, as other processes may hold
+ * pointers to their descriptors.
+ */
+static int
+memzone_table_add(struct rte_mem_config *mcfg)
+{
+	const size_t len = RTE_ALIGN_CEIL(sizeof(struct rte_memzone_entry) *
+		RTE_MAX_MEMZONE, RTE_CACHE_LINE_SIZE);
+	struct rte_memseg *ms = NULL;
+	void *tbl;
+	unsigned i;
+
+	if (mcfg->memzone_nb_tbl == RTE_MEMZONE_MAX_TABLES)
+		return -1;
+
+	/* find the smallest segment that can hold the table */
+	for (i = 0; i < RTE_MAX_MEMSEG; i++) {
+		if (free_memseg[i].addr == NULL)
+			break;
+		if (free_memseg[i].len < len)
+			continue;
+		if (ms == NULL || free_memseg[i].len < ms->len)
+			ms = &free_memseg[i];
+	}
+	if (ms == NULL)
+		return -1;
+
+	/* take it from the end, away from the zones that may be freed */
+	ms->len -= len;
+	tbl = RTE_PTR_ADD(ms->addr, ms->len);
+	memset(tbl, 0, len);
+	mcfg->memzone_tbl[mcfg->memzone_nb_tbl++] = (uintptr_t)tbl;
+
+	return 0;
+}
+
+/*
+ * Get an unused entry of the registry, adding a table to the registry if
+ * all of them are used and grow is set. Return its index, or
+ * MEMZONE_ENTRY_NONE if there is no more room.
+ */
+static uint32_t
+memzone_entry_get(struct rte_mem_config *mcfg, int grow)
+{
+	struct rte_memzone_entry *e;
+	uint32_t idx;
+
+	if (mcfg->memzone_unused != MEMZONE_ENTRY_NONE) {
+		idx = mcfg->memzone_unused;
+		mcfg->memzone_unused = memzone_entry(mcfg, idx)->next;
+	} else {
+		if (mcfg->memzone_idx ==
+				mcfg->memzone_nb_tbl * RTE_MAX_MEMZONE &&
+				(grow == 0 || memzone_table_add(mcfg) < 0))
+			return MEMZONE_ENTRY_NONE;
+		idx = mcfg->memzone_idx++;
+	}
+
+	e = memzone_entry(mcfg, idx);
+	memset(e, 0, sizeof(*e));
+	e->next = MEMZONE_ENTRY_NONE;
+
+	return idx;
+}
+
+/* put back an entry in the unused list */
+static void
+memzone_entry_put(struct rte_mem_config *mcfg, uint32_t idx)
+{
+	struct rte_memzone_entry *e = memzone_entry(mcfg, idx);
+
+	memset(&e->mz, 0, sizeof(e->mz));
+	e->state = MEMZONE_ENTRY_UNUSED;
+	e->next = mcfg->memzone_unused;
+	mcfg->memzone_unused = idx;
+}
+
+/* select the bucket of a memzone name (FNV-1a hash) */
+static inline uint32_t
+memzone_name_hash(const char *name)
+{
+	uint32_t hash = 2166136261U;
+	unsigned i;
+
+	for (i = 0; i < RTE_MEMZONE_NAMESIZE && name[i] != '\0'; i++) {
+		hash ^= (unsigned char)name[i];
+		hash *= 16777619U;
+	}
+
+	return hash & (RTE_MEMZONE_HASH_SIZE - 1);
+}
+
+/* add a memzone in its bucket of the name hash table */
+static void
+memzone_hash_add(struct rte_mem_config *mcfg, uint32_t idx)
+{
+	struct rte_memzone_entry *e = memzone_entry(mcfg, idx);
+	uint32_t bucket = memzone_name_hash(e->mz.name);
+
+	e->next = mcfg->memzone_hash[bucket];
+	mcfg->memzone_hash[bucket] = idx;
+}
+
+/* remove a memzone from its bucket of the name hash table */
+static void
+memzone_hash_del(struct rte_mem_config *mcfg, uint32_t idx)
+{
+	struct rte_memzone_entry *e = memzone_entry(mcfg, idx);
+	uint32_t bucket = memzone_name_hash(e->mz.name);
+	uint32_t prev = MEMZONE_ENTRY_NONE;
+	uint32_t cur = mcfg->memzone_hash[bucket];
+
+	while (cur != idx) {
+		prev = cur;
+		cur = memzone_entry(mcfg, cur)->next;
+	}
+
+	if (prev == MEMZONE_ENTRY_NONE)
+		mcfg->memzone_hash[bucket] = e->next;
+	else
+		memzone_entry(mcfg, prev)->next = e->next;
+}
+
 static inline const struct rte_memzone *
 memzone_lookup_thread_unsafe(const char *name)
 {
-	const struct rte_mem_config *mcfg;
-	unsigned i = 0;
+	struct rte_mem_config *mcfg;
+	struct rte_memzone_entry *e;
+	uint32_t idx;
 
 	/* get pointer to global configuration */
 	mcfg = rte_eal_get_configuration()->mem_config;
 
-	/*
-	 * the algorithm is not optimal (linear), but there are few
-	 * zones and this function should be called at init only
-	 */
-	for (i = 0; i < RTE_MAX_MEMZONE && mcfg->memzone[i].addr != NULL; i++) {
-		if (!strncmp(name, mcfg->memzone[i].name, RTE_MEMZONE_NAMESIZE))
-			return &mcfg->memzone[i];
+	idx = mcfg->memzone_hash[memzone_name_hash(name)];
+	while (idx != MEMZONE_ENTRY_NONE) {
+		e = memzone_entry(mcfg, idx);
+		if (!strncmp(name, e->mz.name, RTE_MEMZONE_NAMESIZE))
+			return &e->mz;
+		idx = e->next;
 	}
 
 	return NULL;
 }
 
+/*
+ * Add an area of free memory in the list of free areas. If the registry
+ * has no unused entry left, the memory of the area is lost.
+ */
+static void
+memzone_area_add(struct rte_mem_config *mcfg, const struct rte_memzone *area)
+{
+	struct rte_memzone_entry *e;
+	uint32_t idx;
+
+	idx = memzone_entry_get(mcfg, 0);
+	if (idx == MEMZONE_ENTRY_NONE) {
+		RTE_LOG(DEBUG, EAL, "%s(): No room in config, losing %zu bytes "
+			"at %p\n", __func__, area->len, area->addr);
+		return;
+	}
+
+	e = memzone_entry(mcfg, idx);
+	e->mz = *area;
+	memset(e->mz.name, 0, sizeof(e->mz.name));
+	e->state = MEMZONE_ENTRY_AREA;
+	e->next = mcfg->memzone_areas;
+	mcfg->memzone_areas = idx;
+}
+
+/* remove an area from the list of free areas, and put back its entry */
+static void
+memzone_area_del(struct rte_mem_config *mcfg, uint32_t prev, uint32_t idx)
+{
+	struct rte_memzone_entry *e = memzone_entry(mcfg, idx);
+
+	if (prev == MEMZONE_ENTRY_NONE)
+		mcfg->memzone_areas = e->next;
+	else
+		memzone_entry(mcfg, prev)->next = e->next;
+
+	memzone_entry_put(mcfg, idx);
+}
+
+/*
+ * Release the memory of a freed memzone. It is merged with the free areas
+ * just before and after it, then given back to its memory segment if it
+ * ends where the free part of the segment starts.
+ */
+static void
+memzone_area_release(struct rte_mem_config *mcfg, struct rte_memzone *area)
+{
+	struct rte_memseg *ms = &free_memseg[area->memseg_id];
+	struct rte_memzone_entry *e;
+	uint32_t prev = MEMZONE_ENTRY_NONE;
+	uint32_t idx, next;
+
+	for (idx = mcfg->memzone_areas; idx != MEMZONE_ENTRY_NONE;
+			idx = next) {
+		e = memzone_entry(mcfg, idx);
+		next = e->next;
+
+		if (e->mz.memseg_id != area->memseg_id ||
+				(e->mz.addr_64 + e->mz.len != area->addr_64 &&
+				area->addr_64 + area->len != e->mz.addr_64)) {
+			prev = idx;
+			continue;
+		}
+
+		if (e->mz.addr_64 < area->addr_64) {
+			area->addr_64 = e->mz.addr_64;
+			area->phys_addr = e->mz.phys_addr;
+		}
+		area->len += e->mz.len;
+		memzone_area_del(mcfg, prev, idx);
+	}
+
+	if (area->addr_64 + area->len == ms->addr_64) {
+		ms->addr_64 = area->addr_64;
+		ms->phys_addr = area->phys_addr;
+		ms->len += area->len;
+		return;
+	}
+
+	memzone_area_add(mcfg, area);
+}
+
 /*
  * Return a pointer to a correctly filled memzone descriptor. If the
  * allocation cannot be done, return NULL.
@@ -123,29 +385,99 @@ align_phys_boundary(const struct rte_memseg *ms, size_t len, size_t align,
 	return (addr_offset);
 }
 
+/* best range of free memory found for a memzone */
+struct memzone_fit {
+	int found;          /**< A range was found. */
+	int is_area;        /**< Range is a free area, not a free memseg. */
+	uint32_t idx;       /**< Index of the free memseg or area entry. */
+	size_t len;         /**< Length of the range. */
+	uint64_t offset;    /**< Offset of the zone in the range. */
+};
+
+/*
+ * Check if a range of free memory matches the requirements of a memzone,
+ * and keep it in fit if it is the best one until now.
+ */
+static void
+memzone_fit_check(struct memzone_fit *fit, const struct rte_memseg *ms,
+		int is_area, uint32_t idx, size_t len, size_t requested_len,
+		int socket_id, unsigned flags, unsigned align, unsigned bound)
+{
+	uint64_t addr_offset;
+
+	/* empty segment, skip it */
+	if (ms->len == 0)
+		return;
+
+	/* bad socket ID */
+	if (socket_id != SOCKET_ID_ANY &&
+	    ms->socket_id != SOCKET_ID_ANY &&
+	    socket_id != ms->socket_id)
+		return;
+
+	/*
+	 * calculate offset to closest alignment that
+	 * meets boundary conditions.
+	 */
+	addr_offset = align_phys_boundary(ms, requested_len, align, bound);
+
+	/* check len */
+	if ((requested_len + addr_offset) > ms->len)
+		return;
+
+	/* check flags for hugepage sizes */
+	if ((flags & RTE_MEMZONE_2MB) &&
+			ms->hugepage_sz == RTE_PGSIZE_1G)
+		return;
+	if ((flags & RTE_MEMZONE_1GB) &&
+			ms->hugepage_sz == RTE_PGSIZE_2M)
+		return;
+	if ((flags & RTE_MEMZONE_16MB) &&
+			ms->hugepage_sz == RTE_PGSIZE_16G)
+		return;
+	if ((flags & RTE_MEMZONE_16GB) &&
+			ms->hugepage_sz == RTE_PGSIZE_16M)
+		return;
+
+	/* this range is the best until now */
+	if (!fit->found)
+		;
+	/* find the biggest contiguous zone */
+	else if (len == 0) {
+		if (ms->len <= fit->len)
+			return;
+	}
+	/*
+	 * find the smallest (we already checked that current
+	 * zone length is > len
+	 */
+	else if (!(ms->len + align < fit->len ||
+			(ms->len <= fit->len + align &&
+			addr_offset < fit->offset)))
+		return;
+
+	fit->found = 1;
+	fit->is_area = is_area;
+	fit->idx = idx;
+	fit->len = ms->len;
+	fit->offset = addr_offset;
+}
+
 static const struct rte_memzone *
 memzone_reserve_aligned_thread_unsafe(const char *name, size_t len,
 		int socket_id, unsigned flags, unsigned align, unsigned bound)
 {
 	struct rte_mem_config *mcfg;
-	unsigned i = 0;
-	int memseg_idx = -1;
-	uint64_t addr_offset, seg_offset = 0;
+	struct rte_memzone_entry *zone, *e;
+	struct rte_memzone area;
+	struct rte_memseg ms;
+	struct memzone_fit fit;
+	uint32_t i, zone_idx, prev;
 	size_t requested_len;
-	size_t memseg_len = 0;
-	phys_addr_t memseg_physaddr;
-	void *memseg_addr;
 
 	/* get pointer to global configuration */
 	mcfg = rte_eal_get_configuration()->mem_config;
 
-	/* no more room in config */
-	if (mcfg->memzone_idx >= RTE_MAX_MEMZONE) {
-		RTE_LOG(ERR, EAL, "%s(): No more room in config\n", __func__);
-		rte_errno = ENOSPC;
-		return NULL;
-	}
-
 	/* zone already exist */
 	if ((memzone_lookup_thread_unsafe(name)) != NULL) {
 		RTE_LOG(DEBUG, EAL, "%s(): memzone <%s> already exists\n",
@@ -186,76 +518,45 @@ memzone_reserve_aligned_thread_unsafe(const char *name, size_t len,
 		return NULL;
 	}
 
-	/* find the smallest segment matching requirements */
+	/*
+	 * get the entry of the zone first: growing the registry takes
+	 * memory from the free segments
+	 */
+	zone_idx = memzone_entry_get(mcfg, 1);
+	if (zone_idx == MEMZONE_ENTRY_NONE) {
+		RTE_LOG(ERR, EAL, "%s(): No more room in config\n", __func__);
+		rte_errno = ENOSPC;
+		return NULL;
+	}
+
+	/*
+	 * find the smallest free area or segment matching requirements,
+	 * the free areas first so that they are reused when possible
+	 */
+	memset(&fit, 0, sizeof(fit));
+	memset(&ms, 0, sizeof(ms));
+	for (i = mcfg->memzone_areas; i != MEMZONE_ENTRY_NONE; i = e->next) {
+		e = memzone_entry(mcfg, i);
+		ms.phys_addr = e->mz.phys_addr;
+		ms.addr_64 = e->mz.addr_64;
+		ms.len = e->mz.len;
+		ms.hugepage_sz = e->mz.hugepage_sz;
+		ms.socket_id = e->mz.socket_id;
+		memzone_fit_check(&fit, &ms, 1, i, len,
+			requested_len, socket_id, flags, align, bound);
+	}
 	for (i = 0; i < RTE_MAX_MEMSEG; i++) {
 		/* last segment */
 		if (free_memseg[i].addr == NULL)
 			break;
-
-		/* empty segment, skip it */
-		if (free_memseg[i].len == 0)
-			continue;
-
-		/* bad socket ID */
-		if (socket_id != SOCKET_ID_ANY &&
-		    free_memseg[i].socket_id != SOCKET_ID_ANY &&
-		    socket_id != free_memseg[i].socket_id)
-			continue;
-
-		/*
-		 * calculate offset to closest alignment that
-		 * meets boundary conditions.
-		 */
-		addr_offset = align_phys_boundary(free_memseg + i,
-			requested_len, align, bound);
-
-		/* check len */
-		if ((requested_len + addr_offset) > free_memseg[i].len)
-			continue;
-
-		/* check flags for hugepage sizes */
-		if ((flags & RTE_MEMZONE_2MB) &&
-				free_memseg[i].hugepage_sz == RTE_PGSIZE_1G)
-			continue;
-		if ((flags & RTE_MEMZONE_1GB) &&
-				free_memseg[i].hugepage_sz == RTE_PGSIZE_2M)
-			continue;
-		if ((flags & RTE_MEMZONE_16MB) &&
-				free_memseg[i].hugepage_sz == RTE_PGSIZE_16G)
-			continue;
-		if ((flags & RTE_MEMZONE_16GB) &&
-				free_memseg[i].hugepage_sz == RTE_PGSIZE_16M)
-			continue;
-
-		/* this segment is the best until now */
-		if (memseg_idx == -1) {
-			memseg_idx = i;
-			memseg_len = free_memseg[i].len;
-			seg_offset = addr_offset;
-		}
-		/* find the biggest contiguous zone */
-		else if (len == 0) {
-			if (free_memseg[i].len > memseg_len) {
-				memseg_idx = i;
-				memseg_len = free_memseg[i].len;
-				seg_offset = addr_offset;
-			}
-		}
-		/*
-		 * find the smallest (we already checked that current
-		 * zone length is > len
-		 */
-		else if (free_memseg[i].len + align < memseg_len ||
-				(free_memseg[i].len <= memseg_len + align &&
-				addr_offset < seg_offset)) {
-			memseg_idx = i;
-			memseg_len = free_memseg[i].len;
-			seg_offset = addr_offset;
-		}
+		memzone_fit_check(&fit, &free_memseg[i], 0, i, len,
+			requested_len, socket_id, flags, align, bound);
 	}
 
 	/* no segment found */
-	if (memseg_idx == -1) {
+	if (!fit.found) {
+		memzone_entry_put(mcfg, zone_idx);
+
 		/*
 		 * If RTE_MEMZONE_SIZE_HINT_ONLY flag is specified,
 		 * try allocating again without the size parameter otherwise -fail.
@@ -270,41 +571,64 @@ memzone_reserve_aligned_thread_unsafe(const char *name, size_t len,
 		return NULL;
 	}
 
-	/* save aligned physical and virtual addresses */
-	memseg_physaddr = free_memseg[memseg_idx].phys_addr + seg_offset;
-	memseg_addr = RTE_PTR_ADD(free_memseg[memseg_idx].addr,
-			(uintptr_t) seg_offset);
+	/* take the whole range of free memory out of its segment or list */
+	memset(&area, 0, sizeof(area));
+	if (fit.is_area) {
+		prev = MEMZONE_ENTRY_NONE;
+		for (i = mcfg->memzone_areas; i != fit.idx; i = e->next) {
+			e = memzone_entry(mcfg, i);
+			prev = i;
+		}
+		area = memzone_entry(mcfg, fit.idx)->mz;
+		memzone_area_del(mcfg, prev, fit.idx);
+	} else {
+		area.phys_addr = free_memseg[fit.idx].phys_addr;
+		area.addr = free_memseg[fit.idx].addr;
+		area.len = fit.len;
+		area.hugepage_sz = free_memseg[fit.idx].hugepage_sz;
+		area.socket_id = free_memseg[fit.idx].socket_id;
+		area.memseg_id = fit.idx;
+	}
+
+	/* fill the zone in config */
+	zone = memzone_entry(mcfg, zone_idx);
+	zone->mz = area;
+	snprintf(zone->mz.name, sizeof(zone->mz.name), "%s", name);
+	zone->mz.phys_addr += fit.offset;
+	zone->mz.addr = RTE_PTR_ADD(area.addr, (uintptr_t)fit.offset);
 
 	/* if we are looking for a biggest memzone */
 	if (len == 0) {
 		if (bound == 0)
-			requested_len = memseg_len - seg_offset;
+			requested_len = fit.len - fit.offset;
 		else
-			requested_len = RTE_ALIGN_CEIL(memseg_physaddr + 1,
-				bound) - memseg_physaddr;
+			requested_len = RTE_ALIGN_CEIL(zone->mz.phys_addr + 1,
+				bound) - zone->mz.phys_addr;
+	}
+	zone->mz.len = requested_len;
+	zone->mz.flags = 0;
+	zone->state = MEMZONE_ENTRY_ZONE;
+	memzone_hash_add(mcfg, zone_idx);
+	mcfg->memzone_cnt++;
+
+	/* keep the alignment padding before the zone as a free area */
+	if (fit.offset != 0) {
+		area.len = fit.offset;
+		memzone_area_add(mcfg, &area);
 	}
-
-	/* set length to correct value */
-	len = (size_t)seg_offset + requested_len;
 
 	/* update our internal state */
-	free_memseg[memseg_idx].len -= len;
-	free_memseg[memseg_idx].phys_addr += len;
-	free_memseg[memseg_idx].addr =
-		(char *)free_memseg[memseg_idx].addr + len;
-
-	/* fill the zone in config */
-	struct rte_memzone *mz = &mcfg->memzone[mcfg->memzone_idx++];
-	snprintf(mz->name, sizeof(mz->name), "%s", name);
-	mz->phys_addr = memseg_physaddr;
-	mz->addr = memseg_addr;
-	mz->len = requested_len;
-	mz->hugepage_sz = free_memseg[memseg_idx].hugepage_sz;
-	mz->socket_id = free_memseg[memseg_idx].socket_id;
-	mz->flags = 0;
-	mz->memseg_id = memseg_idx;
-
-	return mz;
+	area.len = fit.len - fit.offset - requested_len;
+	area.phys_addr = zone->mz.phys_addr + requested_len;
+	area.addr = RTE_PTR_ADD(zone->mz.addr, requested_len);
+	if (!fit.is_area) {
+		free_memseg[fit.idx].len = area.len;
+		free_memseg[fit.idx].phys_addr = area.phys_addr;
+		free_memseg[fit.idx].addr = area.addr;
+	} else if (area.len != 0)
+		memzone_area_add(mcfg, &area);
+
+	return &zone->mz;
 }
 
 /*
@@ -370,6 +694,90 @@ rte_memzone_reserve_bounded(const char *name, size_t len,
 	return mz;
 }
 
+/*
+ * Free a memzone: its descriptor is put back in the registry and its
+ * memory can be reserved again.
+ */
+int
+rte_memzone_free(const struct rte_memzone *mz)
+{
+	struct rte_mem_config *mcfg;
+	struct rte_memzone_entry *e;
+	struct rte_memzone area;
+	uint32_t idx;
+	int ret = -EINVAL;
+
+	if (mz == NULL)
+		return -EINVAL;
+
+	/* get pointer to global configuration */
+	mcfg = rte_eal_get_configuration()->mem_config;
+
+	rte_rwlock_write_lock(&mcfg->mlock);
+
+	idx = memzone_entry_idx(mcfg, mz);
+	if (idx == MEMZONE_ENTRY_NONE || idx >= mcfg->memzone_idx)
+		goto exit;
+	e = memzone_entry(mcfg, idx);
+	if (e->state != MEMZONE_ENTRY_ZONE)
+		goto exit;
+
+	memzone_hash_del(mcfg, idx);
+	mcfg->memzone_cnt--;
+
+	/* put back the entry first, so that the area can use it */
+	area = e->mz;
+	memzone_entry_put(mcfg, idx);
+	memzone_area_release(mcfg, &area);
+	ret = 0;
+
+exit:
+	rte_rwlock_write_unlock(&mcfg->mlock);
+
+	return ret;
+}
+
+/*
+ * Add a memzone which memory is not managed by this process (for example
+ * shared by the host through IVSHMEM). It cannot be freed.
+ */
+const struct rte_memzone *
+rte_eal_memzone_add_fixed(const struct rte_memzone *mz)
+{
+	struct rte_mem_config *mcfg;
+	struct rte_memzone_entry *e;
+	const struct rte_memzone *ret = NULL;
+	uint32_t idx;
+
+	/* get pointer to global configuration */
+	mcfg = rte_eal_get_configuration()->mem_config;
+
+	rte_rwlock_write_lock(&mcfg->mlock);
+
+	if (memzone_lookup_thread_unsafe(mz->name) != NULL) {
+		RTE_LOG(ERR, EAL, "%s(): memzone <%s> already exists\n",
+			__func__, mz->name);
+		goto exit;
+	}
+
+	idx = memzone_entry_get(mcfg, 1);
+	if (idx == MEMZONE_ENTRY_NONE) {
+		RTE_LOG(ERR, EAL, "%s(): No more room in config\n", __func__);
+		goto exit;
+	}
+
+	e = memzone_entry(mcfg, idx);
+	e->mz = *mz;
+	e->state = MEMZONE_ENTRY_FIXED;
+	memzone_hash_add(mcfg, idx);
+	mcfg->memzone_cnt++;
+	ret = &e->mz;
+
+exit:
+	rte_rwlock_write_unlock(&mcfg->mlock);
+
+	return ret;
+}
 
 /*
  * Lookup for the memzone identified by the given name
@@ -396,6 +804,7 @@ void
 rte_memzone_dump(FILE *f)
 {
 	struct rte_mem_config *mcfg;
+	struct rte_memzone_entry *e;
 	unsigned i = 0;
 
 	/* get pointer to global configuration */
@@ -403,17 +812,29 @@ rte_memzone_dump(FILE *f)
 
 	rte_rwlock_read_lock(&mcfg->mlock);
 	/* dump all zones */
-	for (i=0; i<RTE_MAX_MEMZONE; i++) {
-		if (mcfg->memzone[i].addr == NULL)
-			break;
+	for (i = 0; i < mcfg->memzone_idx; i++) {
+		e = memzone_entry(mcfg, i);
+		if (e->state != MEMZONE_ENTRY_ZONE &&
+				e->state != MEMZONE_ENTRY_FIXED)
+			continue;
 		fprintf(f, "Zone %u: name:<%s>, phys:0x%"PRIx64", len:0x%zx"
 		       ", virt:%p, socket_id:%"PRId32", flags:%"PRIx32"\n", i,
-		       mcfg->memzone[i].name,
-		       mcfg->memzone[i].phys_addr,
-		       mcfg->memzone[i].len,
-		       mcfg->memzone[i].addr,
-		       mcfg->memzone[i].socket_id,
-		       mcfg->memzone[i].flags);
+		       e->mz.name,
+		       e->mz.phys_addr,
+		       e->mz.len,
+		       e->mz.addr,
+		       e->mz.socket_id,
+		       e->mz.flags);
+	}
+	/* dump the memory released by freed zones */
+	for (i = mcfg->memzone_areas; i != MEMZONE_ENTRY_NONE; i = e->next) {
+		e = memzone_entry(mcfg, i);
+		fprintf(f, "Free area %u: phys:0x%"PRIx64", len:0x%zx"
+		       ", virt:%p, socket_id:%"PRId32"\n", i,
+		       e->mz.phys_addr,
+		       e->mz.len,
+		       e->mz.addr,
+		       e->mz.socket_id);
 	}
 	rte_rwlock_read_unlock(&mcfg->mlock);
 }
@@ -507,6 +928,14 @@ rte_eal_memzone_init(void)
 
 	/* delete all zones */
 	mcfg->memzone_idx = 0;
+	mcfg->memzone_cnt = 0;
+	mcfg->memzone_nb_tbl = 1;
+	mcfg->memzone_unused = MEMZONE_ENTRY_NONE;
+	mcfg->memzone_areas = MEMZONE_ENTRY_NONE;
+	memset(mcfg->memzone_tbl, 0, sizeof(mcfg->memzone_tbl));
+	mcfg->memzone_tbl[0] = (uintptr_t)mcfg->memzone;
+	for (i = 0; i < RTE_MEMZONE_HASH_SIZE; i++)
+		mcfg->memzone_hash[i] = MEMZONE_ENTRY_NONE;
 	memset(mcfg->memzone, 0, sizeof(mcfg->memzone));
 
 	rte_rwlock_write_unlock(&mcfg->mlock);
@@ -519,14 +948,17 @@ void rte_memzone_walk(void (*func)(const struct rte_memzone *, void *),
 		      void *arg)
 {
 	struct rte_mem_config *mcfg;
+	struct rte_memzone_entry *e;
 	unsigned i;
 
 	mcfg = rte_eal_get_configuration()->mem_config;
 
 	rte_rwlock_read_lock(&mcfg->mlock);
-	for (i=0; i<RTE_MAX_MEMZONE; i++) {
-		if (mcfg->memzone[i].addr != NULL)
-			(*func)(&mcfg->memzone[i], arg);
+	for (i = 0; i < mcfg->memzone_idx; i++) {
+		e = memzone_entry(mcfg, i);
+		if (e->state == MEMZONE_ENTRY_ZONE ||
+				e->state == MEMZONE_ENTRY_FIXED)
+			(*func)(&e->mz, arg);
 	}
 	rte_rwlock_read_unlock(&mcfg->mlock);
 }
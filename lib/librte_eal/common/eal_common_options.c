@@ -84,6 +84,8 @@ eal_long_options[] = {
 	{OPT_PCI_BLACKLIST,     1, NULL, OPT_PCI_BLACKLIST_NUM    },
 	{OPT_PCI_WHITELIST,     1, NULL, OPT_PCI_WHITELIST_NUM    },
 	{OPT_PROC_TYPE,         1, NULL, OPT_PROC_TYPE_NUM        },
+	{OPT_SERVICE_LCORES,    1, NULL, OPT_SERVICE_LCORES_NUM   },
+	{OPT_SINGLE_FILE_SEGMENTS, 0, NULL, OPT_SINGLE_FILE_SEGMENTS_NUM},
 	{OPT_SOCKET_MEM,        1, NULL, OPT_SOCKET_MEM_NUM       },
 	{OPT_SYSLOG,            1, NULL, OPT_SYSLOG_NUM           },
 	{OPT_VDEV,              1, NULL, OPT_VDEV_NUM             },
@@ -121,6 +123,7 @@ eal_reset_internal_config(struct internal_config *internal_cfg)
 	internal_cfg->log_level = RTE_LOG_LEVEL;
 
 	internal_cfg->xen_dom0_support = 0;
+	internal_cfg->single_file_segments = 0;
 
 	/* if set to NONE, interrupt mode is determined automatically */
 	internal_cfg->vfio_intr_mode = RTE_INTR_MODE_NONE;
@@ -132,6 +135,8 @@ eal_reset_internal_config(struct internal_config *internal_cfg)
 #endif
 	internal_cfg->vmware_tsc_map = 0;
 	internal_cfg->create_uio_dev = 0;
+	memset(internal_cfg->service_lcores, 0,
+		sizeof(internal_cfg->service_lcores));
 }
 
 /*
@@ -283,6 +288,59 @@ eal_parse_corelist(const char *corelist)
 	return 0;
 }
 
+/*
+ * Parse the list of service lcores, with the same format as the -l
+ * option. The lcores are checked once all options are parsed.
+ */
+static int
+eal_parse_service_corelist(const char *corelist,
+		struct internal_config *conf)
+{
+	uint8_t *lcores = conf->service_lcores;
+	char *end = NULL;
+	unsigned long idx, min;
+	int count = 0;
+
+	memset(lcores, 0, sizeof(conf->service_lcores));
+
+	do {
+		while (isblank(*corelist))
+			corelist++;
+		if (!isdigit(*corelist))
+			return -1;
+		errno = 0;
+		min = idx = strtoul(corelist, &end, 10);
+		if (errno || end == NULL || idx >= RTE_MAX_LCORE)
+			return -1;
+		while (isblank(*end))
+			end++;
+		if (*end == '-') {
+			corelist = end + 1;
+			while (isblank(*corelist))
+				corelist++;
+			if (!isdigit(*corelist))
+				return -1;
+			errno = 0;
+			idx = strtoul(corelist, &end, 10);
+			if (errno || end == NULL || idx >= RTE_MAX_LCORE ||
+					idx < min)
+				return -1;
+			while (isblank(*end))
+				end++;
+		}
+		if (*end != ',' && *end != '\0')
+			return -1;
+		for (; min <= idx; min++) {
+			if (!lcores[min])
+				count++;
+			lcores[min] = 1;
+		}
+		corelist = end + 1;
+	} while (*end != '\0');
+
+	return count == 0 ? -1 : 0;
+}
+
 /* Changes the lcore id of the master thread */
 static int
 eal_parse_master_lcore(const char *arg)
@@ -785,6 +843,14 @@ eal_parse_common_option(int opt, const char *optarg,
 		}
 		break;
 
+	case OPT_SERVICE_LCORES_NUM:
+		if (eal_parse_service_corelist(optarg, conf) < 0) {
+			RTE_LOG(ERR, EAL, "invalid parameter for --"
+				OPT_SERVICE_LCORES "\n");
+			return -1;
+		}
+		break;
+
 	/* don't know what to do, leave this to caller */
 	default:
 		return 1;
@@ -819,6 +885,7 @@ int
 eal_check_common_options(struct internal_config *internal_cfg)
 {
 	struct rte_config *cfg = rte_eal_get_configuration();
+	unsigned i;
 
 	if (!lcores_parsed) {
 		RTE_LOG(ERR, EAL, "CPU cores must be enabled with options "
@@ -829,6 +896,16 @@ eal_check_common_options(struct internal_config *internal_cfg)
 		RTE_LOG(ERR, EAL, "Master lcore is not enabled for DPDK\n");
 		return -1;
 	}
+	for (i = 0; i < RTE_MAX_LCORE; i++) {
+		if (!internal_cfg->service_lcores[i])
+			continue;
+		if (cfg->lcore_role[i] != ROLE_RTE ||
+				i == cfg->master_lcore) {
+			RTE_LOG(ERR, EAL, "Service lcore %u must be an enabled "
+				"slave lcore\n", i);
+			return -1;
+		}
+	}
 
 	if (internal_cfg->process_type == RTE_PROC_INVALID) {
 		RTE_LOG(ERR, EAL, "Invalid process type specified\n");
@@ -885,6 +962,9 @@ eal_common_usage(void)
 	       "                      '( )' can be omitted for single element group,\n"
 	       "                      '@' can be omitted if cpus and lcores have the same value\n"
 	       "  --"OPT_MASTER_LCORE" ID   Core ID that is used as master\n"
+	       "  --"OPT_SERVICE_LCORES" CORELIST\n"
+	       "                      List of slave cores that run the services,\n"
+	       "                      with the same format as -l\n"
 	       "  -n CHANNELS         Number of memory channels\n"
 	       "  -m MB               Memory to allocate (see also --"OPT_SOCKET_MEM")\n"
 	       "  -r RANKS            Force number of memory ranks (don't detect)\n"
@@ -0,0 +1,569 @@
+/*-
+ *   BSD LICENSE
+ *
+ *   Copyright(c) 2010-2014 Intel Corporation. All rights reserved.
+ *   All rights reserved.
+ *
+ *   Redistribution and use in source and binary forms, with or without
+ *   modification, are permitted provided that the following conditions
+ *   are met:
+ *
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in
+ *       the documentation and/or other materials provided with the
+ *       distribution.
+ *     * Neither the name of Intel Corporation nor the names of its
+ *       contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ *   THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *   "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *   LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ *   A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ *   OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ *   SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ *   LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ *   DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ *   THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ *   (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ *   OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <stdio.h>
+#include <stdint.h>
+#include <inttypes.h>
+#include <string.h>
+#include <errno.h>
+
+#include <rte_common.h>
+#include <rte_log.h>
+#include <rte_memory.h>
+#include <rte_eal.h>
+#include <rte_lcore.h>
+#include <rte_launch.h>
+#include <rte_atomic.h>
+#include <rte_cycles.h>
+#include <rte_branch_prediction.h>
+#include <rte_service.h>
+
+#include "eal_private.h"
+#include "eal_internal_cfg.h"
+
+#define SERVICE_F_REGISTERED    (1 << 0)
+#define SERVICE_F_STATS_ENABLED (1 << 1)
+
+#define RUNSTATE_STOPPED 0
+#define RUNSTATE_RUNNING 1
+
+/* a registered service */
+struct rte_service_spec_impl {
+	struct rte_service_spec spec;
+	uint32_t internal_flags;      /**< SERVICE_F_* flags */
+	volatile uint32_t runstate;   /**< started or stopped by the app */
+	/** held by the lcore running a service that is not MT safe */
+	rte_atomic32_t execute_lock;
+	/** number of service lcores the service is mapped to */
+	rte_atomic32_t num_mapped_cores;
+} __rte_cache_aligned;
+
+/* the state of a service lcore, written only by this lcore when running */
+struct core_state {
+	volatile uint64_t service_mask; /**< services mapped to this lcore */
+	volatile uint32_t runstate;   /**< running or asked to stop */
+	uint32_t is_service_core;
+	uint64_t loops;               /**< iterations of the service loop */
+	uint64_t calls_per_service[RTE_SERVICE_NUM_MAX];
+	uint64_t cycles_per_service[RTE_SERVICE_NUM_MAX];
+} __rte_cache_aligned;
+
+static struct rte_service_spec_impl rte_services[RTE_SERVICE_NUM_MAX];
+static struct core_state lcore_states[RTE_MAX_LCORE];
+static uint32_t rte_service_count;
+
+static inline int
+service_valid(uint32_t id)
+{
+	return id < RTE_SERVICE_NUM_MAX &&
+		(rte_services[id].internal_flags & SERVICE_F_REGISTERED);
+}
+
+static inline int
+service_mt_safe(const struct rte_service_spec_impl *s)
+{
+	return !!(s->spec.capabilities & RTE_SERVICE_CAP_MT_SAFE);
+}
+
+static inline int
+lcore_is_service(uint32_t lcore)
+{
+	return lcore < RTE_MAX_LCORE && lcore_states[lcore].is_service_core;
+}
+
+int32_t
+rte_service_register(const struct rte_service_spec *spec, uint32_t *id)
+{
+	struct rte_service_spec_impl *s;
+	uint32_t i, free_slot = RTE_SERVICE_NUM_MAX;
+
+	if (spec == NULL || spec->callback == NULL || spec->name[0] == '\0' ||
+			memchr(spec->name, '\0', RTE_SERVICE_NAME_MAX) == NULL)
+		return -EINVAL;
+
+	for (i = 0; i < RTE_SERVICE_NUM_MAX; i++) {
+		if (!service_valid(i)) {
+			if (free_slot == RTE_SERVICE_NUM_MAX)
+				free_slot = i;
+			continue;
+		}
+		if (strcmp(rte_services[i].spec.name, spec->name) == 0)
+			return -EEXIST;
+	}
+	if (free_slot == RTE_SERVICE_NUM_MAX)
+		return -ENOSPC;
+
+	s = &rte_services[free_slot];
+	memset(s, 0, sizeof(*s));
+	s->spec = *spec;
+	s->runstate = RUNSTATE_STOPPED;
+	rte_atomic32_init(&s->execute_lock);
+	rte_atomic32_init(&s->num_mapped_cores);
+	/* the service lcores check the flag before reading the spec */
+	rte_wmb();
+	s->internal_flags = SERVICE_F_REGISTERED;
+	rte_service_count++;
+
+	for (i = 0; i < RTE_MAX_LCORE; i++) {
+		lcore_states[i].calls_per_service[free_slot] = 0;
+		lcore_states[i].cycles_per_service[free_slot] = 0;
+	}
+
+	if (id != NULL)
+		*id = free_slot;
+	RTE_LOG(DEBUG, EAL, "service %s registered with id %u\n",
+		spec->name, free_slot);
+	return 0;
+}
+
+int32_t
+rte_service_unregister(uint32_t id)
+{
+	uint32_t i;
+
+	if (!service_valid(id))
+		return -EINVAL;
+
+	rte_services[id].runstate = RUNSTATE_STOPPED;
+	rte_services[id].internal_flags = 0;
+	rte_wmb();
+	for (i = 0; i < RTE_MAX_LCORE; i++)
+		lcore_states[i].service_mask &= ~(UINT64_C(1) << id);
+
+	memset(&rte_services[id].spec, 0, sizeof(rte_services[id].spec));
+	rte_atomic32_clear(&rte_services[id].num_mapped_cores);
+	rte_service_count--;
+	return 0;
+}
+
+uint32_t
+rte_service_get_count(void)
+{
+	return rte_service_count;
+}
+
+int32_t
+rte_service_get_by_name(const char *name, uint32_t *service_id)
+{
+	uint32_t i;
+
+	if (name == NULL || service_id == NULL)
+		return -EINVAL;
+
+	for (i = 0; i < RTE_SERVICE_NUM_MAX; i++) {
+		if (service_valid(i) &&
+				strcmp(rte_services[i].spec.name, name) == 0) {
+			*service_id = i;
+			return 0;
+		}
+	}
+	return -ENODEV;
+}
+
+const char *
+rte_service_get_name(uint32_t id)
+{
+	if (!service_valid(id))
+		return NULL;
+	return rte_services[id].spec.name;
+}
+
+int32_t
+rte_service_runstate_set(uint32_t id, uint32_t runstate)
+{
+	if (!service_valid(id))
+		return -EINVAL;
+
+	rte_services[id].runstate = runstate ?
+		RUNSTATE_RUNNING : RUNSTATE_STOPPED;
+	rte_wmb();
+	return 0;
+}
+
+int32_t
+rte_service_runstate_get(uint32_t id)
+{
+	if (!service_valid(id))
+		return -EINVAL;
+
+	return rte_services[id].runstate == RUNSTATE_RUNNING &&
+		rte_atomic32_read(&rte_services[id].num_mapped_cores) > 0;
+}
+
+int32_t
+rte_service_map_lcore_set(uint32_t id, uint32_t lcore, uint32_t enable)
+{
+	struct core_state *cs;
+	uint64_t bit = UINT64_C(1) << id;
+
+	if (!service_valid(id) || !lcore_is_service(lcore))
+		return -EINVAL;
+
+	cs = &lcore_states[lcore];
+	if (enable && !(cs->service_mask & bit)) {
+		/* count the lcore before it may run the service */
+		rte_atomic32_inc(&rte_services[id].num_mapped_cores);
+		cs->service_mask |= bit;
+	} else if (!enable && (cs->service_mask & bit)) {
+		cs->service_mask &= ~bit;
+		rte_atomic32_dec(&rte_services[id].num_mapped_cores);
+	}
+	rte_wmb();
+	return 0;
+}
+
+int32_t
+rte_service_map_lcore_get(uint32_t id, uint32_t lcore)
+{
+	if (!service_valid(id) || !lcore_is_service(lcore))
+		return -EINVAL;
+
+	return !!(lcore_states[lcore].service_mask & (UINT64_C(1) << id));
+}
+
+/*
+ * Call a service once and account the call to the lcore state cs, which
+ * is NULL for a non-EAL thread.
+ */
+static inline int32_t
+service_run(uint32_t id, struct core_state *cs, int serialize)
+{
+	struct rte_service_spec_impl *s = &rte_services[id];
+	uint64_t start;
+
+	if (!(s->internal_flags & SERVICE_F_REGISTERED) ||
+			s->runstate != RUNSTATE_RUNNING)
+		return -ENOEXEC;
+
+	rte_rmb();
+	if (serialize && !rte_atomic32_test_and_set(&s->execute_lock))
+		return -EBUSY;
+
+	if (s->internal_flags & SERVICE_F_STATS_ENABLED) {
+		start = rte_rdtsc();
+		s->spec.callback(s->spec.callback_userdata);
+		if (cs != NULL)
+			cs->cycles_per_service[id] += rte_rdtsc() - start;
+	} else
+		s->spec.callback(s->spec.callback_userdata);
+
+	if (cs != NULL)
+		cs->calls_per_service[id]++;
+
+	if (serialize)
+		rte_atomic32_clear(&s->execute_lock);
+	return 0;
+}
+
+/* the loop of a service lcore, launched with rte_eal_remote_launch() */
+static int
+service_runner_func(void *arg)
+{
+	struct core_state *cs = &lcore_states[rte_lcore_id()];
+	struct rte_service_spec_impl *s;
+	uint64_t mask;
+	uint32_t i;
+
+	RTE_SET_USED(arg);
+
+	while (cs->runstate == RUNSTATE_RUNNING) {
+		mask = cs->service_mask;
+		for (i = 0; mask != 0; i++, mask >>= 1) {
+			if (!(mask & 1))
+				continue;
+			/*
+			 * A service that is not MT safe is serialized even
+			 * when mapped to this lcore only, as an application
+			 * lcore may run it with
+			 * rte_service_run_iter_on_app_lcore().
+			 */
+			s = &rte_services[i];
+			service_run(i, cs, !service_mt_safe(s));
+		}
+		cs->loops++;
+	}
+	return 0;
+}
+
+int32_t
+rte_service_run_iter_on_app_lcore(uint32_t id)
+{
+	unsigned lcore_id = rte_lcore_id();
+	struct core_state *cs = NULL;
+
+	if (!service_valid(id))
+		return -EINVAL;
+
+	if (lcore_id < RTE_MAX_LCORE)
+		cs = &lcore_states[lcore_id];
+
+	/* a service lcore may be running it at the same time */
+	return service_run(id, cs, !service_mt_safe(&rte_services[id]));
+}
+
+int32_t
+rte_service_lcore_add(uint32_t lcore)
+{
+	struct rte_config *cfg = rte_eal_get_configuration();
+	struct core_state *cs;
+
+	if (lcore >= RTE_MAX_LCORE)
+		return -EINVAL;
+	if (lcore_states[lcore].is_service_core)
+		return -EALREADY;
+	if (cfg->lcore_role[lcore] != ROLE_RTE || lcore == cfg->master_lcore)
+		return -EINVAL;
+	if (lcore_config[lcore].state != WAIT &&
+			lcore_config[lcore].state != FINISHED)
+		return -EBUSY;
+	/* reset the FINISHED state so the lcore can be launched */
+	rte_eal_wait_lcore(lcore);
+
+	cs = &lcore_states[lcore];
+	memset(cs, 0, sizeof(*cs));
+	cs->runstate = RUNSTATE_STOPPED;
+	cs->is_service_core = 1;
+
+	cfg->lcore_role[lcore] = ROLE_SERVICE;
+	cfg->lcore_count--;
+	return 0;
+}
+
+int32_t
+rte_service_lcore_del(uint32_t lcore)
+{
+	struct rte_config *cfg = rte_eal_get_configuration();
+	struct core_state *cs;
+	uint32_t i;
+
+	if (!lcore_is_service(lcore))
+		return -EINVAL;
+
+	cs = &lcore_states[lcore];
+	if (cs->runstate != RUNSTATE_STOPPED)
+		return -EBUSY;
+
+	for (i = 0; i < RTE_SERVICE_NUM_MAX; i++)
+		if (cs->service_mask & (UINT64_C(1) << i))
+			rte_atomic32_dec(&rte_services[i].num_mapped_cores);
+	cs->service_mask = 0;
+	cs->is_service_core = 0;
+
+	cfg->lcore_role[lcore] = ROLE_RTE;
+	cfg->lcore_count++;
+	return 0;
+}
+
+int32_t
+rte_service_lcore_start(uint32_t lcore)
+{
+	struct core_state *cs;
+	int ret;
+
+	if (!lcore_is_service(lcore))
+		return -EINVAL;
+
+	cs = &lcore_states[lcore];
+	if (cs->runstate == RUNSTATE_RUNNING)
+		return -EALREADY;
+
+	cs->runstate = RUNSTATE_RUNNING;
+	rte_wmb();
+	ret = rte_eal_remote_launch(service_runner_func, NULL, lcore);
+	if (ret < 0) {
+		cs->runstate = RUNSTATE_STOPPED;
+		return ret;
+	}
+	return 0;
+}
+
+int32_t
+rte_service_lcore_stop(uint32_t lcore)
+{
+	struct core_state *cs;
+
+	if (!lcore_is_service(lcore))
+		return -EINVAL;
+
+	cs = &lcore_states[lcore];
+	if (cs->runstate == RUNSTATE_STOPPED)
+		return -EALREADY;
+
+	cs->runstate = RUNSTATE_STOPPED;
+	rte_wmb();
+	rte_eal_wait_lcore(lcore);
+	return 0;
+}
+
+int32_t
+rte_service_lcore_count(void)
+{
+	int32_t count = 0;
+	uint32_t i;
+
+	for (i = 0; i < RTE_MAX_LCORE; i++)
+		count += lcore_states[i].is_service_core;
+	return count;
+}
+
+int32_t
+rte_service_lcore_list(uint32_t array[], uint32_t n)
+{
+	uint32_t i, count = 0;
+
+	if ((uint32_t)rte_service_lcore_count() > n)
+		return -ENOMEM;
+	if (array == NULL)
+		return -EINVAL;
+
+	for (i = 0; i < RTE_MAX_LCORE; i++)
+		if (lcore_states[i].is_service_core)
+			array[count++] = i;
+	return count;
+}
+
+int32_t
+rte_service_set_stats_enable(uint32_t id, int32_t enable)
+{
+	if (!service_valid(id))
+		return -EINVAL;
+
+	if (enable)
+		rte_services[id].internal_flags |= SERVICE_F_STATS_ENABLED;
+	else
+		rte_services[id].internal_flags &= ~SERVICE_F_STATS_ENABLED;
+	return 0;
+}
+
+int32_t
+rte_service_stats_get(uint32_t id, uint64_t *calls, uint64_t *cycles)
+{
+	uint64_t total_calls = 0, total_cycles = 0;
+	uint32_t i;
+
+	if (!service_valid(id))
+		return -EINVAL;
+
+	for (i = 0; i < RTE_MAX_LCORE; i++) {
+		total_calls += lcore_states[i].calls_per_service[id];
+		total_cycles += lcore_states[i].cycles_per_service[id];
+	}
+	if (calls != NULL)
+		*calls = total_calls;
+	if (cycles != NULL)
+		*cycles = total_cycles;
+	return 0;
+}
+
+int32_t
+rte_service_stats_reset(uint32_t id)
+{
+	uint32_t i;
+
+	if (!service_valid(id))
+		return -EINVAL;
+
+	for (i = 0; i < RTE_MAX_LCORE; i++) {
+		lcore_states[i].calls_per_service[id] = 0;
+		lcore_states[i].cycles_per_service[id] = 0;
+	}
+	return 0;
+}
+
+static void
+service_dump_one(FILE *f, uint32_t id)
+{
+	const struct rte_service_spec_impl *s = &rte_services[id];
+	uint64_t calls = 0, cycles = 0;
+
+	rte_service_stats_get(id, &calls, &cycles);
+	fprintf(f, "service <%s>@%u: %s, %d lcore(s)%s\n", s->spec.name, id,
+		s->runstate == RUNSTATE_RUNNING ? "started" : "stopped",
+		rte_atomic32_read(&s->num_mapped_cores),
+		service_mt_safe(s) ? ", mt safe" : "");
+	fprintf(f, "  calls=%"PRIu64" cycles=%"PRIu64" cycles/call=%"PRIu64"\n",
+		calls, cycles, calls ? cycles / calls : 0);
+}
+
+int32_t
+rte_service_dump(FILE *f, uint32_t id)
+{
+	uint32_t i;
+
+	if (id != UINT32_MAX) {
+		if (!service_valid(id))
+			return -EINVAL;
+		service_dump_one(f, id);
+		return 0;
+	}
+
+	fprintf(f, "%u service(s)\n", rte_service_count);
+	for (i = 0; i < RTE_SERVICE_NUM_MAX; i++)
+		if (service_valid(i))
+			service_dump_one(f, i);
+
+	for (i = 0; i < RTE_MAX_LCORE; i++) {
+		if (!lcore_states[i].is_service_core)
+			continue;
+		fprintf(f, "service lcore %u: %s, mask=0x%"PRIx64
+			" loops=%"PRIu64"\n", i,
+			lcore_states[i].runstate == RUNSTATE_RUNNING ?
+			"running" : "stopped",
+			lcore_states[i].service_mask, lcore_states[i].loops);
+	}
+	return 0;
+}
+
+/*
+ * Turn the lcores given with --service-lcores into service lcores,
+ * once the threads of all lcores are created.
+ */
+int
+rte_eal_service_init(void)
+{
+	uint32_t i;
+	int ret;
+
+	for (i = 0; i < RTE_MAX_LCORE; i++) {
+		if (!internal_config.service_lcores[i])
+			continue;
+		ret = rte_service_lcore_add(i);
+		if (ret < 0) {
+			RTE_LOG(ERR, EAL, "Cannot use lcore %u as a service "
+				"lcore: %s\n", i, strerror(-ret));
+			return -1;
+		}
+		RTE_LOG(DEBUG, EAL, "lcore %u is a service lcore\n", i);
+	}
+	return 0;
+}
@@ -69,6 +69,10 @@ enum {
 	OPT_NO_PCI_NUM,
 #define OPT_NO_SHCONF         "no-shconf"
 	OPT_NO_SHCONF_NUM,
+#define OPT_SERVICE_LCORES    "service-lcores"
+	OPT_SERVICE_LCORES_NUM,
+#define OPT_SINGLE_FILE_SEGMENTS "single-file-segments"
+	OPT_SINGLE_FILE_SEGMENTS_NUM,
 #define OPT_SOCKET_MEM        "socket-mem"
 	OPT_SOCKET_MEM_NUM,
 #define OPT_SYSLOG            "syslog"
@@ -45,6 +45,22 @@
  */
 int rte_eal_memzone_init(void);
 
+struct rte_memzone;
+
+/**
+ * Add a memzone which memory is not managed by the memzone subsystem,
+ * such as a memzone shared by the host through IVSHMEM. The memzone
+ * cannot be freed.
+ *
+ * @param mz
+ *   The memzone descriptor to copy in the memzone registry.
+ * @return
+ *   - A pointer to the descriptor in the registry on success
+ *   - NULL on error
+ */
+const struct rte_memzone *
+rte_eal_memzone_add_fixed(const struct rte_memzone *mz);
+
 /**
  * Common log initialization function (private to eal).
  *
@@ -232,4 +248,45 @@ int rte_eal_dev_init(void);
  */
 int rte_eal_check_module(const char *module_name);
 
+/**
+ * Turn the lcores given with --service-lcores into service lcores.
+ *
+ * This function is private to the EAL, and must be called once the
+ * threads of the slave lcores are created.
+ *
+ * @return
+ *   0 on success, negative on error
+ */
+int rte_eal_service_init(void);
+
+struct rte_extmem;
+
+/**
+ * Map an area of external memory for DMA in the IOMMU used by the devices,
+ * with the I/O addresses of its pages. Nothing is done if no IOMMU is in
+ * use yet, the registered areas being mapped when it is set up.
+ *
+ * This function is private to the EAL, and is called with the external
+ * memory lock held.
+ *
+ * @param ext
+ *   The registered area.
+ * @return
+ *   0 on success, negative on error
+ */
+int rte_eal_extmem_dma_map(const struct rte_extmem *ext);
+
+/**
+ * Unmap an area of external memory mapped with rte_eal_extmem_dma_map().
+ *
+ * This function is private to the EAL, and is called with the external
+ * memory lock held.
+ *
+ * @param ext
+ *   The registered area.
+ * @return
+ *   0 on success, negative on error
+ */
+int rte_eal_extmem_dma_unmap(const struct rte_extmem *ext);
+
 #endif /* _EAL_PRIVATE_H_ */
@@ -72,6 +72,13 @@ extern "C" {
  */
 #define	rte_rmb() {asm volatile("sync" : : : "memory"); }
 
+#define rte_smp_mb() rte_mb()
+
+/* lwsync orders stores with stores and loads with loads between lcores */
+#define rte_smp_wmb() {asm volatile("lwsync" : : : "memory"); }
+
+#define rte_smp_rmb() {asm volatile("lwsync" : : : "memory"); }
+
 /*------------------------- 16 bit atomic operations -------------------------*/
 /* To be compatible with Power7, use GCC built-in functions for 16 bit
  * operations */
@@ -52,11 +52,12 @@ extern "C" {
 #define RTE_MAGIC 19820526 /**< Magic number written by the main partition when ready. */
 
 /**
- * The lcore role (used in RTE or not).
+ * The lcore role (used in RTE, running services, or not used).
  */
 enum rte_lcore_role_t {
 	ROLE_RTE,
 	ROLE_OFF,
+	ROLE_SERVICE,
 };
 
 /**
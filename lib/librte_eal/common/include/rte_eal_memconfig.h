@@ -44,6 +44,46 @@
 extern "C" {
 #endif
 
+/**
+ * Maximum number of memzone descriptor tables. Each table holds
+ * RTE_MAX_MEMZONE descriptors: the first one is part of the memory
+ * configuration, the others are reserved in hugepage memory when the
+ * registry grows.
+ */
+#define RTE_MEMZONE_MAX_TABLES 16
+
+/** Number of buckets of the hash table of memzone names (power of 2). */
+#define RTE_MEMZONE_HASH_SIZE 4096
+
+/**
+ * Entry of the memzone registry. Besides the descriptor of a reserved
+ * memzone, an entry can describe an area of memory released by
+ * rte_memzone_free(), or be unused.
+ */
+struct rte_memzone_entry {
+	struct rte_memzone mz; /**< Descriptor, must be the first field. */
+	uint32_t state;        /**< Unused, reserved zone or free area. */
+	uint32_t next;         /**< Next entry in a hash bucket or list. */
+} __attribute__((__packed__));
+
+/** Maximum number of external memory regions registered at a time. */
+#define RTE_MAX_EXTMEM 32
+
+/**
+ * Descriptor of an area of memory mapped by the application outside of
+ * the EAL and registered with rte_extmem_register(). Its table of I/O
+ * addresses, one per page, is stored in a memzone.
+ */
+struct rte_extmem {
+	union {
+		void *addr;             /**< Start virtual address. */
+		uint64_t addr_64;       /**< Makes sure addr is always 64 bits */
+	};
+	uint64_t len;                   /**< Length of the area. */
+	uint64_t page_sz;               /**< Page size of the area. */
+	const struct rte_memzone *iova_mz; /**< Table of I/O addresses. */
+} __attribute__((__packed__));
+
 /**
  * the structure for the memory configuration for the RTE.
  * Used by the rte_config structure. It is separated out, as for multi-process
@@ -60,18 +100,35 @@ struct rte_mem_config {
 	 * current lock nest order
 	 *  - qlock->mlock (ring/hash/lpm)
 	 *  - mplock->qlock->mlock (mempool)
+	 *  - extlock->mlock (external memory)
 	 * Notice:
 	 *  *ALWAYS* obtain qlock first if having to obtain both qlock and mlock
 	 */
 	rte_rwlock_t mlock;   /**< only used by memzone LIB for thread-safe. */
 	rte_rwlock_t qlock;   /**< used for tailq operation for thread safe. */
 	rte_rwlock_t mplock;  /**< only used by mempool LIB for thread-safe. */
+	rte_rwlock_t extlock; /**< used for external memory, taken before mlock. */
+
+	uint32_t memzone_idx; /**< Number of memzone entries ever used. */
+	uint32_t memzone_cnt; /**< Number of reserved memzones. */
+	uint32_t memzone_nb_tbl; /**< Number of memzone entry tables. */
+	uint32_t memzone_unused; /**< First entry of the unused list. */
+	uint32_t memzone_areas; /**< First entry of the free area list. */
 
-	uint32_t memzone_idx; /**< Index of memzone */
+	/** Addresses of the memzone entry tables, the first one is memzone[]. */
+	uint64_t memzone_tbl[RTE_MEMZONE_MAX_TABLES];
+
+	/** First entry of each bucket of the memzone name hash table. */
+	uint32_t memzone_hash[RTE_MEMZONE_HASH_SIZE];
 
 	/* memory segments and zones */
 	struct rte_memseg memseg[RTE_MAX_MEMSEG];    /**< Physmem descriptors. */
-	struct rte_memzone memzone[RTE_MAX_MEMZONE]; /**< Memzone descriptors. */
+	/** First table of memzone entries. */
+	struct rte_memzone_entry memzone[RTE_MAX_MEMZONE];
+
+	/* external memory regions */
+	uint32_t nb_extmem;   /**< Number of registered external regions. */
+	struct rte_extmem extmem[RTE_MAX_EXTMEM]; /**< External regions. */
 
 	/* Runtime Physmem descriptors. */
 	struct rte_memseg free_memseg[RTE_MAX_MEMSEG];
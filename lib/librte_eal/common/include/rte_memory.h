@@ -114,8 +114,10 @@ int rte_mem_lock_page(const void *virt);
 
 /**
  * Get physical address of any mapped virtual address in the current process.
- * It is found by browsing the /proc/self/pagemap special file.
- * The page must be locked.
+ * If the address belongs to external memory registered with
+ * rte_extmem_register(), it is found in the I/O address table of the
+ * region. Otherwise it is found by browsing the /proc/self/pagemap special
+ * file and the page must be locked.
  *
  * @param virt
  *   The virtual address.
@@ -124,6 +126,71 @@ int rte_mem_lock_page(const void *virt);
  */
 phys_addr_t rte_mem_virt2phy(const void *virt);
 
+/**
+ * Register an area of memory mapped outside of the EAL, for example
+ * hugepages mapped by the application or device memory, so that its
+ * addresses can be translated by rte_mem_virt2phy(). Mempools can then be
+ * created on it with rte_mempool_xmem_create() without giving the physical
+ * addresses of its pages, and their objects can be used by any PMD.
+ *
+ * The registration is shared by all processes, but the area must be
+ * mapped at the same address in each process using it.
+ *
+ * When the devices are behind an IOMMU (VFIO), the pages of the area are
+ * mapped in it at their I/O addresses, now or when the first device is
+ * attached, so iova_addrs gives the addresses seen by the devices.
+ *
+ * @param va_addr
+ *   Start of the area, aligned on page_sz.
+ * @param len
+ *   Length of the area, a multiple of page_sz.
+ * @param iova_addrs
+ *   Array of the I/O (physical) addresses of each page of the area.
+ *   A page can be set to RTE_BAD_PHYS_ADDR if it is not usable for DMA.
+ *   The array is copied.
+ * @param n_pages
+ *   Number of entries in iova_addrs, must be len / page_sz.
+ * @param page_sz
+ *   Size of the pages of the area, a power of 2.
+ * @return
+ *   - 0 on success.
+ *   - -EINVAL if a parameter is invalid.
+ *   - -EEXIST if the area overlaps an already registered one.
+ *   - -ENOSPC if RTE_MAX_EXTMEM areas are already registered.
+ *   - -ENOMEM if the I/O address table cannot be allocated.
+ *   - -EIO if the area cannot be mapped in the IOMMU.
+ */
+int rte_extmem_register(void *va_addr, size_t len,
+		const phys_addr_t iova_addrs[], unsigned n_pages, size_t page_sz);
+
+/**
+ * Unregister an area of memory registered with rte_extmem_register().
+ * No object allocated from it must be in use by a device anymore.
+ * The area is unmapped from the IOMMU, if any.
+ *
+ * @param va_addr
+ *   Start of the area, as given at registration.
+ * @param len
+ *   Length of the area, as given at registration.
+ * @return
+ *   - 0 on success.
+ *   - -ENOENT if no such area is registered.
+ *   - -EIO if the area cannot be unmapped from the IOMMU, it is kept
+ *     registered.
+ */
+int rte_extmem_unregister(void *va_addr, size_t len);
+
+/**
+ * Get the I/O address of a virtual address in registered external memory.
+ *
+ * @param virt
+ *   The virtual address.
+ * @return
+ *   The I/O address, or RTE_BAD_PHYS_ADDR if the address does not belong
+ *   to a registered area or its page has no I/O address.
+ */
+phys_addr_t rte_extmem_virt2iova(const void *virt);
+
 /**
  * Get the layout of the available physical memory.
  *
@@ -96,7 +96,7 @@ struct rte_memzone {
  *
  * This function reserves some memory and returns a pointer to a
  * correctly filled memzone descriptor. If the allocation cannot be
- * done, return NULL. Note: A reserved zone cannot be freed.
+ * done, return NULL. The zone can be released with rte_memzone_free().
  *
  * @param name
  *   The name of the memzone. If it already exists, the function will
@@ -143,7 +143,7 @@ const struct rte_memzone *rte_memzone_reserve(const char *name,
  * boundary, and returns a pointer to a correctly filled memzone
  * descriptor. If the allocation cannot be done or if the alignment
  * is not a power of 2, returns NULL.
- * Note: A reserved zone cannot be freed.
+ * The zone can be released with rte_memzone_free().
  *
  * @param name
  *   The name of the memzone. If it already exists, the function will
@@ -195,7 +195,7 @@ const struct rte_memzone *rte_memzone_reserve_aligned(const char *name,
  * Memory buffer is reserved in a way, that it wouldn't cross specified
  * boundary. That implies that requested length should be less or equal
  * then boundary.
- * Note: A reserved zone cannot be freed.
+ * The zone can be released with rte_memzone_free().
  *
  * @param name
  *   The name of the memzone. If it already exists, the function will
@@ -239,6 +239,21 @@ const struct rte_memzone *rte_memzone_reserve_bounded(const char *name,
 			size_t len, int socket_id,
 			unsigned flags, unsigned align, unsigned bound);
 
+/**
+ * Free a memzone.
+ *
+ * The memory of the zone can be reserved again by a later memzone, and
+ * its descriptor must not be used anymore, by any process.
+ * Memzones shared by the host through IVSHMEM cannot be freed.
+ *
+ * @param mz
+ *   A pointer to the memzone descriptor.
+ * @return
+ *  - 0 on success.
+ *  - -EINVAL if mz is not a reserved memzone.
+ */
+int rte_memzone_free(const struct rte_memzone *mz);
+
 /**
  * Lookup for a memzone.
  *
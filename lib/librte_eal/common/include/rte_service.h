@@ -0,0 +1,371 @@
+/*-
+ *   BSD LICENSE
+ *
+ *   Copyright(c) 2010-2014 Intel Corporation. All rights reserved.
+ *   All rights reserved.
+ *
+ *   Redistribution and use in source and binary forms, with or without
+ *   modification, are permitted provided that the following conditions
+ *   are met:
+ *
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in
+ *       the documentation and/or other materials provided with the
+ *       distribution.
+ *     * Neither the name of Intel Corporation nor the names of its
+ *       contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ *   THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *   "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *   LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ *   A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ *   OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ *   SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ *   LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ *   DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ *   THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ *   (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ *   OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef _RTE_SERVICE_H_
+#define _RTE_SERVICE_H_
+
+/**
+ * @file
+ *
+ * Service cores
+ *
+ * A service is a function that must be called repeatedly to do some
+ * background work, such as managing timers, running a protocol state
+ * machine or collecting statistics. A component registers its service
+ * once, and the EAL calls it from the lcores that were turned into
+ * service lcores, instead of each application calling it from its own
+ * main loop.
+ *
+ * A service lcore is an EAL lcore that runs the services mapped to it
+ * in a loop. It is set with the --service-lcores EAL option or with
+ * rte_service_lcore_add(). Service lcores are not seen by
+ * RTE_LCORE_FOREACH() and rte_eal_mp_remote_launch(), so the
+ * application only launches its own work on the other lcores.
+ *
+ * A service runs only when it is started with rte_service_runstate_set()
+ * and mapped to at least one running service lcore with
+ * rte_service_map_lcore_set(). A service that is not multi-thread safe
+ * is called by only one lcore at a time, including the application lcores
+ * running it with rte_service_run_iter_on_app_lcore().
+ *
+ * The services and service lcores are local to the process. The
+ * configuration functions are not thread-safe, and must be called from
+ * one control thread.
+ */
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdio.h>
+#include <stdint.h>
+
+/** Maximum number of services that can be registered. */
+#define RTE_SERVICE_NUM_MAX 64
+
+/** Maximum length of the name of a service, including the '\0'. */
+#define RTE_SERVICE_NAME_MAX 32
+
+/**
+ * Capability of a service that can be called by several lcores at the
+ * same time. Such a service is not serialized.
+ */
+#define RTE_SERVICE_CAP_MT_SAFE (1 << 0)
+
+/**
+ * Definition of a service function.
+ *
+ * @param args
+ *   The callback_userdata of the service.
+ * @return
+ *   0 if some work was done, a negative value otherwise. The value
+ *   is only informative.
+ */
+typedef int32_t (*rte_service_func)(void *args);
+
+/**
+ * The description of a service, given at registration.
+ */
+struct rte_service_spec {
+	char name[RTE_SERVICE_NAME_MAX]; /**< Unique name of the service. */
+	rte_service_func callback;       /**< Function called to run it. */
+	void *callback_userdata;         /**< Argument of the callback. */
+	uint32_t capabilities;           /**< RTE_SERVICE_CAP_* flags. */
+	int socket_id; /**< Preferred socket of the lcores, or SOCKET_ID_ANY. */
+};
+
+/**
+ * Register a service.
+ *
+ * The service is stopped and not mapped to any lcore after
+ * registration.
+ *
+ * @param spec
+ *   The description of the service, copied by the function.
+ * @param service_id
+ *   If not NULL, the identifier of the new service is stored here.
+ * @return
+ *   - 0: Success.
+ *   - (-EINVAL): Invalid name or callback.
+ *   - (-EEXIST): A service with the same name is registered.
+ *   - (-ENOSPC): RTE_SERVICE_NUM_MAX services are already registered.
+ */
+int32_t rte_service_register(const struct rte_service_spec *spec,
+		uint32_t *service_id);
+
+/**
+ * Unregister a service.
+ *
+ * The service is removed from all service lcores. The caller must make
+ * sure that the service is not being run, for instance by stopping it
+ * and the lcores it is mapped to.
+ *
+ * @param id
+ *   The identifier of the service.
+ * @return
+ *   - 0: Success.
+ *   - (-EINVAL): No service with this identifier.
+ */
+int32_t rte_service_unregister(uint32_t id);
+
+/**
+ * Return the number of registered services.
+ */
+uint32_t rte_service_get_count(void);
+
+/**
+ * Look up a service by its name.
+ *
+ * @param name
+ *   The name of the service.
+ * @param service_id
+ *   The identifier of the service is stored here.
+ * @return
+ *   - 0: Success.
+ *   - (-EINVAL): Invalid parameter.
+ *   - (-ENODEV): No service with this name.
+ */
+int32_t rte_service_get_by_name(const char *name, uint32_t *service_id);
+
+/**
+ * Return the name of a service, or NULL if the identifier is invalid.
+ */
+const char *rte_service_get_name(uint32_t id);
+
+/**
+ * Start or stop a service.
+ *
+ * A started service is run by the service lcores it is mapped to.
+ *
+ * @param id
+ *   The identifier of the service.
+ * @param runstate
+ *   1 to start the service, 0 to stop it.
+ * @return
+ *   - 0: Success.
+ *   - (-EINVAL): No service with this identifier.
+ */
+int32_t rte_service_runstate_set(uint32_t id, uint32_t runstate);
+
+/**
+ * Get the run state of a service.
+ *
+ * @param id
+ *   The identifier of the service.
+ * @return
+ *   - 1: The service is started and mapped to a service lcore.
+ *   - 0: The service is stopped or not mapped.
+ *   - (-EINVAL): No service with this identifier.
+ */
+int32_t rte_service_runstate_get(uint32_t id);
+
+/**
+ * Enable or disable the run of a service by a service lcore.
+ *
+ * @param id
+ *   The identifier of the service.
+ * @param lcore
+ *   The service lcore.
+ * @param enable
+ *   1 to map the service to the lcore, 0 to unmap it.
+ * @return
+ *   - 0: Success.
+ *   - (-EINVAL): Invalid service, or the lcore is not a service lcore.
+ */
+int32_t rte_service_map_lcore_set(uint32_t id, uint32_t lcore,
+		uint32_t enable);
+
+/**
+ * Check if a service is mapped to a service lcore.
+ *
+ * @return
+ *   - 1: The service is mapped to the lcore.
+ *   - 0: The service is not mapped to the lcore.
+ *   - (-EINVAL): Invalid service, or the lcore is not a service lcore.
+ */
+int32_t rte_service_map_lcore_get(uint32_t id, uint32_t lcore);
+
+/**
+ * Run a service once on the calling lcore.
+ *
+ * This lets an application lcore run a service itself, for instance when
+ * no lcore can be given to services. A service that is not multi-thread
+ * safe is not run if a service lcore is running it at the same time.
+ *
+ * @param id
+ *   The identifier of the service.
+ * @return
+ *   - 0: The service was run.
+ *   - (-EINVAL): No service with this identifier.
+ *   - (-ENOEXEC): The service is stopped.
+ *   - (-EBUSY): The service is being run by another lcore.
+ */
+int32_t rte_service_run_iter_on_app_lcore(uint32_t id);
+
+/**
+ * Turn an lcore into a service lcore.
+ *
+ * The lcore must be an enabled slave lcore waiting for work. It is
+ * removed from the lcores seen by RTE_LCORE_FOREACH(), and rte_lcore_count()
+ * is decreased.
+ *
+ * @param lcore
+ *   The identifier of the lcore.
+ * @return
+ *   - 0: Success.
+ *   - (-EINVAL): The lcore is not enabled or is the master lcore.
+ *   - (-EALREADY): The lcore is already a service lcore.
+ *   - (-EBUSY): The lcore is running a function.
+ */
+int32_t rte_service_lcore_add(uint32_t lcore);
+
+/**
+ * Give a service lcore back to the application.
+ *
+ * @param lcore
+ *   The identifier of the service lcore.
+ * @return
+ *   - 0: Success.
+ *   - (-EINVAL): The lcore is not a service lcore.
+ *   - (-EBUSY): The lcore is running, it must be stopped first.
+ */
+int32_t rte_service_lcore_del(uint32_t lcore);
+
+/**
+ * Start a service lcore.
+ *
+ * The services mapped to the lcore are run in a loop launched with
+ * rte_eal_remote_launch(), until rte_service_lcore_stop() is called.
+ *
+ * @param lcore
+ *   The identifier of the service lcore.
+ * @return
+ *   - 0: Success.
+ *   - (-EINVAL): The lcore is not a service lcore.
+ *   - (-EALREADY): The lcore is already running.
+ *   - (-EBUSY): The lcore could not be launched.
+ */
+int32_t rte_service_lcore_start(uint32_t lcore);
+
+/**
+ * Stop a service lcore, and wait for the end of its loop.
+ *
+ * @param lcore
+ *   The identifier of the service lcore.
+ * @return
+ *   - 0: Success.
+ *   - (-EINVAL): The lcore is not a service lcore.
+ *   - (-EALREADY): The lcore is not running.
+ */
+int32_t rte_service_lcore_stop(uint32_t lcore);
+
+/**
+ * Return the number of service lcores.
+ */
+int32_t rte_service_lcore_count(void);
+
+/**
+ * Get the list of service lcores.
+ *
+ * @param array
+ *   The identifiers of the service lcores are stored here.
+ * @param n
+ *   The size of the array.
+ * @return
+ *   - The number of service lcores on success.
+ *   - (-ENOMEM): The array is too small.
+ */
+int32_t rte_service_lcore_list(uint32_t array[], uint32_t n);
+
+/**
+ * Enable or disable the measure of the cycles spent in a service.
+ *
+ * The calls to a service are always counted. When enabled, the TSC is
+ * also read around each call, to account the cycles spent in it.
+ *
+ * @param id
+ *   The identifier of the service.
+ * @param enable
+ *   1 to measure the cycles, 0 to stop measuring them.
+ * @return
+ *   - 0: Success.
+ *   - (-EINVAL): No service with this identifier.
+ */
+int32_t rte_service_set_stats_enable(uint32_t id, int32_t enable);
+
+/**
+ * Get the statistics of a service, summed over all lcores.
+ *
+ * @param id
+ *   The identifier of the service.
+ * @param calls
+ *   If not NULL, the number of calls to the service is stored here.
+ * @param cycles
+ *   If not NULL, the number of cycles spent in the service is stored here.
+ * @return
+ *   - 0: Success.
+ *   - (-EINVAL): No service with this identifier.
+ */
+int32_t rte_service_stats_get(uint32_t id, uint64_t *calls,
+		uint64_t *cycles);
+
+/**
+ * Reset the statistics of a service.
+ *
+ * @param id
+ *   The identifier of the service.
+ * @return
+ *   - 0: Success.
+ *   - (-EINVAL): No service with this identifier.
+ */
+int32_t rte_service_stats_reset(uint32_t id);
+
+/**
+ * Dump the state and statistics of a service to a file.
+ *
+ * @param f
+ *   A pointer to a file for output.
+ * @param id
+ *   The identifier of the service, or UINT32_MAX to dump all services
+ *   and service lcores.
+ * @return
+ *   - 0: Success.
+ *   - (-EINVAL): No service with this identifier.
+ */
+int32_t rte_service_dump(FILE *f, uint32_t id);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _RTE_SERVICE_H_ */
@@ -359,6 +359,8 @@ eal_usage(const char *prgname)
 	       "  --"OPT_CREATE_UIO_DEV"    Create /dev/uioX (usually done by hotplug)\n"
 	       "  --"OPT_VFIO_INTR"         Interrupt mode for VFIO (legacy|msi|msix)\n"
 	       "  --"OPT_XEN_DOM0"          Support running on Xen dom0 without hugetlbfs\n"
+	       "  --"OPT_SINGLE_FILE_SEGMENTS" Map hugepages with one file per socket\n"
+	       "                      (faster startup, physical addresses on demand)\n"
 	       "\n");
 	/* Allow the application to print its usage message too if hook is set */
 	if ( rte_application_usage_hook ) {
@@ -564,6 +566,10 @@ eal_parse_args(int argc, char **argv)
 #endif
 			break;
 
+		case OPT_SINGLE_FILE_SEGMENTS_NUM:
+			internal_config.single_file_segments = 1;
+			break;
+
 		case OPT_HUGE_DIR_NUM:
 			internal_config.hugepage_dir = optarg;
 			break;
@@ -638,6 +644,17 @@ eal_parse_args(int argc, char **argv)
 		return -1;
 	}
 
+	/* --single-file-segments only changes how hugetlbfs is used */
+	if (internal_config.single_file_segments &&
+	    (internal_config.no_hugetlbfs ||
+	     internal_config.xen_dom0_support)) {
+		RTE_LOG(ERR, EAL, "Option --"OPT_SINGLE_FILE_SEGMENTS" cannot be "
+			"specified together with --"OPT_NO_HUGE" or --"
+			OPT_XEN_DOM0"\n");
+		eal_usage(prgname);
+		return -1;
+	}
+
 	if (optind >= 0)
 		argv[optind-1] = prgname;
 	ret = optind-1;
@@ -841,6 +858,9 @@ rte_eal_init(int argc, char **argv)
 	rte_eal_mp_remote_launch(sync_func, NULL, SKIP_MASTER);
 	rte_eal_mp_wait_lcore();
 
+	if (rte_eal_service_init() < 0)
+		rte_panic("Cannot init service lcores\n");
+
 	/* Probe & Initialize PCI devices */
 	if (rte_eal_pci_probe())
 		rte_panic("Cannot probe PCI\n");
@@ -751,10 +751,11 @@ rte_eal_ivshmem_obj_init(void)
 	struct rte_ring_list* ring_list = NULL;
 	struct rte_mem_config * mcfg;
 	struct ivshmem_segment * seg;
-	struct rte_memzone * mz;
+	struct rte_memzone zone;
+	const struct rte_memzone * mz;
 	struct rte_ring * r;
 	struct rte_tailq_entry *te;
-	unsigned i, ms, idx;
+	unsigned i, ms;
 	uint64_t offset;
 
 	/* secondary process would not need any object discovery - it'll all
@@ -776,19 +777,10 @@ rte_eal_ivshmem_obj_init(void)
 
 		seg = &ivshmem_config->segment[i];
 
-		/* add memzone */
-		if (mcfg->memzone_idx == RTE_MAX_MEMZONE) {
-			RTE_LOG(ERR, EAL, "No more memory zones available!\n");
-			return -1;
-		}
-
-		idx = mcfg->memzone_idx;
-
 		RTE_LOG(DEBUG, EAL, "Found memzone: '%s' at %p (len 0x%" PRIx64 ")\n",
 				seg->entry.mz.name, seg->entry.mz.addr, seg->entry.mz.len);
 
-		memcpy(&mcfg->memzone[idx], &seg->entry.mz,
-				sizeof(struct rte_memzone));
+		memcpy(&zone, &seg->entry.mz, sizeof(struct rte_memzone));
 
 		/* find ioremap address */
 		for (ms = 0; ms <= RTE_MAX_MEMSEG; ms++) {
@@ -796,23 +788,28 @@ rte_eal_ivshmem_obj_init(void)
 				RTE_LOG(ERR, EAL, "Physical address of segment not found!\n");
 				return -1;
 			}
-			if (CONTAINS(mcfg->memseg[ms], mcfg->memzone[idx])) {
-				offset = mcfg->memzone[idx].addr_64 -
-								mcfg->memseg[ms].addr_64;
-				mcfg->memzone[idx].ioremap_addr = mcfg->memseg[ms].ioremap_addr +
+			if (CONTAINS(mcfg->memseg[ms], zone)) {
+				offset = zone.addr_64 - mcfg->memseg[ms].addr_64;
+				zone.ioremap_addr = mcfg->memseg[ms].ioremap_addr +
 						offset;
 				break;
 			}
 		}
 
-		mcfg->memzone_idx++;
+		/* add memzone */
+		if (rte_eal_memzone_add_fixed(&zone) == NULL) {
+			RTE_LOG(ERR, EAL, "Cannot add memzone '%s'!\n", zone.name);
+			return -1;
+		}
 	}
 
 	rte_rwlock_write_lock(RTE_EAL_TAILQ_RWLOCK);
 
 	/* find rings */
-	for (i = 0; i < mcfg->memzone_idx; i++) {
-		mz = &mcfg->memzone[i];
+	for (i = 0; i < ivshmem_config->segment_idx && i <= RTE_MAX_MEMZONE; i++) {
+		mz = rte_memzone_lookup(ivshmem_config->segment[i].entry.mz.name);
+		if (mz == NULL)
+			continue;
 
 		/* check if memzone has a ring prefix */
 		if (strncmp(mz->name, RTE_RING_MZ_PREFIX,
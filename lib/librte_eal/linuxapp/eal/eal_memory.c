@@ -80,6 +80,8 @@
 #include <errno.h>
 #include <sys/ioctl.h>
 #include <sys/time.h>
+#include <sys/syscall.h>
+#include <linux/mempolicy.h>
 
 #include <rte_log.h>
 #include <rte_memory.h>
@@ -135,6 +137,11 @@ rte_mem_virt2phy(const void *virtaddr)
 	int page_size;
 	off_t offset;
 
+	/* memory mapped by the application has its own address table */
+	physaddr = rte_extmem_virt2iova(virtaddr);
+	if (physaddr != RTE_BAD_PHYS_ADDR)
+		return physaddr;
+
 	/* standard page size */
 	page_size = getpagesize();
 
@@ -304,6 +311,7 @@ map_all_hugepages(struct hugepage_file *hugepg_tbl,
 		if (orig) {
 			hugepg_tbl[i].file_id = i;
 			hugepg_tbl[i].size = hugepage_sz;
+			hugepg_tbl[i].repeated = 1;
 #ifdef RTE_EAL_SINGLE_FILE_SEGMENTS
 			eal_get_hugefile_temp_path(hugepg_tbl[i].filepath,
 					sizeof(hugepg_tbl[i].filepath), hpi->hugedir,
@@ -1019,6 +1027,238 @@ calc_num_pages_per_socket(uint64_t * memory,
 	return total_num_pages;
 }
 
+/*
+ * Read the number of free hugepages of each size on each NUMA node from
+ * sysfs. Without NUMA support in the kernel, all free hugepages are
+ * accounted to socket 0.
+ */
+static void
+get_free_pages_per_socket(struct hugepage_info *hp_info, unsigned num_hp_info)
+{
+	char path[PATH_MAX];
+	unsigned long free_pages;
+	unsigned i, socket;
+	int found;
+
+	for (i = 0; i < num_hp_info; i++) {
+		uint32_t total = hp_info[i].num_pages[0];
+
+		found = 0;
+
+		memset(hp_info[i].num_pages, 0, sizeof(hp_info[i].num_pages));
+		for (socket = 0; socket < RTE_MAX_NUMA_NODES; socket++) {
+			snprintf(path, sizeof(path), "/sys/devices/system/node/"
+				"node%u/hugepages/hugepages-%" PRIu64 "kB/"
+				"free_hugepages", socket,
+				hp_info[i].hugepage_sz / 1024);
+			if (eal_parse_sysfs_value(path, &free_pages) < 0)
+				continue;
+			found = 1;
+			hp_info[i].num_pages[socket] =
+				RTE_MIN((uint32_t)free_pages, total);
+			total -= hp_info[i].num_pages[socket];
+		}
+		if (!found)
+			hp_info[i].num_pages[0] = total;
+	}
+}
+
+/*
+ * Allocate the hugepages of a file from a NUMA node, before they are mapped.
+ * The pages are taken with fallocate() under a memory policy bound to the
+ * node, so that a node without enough free hugepages is an error here
+ * instead of a SIGBUS when the pages are faulted in. Failing to set the
+ * policy is only fatal if the kernel is NUMA-aware and the node is not the
+ * first one.
+ */
+static int
+allocate_on_socket(int fd, size_t len, int socket)
+{
+	unsigned long nodemask[RTE_MAX_NUMA_NODES / (8 * sizeof(long)) + 1];
+	unsigned long oldmask[RTE_MAX_NUMA_NODES / (8 * sizeof(long)) + 1];
+	int oldpolicy, bound = 0, ret, err;
+
+	memset(nodemask, 0, sizeof(nodemask));
+	nodemask[socket / (8 * sizeof(long))] = 1UL << (socket % (8 * sizeof(long)));
+
+	if (syscall(__NR_get_mempolicy, &oldpolicy, oldmask,
+			sizeof(oldmask) * 8, NULL, 0) == 0 &&
+			syscall(__NR_set_mempolicy, MPOL_BIND, nodemask,
+			sizeof(nodemask) * 8) == 0)
+		bound = 1;
+	else if (socket != 0 || (errno != ENOSYS && errno != EINVAL)) {
+		RTE_LOG(ERR, EAL, "%s(): cannot bind memory to socket %d: %s\n",
+			__func__, socket, strerror(errno));
+		return -1;
+	}
+
+	ret = syscall(__NR_fallocate, fd, 0, (off_t)0, (off_t)len);
+	err = errno;
+
+	if (bound)
+		syscall(__NR_set_mempolicy, oldpolicy, oldmask,
+			sizeof(oldmask) * 8);
+
+	if (ret < 0) {
+		if (err == EOPNOTSUPP)
+			RTE_LOG(ERR, EAL, "%s(): hugetlbfs does not support "
+				"fallocate(), needed by --single-file-segments\n",
+				__func__);
+		else
+			RTE_LOG(ERR, EAL, "%s(): cannot allocate %zu MB of "
+				"hugepages on socket %d: %s\n", __func__,
+				len >> 20, socket, strerror(err));
+		return -1;
+	}
+	return 0;
+}
+
+/*
+ * Map the hugepages with one file per socket and page size, when
+ * --single-file-segments is given. The pages of each file are allocated on
+ * its socket, and the file is mapped once and becomes one memory segment.
+ *
+ * Unlike rte_eal_hugepage_init(), the physical address of each page is not
+ * looked up and the pages are not sorted: startup only costs the page
+ * faults. As with --no-huge, the phys_addr of the segments is their virtual
+ * address, which can only be used as IO address with an IOMMU: PCI devices
+ * not bound to VFIO are refused at probe time. The physical address of a
+ * page is resolved on demand with rte_mem_virt2phy().
+ */
+static int
+single_file_hugepage_init(void)
+{
+	struct rte_mem_config *mcfg;
+	struct hugepage_file *hugepage;
+	struct hugepage_info hp_info[MAX_HUGEPAGE_SIZES];
+	struct hugepage_info used_hp[MAX_HUGEPAGE_SIZES];
+	uint64_t memory[RTE_MAX_NUMA_NODES];
+	unsigned i, socket, num_hp_info;
+	int nr_files = 0, file_id = 0, j, fd;
+	size_t len, off;
+	void *addr, *va;
+
+	mcfg = rte_eal_get_configuration()->mem_config;
+	num_hp_info = internal_config.num_hugepage_sizes;
+
+	memcpy(hp_info, internal_config.hugepage_info, sizeof(hp_info));
+	get_free_pages_per_socket(hp_info, num_hp_info);
+	memcpy(internal_config.hugepage_info, hp_info, sizeof(hp_info));
+
+	memset(used_hp, 0, sizeof(used_hp));
+	for (i = 0; i < num_hp_info; i++)
+		used_hp[i].hugepage_sz = hp_info[i].hugepage_sz;
+	for (i = 0; i < RTE_MAX_NUMA_NODES; i++)
+		memory[i] = internal_config.socket_mem[i];
+
+	if (calc_num_pages_per_socket(memory, hp_info, used_hp,
+			num_hp_info) < 0)
+		return -1;
+
+	for (i = 0; i < num_hp_info; i++)
+		for (socket = 0; socket < RTE_MAX_NUMA_NODES; socket++)
+			if (used_hp[i].num_pages[socket] != 0)
+				nr_files++;
+
+	hugepage = create_shared_memory(eal_hugepage_info_path(),
+			nr_files * sizeof(struct hugepage_file));
+	if (hugepage == NULL) {
+		RTE_LOG(ERR, EAL, "Failed to create shared memory!\n");
+		return -1;
+	}
+	memset(hugepage, 0, nr_files * sizeof(struct hugepage_file));
+
+	/* find earliest free memseg, see rte_eal_hugepage_init() */
+	for (j = 0; j < RTE_MAX_MEMSEG; j++)
+		if (mcfg->memseg[j].addr == NULL)
+			break;
+
+	for (i = 0; i < num_hp_info; i++) {
+		for (socket = 0; socket < RTE_MAX_NUMA_NODES; socket++) {
+			struct hugepage_file *hf = &hugepage[file_id];
+			uint64_t hugepage_sz = used_hp[i].hugepage_sz;
+
+			if (used_hp[i].num_pages[socket] == 0)
+				continue;
+
+			if (j == RTE_MAX_MEMSEG) {
+				RTE_LOG(ERR, EAL, "Not enough memsegs, increase "
+					"%s\n", RTE_STR(CONFIG_RTE_MAX_MEMSEG));
+				return -ENOMEM;
+			}
+
+			RTE_LOG(INFO, EAL, "Requesting %u pages of size %uMB "
+				"from socket %u\n", used_hp[i].num_pages[socket],
+				(unsigned)(hugepage_sz / 0x100000), socket);
+
+			hf->file_id = file_id;
+			hf->size = hugepage_sz;
+			hf->repeated = used_hp[i].num_pages[socket];
+			hf->socket_id = socket;
+			hf->memseg_id = j;
+			hf->physaddr = 0;
+			eal_get_hugefile_path(hf->filepath, sizeof(hf->filepath),
+					used_hp[i].hugedir, file_id);
+
+			len = hugepage_sz * hf->repeated;
+			addr = get_virtual_area(&len, hugepage_sz);
+			if (addr == NULL || len != hugepage_sz * hf->repeated) {
+				RTE_LOG(ERR, EAL, "%s(): cannot reserve a virtual "
+					"area of %" PRIu64 " pages\n", __func__,
+					(uint64_t)hf->repeated);
+				return -1;
+			}
+
+			fd = open(hf->filepath, O_CREAT | O_RDWR, 0755);
+			if (fd < 0) {
+				RTE_LOG(ERR, EAL, "%s(): open failed: %s\n",
+					__func__, strerror(errno));
+				return -1;
+			}
+
+			if (allocate_on_socket(fd, len, socket) < 0) {
+				close(fd);
+				return -1;
+			}
+
+			va = mmap(addr, len, PROT_READ | PROT_WRITE,
+					MAP_SHARED, fd, 0);
+			if (va == MAP_FAILED) {
+				RTE_LOG(ERR, EAL, "%s(): mmap failed: %s\n",
+					__func__, strerror(errno));
+				close(fd);
+				return -1;
+			}
+
+			/* set shared flock on the file. */
+			if (flock(fd, LOCK_SH | LOCK_NB) == -1) {
+				RTE_LOG(ERR, EAL, "%s(): Locking file failed:%s\n",
+					__func__, strerror(errno));
+				close(fd);
+				return -1;
+			}
+			close(fd);
+
+			/* fault the pages in, they are zeroed by the kernel */
+			for (off = 0; off < len; off += hugepage_sz)
+				*(volatile char *)RTE_PTR_ADD(va, off) = 0;
+
+			hf->orig_va = NULL;
+			hf->final_va = va;
+
+			mcfg->memseg[j].phys_addr = (phys_addr_t)(uintptr_t)va;
+			mcfg->memseg[j].addr = va;
+			mcfg->memseg[j].len = len;
+			mcfg->memseg[j].socket_id = socket;
+			mcfg->memseg[j].hugepage_sz = hugepage_sz;
+			j++;
+			file_id++;
+		}
+	}
+
+	return 0;
+}
+
 /*
  * Prepare physical memory mapping: fill configuration structure with
  * these infos, return 0 on success.
@@ -1079,6 +1319,9 @@ rte_eal_hugepage_init(void)
 #endif
 	}
 
+	/* map one file per socket, without looking at physical addresses */
+	if (internal_config.single_file_segments)
+		return single_file_hugepage_init();
 
 	/* calculate total number of hugepages available. at this point we haven't
 	 * yet started sorting them so they all are on socket 0 */
@@ -1493,11 +1736,7 @@ rte_eal_hugepage_attach(void)
 						hp[i].filepath);
 					goto error;
 				}
-#ifdef RTE_EAL_SINGLE_FILE_SEGMENTS
 				mapping_size = hp[i].size * hp[i].repeated;
-#else
-				mapping_size = hp[i].size;
-#endif
 				addr = mmap(RTE_PTR_ADD(base_addr, offset),
 						mapping_size, PROT_READ | PROT_WRITE,
 						MAP_SHARED, fd, 0);
@@ -46,6 +46,7 @@
 #include "eal_filesystem.h"
 #include "eal_private.h"
 #include "eal_pci_init.h"
+#include "eal_internal_cfg.h"
 
 /**
  * @file
@@ -591,6 +592,25 @@ pci_map_device(struct rte_pci_device *dev)
 	return ret;
 }
 
+/*
+ * Check that the device can DMA to the memory segments: with
+ * --single-file-segments, their phys_addr is a virtual address, which only
+ * the IOMMU programmed by VFIO translates.
+ */
+static int
+pci_check_dma_addr(struct rte_pci_device *dev)
+{
+	if (!internal_config.single_file_segments)
+		return 0;
+#ifdef VFIO_PRESENT
+	if (dev->kdrv == RTE_KDRV_VFIO && pci_vfio_is_enabled())
+		return 0;
+#endif
+	RTE_LOG(ERR, EAL, "  Device is not bound to vfio-pci, it cannot be "
+		"used with --single-file-segments\n");
+	return -1;
+}
+
 #ifdef RTE_LIBRTE_EAL_HOTPLUG
 static void
 pci_unmap_device(struct rte_pci_device *dev)
@@ -658,6 +678,9 @@ rte_eal_pci_probe_one_driver(struct rte_pci_driver *dr, struct rte_pci_device *d
 			return 1;
 		}
 
+		if (pci_check_dma_addr(dev) < 0)
+			return -1;
+
 		if (dr->drv_flags & RTE_PCI_DRV_NEED_MAPPING) {
 #ifdef RTE_PCI_CONFIG
 			/*
@@ -192,11 +192,86 @@ pci_vfio_set_bus_master(int dev_fd)
 	return 0;
 }
 
+/*
+ * map or unmap the pages of an external memory area for DMA, merging the
+ * pages which are contiguous in I/O address space. Pages without an I/O
+ * address are skipped.
+ */
+static int
+pci_vfio_extmem_dma(int vfio_container_fd, const struct rte_extmem *ext,
+		int map)
+{
+	const phys_addr_t *iova_tbl = ext->iova_mz->addr;
+	uint64_t n_pages = ext->len / ext->page_sz;
+	uint64_t start, end;
+	int ret;
+
+	for (start = 0; start < n_pages; start = end) {
+		end = start + 1;
+		if (iova_tbl[start] == RTE_BAD_PHYS_ADDR)
+			continue;
+		while (end < n_pages && iova_tbl[end] != RTE_BAD_PHYS_ADDR &&
+				iova_tbl[end] == iova_tbl[end - 1] + ext->page_sz)
+			end++;
+
+		if (map) {
+			struct vfio_iommu_type1_dma_map dma_map;
+
+			memset(&dma_map, 0, sizeof(dma_map));
+			dma_map.argsz = sizeof(struct vfio_iommu_type1_dma_map);
+			dma_map.vaddr = ext->addr_64 + start * ext->page_sz;
+			dma_map.size = (end - start) * ext->page_sz;
+			dma_map.iova = iova_tbl[start];
+			dma_map.flags = VFIO_DMA_MAP_FLAG_READ |
+				VFIO_DMA_MAP_FLAG_WRITE;
+
+			ret = ioctl(vfio_container_fd, VFIO_IOMMU_MAP_DMA,
+					&dma_map);
+		} else {
+			struct vfio_iommu_type1_dma_unmap dma_unmap;
+
+			memset(&dma_unmap, 0, sizeof(dma_unmap));
+			dma_unmap.argsz =
+				sizeof(struct vfio_iommu_type1_dma_unmap);
+			dma_unmap.size = (end - start) * ext->page_sz;
+			dma_unmap.iova = iova_tbl[start];
+
+			ret = ioctl(vfio_container_fd, VFIO_IOMMU_UNMAP_DMA,
+					&dma_unmap);
+		}
+
+		if (ret) {
+			RTE_LOG(ERR, EAL, "  cannot %s external memory %p for "
+					"DMA, error %i (%s)\n", map ? "map" : "unmap",
+					ext->addr, errno, strerror(errno));
+			return -1;
+		}
+	}
+
+	return 0;
+}
+
+/*
+ * the DMA mappings of the container are set up by the primary process once
+ * a group is attached, and are shared with the secondary processes which
+ * got the container from it.
+ */
+static int
+pci_vfio_container_has_dma(void)
+{
+	if (vfio_cfg.vfio_enabled == 0)
+		return 0;
+	if (internal_config.process_type == RTE_PROC_PRIMARY)
+		return vfio_cfg.vfio_container_has_dma;
+	return vfio_cfg.vfio_group_idx > 0;
+}
+
 /* set up DMA mappings */
 static int
 pci_vfio_setup_dma_maps(int vfio_container_fd)
 {
 	const struct rte_memseg *ms = rte_eal_get_physmem_layout();
+	struct rte_mem_config *mcfg;
 	int i, ret;
 
 	ret = ioctl(vfio_container_fd, VFIO_SET_IOMMU,
@@ -230,7 +305,24 @@ pci_vfio_setup_dma_maps(int vfio_container_fd)
 		}
 	}
 
-	return 0;
+	/*
+	 * map the external memory registered so far. Holding the lock until
+	 * the container is flagged makes the areas registered from now on be
+	 * mapped by rte_extmem_register().
+	 */
+	mcfg = rte_eal_get_configuration()->mem_config;
+	rte_rwlock_read_lock(&mcfg->extlock);
+	for (i = 0; i < (int)mcfg->nb_extmem; i++) {
+		ret = pci_vfio_extmem_dma(vfio_container_fd,
+				&mcfg->extmem[i], 1);
+		if (ret)
+			break;
+	}
+	if (ret == 0)
+		vfio_cfg.vfio_container_has_dma = 1;
+	rte_rwlock_read_unlock(&mcfg->extlock);
+
+	return ret;
 }
 
 /* set up interrupt support (but not enable interrupts) */
@@ -657,7 +749,6 @@ pci_vfio_map_resource(struct rte_pci_device *dev)
 					"error %i (%s)\n", pci_addr, errno, strerror(errno));
 			return -1;
 		}
-		vfio_cfg.vfio_container_has_dma = 1;
 	}
 
 	/* get a file descriptor for the device */
@@ -909,4 +1000,40 @@ pci_vfio_is_enabled(void)
 {
 	return vfio_cfg.vfio_enabled;
 }
+
+int
+rte_eal_extmem_dma_map(const struct rte_extmem *ext)
+{
+	if (!pci_vfio_container_has_dma())
+		return 0;
+
+	if (pci_vfio_extmem_dma(vfio_cfg.vfio_container_fd, ext, 1) < 0) {
+		/* drop the pages mapped before the failure */
+		pci_vfio_extmem_dma(vfio_cfg.vfio_container_fd, ext, 0);
+		return -1;
+	}
+	return 0;
+}
+
+int
+rte_eal_extmem_dma_unmap(const struct rte_extmem *ext)
+{
+	if (!pci_vfio_container_has_dma())
+		return 0;
+
+	return pci_vfio_extmem_dma(vfio_cfg.vfio_container_fd, ext, 0);
+}
+#else
+
+int
+rte_eal_extmem_dma_map(const struct rte_extmem *ext __rte_unused)
+{
+	return 0;
+}
+
+int
+rte_eal_extmem_dma_unmap(const struct rte_extmem *ext __rte_unused)
+{
+	return 0;
+}
 #endif
@@ -55,6 +55,10 @@
 #include <rte_log.h>
 #include <rte_rwlock.h>
 #include <rte_spinlock.h>
+#include <rte_ring.h>
+#if defined(RTE_MACHINE_CPUFLAG_SSE2)
+#include <rte_vect.h>
+#endif
 
 #include "rte_hash.h"
 
@@ -92,6 +96,45 @@ EAL_REGISTER_TAILQ(rte_hash_tailq)
 /* The high bit is always set in real signatures */
 #define NULL_SIGNATURE          0
 
+/* Key index stored in a cuckoo bucket entry that holds no key */
+#define EMPTY_SLOT              0
+
+/* Maximum number of buckets visited when searching for a displacement path */
+#define CUCKOO_BFS_QUEUE_MAX_LEN 512
+
+/* Distance, in keys, of bucket pre-fetches ahead of signature compares */
+#define CUCKOO_PREFETCH_OFFSET  8
+
+/*
+ * Cuckoo bucket. Signatures and key indexes of all entries share one cache
+ * line, so a bucket can be checked with a single memory access.
+ */
+struct rte_hash_bucket {
+	hash_sig_t sig_current[RTE_HASH_CUCKOO_BUCKET_ENTRIES];
+	hash_sig_t sig_alt[RTE_HASH_CUCKOO_BUCKET_ENTRIES];
+	uint32_t key_idx[RTE_HASH_CUCKOO_BUCKET_ENTRIES];
+} __rte_cache_aligned;
+
+/*
+ * Slot of the cuckoo key store. The user data sits next to the key, so a
+ * lookup returning the data touches no extra cache line.
+ */
+struct rte_hash_key {
+	union {
+		uintptr_t idata;
+		void *pdata;
+	};
+	/* Variable key size */
+	char key[0];
+} __attribute__((aligned(KEY_ALIGNMENT)));
+
+/* Node of the breadth-first search for a cuckoo displacement path */
+struct cuckoo_path_node {
+	struct rte_hash_bucket *bkt;	/* Bucket visited by this node */
+	struct cuckoo_path_node *prev;	/* Node the entry is moved from */
+	int prev_slot;			/* Entry of prev moved into bkt */
+};
+
 /* Returns a pointer to the first signature in specified bucket. */
 static inline hash_sig_t *
 get_sig_tbl_bucket(const struct rte_hash *h, uint32_t bucket_index)
@@ -141,6 +184,26 @@ find_first(uint32_t sig, const uint32_t *sig_bucket, uint32_t num_sigs)
 	return -1;
 }
 
+/* Returns the signature used to find the alternate bucket of a key. */
+static inline hash_sig_t
+rte_hash_secondary_hash(const hash_sig_t primary_hash)
+{
+	static const unsigned all_bits_shift = 12;
+	static const unsigned alt_bits_xor = 0x5bd1e995;
+
+	uint32_t tag = primary_hash >> all_bits_shift;
+
+	return primary_hash ^ ((tag + 1) * alt_bits_xor);
+}
+
+/* Returns a pointer to the cuckoo key slot with the specified index. */
+static inline struct rte_hash_key *
+get_key_from_store(const struct rte_hash *h, uint32_t key_idx)
+{
+	return (struct rte_hash_key *)
+		&h->key_store[(size_t)key_idx * h->key_entry_size];
+}
+
 struct rte_hash *
 rte_hash_find_existing(const char *name)
 {
@@ -170,20 +233,30 @@ rte_hash_create(const struct rte_hash_parameters *params)
 {
 	struct rte_hash *h = NULL;
 	struct rte_tailq_entry *te;
-	uint32_t num_buckets, sig_bucket_size, key_size,
-		hash_tbl_size, sig_tbl_size, key_tbl_size, mem_size;
+	uint32_t num_buckets, sig_bucket_size, key_size, bucket_entries;
+	size_t hash_tbl_size, sig_tbl_size, key_tbl_size, mem_size;
+	size_t ring_size, data_tbl_size;
+	uint32_t num_key_slots, ring_count, i;
 	char hash_name[RTE_HASH_NAMESIZE];
 	struct rte_hash_list *hash_list;
+	int cuckoo;
 
 	hash_list = RTE_TAILQ_CAST(rte_hash_tailq.head, rte_hash_list);
 
+	cuckoo = (params != NULL) &&
+		(params->extra_flag & (RTE_HASH_EXTRA_FLAGS_CUCKOO |
+				       RTE_HASH_EXTRA_FLAGS_RW_CONCURRENCY |
+				       RTE_HASH_EXTRA_FLAGS_MULTI_WRITER_ADD));
+	bucket_entries = cuckoo ? RTE_HASH_CUCKOO_BUCKET_ENTRIES :
+		(params != NULL ? params->bucket_entries : 0);
+
 	/* Check for valid parameters */
 	if ((params == NULL) ||
 			(params->entries > RTE_HASH_ENTRIES_MAX) ||
-			(params->bucket_entries > RTE_HASH_BUCKET_ENTRIES_MAX) ||
-			(params->entries < params->bucket_entries) ||
+			(bucket_entries > RTE_HASH_BUCKET_ENTRIES_MAX) ||
+			(params->entries < bucket_entries) ||
 			!rte_is_power_of_2(params->entries) ||
-			!rte_is_power_of_2(params->bucket_entries) ||
+			!rte_is_power_of_2(bucket_entries) ||
 			(params->key_len == 0) ||
 			(params->key_len > RTE_HASH_KEY_LENGTH_MAX)) {
 		rte_errno = EINVAL;
@@ -194,19 +267,43 @@ rte_hash_create(const struct rte_hash_parameters *params)
 	snprintf(hash_name, sizeof(hash_name), "HT_%s", params->name);
 
 	/* Calculate hash dimensions */
-	num_buckets = params->entries / params->bucket_entries;
-	sig_bucket_size = align_size(params->bucket_entries *
-				     sizeof(hash_sig_t), SIG_BUCKET_ALIGNMENT);
+	num_buckets = params->entries / bucket_entries;
 	key_size =  align_size(params->key_len, KEY_ALIGNMENT);
-
 	hash_tbl_size = align_size(sizeof(struct rte_hash), RTE_CACHE_LINE_SIZE);
-	sig_tbl_size = align_size(num_buckets * sig_bucket_size,
-				  RTE_CACHE_LINE_SIZE);
-	key_tbl_size = align_size(num_buckets * key_size *
-				  params->bucket_entries, RTE_CACHE_LINE_SIZE);
+
+	if (cuckoo) {
+		/*
+		 * Key slot 0 is never used, so that an empty bucket entry can
+		 * be told apart from a used one by its key index alone.
+		 */
+		num_key_slots = params->entries + 1;
+		ring_count = rte_align32pow2(num_key_slots);
+		key_size = align_size(sizeof(struct rte_hash_key) +
+				      params->key_len, KEY_ALIGNMENT);
+		sig_bucket_size = 0;
+		sig_tbl_size = (size_t)num_buckets *
+			sizeof(struct rte_hash_bucket);
+		key_tbl_size = RTE_ALIGN((size_t)num_key_slots * key_size,
+					 RTE_CACHE_LINE_SIZE);
+		ring_size = rte_ring_get_memsize(ring_count);
+		data_tbl_size = 0;
+	} else {
+		num_key_slots = 0;
+		ring_count = 0;
+		sig_bucket_size = align_size(bucket_entries *
+				sizeof(hash_sig_t), SIG_BUCKET_ALIGNMENT);
+		sig_tbl_size = RTE_ALIGN((size_t)num_buckets * sig_bucket_size,
+					 RTE_CACHE_LINE_SIZE);
+		key_tbl_size = RTE_ALIGN((size_t)num_buckets * key_size *
+				bucket_entries, RTE_CACHE_LINE_SIZE);
+		ring_size = 0;
+		data_tbl_size = RTE_ALIGN((size_t)params->entries *
+				sizeof(void *), RTE_CACHE_LINE_SIZE);
+	}
 
 	/* Total memory required for hash context */
-	mem_size = hash_tbl_size + sig_tbl_size + key_tbl_size;
+	mem_size = hash_tbl_size + sig_tbl_size + key_tbl_size + ring_size +
+		data_tbl_size;
 
 	rte_rwlock_write_lock(RTE_EAL_TAILQ_RWLOCK);
 
@@ -236,18 +333,54 @@ rte_hash_create(const struct rte_hash_parameters *params)
 	/* Setup hash context */
 	snprintf(h->name, sizeof(h->name), "%s", params->name);
 	h->entries = params->entries;
-	h->bucket_entries = params->bucket_entries;
+	h->bucket_entries = bucket_entries;
 	h->key_len = params->key_len;
 	h->hash_func_init_val = params->hash_func_init_val;
 	h->num_buckets = num_buckets;
 	h->bucket_bitmask = h->num_buckets - 1;
 	h->sig_msb = 1 << (sizeof(hash_sig_t) * 8 - 1);
-	h->sig_tbl = (uint8_t *)h + hash_tbl_size;
-	h->sig_tbl_bucket_size = sig_bucket_size;
-	h->key_tbl = h->sig_tbl + sig_tbl_size;
-	h->key_tbl_key_size = key_size;
 	h->hash_func = (params->hash_func == NULL) ?
 		DEFAULT_HASH_FUNC : params->hash_func;
+	h->extra_flag = params->extra_flag;
+	if (h->extra_flag & RTE_HASH_EXTRA_FLAGS_MULTI_WRITER_ADD)
+		h->extra_flag |= RTE_HASH_EXTRA_FLAGS_RW_CONCURRENCY;
+	if (h->extra_flag & RTE_HASH_EXTRA_FLAGS_RW_CONCURRENCY)
+		h->extra_flag |= RTE_HASH_EXTRA_FLAGS_CUCKOO;
+	rte_spinlock_init(&h->writer_lock);
+
+	/* Select the widest signature compare supported by this CPU */
+	h->sig_cmp_fn = RTE_HASH_COMPARE_SCALAR;
+#if defined(RTE_MACHINE_CPUFLAG_AVX2)
+	if (rte_cpu_get_flag_enabled(RTE_CPUFLAG_AVX2))
+		h->sig_cmp_fn = RTE_HASH_COMPARE_AVX2;
+	else
+#endif
+#if defined(RTE_MACHINE_CPUFLAG_SSE2)
+	if (rte_cpu_get_flag_enabled(RTE_CPUFLAG_SSE2))
+		h->sig_cmp_fn = RTE_HASH_COMPARE_SSE;
+#endif
+
+	if (cuckoo) {
+		h->buckets = (struct rte_hash_bucket *)
+			((uint8_t *)h + hash_tbl_size);
+		h->key_store = (uint8_t *)h->buckets + sig_tbl_size;
+		h->key_entry_size = key_size;
+		h->free_slots = (struct rte_ring *)
+			(h->key_store + key_tbl_size);
+		rte_ring_init(h->free_slots, hash_name, ring_count,
+			      RING_F_SP_ENQ | RING_F_SC_DEQ);
+
+		/* Populate free slots ring, skipping the unused slot 0 */
+		for (i = 1; i < num_key_slots; i++)
+			rte_ring_sp_enqueue(h->free_slots,
+					    (void *)((uintptr_t) i));
+	} else {
+		h->sig_tbl = (uint8_t *)h + hash_tbl_size;
+		h->sig_tbl_bucket_size = sig_bucket_size;
+		h->key_tbl = h->sig_tbl + sig_tbl_size;
+		h->key_tbl_key_size = key_size;
+		h->data_tbl = (void **)(h->key_tbl + key_tbl_size);
+	}
 
 	te->data = (void *) h;
 
@@ -291,9 +424,501 @@ rte_hash_free(struct rte_hash *h)
 	rte_free(te);
 }
 
+/*
+ * Writers of the cuckoo engine make the change counter odd while they move or
+ * remove entries, so that lock-free readers can detect that a key may have
+ * been missed and retry.
+ */
+static inline void
+cuckoo_write_begin(const struct rte_hash *h)
+{
+	struct rte_hash *wh = (struct rte_hash *)(uintptr_t)h;
+
+	wh->change_cnt++;
+	rte_smp_wmb();
+}
+
+static inline void
+cuckoo_write_end(const struct rte_hash *h)
+{
+	struct rte_hash *wh = (struct rte_hash *)(uintptr_t)h;
+
+	rte_smp_wmb();
+	wh->change_cnt++;
+}
+
+/* Waits for in-progress updates and returns the change counter. */
+static inline uint32_t
+cuckoo_read_begin(const struct rte_hash *h)
+{
+	uint32_t cnt;
+
+	while (unlikely((cnt = h->change_cnt) & 1))
+		rte_pause();
+	rte_smp_rmb();
+	return cnt;
+}
+
+/* Returns non-zero if the table changed since cuckoo_read_begin(). */
+static inline int
+cuckoo_read_retry(const struct rte_hash *h, uint32_t cnt)
+{
+	rte_smp_rmb();
+	return unlikely(h->change_cnt != cnt);
+}
+
+/*
+ * Search the cuckoo graph breadth-first, starting from the two candidate
+ * buckets of a new key, for the shortest chain of entries that can be moved
+ * to their alternate bucket so that one of the candidate buckets gets a free
+ * entry. The search is bounded by CUCKOO_BFS_QUEUE_MAX_LEN, which bounds the
+ * insertion time. On success the entries along the path are moved and the
+ * index of the freed entry is returned, with *bkt set to the bucket holding
+ * it. Returns -ENOSPC if no path was found.
+ */
+static inline int
+cuckoo_make_space(const struct rte_hash *h, struct rte_hash_bucket **bkt,
+		  struct rte_hash_bucket *prim_bkt,
+		  struct rte_hash_bucket *sec_bkt)
+{
+	struct cuckoo_path_node queue[CUCKOO_BFS_QUEUE_MAX_LEN];
+	struct cuckoo_path_node *tail, *head, *node, *prev_node;
+	struct rte_hash_bucket *curr_bkt, *prev_bkt;
+	int i, slot, prev_slot;
+
+	queue[0].bkt = prim_bkt;
+	queue[0].prev = NULL;
+	queue[0].prev_slot = -1;
+	queue[1].bkt = sec_bkt;
+	queue[1].prev = NULL;
+	queue[1].prev_slot = -1;
+	tail = &queue[0];
+	head = &queue[2];
+
+	while (likely(tail != head && head <= &queue[CUCKOO_BFS_QUEUE_MAX_LEN -
+			RTE_HASH_CUCKOO_BUCKET_ENTRIES])) {
+		curr_bkt = tail->bkt;
+		for (i = 0; i < RTE_HASH_CUCKOO_BUCKET_ENTRIES; i++) {
+			if (curr_bkt->key_idx[i] == EMPTY_SLOT)
+				break;
+		}
+
+		if (i == RTE_HASH_CUCKOO_BUCKET_ENTRIES) {
+			/* Bucket full, queue the alternate of every entry */
+			for (i = 0; i < RTE_HASH_CUCKOO_BUCKET_ENTRIES; i++) {
+				head->bkt = &h->buckets[curr_bkt->sig_alt[i] &
+							h->bucket_bitmask];
+				head->prev = tail;
+				head->prev_slot = i;
+				head++;
+			}
+			tail++;
+			continue;
+		}
+
+		/*
+		 * Free entry found: walk the path back, moving every entry
+		 * into the entry freed by the previous move.
+		 */
+		node = tail;
+		slot = i;
+		while (node->prev != NULL) {
+			prev_node = node->prev;
+			prev_bkt = prev_node->bkt;
+			prev_slot = node->prev_slot;
+
+			curr_bkt->sig_current[slot] = prev_bkt->sig_alt[prev_slot];
+			curr_bkt->sig_alt[slot] = prev_bkt->sig_current[prev_slot];
+			curr_bkt->key_idx[slot] = prev_bkt->key_idx[prev_slot];
+
+			slot = prev_slot;
+			node = prev_node;
+			curr_bkt = prev_bkt;
+		}
+		*bkt = curr_bkt;
+		return slot;
+	}
+
+	return -ENOSPC;
+}
+
 static inline int32_t
-__rte_hash_add_key_with_hash(const struct rte_hash *h,
+cuckoo_add_key(const struct rte_hash *h, const void *key, hash_sig_t sig,
+	       void *data)
+{
+	struct rte_hash_key *k;
+	hash_sig_t alt_hash;
+	struct rte_hash_bucket *prim_bkt, *sec_bkt, *bkt;
+	void *slot_id;
+	uint32_t key_idx;
+	unsigned i;
+	int ret;
+
+	alt_hash = rte_hash_secondary_hash(sig);
+	prim_bkt = &h->buckets[sig & h->bucket_bitmask];
+	sec_bkt = &h->buckets[alt_hash & h->bucket_bitmask];
+	rte_prefetch0(prim_bkt);
+	rte_prefetch0(sec_bkt);
+
+	/* Check if key is already present in the hash, update its data */
+	for (i = 0; i < RTE_HASH_CUCKOO_BUCKET_ENTRIES; i++) {
+		if (prim_bkt->sig_current[i] != sig ||
+				prim_bkt->key_idx[i] == EMPTY_SLOT)
+			continue;
+		k = get_key_from_store(h, prim_bkt->key_idx[i]);
+		if (memcmp(key, k->key, h->key_len) == 0) {
+			k->pdata = data;
+			return prim_bkt->key_idx[i] - 1;
+		}
+	}
+	for (i = 0; i < RTE_HASH_CUCKOO_BUCKET_ENTRIES; i++) {
+		if (sec_bkt->sig_current[i] != alt_hash ||
+				sec_bkt->sig_alt[i] != sig ||
+				sec_bkt->key_idx[i] == EMPTY_SLOT)
+			continue;
+		k = get_key_from_store(h, sec_bkt->key_idx[i]);
+		if (memcmp(key, k->key, h->key_len) == 0) {
+			k->pdata = data;
+			return sec_bkt->key_idx[i] - 1;
+		}
+	}
+
+	/* Get a free slot in the key store */
+	if (rte_ring_sc_dequeue(h->free_slots, &slot_id) != 0)
+		return -ENOSPC;
+	key_idx = (uint32_t)((uintptr_t) slot_id);
+	k = get_key_from_store(h, key_idx);
+	rte_memcpy(k->key, key, h->key_len);
+	k->pdata = data;
+
+	/* Use a free entry of the primary bucket, then of the secondary */
+	for (i = 0; i < RTE_HASH_CUCKOO_BUCKET_ENTRIES; i++) {
+		if (prim_bkt->key_idx[i] == EMPTY_SLOT) {
+			prim_bkt->sig_current[i] = sig;
+			prim_bkt->sig_alt[i] = alt_hash;
+			rte_smp_wmb();
+			prim_bkt->key_idx[i] = key_idx;
+			return key_idx - 1;
+		}
+	}
+	for (i = 0; i < RTE_HASH_CUCKOO_BUCKET_ENTRIES; i++) {
+		if (sec_bkt->key_idx[i] == EMPTY_SLOT) {
+			sec_bkt->sig_current[i] = alt_hash;
+			sec_bkt->sig_alt[i] = sig;
+			rte_smp_wmb();
+			sec_bkt->key_idx[i] = key_idx;
+			return key_idx - 1;
+		}
+	}
+
+	/* Both buckets are full, displace existing entries */
+	cuckoo_write_begin(h);
+	ret = cuckoo_make_space(h, &bkt, prim_bkt, sec_bkt);
+	if (ret < 0) {
+		cuckoo_write_end(h);
+		rte_ring_sp_enqueue(h->free_slots,
+				    (void *)((uintptr_t) key_idx));
+		return ret;
+	}
+
+	if (bkt == prim_bkt) {
+		bkt->sig_current[ret] = sig;
+		bkt->sig_alt[ret] = alt_hash;
+	} else {
+		bkt->sig_current[ret] = alt_hash;
+		bkt->sig_alt[ret] = sig;
+	}
+	bkt->key_idx[ret] = key_idx;
+	cuckoo_write_end(h);
+
+	return key_idx - 1;
+}
+
+static inline int32_t
+__rte_cuckoo_hash_add_key_with_hash(const struct rte_hash *h,
+				const void *key, hash_sig_t sig, void *data)
+{
+	rte_spinlock_t *lock = (rte_spinlock_t *)(uintptr_t)&h->writer_lock;
+	int32_t ret;
+
+	if (!(h->extra_flag & RTE_HASH_EXTRA_FLAGS_MULTI_WRITER_ADD))
+		return cuckoo_add_key(h, key, sig, data);
+
+	rte_spinlock_lock(lock);
+	ret = cuckoo_add_key(h, key, sig, data);
+	rte_spinlock_unlock(lock);
+	return ret;
+}
+
+/*
+ * Compare the signatures of a key against all entries of its two candidate
+ * buckets. Bit n of *prim_hits (*sec_hits) is set if entry n of the primary
+ * (secondary) bucket may hold the key.
+ */
+static inline void
+compare_signatures(const struct rte_hash *h,
+		   const struct rte_hash_bucket *prim_bkt,
+		   const struct rte_hash_bucket *sec_bkt,
+		   hash_sig_t sig, hash_sig_t alt_hash,
+		   uint32_t *prim_hits, uint32_t *sec_hits)
+{
+	unsigned i;
+
+	switch (h->sig_cmp_fn) {
+#if defined(RTE_MACHINE_CPUFLAG_AVX2)
+	case RTE_HASH_COMPARE_AVX2: {
+		/* Current and alternate signatures are contiguous */
+		__m256i prim_sigs = _mm256_setr_epi32(sig, sig, sig, sig,
+			alt_hash, alt_hash, alt_hash, alt_hash);
+		__m256i sec_sigs = _mm256_setr_epi32(alt_hash, alt_hash,
+			alt_hash, alt_hash, sig, sig, sig, sig);
+		uint32_t prim_mask, sec_mask;
+
+		prim_mask = _mm256_movemask_ps(_mm256_castsi256_ps(
+			_mm256_cmpeq_epi32(prim_sigs, _mm256_load_si256(
+				(const __m256i *)prim_bkt->sig_current))));
+		sec_mask = _mm256_movemask_ps(_mm256_castsi256_ps(
+			_mm256_cmpeq_epi32(sec_sigs, _mm256_load_si256(
+				(const __m256i *)sec_bkt->sig_current))));
+		*prim_hits = prim_mask & (prim_mask >> 4) & 0xf;
+		*sec_hits = sec_mask & (sec_mask >> 4) & 0xf;
+		break;
+	}
+#endif
+#if defined(RTE_MACHINE_CPUFLAG_SSE2)
+	case RTE_HASH_COMPARE_SSE: {
+		__m128i prim_cmp, sec_cmp;
+
+		prim_cmp = _mm_cmpeq_epi32(_mm_set1_epi32(sig),
+			_mm_load_si128((const __m128i *)prim_bkt->sig_current));
+		sec_cmp = _mm_and_si128(
+			_mm_cmpeq_epi32(_mm_set1_epi32(alt_hash), _mm_load_si128(
+				(const __m128i *)sec_bkt->sig_current)),
+			_mm_cmpeq_epi32(_mm_set1_epi32(sig), _mm_load_si128(
+				(const __m128i *)sec_bkt->sig_alt)));
+		*prim_hits = _mm_movemask_ps(_mm_castsi128_ps(prim_cmp));
+		*sec_hits = _mm_movemask_ps(_mm_castsi128_ps(sec_cmp));
+		break;
+	}
+#endif
+	default:
+		*prim_hits = 0;
+		*sec_hits = 0;
+		for (i = 0; i < RTE_HASH_CUCKOO_BUCKET_ENTRIES; i++) {
+			*prim_hits |= (prim_bkt->sig_current[i] == sig) << i;
+			*sec_hits |= ((sec_bkt->sig_current[i] == alt_hash) &
+				      (sec_bkt->sig_alt[i] == sig)) << i;
+		}
+	}
+}
+
+/*
+ * Returns the bucket and entry holding a key in the cuckoo engine, or -ENOENT
+ * if the key is not in the table.
+ */
+static inline int
+cuckoo_find_entry(const struct rte_hash *h, const void *key, hash_sig_t sig,
+		  struct rte_hash_bucket **bkt)
+{
+	hash_sig_t alt_hash;
+	struct rte_hash_bucket *prim_bkt, *sec_bkt;
+	uint32_t prim_hits, sec_hits, hits;
+	int i;
+
+	alt_hash = rte_hash_secondary_hash(sig);
+	prim_bkt = &h->buckets[sig & h->bucket_bitmask];
+	sec_bkt = &h->buckets[alt_hash & h->bucket_bitmask];
+
+	compare_signatures(h, prim_bkt, sec_bkt, sig, alt_hash,
+			   &prim_hits, &sec_hits);
+
+	for (hits = prim_hits; hits != 0; hits &= hits - 1) {
+		i = __builtin_ctz(hits);
+		if (prim_bkt->key_idx[i] != EMPTY_SLOT &&
+				memcmp(key, get_key_from_store(h,
+					prim_bkt->key_idx[i])->key,
+					h->key_len) == 0) {
+			*bkt = prim_bkt;
+			return i;
+		}
+	}
+	for (hits = sec_hits; hits != 0; hits &= hits - 1) {
+		i = __builtin_ctz(hits);
+		if (sec_bkt->key_idx[i] != EMPTY_SLOT &&
+				memcmp(key, get_key_from_store(h,
+					sec_bkt->key_idx[i])->key,
+					h->key_len) == 0) {
+			*bkt = sec_bkt;
+			return i;
+		}
+	}
+
+	return -ENOENT;
+}
+
+static inline int32_t
+cuckoo_del_key(const struct rte_hash *h, const void *key, hash_sig_t sig)
+{
+	struct rte_hash_bucket *bkt;
+	uint32_t key_idx;
+	int i;
+
+	i = cuckoo_find_entry(h, key, sig, &bkt);
+	if (i < 0)
+		return i;
+
+	/*
+	 * The key slot may be reused as soon as it is back in the ring, so
+	 * readers still comparing against it must notice the change.
+	 */
+	key_idx = bkt->key_idx[i];
+	cuckoo_write_begin(h);
+	bkt->key_idx[i] = EMPTY_SLOT;
+	bkt->sig_current[i] = NULL_SIGNATURE;
+	bkt->sig_alt[i] = NULL_SIGNATURE;
+	cuckoo_write_end(h);
+	rte_ring_sp_enqueue(h->free_slots, (void *)((uintptr_t) key_idx));
+
+	return key_idx - 1;
+}
+
+static inline int32_t
+__rte_cuckoo_hash_del_key_with_hash(const struct rte_hash *h,
 				const void *key, hash_sig_t sig)
+{
+	rte_spinlock_t *lock = (rte_spinlock_t *)(uintptr_t)&h->writer_lock;
+	int32_t ret;
+
+	if (!(h->extra_flag & RTE_HASH_EXTRA_FLAGS_MULTI_WRITER_ADD))
+		return cuckoo_del_key(h, key, sig);
+
+	rte_spinlock_lock(lock);
+	ret = cuckoo_del_key(h, key, sig);
+	rte_spinlock_unlock(lock);
+	return ret;
+}
+
+static inline int32_t
+__rte_cuckoo_hash_lookup_with_hash(const struct rte_hash *h,
+			const void *key, hash_sig_t sig, void **data)
+{
+	struct rte_hash_bucket *bkt;
+	uint32_t cnt = 0;
+	void *pdata = NULL;
+	int32_t ret;
+	int concurrent, i;
+
+	concurrent = h->extra_flag & RTE_HASH_EXTRA_FLAGS_RW_CONCURRENCY;
+	do {
+		if (concurrent)
+			cnt = cuckoo_read_begin(h);
+		i = cuckoo_find_entry(h, key, sig, &bkt);
+		if (i < 0)
+			ret = i;
+		else {
+			ret = (int32_t)(bkt->key_idx[i] - 1);
+			pdata = get_key_from_store(h, bkt->key_idx[i])->pdata;
+		}
+	} while (concurrent && cuckoo_read_retry(h, cnt));
+
+	if (data != NULL && ret >= 0)
+		*data = pdata;
+	return ret;
+}
+
+static inline void
+__rte_cuckoo_hash_lookup_bulk(const struct rte_hash *h, const void **keys,
+		      uint32_t num_keys, int32_t *positions, void *data[])
+{
+	struct rte_hash_key *k;
+	uint32_t i;
+	hash_sig_t sigs[RTE_HASH_LOOKUP_BULK_MAX];
+	hash_sig_t alt_hashes[RTE_HASH_LOOKUP_BULK_MAX];
+	struct rte_hash_bucket *prim_bkt[RTE_HASH_LOOKUP_BULK_MAX];
+	struct rte_hash_bucket *sec_bkt[RTE_HASH_LOOKUP_BULK_MAX];
+	uint32_t prim_hits[RTE_HASH_LOOKUP_BULK_MAX];
+	uint32_t sec_hits[RTE_HASH_LOOKUP_BULK_MAX];
+	uint32_t hits, key_idx, cnt = 0;
+	int concurrent;
+
+	/*
+	 * Compute signatures, pre-fetching the buckets of the first keys
+	 * only: the others are pre-fetched while comparing earlier keys, to
+	 * keep the number of outstanding loads bounded at large bursts.
+	 */
+	for (i = 0; i < num_keys; i++) {
+		sigs[i] = rte_hash_hash(h, keys[i]);
+		alt_hashes[i] = rte_hash_secondary_hash(sigs[i]);
+		prim_bkt[i] = &h->buckets[sigs[i] & h->bucket_bitmask];
+		sec_bkt[i] = &h->buckets[alt_hashes[i] & h->bucket_bitmask];
+		if (i < CUCKOO_PREFETCH_OFFSET) {
+			rte_prefetch0(prim_bkt[i]);
+			rte_prefetch0(sec_bkt[i]);
+		}
+	}
+
+	concurrent = h->extra_flag & RTE_HASH_EXTRA_FLAGS_RW_CONCURRENCY;
+retry:
+	if (concurrent)
+		cnt = cuckoo_read_begin(h);
+
+	/* Compare signatures and pre-fetch the keys of matching entries */
+	for (i = 0; i < num_keys; i++) {
+		if (i + CUCKOO_PREFETCH_OFFSET < num_keys) {
+			rte_prefetch0(prim_bkt[i + CUCKOO_PREFETCH_OFFSET]);
+			rte_prefetch0(sec_bkt[i + CUCKOO_PREFETCH_OFFSET]);
+		}
+
+		compare_signatures(h, prim_bkt[i], sec_bkt[i], sigs[i],
+				   alt_hashes[i], &prim_hits[i], &sec_hits[i]);
+
+		if (prim_hits[i] != 0)
+			rte_prefetch0(get_key_from_store(h,
+				prim_bkt[i]->key_idx[__builtin_ctz(prim_hits[i])]));
+		if (sec_hits[i] != 0)
+			rte_prefetch0(get_key_from_store(h,
+				sec_bkt[i]->key_idx[__builtin_ctz(sec_hits[i])]));
+	}
+
+	/* Compare keys of matching entries */
+	for (i = 0; i < num_keys; i++) {
+		positions[i] = -ENOENT;
+
+		for (hits = prim_hits[i]; hits != 0; hits &= hits - 1) {
+			key_idx = prim_bkt[i]->key_idx[__builtin_ctz(hits)];
+			if (key_idx == EMPTY_SLOT)
+				continue;
+			k = get_key_from_store(h, key_idx);
+			if (memcmp(keys[i], k->key, h->key_len) == 0) {
+				positions[i] = key_idx - 1;
+				if (data != NULL)
+					data[i] = k->pdata;
+				goto next_key;
+			}
+		}
+		for (hits = sec_hits[i]; hits != 0; hits &= hits - 1) {
+			key_idx = sec_bkt[i]->key_idx[__builtin_ctz(hits)];
+			if (key_idx == EMPTY_SLOT)
+				continue;
+			k = get_key_from_store(h, key_idx);
+			if (memcmp(keys[i], k->key, h->key_len) == 0) {
+				positions[i] = key_idx - 1;
+				if (data != NULL)
+					data[i] = k->pdata;
+				goto next_key;
+			}
+		}
+next_key:
+		continue;
+	}
+
+	if (concurrent && cuckoo_read_retry(h, cnt))
+		goto retry;
+}
+
+static inline int32_t
+__rte_hash_add_key_with_hash(const struct rte_hash *h,
+				const void *key, hash_sig_t sig, void *data)
 {
 	hash_sig_t *sig_bucket;
 	uint8_t *key_bucket;
@@ -311,7 +936,9 @@ __rte_hash_add_key_with_hash(const struct rte_hash *h,
 		if ((sig == sig_bucket[i]) &&
 		    likely(memcmp(key, get_key_from_bucket(h, key_bucket, i),
 				  h->key_len) == 0)) {
-			return bucket_index * h->bucket_entries + i;
+			pos = bucket_index * h->bucket_entries + i;
+			h->data_tbl[pos] = data;
+			return pos;
 		}
 	}
 
@@ -324,7 +951,18 @@ __rte_hash_add_key_with_hash(const struct rte_hash *h,
 	/* Add the new key to the bucket */
 	sig_bucket[pos] = sig;
 	rte_memcpy(get_key_from_bucket(h, key_bucket, pos), key, h->key_len);
-	return bucket_index * h->bucket_entries + pos;
+	pos += bucket_index * h->bucket_entries;
+	h->data_tbl[pos] = data;
+	return pos;
+}
+
+static inline int32_t
+hash_add_key(const struct rte_hash *h, const void *key, hash_sig_t sig,
+	     void *data)
+{
+	if (h->extra_flag & RTE_HASH_EXTRA_FLAGS_CUCKOO)
+		return __rte_cuckoo_hash_add_key_with_hash(h, key, sig, data);
+	return __rte_hash_add_key_with_hash(h, key, sig, data);
 }
 
 int32_t
@@ -332,14 +970,35 @@ rte_hash_add_key_with_hash(const struct rte_hash *h,
 				const void *key, hash_sig_t sig)
 {
 	RETURN_IF_TRUE(((h == NULL) || (key == NULL)), -EINVAL);
-	return __rte_hash_add_key_with_hash(h, key, sig);
+	return hash_add_key(h, key, sig, NULL);
 }
 
 int32_t
 rte_hash_add_key(const struct rte_hash *h, const void *key)
 {
 	RETURN_IF_TRUE(((h == NULL) || (key == NULL)), -EINVAL);
-	return __rte_hash_add_key_with_hash(h, key, rte_hash_hash(h, key));
+	return hash_add_key(h, key, rte_hash_hash(h, key), NULL);
+}
+
+int
+rte_hash_add_key_with_hash_data(const struct rte_hash *h,
+				const void *key, hash_sig_t sig, void *data)
+{
+	int32_t ret;
+
+	RETURN_IF_TRUE(((h == NULL) || (key == NULL)), -EINVAL);
+	ret = hash_add_key(h, key, sig, data);
+	return (ret < 0) ? ret : 0;
+}
+
+int
+rte_hash_add_key_data(const struct rte_hash *h, const void *key, void *data)
+{
+	int32_t ret;
+
+	RETURN_IF_TRUE(((h == NULL) || (key == NULL)), -EINVAL);
+	ret = hash_add_key(h, key, rte_hash_hash(h, key), data);
+	return (ret < 0) ? ret : 0;
 }
 
 static inline int32_t
@@ -374,6 +1033,8 @@ rte_hash_del_key_with_hash(const struct rte_hash *h,
 				const void *key, hash_sig_t sig)
 {
 	RETURN_IF_TRUE(((h == NULL) || (key == NULL)), -EINVAL);
+	if (h->extra_flag & RTE_HASH_EXTRA_FLAGS_CUCKOO)
+		return __rte_cuckoo_hash_del_key_with_hash(h, key, sig);
 	return __rte_hash_del_key_with_hash(h, key, sig);
 }
 
@@ -381,13 +1042,18 @@ int32_t
 rte_hash_del_key(const struct rte_hash *h, const void *key)
 {
 	RETURN_IF_TRUE(((h == NULL) || (key == NULL)), -EINVAL);
+	if (h->extra_flag & RTE_HASH_EXTRA_FLAGS_CUCKOO)
+		return __rte_cuckoo_hash_del_key_with_hash(h, key,
+				rte_hash_hash(h, key));
 	return __rte_hash_del_key_with_hash(h, key, rte_hash_hash(h, key));
 }
 
 static inline int32_t
 __rte_hash_lookup_with_hash(const struct rte_hash *h,
-			const void *key, hash_sig_t sig)
+			const void *key, hash_sig_t sig, void **data)
 {
+	int32_t pos;
+
 	hash_sig_t *sig_bucket;
 	uint8_t *key_bucket;
 	uint32_t bucket_index, i;
@@ -403,38 +1069,69 @@ __rte_hash_lookup_with_hash(const struct rte_hash *h,
 		if ((sig == sig_bucket[i]) &&
 		    likely(memcmp(key, get_key_from_bucket(h, key_bucket, i),
 				  h->key_len) == 0)) {
-			return bucket_index * h->bucket_entries + i;
+			pos = bucket_index * h->bucket_entries + i;
+			if (data != NULL)
+				*data = h->data_tbl[pos];
+			return pos;
 		}
 	}
 
 	return -ENOENT;
 }
 
+static inline int32_t
+hash_lookup(const struct rte_hash *h, const void *key, hash_sig_t sig,
+	    void **data)
+{
+	if (h->extra_flag & RTE_HASH_EXTRA_FLAGS_CUCKOO)
+		return __rte_cuckoo_hash_lookup_with_hash(h, key, sig, data);
+	return __rte_hash_lookup_with_hash(h, key, sig, data);
+}
+
 int32_t
 rte_hash_lookup_with_hash(const struct rte_hash *h,
 			const void *key, hash_sig_t sig)
 {
 	RETURN_IF_TRUE(((h == NULL) || (key == NULL)), -EINVAL);
-	return __rte_hash_lookup_with_hash(h, key, sig);
+	return hash_lookup(h, key, sig, NULL);
 }
 
 int32_t
 rte_hash_lookup(const struct rte_hash *h, const void *key)
 {
 	RETURN_IF_TRUE(((h == NULL) || (key == NULL)), -EINVAL);
-	return __rte_hash_lookup_with_hash(h, key, rte_hash_hash(h, key));
+	return hash_lookup(h, key, rte_hash_hash(h, key), NULL);
 }
 
 int
-rte_hash_lookup_bulk(const struct rte_hash *h, const void **keys,
-		      uint32_t num_keys, int32_t *positions)
+rte_hash_lookup_with_hash_data(const struct rte_hash *h,
+			const void *key, hash_sig_t sig, void **data)
+{
+	RETURN_IF_TRUE(((h == NULL) || (key == NULL) || (data == NULL)),
+		       -EINVAL);
+	return hash_lookup(h, key, sig, data);
+}
+
+int
+rte_hash_lookup_data(const struct rte_hash *h, const void *key, void **data)
+{
+	RETURN_IF_TRUE(((h == NULL) || (key == NULL) || (data == NULL)),
+		       -EINVAL);
+	return hash_lookup(h, key, rte_hash_hash(h, key), data);
+}
+
+static inline void
+__rte_hash_lookup_bulk(const struct rte_hash *h, const void **keys,
+		      uint32_t num_keys, int32_t *positions, void *data[])
 {
 	uint32_t i, j, bucket_index;
 	hash_sig_t sigs[RTE_HASH_LOOKUP_BULK_MAX];
 
-	RETURN_IF_TRUE(((h == NULL) || (keys == NULL) || (num_keys == 0) ||
-			(num_keys > RTE_HASH_LOOKUP_BULK_MAX) ||
-			(positions == NULL)), -EINVAL);
+	if (h->extra_flag & RTE_HASH_EXTRA_FLAGS_CUCKOO) {
+		__rte_cuckoo_hash_lookup_bulk(h, keys, num_keys, positions,
+					      data);
+		return;
+	}
 
 	/* Get the hash signature and bucket index */
 	for (i = 0; i < num_keys; i++) {
@@ -462,10 +1159,96 @@ rte_hash_lookup_bulk(const struct rte_hash *h, const void **keys,
 					  h->key_len) == 0)) {
 				positions[i] = bucket_index *
 					h->bucket_entries + j;
+				if (data != NULL)
+					data[i] = h->data_tbl[positions[i]];
 				break;
 			}
 		}
 	}
+}
+
+int
+rte_hash_lookup_bulk(const struct rte_hash *h, const void **keys,
+		      uint32_t num_keys, int32_t *positions)
+{
+	RETURN_IF_TRUE(((h == NULL) || (keys == NULL) || (num_keys == 0) ||
+			(num_keys > RTE_HASH_LOOKUP_BULK_MAX) ||
+			(positions == NULL)), -EINVAL);
 
+	__rte_hash_lookup_bulk(h, keys, num_keys, positions, NULL);
 	return 0;
 }
+
+int
+rte_hash_lookup_bulk_data(const struct rte_hash *h, const void **keys,
+		      uint32_t num_keys, uint64_t *hit_mask, void *data[])
+{
+	int32_t positions[RTE_HASH_LOOKUP_BULK_MAX];
+	uint64_t hits = 0;
+	uint32_t i;
+	int num_hits = 0;
+
+	RETURN_IF_TRUE(((h == NULL) || (keys == NULL) || (num_keys == 0) ||
+			(num_keys > RTE_HASH_LOOKUP_BULK_MAX) ||
+			(hit_mask == NULL) || (data == NULL)), -EINVAL);
+
+	__rte_hash_lookup_bulk(h, keys, num_keys, positions, data);
+
+	for (i = 0; i < num_keys; i++) {
+		if (positions[i] >= 0) {
+			hits |= 1ULL << i;
+			num_hits++;
+		}
+	}
+	*hit_mask = hits;
+	return num_hits;
+}
+
+int32_t
+rte_hash_iterate(const struct rte_hash *h, const void **key, void **data,
+		 uint32_t *next)
+{
+	struct rte_hash_key *k;
+	uint32_t idx, total_entries;
+	uint8_t *key_bucket;
+
+	RETURN_IF_TRUE(((h == NULL) || (key == NULL) || (data == NULL) ||
+			(next == NULL)), -EINVAL);
+
+	total_entries = h->num_buckets * h->bucket_entries;
+
+	if (h->extra_flag & RTE_HASH_EXTRA_FLAGS_CUCKOO) {
+		/* Skip to the next used entry of the bucket array */
+		for (idx = *next; idx < total_entries; idx++) {
+			if (h->buckets[idx / RTE_HASH_CUCKOO_BUCKET_ENTRIES]
+				.key_idx[idx % RTE_HASH_CUCKOO_BUCKET_ENTRIES]
+					!= EMPTY_SLOT)
+				break;
+		}
+		if (idx >= total_entries)
+			return -ENOENT;
+
+		*next = idx + 1;
+		idx = h->buckets[idx / RTE_HASH_CUCKOO_BUCKET_ENTRIES]
+			.key_idx[idx % RTE_HASH_CUCKOO_BUCKET_ENTRIES];
+		k = get_key_from_store(h, idx);
+		*key = k->key;
+		*data = k->pdata;
+		return idx - 1;
+	}
+
+	/* Skip to the next entry with a valid signature */
+	for (idx = *next; idx < total_entries; idx++) {
+		if (get_sig_tbl_bucket(h, idx / h->bucket_entries)
+				[idx % h->bucket_entries] != NULL_SIGNATURE)
+			break;
+	}
+	if (idx >= total_entries)
+		return -ENOENT;
+
+	*next = idx + 1;
+	key_bucket = get_key_tbl_bucket(h, idx / h->bucket_entries);
+	*key = get_key_from_bucket(h, key_bucket, idx % h->bucket_entries);
+	*data = h->data_tbl[idx];
+	return idx;
+}
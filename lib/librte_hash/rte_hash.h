@@ -43,6 +43,9 @@
 #include <stdint.h>
 #include <sys/queue.h>
 
+#include <rte_memory.h>
+#include <rte_spinlock.h>
+
 #ifdef __cplusplus
 extern "C" {
 #endif
@@ -57,12 +60,35 @@ extern "C" {
 #define RTE_HASH_KEY_LENGTH_MAX			64
 
 /** Max number of keys that can be searched for using rte_hash_lookup_multi. */
-#define RTE_HASH_LOOKUP_BULK_MAX		16
+#define RTE_HASH_LOOKUP_BULK_MAX		64
 #define RTE_HASH_LOOKUP_MULTI_MAX		RTE_HASH_LOOKUP_BULK_MAX
 
 /** Max number of characters in hash name.*/
 #define RTE_HASH_NAMESIZE			32
 
+/** Number of entries in a bucket of the cuckoo engine. */
+#define RTE_HASH_CUCKOO_BUCKET_ENTRIES		4
+
+/**
+ * Select the cuckoo engine: every key has a primary and an alternate bucket
+ * and existing keys are displaced on insert, so the table can be filled close
+ * to its capacity. bucket_entries is ignored when this flag is set.
+ */
+#define RTE_HASH_EXTRA_FLAGS_CUCKOO		0x01
+
+/**
+ * Allow lookups to run on any number of lcores concurrently with add and
+ * delete operations, without taking any lock. Implies the cuckoo engine.
+ */
+#define RTE_HASH_EXTRA_FLAGS_RW_CONCURRENCY	0x02
+
+/**
+ * Allow add and delete operations to be called from several lcores at the
+ * same time. Writers are serialized internally, and lookups stay lock-free
+ * as with RTE_HASH_EXTRA_FLAGS_RW_CONCURRENCY, which this flag implies.
+ */
+#define RTE_HASH_EXTRA_FLAGS_MULTI_WRITER_ADD	0x04
+
 /** Signature of key that is stored internally. */
 typedef uint32_t hash_sig_t;
 
@@ -82,8 +108,20 @@ struct rte_hash_parameters {
 	rte_hash_function hash_func;	/**< Function used to calculate hash. */
 	uint32_t hash_func_init_val;	/**< Init value used by hash_func. */
 	int socket_id;			/**< NUMA Socket ID for memory. */
+	uint8_t extra_flag;		/**< RTE_HASH_EXTRA_FLAGS_* values. */
 };
 
+/** Signature compare implementation used by the cuckoo engine. */
+enum rte_hash_sig_compare_function {
+	RTE_HASH_COMPARE_SCALAR = 0,	/**< Compare one entry at a time. */
+	RTE_HASH_COMPARE_SSE,		/**< Compare a bucket with SSE2. */
+	RTE_HASH_COMPARE_AVX2,		/**< Compare a bucket with AVX2. */
+	RTE_HASH_COMPARE_NUM
+};
+
+struct rte_hash_bucket;
+struct rte_ring;
+
 /** A hash table structure. */
 struct rte_hash {
 	char name[RTE_HASH_NAMESIZE];	/**< Name of the hash. */
@@ -104,6 +142,21 @@ struct rte_hash {
 	uint32_t key_tbl_key_size;	/**< Keys may be padded for alignment
 					   reasons, and this is the key size
 					   used	by key_tbl. */
+	void **data_tbl;	/**< User data of each key_tbl entry. */
+	uint32_t extra_flag;	/**< RTE_HASH_EXTRA_FLAGS_* values. */
+	struct rte_hash_bucket *buckets;	/**< Cuckoo engine buckets. */
+	uint8_t *key_store;	/**< Cuckoo engine key slots, slot 0 unused. */
+	uint32_t key_entry_size;	/**< Size of a slot in key_store. */
+	struct rte_ring *free_slots;	/**< Ring of free key_store slots. */
+	/** Signature compare used by cuckoo bulk lookups, selected at
+	 * creation from the CPU flags. */
+	enum rte_hash_sig_compare_function sig_cmp_fn;
+
+	/** Incremented by a writer before and after it moves or removes
+	 * cuckoo entries: odd while an update is in progress. Lock-free
+	 * readers retry when it changes during their search. */
+	volatile uint32_t change_cnt __rte_cache_aligned;
+	rte_spinlock_t writer_lock;	/**< Serializes multiple writers. */
 };
 
 /**
@@ -150,7 +203,8 @@ rte_hash_free(struct rte_hash *h);
 
 /**
  * Add a key to an existing hash table. This operation is not multi-thread safe
- * and should only be called from one thread.
+ * and should only be called from one thread, unless the table was created
+ * with RTE_HASH_EXTRA_FLAGS_MULTI_WRITER_ADD.
  *
  * @param h
  *   Hash table to add the key to.
@@ -167,7 +221,8 @@ rte_hash_add_key(const struct rte_hash *h, const void *key);
 
 /**
  * Add a key to an existing hash table. This operation is not multi-thread safe
- * and should only be called from one thread.
+ * and should only be called from one thread, unless the table was created
+ * with RTE_HASH_EXTRA_FLAGS_MULTI_WRITER_ADD.
  *
  * @param h
  *   Hash table to add the key to.
@@ -185,9 +240,54 @@ int32_t
 rte_hash_add_key_with_hash(const struct rte_hash *h,
 				const void *key, hash_sig_t sig);
 
+/**
+ * Add a key and its user data to an existing hash table. If the key is
+ * already in the table, its data is replaced. This operation is not
+ * multi-thread safe and should only be called from one thread, unless the
+ * table was created with RTE_HASH_EXTRA_FLAGS_MULTI_WRITER_ADD.
+ *
+ * @param h
+ *   Hash table to add the key to.
+ * @param key
+ *   Key to add to the hash table.
+ * @param data
+ *   Data to store with the key.
+ * @return
+ *   - 0 if the key and data were added.
+ *   - -EINVAL if the parameters are invalid.
+ *   - -ENOSPC if there is no space in the hash for this key.
+ */
+int
+rte_hash_add_key_data(const struct rte_hash *h, const void *key, void *data);
+
+/**
+ * Add a key and its user data to an existing hash table, using a hash value
+ * computed by the caller. If the key is already in the table, its data is
+ * replaced. This operation is not multi-thread safe and should only be called
+ * from one thread, unless the table was created with
+ * RTE_HASH_EXTRA_FLAGS_MULTI_WRITER_ADD.
+ *
+ * @param h
+ *   Hash table to add the key to.
+ * @param key
+ *   Key to add to the hash table.
+ * @param sig
+ *   Hash value to add to the hash table.
+ * @param data
+ *   Data to store with the key.
+ * @return
+ *   - 0 if the key and data were added.
+ *   - -EINVAL if the parameters are invalid.
+ *   - -ENOSPC if there is no space in the hash for this key.
+ */
+int
+rte_hash_add_key_with_hash_data(const struct rte_hash *h,
+				const void *key, hash_sig_t sig, void *data);
+
 /**
  * Remove a key from an existing hash table. This operation is not multi-thread
- * safe and should only be called from one thread.
+ * safe and should only be called from one thread, unless the table was created
+ * with RTE_HASH_EXTRA_FLAGS_MULTI_WRITER_ADD.
  *
  * @param h
  *   Hash table to remove the key from.
@@ -205,7 +305,8 @@ rte_hash_del_key(const struct rte_hash *h, const void *key);
 
 /**
  * Remove a key from an existing hash table. This operation is not multi-thread
- * safe and should only be called from one thread.
+ * safe and should only be called from one thread, unless the table was created
+ * with RTE_HASH_EXTRA_FLAGS_MULTI_WRITER_ADD.
  *
  * @param h
  *   Hash table to remove the key from.
@@ -226,7 +327,9 @@ rte_hash_del_key_with_hash(const struct rte_hash *h,
 
 
 /**
- * Find a key in the hash table. This operation is multi-thread safe.
+ * Find a key in the hash table. This operation is multi-thread safe. It is
+ * only safe against concurrent add and delete operations if the table was
+ * created with RTE_HASH_EXTRA_FLAGS_RW_CONCURRENCY.
  *
  * @param h
  *   Hash table to look in.
@@ -243,7 +346,9 @@ int32_t
 rte_hash_lookup(const struct rte_hash *h, const void *key);
 
 /**
- * Find a key in the hash table. This operation is multi-thread safe.
+ * Find a key in the hash table. This operation is multi-thread safe. It is
+ * only safe against concurrent add and delete operations if the table was
+ * created with RTE_HASH_EXTRA_FLAGS_RW_CONCURRENCY.
  *
  * @param h
  *   Hash table to look in.
@@ -262,6 +367,48 @@ int32_t
 rte_hash_lookup_with_hash(const struct rte_hash *h,
 				const void *key, hash_sig_t sig);
 
+/**
+ * Find a key in the hash table and return its user data. This operation is
+ * multi-thread safe. It is only safe against concurrent add and delete
+ * operations if the table was created with RTE_HASH_EXTRA_FLAGS_RW_CONCURRENCY.
+ *
+ * @param h
+ *   Hash table to look in.
+ * @param key
+ *   Key to find.
+ * @param data
+ *   Output with the data stored with the key, if it is found.
+ * @return
+ *   - -EINVAL if the parameters are invalid.
+ *   - -ENOENT if the key is not found.
+ *   - The position of the key, as returned by rte_hash_lookup().
+ */
+int
+rte_hash_lookup_data(const struct rte_hash *h, const void *key, void **data);
+
+/**
+ * Find a key in the hash table, using a hash value computed by the caller,
+ * and return its user data. This operation is multi-thread safe. It is only
+ * safe against concurrent add and delete operations if the table was created
+ * with RTE_HASH_EXTRA_FLAGS_RW_CONCURRENCY.
+ *
+ * @param h
+ *   Hash table to look in.
+ * @param key
+ *   Key to find.
+ * @param sig
+ *   Hash value to find.
+ * @param data
+ *   Output with the data stored with the key, if it is found.
+ * @return
+ *   - -EINVAL if the parameters are invalid.
+ *   - -ENOENT if the key is not found.
+ *   - The position of the key, as returned by rte_hash_lookup().
+ */
+int
+rte_hash_lookup_with_hash_data(const struct rte_hash *h, const void *key,
+				hash_sig_t sig, void **data);
+
 
 /**
  * Calc a hash value by key. This operation is not multi-process safe.
@@ -283,6 +430,8 @@ rte_hash_hash(const struct rte_hash *h, const void *key)
 #define rte_hash_lookup_multi rte_hash_lookup_bulk
 /**
  * Find multiple keys in the hash table. This operation is multi-thread safe.
+ * It is only safe against concurrent add and delete operations if the table
+ * was created with RTE_HASH_EXTRA_FLAGS_RW_CONCURRENCY.
  *
  * @param h
  *   Hash table to look in.
@@ -302,6 +451,54 @@ rte_hash_hash(const struct rte_hash *h, const void *key)
 int
 rte_hash_lookup_bulk(const struct rte_hash *h, const void **keys,
 		      uint32_t num_keys, int32_t *positions);
+
+/**
+ * Find multiple keys in the hash table and return their user data. This
+ * operation is multi-thread safe. It is only safe against concurrent add and
+ * delete operations if the table was created with
+ * RTE_HASH_EXTRA_FLAGS_RW_CONCURRENCY.
+ *
+ * @param h
+ *   Hash table to look in.
+ * @param keys
+ *   A pointer to a list of keys to look for.
+ * @param num_keys
+ *   How many keys are in the keys list (less than RTE_HASH_LOOKUP_BULK_MAX).
+ * @param hit_mask
+ *   Output containing a bitmask with all successful lookups: bit i is set
+ *   if keys[i] was found.
+ * @param data
+ *   Output containing the data of the keys found. Entries of keys which were
+ *   not found are left unchanged.
+ * @return
+ *   -EINVAL if there's an error, otherwise the number of keys found.
+ */
+int
+rte_hash_lookup_bulk_data(const struct rte_hash *h, const void **keys,
+		      uint32_t num_keys, uint64_t *hit_mask, void *data[]);
+
+/**
+ * Iterate through the hash table, returning one key and its data per call.
+ * This operation is not safe against concurrent add or delete operations:
+ * keys added or deleted during an iteration may be missed or returned twice.
+ *
+ * @param h
+ *   Hash table to iterate.
+ * @param key
+ *   Output containing a pointer to the key, inside the table.
+ * @param data
+ *   Output containing the data stored with the key.
+ * @param next
+ *   Iteration state. Must be set to 0 before the first call, and is updated
+ *   by each call.
+ * @return
+ *   - -EINVAL if the parameters are invalid.
+ *   - -ENOENT if the end of the table has been reached.
+ *   - The position of the key returned, as returned by rte_hash_lookup().
+ */
+int32_t
+rte_hash_iterate(const struct rte_hash *h, const void **key, void **data,
+		 uint32_t *next);
 #ifdef __cplusplus
 }
 #endif
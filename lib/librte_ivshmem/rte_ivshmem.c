@@ -127,27 +127,32 @@ overlap(const struct rte_memzone * s1, const struct rte_memzone * s2)
 	return 0;
 }
 
+struct memzone_by_addr {
+	const void *addr;
+	const struct rte_memzone *mz;
+};
+
+static void
+memzone_by_addr_cb(const struct rte_memzone *mz, void *arg)
+{
+	struct memzone_by_addr *search = arg;
+
+	if (mz->addr_64 == (uint64_t)(uintptr_t)search->addr)
+		search->mz = mz;
+}
+
 static struct rte_memzone *
 get_memzone_by_addr(const void * addr)
 {
-	struct rte_memzone * tmp, * mz;
-	struct rte_mem_config * mcfg;
-	int i;
+	struct memzone_by_addr search;
 
-	mcfg = rte_eal_get_configuration()->mem_config;
-	mz = NULL;
+	search.addr = addr;
+	search.mz = NULL;
 
 	/* find memzone for the ring */
-	for (i = 0; i < RTE_MAX_MEMZONE; i++) {
-		tmp = &mcfg->memzone[i];
+	rte_memzone_walk(memzone_by_addr_cb, &search);
 
-		if (tmp->addr_64 == (uint64_t) addr) {
-			mz = tmp;
-			break;
-		}
-	}
-
-	return mz;
+	return (struct rte_memzone *)(uintptr_t)search.mz;
 }
 
 static int
@@ -533,6 +538,13 @@ add_mempool_to_metadata(const struct rte_mempool * mp,
 	struct rte_memzone * mz;
 	int ret;
 
+	/* only the ring handlers store the objects in shared memory */
+	if (strncmp(rte_mempool_ops_get(mp->ops_index)->name, "ring_", 5)) {
+		RTE_LOG(ERR, EAL, "Cannot share mempool with handler %s!\n",
+			rte_mempool_ops_get(mp->ops_index)->name);
+		return -1;
+	}
+
 	mz = get_memzone_by_addr(mp);
 	ret = 0;
 
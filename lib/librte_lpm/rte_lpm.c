@@ -52,6 +52,7 @@
 #include <rte_errno.h>
 #include <rte_rwlock.h>
 #include <rte_spinlock.h>
+#include <rte_atomic.h>
 
 #include "rte_lpm.h"
 
@@ -116,6 +117,40 @@ depth_to_range(uint8_t depth)
 	return (1 << (RTE_LPM_MAX_DEPTH - depth));
 }
 
+/*
+ * Lookups read the tables without any lock, so the writer must never let
+ * them see a partially written entry, nor an entry pointing to a tbl8 group
+ * which is not completely written yet. Entries are therefore updated with a
+ * single store, ordered after all the stores that precede it.
+ */
+static inline void
+tbl24_write(struct rte_lpm_tbl24_entry *dst, struct rte_lpm_tbl24_entry src)
+{
+	union {
+		struct rte_lpm_tbl24_entry entry;
+		uint16_t val;
+	} u;
+
+	u.entry = src;
+	rte_compiler_barrier();
+	*(volatile uint16_t *)(uintptr_t)dst = u.val;
+	rte_compiler_barrier();
+}
+
+static inline void
+tbl8_write(struct rte_lpm_tbl8_entry *dst, struct rte_lpm_tbl8_entry src)
+{
+	union {
+		struct rte_lpm_tbl8_entry entry;
+		uint16_t val;
+	} u;
+
+	u.entry = src;
+	rte_compiler_barrier();
+	*(volatile uint16_t *)(uintptr_t)dst = u.val;
+	rte_compiler_barrier();
+}
+
 /*
  * Find an existing lpm table and return a pointer to it.
  */
@@ -443,11 +478,16 @@ add_depth_small(struct rte_lpm *lpm, uint32_t ip, uint8_t depth,
 
 			/* Setting tbl24 entry in one go to avoid race
 			 * conditions */
-			lpm->tbl24[i] = new_tbl24_entry;
+			tbl24_write(&lpm->tbl24[i], new_tbl24_entry);
 
 			continue;
 		}
 
+		/* A valid and non-extended entry of a more specific rule is
+		 * kept. */
+		if (lpm->tbl24[i].ext_entry == 0)
+			continue;
+
 		/* If tbl24 entry is valid and extended calculate the index
 		 * into tbl8. */
 		tbl8_index = lpm->tbl24[i].tbl8_gindex *
@@ -468,7 +508,7 @@ add_depth_small(struct rte_lpm *lpm, uint32_t ip, uint8_t depth,
 				 * Setting tbl8 entry in one go to avoid race
 				 * conditions
 				 */
-				lpm->tbl8[j] = new_tbl8_entry;
+				tbl8_write(&lpm->tbl8[j], new_tbl8_entry);
 
 				continue;
 			}
@@ -523,7 +563,8 @@ add_depth_big(struct rte_lpm *lpm, uint32_t ip_masked, uint8_t depth,
 			.depth = 0,
 		};
 
-		lpm->tbl24[tbl24_index] = new_tbl24_entry;
+		/* Publish the tbl8 group once all its entries are written */
+		tbl24_write(&lpm->tbl24[tbl24_index], new_tbl24_entry);
 
 	}/* If valid entry but not extended calculate the index into Table8. */
 	else if (lpm->tbl24[tbl24_index].ext_entry == 0) {
@@ -574,7 +615,8 @@ add_depth_big(struct rte_lpm *lpm, uint32_t ip_masked, uint8_t depth,
 				.depth = 0,
 		};
 
-		lpm->tbl24[tbl24_index] = new_tbl24_entry;
+		/* Publish the tbl8 group once all its entries are written */
+		tbl24_write(&lpm->tbl24[tbl24_index], new_tbl24_entry);
 
 	}
 	else { /*
@@ -600,7 +642,7 @@ add_depth_big(struct rte_lpm *lpm, uint32_t ip_masked, uint8_t depth,
 				 * Setting tbl8 entry in one go to avoid race
 				 * condition
 				 */
-				lpm->tbl8[i] = new_tbl8_entry;
+				tbl8_write(&lpm->tbl8[i], new_tbl8_entry);
 
 				continue;
 			}
@@ -727,9 +769,13 @@ delete_depth_small(struct rte_lpm *lpm, uint32_t ip_masked,
 
 			if (lpm->tbl24[i].ext_entry == 0 &&
 					lpm->tbl24[i].depth <= depth ) {
-				lpm->tbl24[i].valid = INVALID;
+				struct rte_lpm_tbl24_entry new_tbl24_entry =
+					lpm->tbl24[i];
+
+				new_tbl24_entry.valid = INVALID;
+				tbl24_write(&lpm->tbl24[i], new_tbl24_entry);
 			}
-			else {
+			else if (lpm->tbl24[i].ext_entry == 1) {
 				/*
 				 * If TBL24 entry is extended, then there has
 				 * to be a rule with depth >= 25 in the
@@ -742,9 +788,14 @@ delete_depth_small(struct rte_lpm *lpm, uint32_t ip_masked,
 
 				for (j = tbl8_index; j < (tbl8_index +
 					RTE_LPM_TBL8_GROUP_NUM_ENTRIES); j++) {
-
-					if (lpm->tbl8[j].depth <= depth)
-						lpm->tbl8[j].valid = INVALID;
+					struct rte_lpm_tbl8_entry new_tbl8_entry =
+						lpm->tbl8[j];
+
+					if (new_tbl8_entry.depth <= depth) {
+						new_tbl8_entry.valid = INVALID;
+						tbl8_write(&lpm->tbl8[j],
+							   new_tbl8_entry);
+					}
 				}
 			}
 		}
@@ -764,6 +815,7 @@ delete_depth_small(struct rte_lpm *lpm, uint32_t ip_masked,
 
 		struct rte_lpm_tbl8_entry new_tbl8_entry = {
 			.valid = VALID,
+			.valid_group = VALID,
 			.depth = sub_rule_depth,
 			.next_hop = lpm->rules_tbl
 			[sub_rule_index].next_hop,
@@ -773,9 +825,9 @@ delete_depth_small(struct rte_lpm *lpm, uint32_t ip_masked,
 
 			if (lpm->tbl24[i].ext_entry == 0 &&
 					lpm->tbl24[i].depth <= depth ) {
-				lpm->tbl24[i] = new_tbl24_entry;
+				tbl24_write(&lpm->tbl24[i], new_tbl24_entry);
 			}
-			else {
+			else if (lpm->tbl24[i].ext_entry == 1) {
 				/*
 				 * If TBL24 entry is extended, then there has
 				 * to be a rule with depth >= 25 in the
@@ -790,7 +842,8 @@ delete_depth_small(struct rte_lpm *lpm, uint32_t ip_masked,
 					RTE_LPM_TBL8_GROUP_NUM_ENTRIES); j++) {
 
 					if (lpm->tbl8[j].depth <= depth)
-						lpm->tbl8[j] = new_tbl8_entry;
+						tbl8_write(&lpm->tbl8[j],
+							   new_tbl8_entry);
 				}
 			}
 		}
@@ -879,8 +932,12 @@ delete_depth_big(struct rte_lpm *lpm, uint32_t ip_masked,
 		 * rule_to_delete must be removed or modified.
 		 */
 		for (i = tbl8_index; i < (tbl8_index + tbl8_range); i++) {
-			if (lpm->tbl8[i].depth <= depth)
-				lpm->tbl8[i].valid = INVALID;
+			struct rte_lpm_tbl8_entry new_tbl8_entry = lpm->tbl8[i];
+
+			if (new_tbl8_entry.depth <= depth) {
+				new_tbl8_entry.valid = INVALID;
+				tbl8_write(&lpm->tbl8[i], new_tbl8_entry);
+			}
 		}
 	}
 	else {
@@ -898,7 +955,7 @@ delete_depth_big(struct rte_lpm *lpm, uint32_t ip_masked,
 		 */
 		for (i = tbl8_index; i < (tbl8_index + tbl8_range); i++) {
 			if (lpm->tbl8[i].depth <= depth)
-				lpm->tbl8[i] = new_tbl8_entry;
+				tbl8_write(&lpm->tbl8[i], new_tbl8_entry);
 		}
 	}
 
@@ -911,8 +968,12 @@ delete_depth_big(struct rte_lpm *lpm, uint32_t ip_masked,
 	tbl8_recycle_index = tbl8_recycle_check(lpm->tbl8, tbl8_group_start);
 
 	if (tbl8_recycle_index == -EINVAL){
+		struct rte_lpm_tbl24_entry new_tbl24_entry =
+			lpm->tbl24[tbl24_index];
+
 		/* Set tbl24 before freeing tbl8 to avoid race condition. */
-		lpm->tbl24[tbl24_index].valid = 0;
+		new_tbl24_entry.valid = INVALID;
+		tbl24_write(&lpm->tbl24[tbl24_index], new_tbl24_entry);
 		tbl8_free(lpm->tbl8, tbl8_group_start);
 	}
 	else if (tbl8_recycle_index > -1) {
@@ -925,7 +986,7 @@ delete_depth_big(struct rte_lpm *lpm, uint32_t ip_masked,
 		};
 
 		/* Set tbl24 before freeing tbl8 to avoid race condition. */
-		lpm->tbl24[tbl24_index] = new_tbl24_entry;
+		tbl24_write(&lpm->tbl24[tbl24_index], new_tbl24_entry);
 		tbl8_free(lpm->tbl8, tbl8_group_start);
 	}
 
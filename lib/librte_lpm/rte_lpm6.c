@@ -68,6 +68,9 @@
 #define BYTE_SIZE                                 8
 #define BYTES2_SIZE                              16
 
+/* Number of addresses whose lookups are interleaved in a bulk lookup. */
+#define LOOKUP_BULK_CHUNK                        32
+
 #define lpm6_tbl8_gindex next_hop
 
 /** Flags for setting an entry as valid/invalid. */
@@ -626,43 +629,69 @@ rte_lpm6_lookup(const struct rte_lpm6 *lpm, uint8_t *ip, uint8_t *next_hop)
 
 /*
  * Looks up a group of IP addresses
+ *
+ * A lookup reads one table entry per level, and each read depends on the
+ * previous one. Instead of walking the levels of one address after the
+ * other, the addresses are processed in chunks, one level at a time for
+ * all the unfinished lookups of the chunk, so that the reads of different
+ * addresses are independent and their cache misses overlap.
  */
 int
 rte_lpm6_lookup_bulk_func(const struct rte_lpm6 *lpm,
 		uint8_t ips[][RTE_LPM6_IPV6_ADDR_SIZE],
 		int16_t * next_hops, unsigned n)
 {
-	unsigned i;
-	const struct rte_lpm6_tbl_entry *tbl;
-	const struct rte_lpm6_tbl_entry *tbl_next;
-	uint32_t tbl24_index;
-	uint8_t first_byte, next_hop;
-	int status;
+	uint32_t tbl_entries[LOOKUP_BULK_CHUNK];
+	uint8_t active[LOOKUP_BULK_CHUNK];
+	unsigned base, num, num_active, i, j, k;
+	uint32_t tbl24_index, tbl8_index, tbl_entry;
+	const uint32_t *ptbl;
+	uint8_t byte;
 
 	/* DEBUG: Check user input arguments. */
 	if ((lpm == NULL) || (ips == NULL) || (next_hops == NULL)) {
 		return -EINVAL;
 	}
 
-	for (i = 0; i < n; i++) {
-		first_byte = LOOKUP_FIRST_BYTE;
-		tbl24_index = (ips[i][0] << BYTES2_SIZE) |
-				(ips[i][1] << BYTE_SIZE) | ips[i][2];
-
-		/* Calculate pointer to the first entry to be inspected */
-		tbl = &lpm->tbl24[tbl24_index];
-
-		do {
-			/* Continue inspecting following levels until success or failure */
-			status = lookup_step(lpm, tbl, &tbl_next, ips[i], first_byte++,
-					&next_hop);
-			tbl = tbl_next;
-		} while (status == 1);
-
-		if (status < 0)
-			next_hops[i] = -1;
-		else
-			next_hops[i] = next_hop;
+	for (base = 0; base < n; base += LOOKUP_BULK_CHUNK) {
+		num = RTE_MIN(n - base, (unsigned)LOOKUP_BULK_CHUNK);
+
+		/* Read the tbl24 entries of all the addresses first */
+		for (i = 0; i < num; i++) {
+			const uint8_t *ip = ips[base + i];
+
+			tbl24_index = (ip[0] << BYTES2_SIZE) |
+					(ip[1] << BYTE_SIZE) | ip[2];
+			ptbl = (const uint32_t *)&lpm->tbl24[tbl24_index];
+			tbl_entries[i] = *ptbl;
+			active[i] = (uint8_t)i;
+		}
+		num_active = num;
+
+		/* Then go one level deeper for the unfinished lookups */
+		for (byte = LOOKUP_FIRST_BYTE - 1; num_active != 0; byte++) {
+			k = 0;
+
+			for (j = 0; j < num_active; j++) {
+				i = active[j];
+				tbl_entry = tbl_entries[i];
+
+				if ((tbl_entry & RTE_LPM6_VALID_EXT_ENTRY_BITMASK) ==
+						RTE_LPM6_VALID_EXT_ENTRY_BITMASK) {
+					tbl8_index = ips[base + i][byte] +
+						((tbl_entry & RTE_LPM6_TBL8_BITMASK) *
+						RTE_LPM6_TBL8_GROUP_NUM_ENTRIES);
+					ptbl = (const uint32_t *)
+						&lpm->tbl8[tbl8_index];
+					tbl_entries[i] = *ptbl;
+					active[k++] = (uint8_t)i;
+				} else if (tbl_entry & RTE_LPM6_LOOKUP_SUCCESS)
+					next_hops[base + i] = (uint8_t)tbl_entry;
+				else
+					next_hops[base + i] = -1;
+			}
+			num_active = k;
+		}
 	}
 
 	return 0;
@@ -0,0 +1,522 @@
+/*-
+ *   BSD LICENSE
+ *
+ *   Copyright(c) 2010-2015 Intel Corporation. All rights reserved.
+ *   All rights reserved.
+ *
+ *   Redistribution and use in source and binary forms, with or without
+ *   modification, are permitted provided that the following conditions
+ *   are met:
+ *
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in
+ *       the documentation and/or other materials provided with the
+ *       distribution.
+ *     * Neither the name of Intel Corporation nor the names of its
+ *       contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ *   THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *   "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *   LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ *   A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ *   OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ *   SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ *   LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ *   DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ *   THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ *   (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ *   OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef _RTE_LPM_EXT_H_
+#define _RTE_LPM_EXT_H_
+
+/**
+ * @file
+ * RTE Longest Prefix Match (LPM) with extended next hops
+ *
+ * Variant of the IPv4 LPM table storing 24-bit next hops, whose number of
+ * tbl8 groups is set at creation time.
+ */
+
+#include <errno.h>
+#include <sys/queue.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <rte_branch_prediction.h>
+#include <rte_memory.h>
+#include <rte_common.h>
+#include <rte_atomic.h>
+#include <rte_lcore.h>
+#include <rte_vect.h>
+#include <rte_lpm.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** Maximum number of tbl8 groups of an extended LPM table. */
+#define RTE_LPM_EXT_MAX_TBL8_NUM_GROUPS (1 << 24)
+
+/** Maximum next hop value of an extended LPM table. */
+#define RTE_LPM_EXT_MAX_NEXT_HOP        ((1 << 24) - 1)
+
+/** @internal bitmask with valid and ext_entry/valid_group fields set */
+#define RTE_LPM_EXT_VALID_EXT_ENTRY_BITMASK 0x03000000
+
+/** Bitmask used to indicate successful lookup */
+#define RTE_LPM_EXT_LOOKUP_SUCCESS      0x01000000
+
+/** Bitmask of the next hop in a lookup result */
+#define RTE_LPM_EXT_NEXT_HOP_MASK       0x00ffffff
+
+/**
+ * Creation flag allowing lookups to run concurrently with add and delete
+ * operations: freed tbl8 groups are only reused once all the registered
+ * readers have reported a quiescent state.
+ */
+#define RTE_LPM_EXT_F_RW_CONCURRENCY    0x1
+
+/**
+ * @internal Tbl24 and tbl8 entry structure. In tbl24 entries, the valid_group
+ * flag is the external entry flag and the next hop field holds the index of
+ * the tbl8 group when it is set.
+ */
+struct rte_lpm_ext_tbl_entry {
+	uint32_t next_hop    :24; /**< Next hop or tbl8 group index. */
+	uint32_t valid       :1;  /**< Validation flag. */
+	uint32_t valid_group :1;  /**< Group validation / external entry flag. */
+	uint32_t depth       :6;  /**< Rule depth. */
+};
+
+/** @internal Rule structure. */
+struct rte_lpm_ext_rule {
+	uint32_t ip; /**< Rule IP address. */
+	uint32_t next_hop; /**< Rule next hop. */
+};
+
+/** Extended LPM configuration structure. */
+struct rte_lpm_ext_config {
+	uint32_t max_rules;      /**< Max number of rules. */
+	uint32_t number_tbl8s;   /**< Number of tbl8 groups to allocate. */
+	int flags;               /**< RTE_LPM_EXT_F_* flags. */
+};
+
+/** @internal Freed tbl8 group waiting to be reclaimed. */
+struct rte_lpm_ext_tbl8_pending {
+	uint32_t group;   /**< Index of the tbl8 group. */
+	uint64_t epoch;   /**< Epoch at which the group was freed. */
+};
+
+/** @internal Per lcore state of a reader. */
+struct rte_lpm_ext_reader {
+	volatile uint64_t epoch; /**< Last epoch seen, UINT64_MAX if offline. */
+} __rte_cache_aligned;
+
+/** @internal Extended LPM structure. */
+struct rte_lpm_ext {
+	/* LPM metadata. */
+	char name[RTE_LPM_NAMESIZE];        /**< Name of the lpm. */
+	uint32_t max_rules; /**< Max. balanced rules per lpm. */
+	uint32_t number_tbl8s; /**< Number of tbl8 groups. */
+	uint32_t flags; /**< RTE_LPM_EXT_F_* flags. */
+	uint32_t tbl8_next; /**< Next tbl8 group tried by allocation. */
+	struct rte_lpm_rule_info rule_info[RTE_LPM_MAX_DEPTH]; /**< Rule info table. */
+
+	/* LPM Tables. */
+	struct rte_lpm_ext_tbl_entry tbl24[RTE_LPM_TBL24_NUM_ENTRIES] \
+			__rte_cache_aligned; /**< LPM tbl24 table. */
+	struct rte_lpm_ext_tbl_entry *tbl8; /**< LPM tbl8 table. */
+	struct rte_lpm_ext_rule *rules_tbl; /**< LPM rules. */
+
+	/* Deferred reclamation of tbl8 groups (RTE_LPM_EXT_F_RW_CONCURRENCY). */
+	struct rte_lpm_ext_tbl8_pending *tbl8_pending; /**< FIFO of freed groups. */
+	uint32_t pending_head;  /**< Oldest entry of the FIFO. */
+	uint32_t pending_count; /**< Number of entries in the FIFO. */
+	volatile uint64_t epoch __rte_cache_aligned; /**< Writer epoch. */
+	struct rte_lpm_ext_reader readers[RTE_MAX_LCORE]; /**< Reader states. */
+};
+
+/**
+ * Create an extended LPM object.
+ *
+ * @param name
+ *   LPM object name
+ * @param socket_id
+ *   NUMA socket ID for LPM table memory allocation
+ * @param config
+ *   Structure containing the configuration
+ * @return
+ *   Handle to LPM object on success, NULL otherwise with rte_errno set
+ *   to an appropriate values. Possible rte_errno values include:
+ *    - E_RTE_NO_CONFIG - function could not get pointer to rte_config structure
+ *    - E_RTE_SECONDARY - function was called from a secondary process instance
+ *    - EINVAL - invalid parameter passed to function
+ *    - ENOSPC - the maximum number of memzones has already been allocated
+ *    - EEXIST - a memzone with the same name already exists
+ *    - ENOMEM - no appropriate memory area found in which to create memzone
+ */
+struct rte_lpm_ext *
+rte_lpm_ext_create(const char *name, int socket_id,
+		const struct rte_lpm_ext_config *config);
+
+/**
+ * Find an existing extended LPM object and return a pointer to it.
+ *
+ * @param name
+ *   Name of the lpm object as passed to rte_lpm_ext_create()
+ * @return
+ *   Pointer to lpm object or NULL if object not found with rte_errno
+ *   set appropriately. Possible rte_errno values include:
+ *    - ENOENT - required entry not available to return.
+ */
+struct rte_lpm_ext *
+rte_lpm_ext_find_existing(const char *name);
+
+/**
+ * Free an extended LPM object.
+ *
+ * @param lpm
+ *   LPM object handle
+ * @return
+ *   None
+ */
+void
+rte_lpm_ext_free(struct rte_lpm_ext *lpm);
+
+/**
+ * Add a rule to the extended LPM table.
+ *
+ * @param lpm
+ *   LPM object handle
+ * @param ip
+ *   IP of the rule to be added to the LPM table
+ * @param depth
+ *   Depth of the rule to be added to the LPM table
+ * @param next_hop
+ *   Next hop of the rule to be added to the LPM table, at most
+ *   RTE_LPM_EXT_MAX_NEXT_HOP
+ * @return
+ *   0 on success, negative value otherwise
+ */
+int
+rte_lpm_ext_add(struct rte_lpm_ext *lpm, uint32_t ip, uint8_t depth,
+		uint32_t next_hop);
+
+/**
+ * Check if a rule is present in the extended LPM table,
+ * and provide its next hop if it is.
+ *
+ * @param lpm
+ *   LPM object handle
+ * @param ip
+ *   IP of the rule to be searched
+ * @param depth
+ *   Depth of the rule to searched
+ * @param next_hop
+ *   Next hop of the rule (valid only if it is found)
+ * @return
+ *   1 if the rule exists, 0 if it does not, a negative value on failure
+ */
+int
+rte_lpm_ext_is_rule_present(struct rte_lpm_ext *lpm, uint32_t ip,
+		uint8_t depth, uint32_t *next_hop);
+
+/**
+ * Delete a rule from the extended LPM table.
+ *
+ * @param lpm
+ *   LPM object handle
+ * @param ip
+ *   IP of the rule to be deleted from the LPM table
+ * @param depth
+ *   Depth of the rule to be deleted from the LPM table
+ * @return
+ *   0 on success, negative value otherwise
+ */
+int
+rte_lpm_ext_delete(struct rte_lpm_ext *lpm, uint32_t ip, uint8_t depth);
+
+/**
+ * Delete all rules from the extended LPM table. This must not run
+ * concurrently with lookups, even with RTE_LPM_EXT_F_RW_CONCURRENCY.
+ *
+ * @param lpm
+ *   LPM object handle
+ */
+void
+rte_lpm_ext_delete_all(struct rte_lpm_ext *lpm);
+
+/**
+ * Register an lcore doing lookups in an extended LPM table created with
+ * RTE_LPM_EXT_F_RW_CONCURRENCY. Until it is unregistered, the lcore must
+ * call rte_lpm_ext_reader_quiescent() regularly, or tbl8 groups freed by
+ * delete operations can not be reused by add operations.
+ *
+ * @param lpm
+ *   LPM object handle
+ * @param lcore_id
+ *   Id of the lcore doing lookups
+ * @return
+ *   0 on success, -EINVAL if the parameters are invalid
+ */
+int
+rte_lpm_ext_reader_register(struct rte_lpm_ext *lpm, unsigned lcore_id);
+
+/**
+ * Unregister an lcore doing lookups in an extended LPM table. The lcore
+ * must not do any lookup in the table after this call.
+ *
+ * @param lpm
+ *   LPM object handle
+ * @param lcore_id
+ *   Id of the lcore doing lookups
+ * @return
+ *   0 on success, -EINVAL if the parameters are invalid
+ */
+int
+rte_lpm_ext_reader_unregister(struct rte_lpm_ext *lpm, unsigned lcore_id);
+
+/**
+ * Report that a registered lcore does not hold any result or table entry
+ * read by its previous lookups in an extended LPM table, typically once per
+ * burst of packets.
+ *
+ * @param lpm
+ *   LPM object handle
+ * @param lcore_id
+ *   Id of the lcore doing lookups
+ */
+static inline void
+rte_lpm_ext_reader_quiescent(struct rte_lpm_ext *lpm, unsigned lcore_id)
+{
+	/* Previous lookups complete before the new epoch is reported */
+	rte_compiler_barrier();
+	lpm->readers[lcore_id].epoch = lpm->epoch;
+	rte_compiler_barrier();
+}
+
+/**
+ * Lookup an IP into the extended LPM table.
+ *
+ * @param lpm
+ *   LPM object handle
+ * @param ip
+ *   IP to be looked up in the LPM table
+ * @param next_hop
+ *   Next hop of the most specific rule found for IP (valid on lookup hit only)
+ * @return
+ *   -EINVAL for incorrect arguments, -ENOENT on lookup miss, 0 on lookup hit
+ */
+static inline int
+rte_lpm_ext_lookup(const struct rte_lpm_ext *lpm, uint32_t ip,
+		uint32_t *next_hop)
+{
+	unsigned tbl24_index = (ip >> 8);
+	uint32_t tbl_entry;
+	const uint32_t *ptbl;
+
+	/* DEBUG: Check user input arguments. */
+	RTE_LPM_RETURN_IF_TRUE(((lpm == NULL) || (next_hop == NULL)), -EINVAL);
+
+	/* Copy tbl24 entry */
+	ptbl = (const uint32_t *)&lpm->tbl24[tbl24_index];
+	tbl_entry = *ptbl;
+
+	/* Copy tbl8 entry (only if needed) */
+	if (unlikely((tbl_entry & RTE_LPM_EXT_VALID_EXT_ENTRY_BITMASK) ==
+			RTE_LPM_EXT_VALID_EXT_ENTRY_BITMASK)) {
+
+		unsigned tbl8_index = (uint8_t)ip +
+				((tbl_entry & RTE_LPM_EXT_NEXT_HOP_MASK) *
+				 RTE_LPM_TBL8_GROUP_NUM_ENTRIES);
+
+		ptbl = (const uint32_t *)&lpm->tbl8[tbl8_index];
+		tbl_entry = *ptbl;
+	}
+
+	*next_hop = tbl_entry & RTE_LPM_EXT_NEXT_HOP_MASK;
+	return (tbl_entry & RTE_LPM_EXT_LOOKUP_SUCCESS) ? 0 : -ENOENT;
+}
+
+/**
+ * Lookup multiple IP addresses in an extended LPM table. This may be
+ * implemented as a macro, so the address of the function should not be used.
+ *
+ * @param lpm
+ *   LPM object handle
+ * @param ips
+ *   Array of IPs to be looked up in the LPM table
+ * @param next_hops
+ *   Next hop of the most specific rule found for IP (valid on lookup hit only).
+ *   This is an array of four byte values. The lookup was successful if the
+ *   RTE_LPM_EXT_LOOKUP_SUCCESS bit is set, and the next hop is then given by
+ *   the RTE_LPM_EXT_NEXT_HOP_MASK bits.
+ * @param n
+ *   Number of elements in ips (and next_hops) array to lookup. This should be a
+ *   compile time constant, and divisible by 8 for best performance.
+ *  @return
+ *   -EINVAL for incorrect arguments, otherwise 0
+ */
+#define rte_lpm_ext_lookup_bulk(lpm, ips, next_hops, n) \
+		rte_lpm_ext_lookup_bulk_func(lpm, ips, next_hops, n)
+
+static inline int
+rte_lpm_ext_lookup_bulk_func(const struct rte_lpm_ext *lpm,
+		const uint32_t *ips, uint32_t *next_hops, const unsigned n)
+{
+	unsigned i;
+	unsigned tbl24_indexes[n];
+	const uint32_t *ptbl;
+
+	/* DEBUG: Check user input arguments. */
+	RTE_LPM_RETURN_IF_TRUE(((lpm == NULL) || (ips == NULL) ||
+			(next_hops == NULL)), -EINVAL);
+
+	for (i = 0; i < n; i++) {
+		tbl24_indexes[i] = ips[i] >> 8;
+	}
+
+	for (i = 0; i < n; i++) {
+		/* Simply copy tbl24 entry to output */
+		ptbl = (const uint32_t *)&lpm->tbl24[tbl24_indexes[i]];
+		next_hops[i] = *ptbl;
+
+		/* Overwrite output with tbl8 entry if needed */
+		if (unlikely((next_hops[i] &
+				RTE_LPM_EXT_VALID_EXT_ENTRY_BITMASK) ==
+				RTE_LPM_EXT_VALID_EXT_ENTRY_BITMASK)) {
+
+			unsigned tbl8_index = (uint8_t)ips[i] +
+					((next_hops[i] &
+					  RTE_LPM_EXT_NEXT_HOP_MASK) *
+					 RTE_LPM_TBL8_GROUP_NUM_ENTRIES);
+
+			ptbl = (const uint32_t *)&lpm->tbl8[tbl8_index];
+			next_hops[i] = *ptbl;
+		}
+	}
+	return 0;
+}
+
+/**
+ * Lookup four IP addresses in an extended LPM table.
+ *
+ * @param lpm
+ *   LPM object handle
+ * @param ip
+ *   Four IPs to be looked up in the LPM table
+ * @param hop
+ *   Next hop of the most specific rule found for IP (valid on lookup hit only).
+ *   This is an 4 elements array of four byte values.
+ *   If the lookup was successful for the given IP, then the corresponding
+ *   element is the actual next hop.
+ *   If the lookup for the given IP failed, then corresponding element would
+ *   contain default value, see description of then next parameter.
+ * @param defv
+ *   Default value to populate into corresponding element of hop[] array,
+ *   if lookup would fail.
+ */
+static inline void
+rte_lpm_ext_lookupx4(const struct rte_lpm_ext *lpm, __m128i ip,
+	uint32_t hop[4], uint32_t defv)
+{
+	__m128i i24, t;
+	rte_xmm_t i8;
+	uint32_t tbl[4];
+	uint64_t idx;
+	const uint32_t *ptbl;
+
+	const __m128i mask8 =
+		_mm_set_epi32(UINT8_MAX, UINT8_MAX, UINT8_MAX, UINT8_MAX);
+
+	/* RTE_LPM_EXT_VALID_EXT_ENTRY_BITMASK for 4 LPM entries. */
+	const __m128i mask_xv = _mm_set1_epi32(
+		(int32_t)RTE_LPM_EXT_VALID_EXT_ENTRY_BITMASK);
+
+	/* RTE_LPM_EXT_LOOKUP_SUCCESS for 4 LPM entries. */
+	const __m128i mask_v = _mm_set1_epi32(
+		(int32_t)RTE_LPM_EXT_LOOKUP_SUCCESS);
+
+	/* RTE_LPM_EXT_NEXT_HOP_MASK for 4 LPM entries. */
+	const __m128i mask_nh = _mm_set1_epi32(
+		(int32_t)RTE_LPM_EXT_NEXT_HOP_MASK);
+
+	/* get 4 indexes for tbl24[]. */
+	i24 = _mm_srli_epi32(ip, CHAR_BIT);
+
+	/* extract values from tbl24[] */
+	idx = _mm_cvtsi128_si64(i24);
+	i24 = _mm_srli_si128(i24, sizeof(uint64_t));
+
+	ptbl = (const uint32_t *)&lpm->tbl24[(uint32_t)idx];
+	tbl[0] = *ptbl;
+	ptbl = (const uint32_t *)&lpm->tbl24[idx >> 32];
+	tbl[1] = *ptbl;
+
+	idx = _mm_cvtsi128_si64(i24);
+
+	ptbl = (const uint32_t *)&lpm->tbl24[(uint32_t)idx];
+	tbl[2] = *ptbl;
+	ptbl = (const uint32_t *)&lpm->tbl24[idx >> 32];
+	tbl[3] = *ptbl;
+
+	/* get 4 indexes for tbl8[]. */
+	i8.x = _mm_and_si128(ip, mask8);
+
+	t = _mm_set_epi32(tbl[3], tbl[2], tbl[1], tbl[0]);
+
+	/* search successfully finished for all 4 IP addresses. */
+	if (likely(_mm_movemask_epi8(_mm_cmpeq_epi32(
+			_mm_and_si128(t, mask_xv), mask_v)) == 0xffff)) {
+		_mm_storeu_si128((__m128i *)hop, _mm_and_si128(t, mask_nh));
+		return;
+	}
+
+	if (unlikely((tbl[0] & RTE_LPM_EXT_VALID_EXT_ENTRY_BITMASK) ==
+			RTE_LPM_EXT_VALID_EXT_ENTRY_BITMASK)) {
+		i8.u32[0] = i8.u32[0] + (tbl[0] & RTE_LPM_EXT_NEXT_HOP_MASK) *
+			RTE_LPM_TBL8_GROUP_NUM_ENTRIES;
+		ptbl = (const uint32_t *)&lpm->tbl8[i8.u32[0]];
+		tbl[0] = *ptbl;
+	}
+	if (unlikely((tbl[1] & RTE_LPM_EXT_VALID_EXT_ENTRY_BITMASK) ==
+			RTE_LPM_EXT_VALID_EXT_ENTRY_BITMASK)) {
+		i8.u32[1] = i8.u32[1] + (tbl[1] & RTE_LPM_EXT_NEXT_HOP_MASK) *
+			RTE_LPM_TBL8_GROUP_NUM_ENTRIES;
+		ptbl = (const uint32_t *)&lpm->tbl8[i8.u32[1]];
+		tbl[1] = *ptbl;
+	}
+	if (unlikely((tbl[2] & RTE_LPM_EXT_VALID_EXT_ENTRY_BITMASK) ==
+			RTE_LPM_EXT_VALID_EXT_ENTRY_BITMASK)) {
+		i8.u32[2] = i8.u32[2] + (tbl[2] & RTE_LPM_EXT_NEXT_HOP_MASK) *
+			RTE_LPM_TBL8_GROUP_NUM_ENTRIES;
+		ptbl = (const uint32_t *)&lpm->tbl8[i8.u32[2]];
+		tbl[2] = *ptbl;
+	}
+	if (unlikely((tbl[3] & RTE_LPM_EXT_VALID_EXT_ENTRY_BITMASK) ==
+			RTE_LPM_EXT_VALID_EXT_ENTRY_BITMASK)) {
+		i8.u32[3] = i8.u32[3] + (tbl[3] & RTE_LPM_EXT_NEXT_HOP_MASK) *
+			RTE_LPM_TBL8_GROUP_NUM_ENTRIES;
+		ptbl = (const uint32_t *)&lpm->tbl8[i8.u32[3]];
+		tbl[3] = *ptbl;
+	}
+
+	hop[0] = (tbl[0] & RTE_LPM_EXT_LOOKUP_SUCCESS) ?
+		tbl[0] & RTE_LPM_EXT_NEXT_HOP_MASK : defv;
+	hop[1] = (tbl[1] & RTE_LPM_EXT_LOOKUP_SUCCESS) ?
+		tbl[1] & RTE_LPM_EXT_NEXT_HOP_MASK : defv;
+	hop[2] = (tbl[2] & RTE_LPM_EXT_LOOKUP_SUCCESS) ?
+		tbl[2] & RTE_LPM_EXT_NEXT_HOP_MASK : defv;
+	hop[3] = (tbl[3] & RTE_LPM_EXT_LOOKUP_SUCCESS) ?
+		tbl[3] & RTE_LPM_EXT_NEXT_HOP_MASK : defv;
+}
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _RTE_LPM_EXT_H_ */
@@ -0,0 +1,161 @@
+/*-
+ *   BSD LICENSE
+ *
+ *   Copyright(c) 2010-2014 Intel Corporation. All rights reserved.
+ *   All rights reserved.
+ *
+ *   Redistribution and use in source and binary forms, with or without
+ *   modification, are permitted provided that the following conditions
+ *   are met:
+ *
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in
+ *       the documentation and/or other materials provided with the
+ *       distribution.
+ *     * Neither the name of Intel Corporation nor the names of its
+ *       contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ *   THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *   "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *   LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ *   A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ *   OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ *   SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ *   LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ *   DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ *   THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ *   (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ *   OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <stddef.h>
+#include <stdint.h>
+#include <sys/queue.h>
+
+#include <rte_memory.h>
+#include <rte_eal.h>
+#include <rte_eal_memconfig.h>
+#include <rte_per_lcore.h>
+#include <rte_lcore.h>
+#include <rte_common.h>
+#include <rte_branch_prediction.h>
+
+#include "malloc_elem.h"
+#include "malloc_heap.h"
+#include "malloc_cache.h"
+
+#if RTE_MALLOC_LCORE_CACHE_SIZE > 0
+
+/*
+ * A cache holds up to 2 * RTE_MALLOC_LCORE_CACHE_SIZE busy elements of
+ * each size class, all from the heap of the socket of its lcore. It is
+ * refilled and flushed by RTE_MALLOC_LCORE_CACHE_SIZE elements at a time.
+ * The caches are local to the process, only EAL threads use them.
+ *
+ * The elements in a cache are in the ELEM_CACHED state, so that freeing
+ * one of them again is detected as for the elements of a heap.
+ */
+struct malloc_lcore_cache {
+	unsigned len[MALLOC_CACHE_NUM_CLASSES];
+	void *objs[MALLOC_CACHE_NUM_CLASSES][RTE_MALLOC_LCORE_CACHE_SIZE * 2];
+} __rte_cache_aligned;
+
+static struct malloc_lcore_cache lcore_cache[RTE_MAX_LCORE];
+
+static inline struct malloc_elem *
+obj_to_elem(void *obj)
+{
+	return RTE_PTR_SUB(obj, MALLOC_ELEM_HEADER_LEN);
+}
+
+/* index of the smallest class that can hold size bytes */
+static inline unsigned
+size_to_class(size_t size)
+{
+	if (size <= RTE_CACHE_LINE_SIZE)
+		return 0;
+	return sizeof(long) * 8 - __builtin_clzl((size - 1) /
+			RTE_CACHE_LINE_SIZE);
+}
+
+void *
+malloc_cache_alloc(size_t size, unsigned align, int socket_arg)
+{
+	struct rte_mem_config *mcfg = rte_eal_get_configuration()->mem_config;
+	struct malloc_lcore_cache *cache;
+	unsigned lcore_id = rte_lcore_id();
+	unsigned cls, socket, i;
+	void *obj;
+
+	if (size > MALLOC_CACHE_MAX_SIZE || align > RTE_CACHE_LINE_SIZE ||
+	    lcore_id >= RTE_MAX_LCORE)
+		return NULL;
+
+	socket = malloc_get_numa_socket();
+	if (socket_arg != SOCKET_ID_ANY && (unsigned)socket_arg != socket)
+		return NULL;
+
+	cache = &lcore_cache[lcore_id];
+	cls = size_to_class(size);
+	if (unlikely(cache->len[cls] == 0)) {
+		cache->len[cls] = malloc_heap_alloc_bulk(
+				&mcfg->malloc_heaps[socket],
+				RTE_CACHE_LINE_SIZE << cls, cache->objs[cls],
+				RTE_MALLOC_LCORE_CACHE_SIZE);
+		if (cache->len[cls] == 0)
+			return NULL;
+		for (i = 0; i < cache->len[cls]; i++)
+			obj_to_elem(cache->objs[cls][i])->state = ELEM_CACHED;
+	}
+
+	obj = cache->objs[cls][--cache->len[cls]];
+	obj_to_elem(obj)->state = ELEM_BUSY;
+	return obj;
+}
+
+int
+malloc_cache_free(struct malloc_elem *elem)
+{
+	struct rte_mem_config *mcfg = rte_eal_get_configuration()->mem_config;
+	struct malloc_lcore_cache *cache;
+	unsigned lcore_id = rte_lcore_id();
+	struct malloc_heap *heap;
+	size_t size;
+	unsigned cls, i;
+
+	/* a block freed twice is not busy anymore, the heap rejects it */
+	if (!malloc_elem_cookies_ok(elem) || elem->state != ELEM_BUSY ||
+	    elem->pad != 0 || lcore_id >= RTE_MAX_LCORE)
+		return -1;
+
+	/* only blocks from the local heap, that fit in a class, are cached */
+	heap = &mcfg->malloc_heaps[malloc_get_numa_socket()];
+	size = elem->size - MALLOC_ELEM_OVERHEAD;
+	if (elem->heap != heap || size < RTE_CACHE_LINE_SIZE ||
+	    size >= 2 * MALLOC_CACHE_MAX_SIZE)
+		return -1;
+
+	/* the biggest class this block can hold */
+	cls = sizeof(long) * 8 - 1 - __builtin_clzl(size / RTE_CACHE_LINE_SIZE);
+	if (cls >= MALLOC_CACHE_NUM_CLASSES)
+		cls = MALLOC_CACHE_NUM_CLASSES - 1;
+
+	cache = &lcore_cache[lcore_id];
+	if (unlikely(cache->len[cls] == RTE_MALLOC_LCORE_CACHE_SIZE * 2)) {
+		cache->len[cls] -= RTE_MALLOC_LCORE_CACHE_SIZE;
+		for (i = cache->len[cls]; i < RTE_MALLOC_LCORE_CACHE_SIZE * 2;
+				i++)
+			obj_to_elem(cache->objs[cls][i])->state = ELEM_BUSY;
+		malloc_heap_free_bulk(heap, &cache->objs[cls][cache->len[cls]],
+				RTE_MALLOC_LCORE_CACHE_SIZE);
+	}
+	elem->state = ELEM_CACHED;
+	cache->objs[cls][cache->len[cls]++] = &elem[1];
+
+	return 0;
+}
+
+#endif /* RTE_MALLOC_LCORE_CACHE_SIZE > 0 */
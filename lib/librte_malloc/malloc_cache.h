@@ -0,0 +1,93 @@
+/*-
+ *   BSD LICENSE
+ *
+ *   Copyright(c) 2010-2014 Intel Corporation. All rights reserved.
+ *   All rights reserved.
+ *
+ *   Redistribution and use in source and binary forms, with or without
+ *   modification, are permitted provided that the following conditions
+ *   are met:
+ *
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in
+ *       the documentation and/or other materials provided with the
+ *       distribution.
+ *     * Neither the name of Intel Corporation nor the names of its
+ *       contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ *   THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *   "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *   LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ *   A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ *   OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ *   SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ *   LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ *   DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ *   THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ *   (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ *   OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef MALLOC_CACHE_H_
+#define MALLOC_CACHE_H_
+
+#include <stddef.h>
+
+#include "malloc_elem.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Blocks of data of up to MALLOC_CACHE_MAX_SIZE bytes are served from
+ * per-lcore caches, one per size class: 64, 128, 256 and 512 bytes with
+ * 64-byte cache lines.
+ */
+#define MALLOC_CACHE_NUM_CLASSES 4
+#define MALLOC_CACHE_MAX_SIZE \
+	(RTE_CACHE_LINE_SIZE << (MALLOC_CACHE_NUM_CLASSES - 1))
+
+#if RTE_MALLOC_LCORE_CACHE_SIZE > 0
+
+/*
+ * Allocate a block of data from the cache of the calling lcore. Returns
+ * NULL if the request cannot be served by the cache, in which case the
+ * block must be allocated from a heap.
+ */
+void *
+malloc_cache_alloc(size_t size, unsigned align, int socket_arg);
+
+/*
+ * Put a busy element in the cache of the calling lcore. Returns -1 if the
+ * element cannot be cached, in which case it must be freed to its heap,
+ * which also rejects an element that is not busy.
+ */
+int
+malloc_cache_free(struct malloc_elem *elem);
+
+#else
+
+static inline void *
+malloc_cache_alloc(size_t size __rte_unused, unsigned align __rte_unused,
+		int socket_arg __rte_unused)
+{
+	return NULL;
+}
+
+static inline int
+malloc_cache_free(struct malloc_elem *elem __rte_unused)
+{
+	return -1;
+}
+
+#endif /* RTE_MALLOC_LCORE_CACHE_SIZE > 0 */
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* MALLOC_CACHE_H_ */
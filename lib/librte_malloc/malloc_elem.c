@@ -240,17 +240,11 @@ join_elem(struct malloc_elem *elem1, struct malloc_elem *elem2)
 }
 
 /*
- * free a malloc_elem block by adding it to the free list. If the
- * blocks either immediately before or immediately after newly freed block
- * are also free, the blocks are merged together.
+ * free a malloc_elem block, with the lock of its heap already held.
  */
-int
-malloc_elem_free(struct malloc_elem *elem)
+void
+malloc_elem_free_nolock(struct malloc_elem *elem)
 {
-	if (!malloc_elem_cookies_ok(elem) || elem->state != ELEM_BUSY)
-		return -1;
-
-	rte_spinlock_lock(&(elem->heap->lock));
 	struct malloc_elem *next = RTE_PTR_ADD(elem, elem->size);
 	if (next->state == ELEM_FREE){
 		/* remove from free list, join to this one */
@@ -273,6 +267,21 @@ malloc_elem_free(struct malloc_elem *elem)
 	}
 	/* decrease heap's count of allocated elements */
 	elem->heap->alloc_count--;
+}
+
+/*
+ * free a malloc_elem block by adding it to the free list. If the
+ * blocks either immediately before or immediately after newly freed block
+ * are also free, the blocks are merged together.
+ */
+int
+malloc_elem_free(struct malloc_elem *elem)
+{
+	if (!malloc_elem_cookies_ok(elem) || elem->state != ELEM_BUSY)
+		return -1;
+
+	rte_spinlock_lock(&(elem->heap->lock));
+	malloc_elem_free_nolock(elem);
 	rte_spinlock_unlock(&(elem->heap->lock));
 
 	return 0;
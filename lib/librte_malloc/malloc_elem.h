@@ -42,7 +42,8 @@ struct malloc_heap;
 enum elem_state {
 	ELEM_FREE = 0,
 	ELEM_BUSY,
-	ELEM_PAD  /* element is a padding-only header */
+	ELEM_PAD,  /* element is a padding-only header */
+	ELEM_CACHED  /* busy element held by a per-lcore cache */
 };
 
 struct malloc_elem {
@@ -168,6 +169,13 @@ malloc_elem_alloc(struct malloc_elem *elem, size_t size, unsigned align);
 int
 malloc_elem_free(struct malloc_elem *elem);
 
+/*
+ * same as malloc_elem_free(), for a valid busy element whose heap is
+ * already locked by the caller.
+ */
+void
+malloc_elem_free_nolock(struct malloc_elem *elem);
+
 /*
  * attempt to resize a malloc_elem by expanding into any free space
  * immediately after it in memory.
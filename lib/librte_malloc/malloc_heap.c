@@ -173,6 +173,54 @@ malloc_heap_alloc(struct malloc_heap *heap,
 
 }
 
+/*
+ * Allocate up to n blocks of data of the same size, aligned on a cache
+ * line, taking the heap lock only once. This is used to refill the
+ * per-lcore caches. Returns the number of blocks allocated.
+ */
+unsigned
+malloc_heap_alloc_bulk(struct malloc_heap *heap, size_t size,
+		void **objs, unsigned n)
+{
+	const unsigned align = RTE_CACHE_LINE_SIZE;
+	struct malloc_elem *elem;
+	unsigned i;
+
+	size = RTE_CACHE_LINE_ROUNDUP(size);
+	rte_spinlock_lock(&heap->lock);
+	for (i = 0; i < n; i++) {
+		elem = find_suitable_element(heap, size, align);
+		if (elem == NULL) {
+			if (malloc_heap_add_memzone(heap, size, align) < 0)
+				break;
+			elem = find_suitable_element(heap, size, align);
+			if (elem == NULL)
+				break;
+		}
+		elem = malloc_elem_alloc(elem, size, align);
+		/* increase heap's count of allocated elements */
+		heap->alloc_count++;
+		objs[i] = &elem[1];
+	}
+	rte_spinlock_unlock(&heap->lock);
+	return i;
+}
+
+/*
+ * Free n blocks of data allocated from the same heap, taking the heap
+ * lock only once. This is used to flush the per-lcore caches.
+ */
+void
+malloc_heap_free_bulk(struct malloc_heap *heap, void * const *objs, unsigned n)
+{
+	unsigned i;
+
+	rte_spinlock_lock(&heap->lock);
+	for (i = 0; i < n; i++)
+		malloc_elem_free_nolock(malloc_elem_from_data(objs[i]));
+	rte_spinlock_unlock(&heap->lock);
+}
+
 /*
  * Function to retrieve data for heap on given socket
  */
@@ -56,6 +56,13 @@ void *
 malloc_heap_alloc(struct malloc_heap *heap, const char *type,
 		size_t size, unsigned align);
 
+unsigned
+malloc_heap_alloc_bulk(struct malloc_heap *heap, size_t size,
+		void **objs, unsigned n);
+
+void
+malloc_heap_free_bulk(struct malloc_heap *heap, void * const *objs, unsigned n);
+
 int
 malloc_heap_get_stats(const struct malloc_heap *heap,
 		struct rte_malloc_socket_stats *socket_stats);
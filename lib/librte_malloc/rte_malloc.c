@@ -53,13 +53,19 @@
 #include <rte_malloc.h>
 #include "malloc_elem.h"
 #include "malloc_heap.h"
+#include "malloc_cache.h"
 
 
 /* Free the memory space back to heap */
 void rte_free(void *addr)
 {
+	struct malloc_elem *elem;
+
 	if (addr == NULL) return;
-	if (malloc_elem_free(malloc_elem_from_data(addr)) < 0)
+	elem = malloc_elem_from_data(addr);
+	if (malloc_cache_free(elem) == 0)
+		return;
+	if (malloc_elem_free(elem) < 0)
 		rte_panic("Fatal error: Invalid memory\n");
 }
 
@@ -86,6 +92,11 @@ rte_malloc_socket(const char *type, size_t size, unsigned align, int socket_arg)
 	if (socket >= RTE_MAX_NUMA_NODES)
 		return NULL;
 
+	/* small blocks are served from the cache of the lcore */
+	ret = malloc_cache_alloc(size, align, socket_arg);
+	if (ret != NULL)
+		return ret;
+
 	ret = malloc_heap_alloc(&mcfg->malloc_heaps[socket], type,
 				size, align == 0 ? 1 : align);
 	if (ret != NULL || socket_arg != SOCKET_ID_ANY)
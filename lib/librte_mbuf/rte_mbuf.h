@@ -54,11 +54,13 @@
  */
 
 #include <stdint.h>
+#include <string.h>
 #include <rte_mempool.h>
 #include <rte_memory.h>
 #include <rte_atomic.h>
 #include <rte_prefetch.h>
 #include <rte_branch_prediction.h>
+#include <rte_mbuf_dyn.h>
 
 #ifdef __cplusplus
 extern "C" {
@@ -105,6 +107,14 @@ extern "C" {
 
 /* add new TX flags here */
 
+/**
+ * The bits between PKT_FIRST_FREE and PKT_LAST_FREE are not used by the
+ * flags above, they are given to the dynamic flags registered with
+ * rte_mbuf_dynflag_register().
+ */
+#define PKT_FIRST_FREE       (1ULL << 15)
+#define PKT_LAST_FREE        (1ULL << 49)
+
 /**
  * TCP segmentation offload. To enable this offload feature for a
  * packet to be transmitted on hardware supporting TSO:
@@ -190,6 +200,7 @@ extern "C" {
  */
 #define PKT_TX_OUTER_IPV6    (1ULL << 60)
 
+#define EXT_ATTACHED_MBUF    (1ULL << 61) /**< Mbuf with external buffer */
 #define IND_ATTACHED_MBUF    (1ULL << 62) /**< Indirect attached mbuf */
 
 /* Use final bit of flags to indicate a control mbuf */
@@ -224,6 +235,36 @@ typedef uint8_t  MARKER8[0];  /**< generic marker with 1B alignment */
 typedef uint64_t MARKER64[0]; /**< marker that allows us to overwrite 8 bytes
                                * with a single assignment */
 
+/**
+ * Function called to free an external buffer when the last mbuf attached
+ * to it is freed.
+ *
+ * @param addr
+ *   The address of the external buffer, as given to
+ *   rte_pktmbuf_attach_extbuf().
+ * @param opaque
+ *   The opaque argument given to rte_mbuf_ext_shinfo_init().
+ */
+typedef void (*rte_mbuf_extbuf_free_callback_t)(void *addr, void *opaque);
+
+/**
+ * Shared data of an external buffer attached to mbufs with
+ * rte_pktmbuf_attach_extbuf(). It is owned by the application and
+ * must stay valid until the free callback is called.
+ */
+struct rte_mbuf_ext_shared_info {
+	rte_mbuf_extbuf_free_callback_t free_cb; /**< Free callback. */
+	void *fcb_opaque;                        /**< Free callback argument. */
+	/**
+	 * 16-bit Reference counter, accessed like the one of the mbuf:
+	 * it counts the attached mbufs, plus the reference of the owner.
+	 */
+	union {
+		rte_atomic16_t refcnt_atomic; /**< Atomically accessed refcnt */
+		uint16_t refcnt;              /**< Non-atomically accessed refcnt */
+	};
+};
+
 /**
  * The generic rte_mbuf, containing a packet mbuf.
  */
@@ -291,6 +332,9 @@ struct rte_mbuf {
 
 	uint32_t seqn; /**< Sequence number. See also rte_reorder_insert() */
 
+	/** Reserved for dynamic fields, see rte_mbuf_dynfield_register(). */
+	uint32_t dynfield0[2];
+
 	/* second cache line - fields only used in slow path or on TX */
 	MARKER cacheline1 __rte_cache_aligned;
 
@@ -319,9 +363,15 @@ struct rte_mbuf {
 		};
 	};
 
+	/** Shared data of the external buffer, if EXT_ATTACHED_MBUF is set. */
+	struct rte_mbuf_ext_shared_info *shinfo;
+
 	/** Size of the application private data. In case of an indirect
 	 * mbuf, it stores the direct mbuf private data size. */
 	uint16_t priv_size;
+
+	/** Reserved for dynamic fields, see rte_mbuf_dynfield_register(). */
+	uint16_t dynfield1[11];
 } __rte_cache_aligned;
 
 static inline uint16_t rte_pktmbuf_priv_size(struct rte_mempool *mp);
@@ -368,9 +418,17 @@ rte_mbuf_to_baddr(struct rte_mbuf *md)
 #define RTE_MBUF_INDIRECT(mb)   ((mb)->ol_flags & IND_ATTACHED_MBUF)
 
 /**
- * Returns TRUE if given mbuf is direct, or FALSE otherwise.
+ * Returns TRUE if given mbuf is attached to an external buffer, or FALSE
+ * otherwise.
+ */
+#define RTE_MBUF_HAS_EXTBUF(mb) ((mb)->ol_flags & EXT_ATTACHED_MBUF)
+
+/**
+ * Returns TRUE if given mbuf is direct, or FALSE otherwise. A direct mbuf
+ * uses its own data buffer.
  */
-#define RTE_MBUF_DIRECT(mb)     (!RTE_MBUF_INDIRECT(mb))
+#define RTE_MBUF_DIRECT(mb) \
+	(!((mb)->ol_flags & (IND_ATTACHED_MBUF | EXT_ATTACHED_MBUF)))
 
 /**
  * Private data in case of pktmbuf pool.
@@ -488,6 +546,74 @@ rte_mbuf_refcnt_set(struct rte_mbuf *m, uint16_t new_value)
 
 #endif /* RTE_MBUF_REFCNT_ATOMIC */
 
+#ifdef RTE_MBUF_REFCNT_ATOMIC
+
+/**
+ * Adds given value to the refcnt of an external buffer and returns its
+ * new value.
+ */
+static inline uint16_t
+rte_mbuf_ext_refcnt_update(struct rte_mbuf_ext_shared_info *shinfo,
+	int16_t value)
+{
+	return (uint16_t)(rte_atomic16_add_return(&shinfo->refcnt_atomic,
+		value));
+}
+
+/**
+ * Reads the refcnt of an external buffer.
+ */
+static inline uint16_t
+rte_mbuf_ext_refcnt_read(const struct rte_mbuf_ext_shared_info *shinfo)
+{
+	return (uint16_t)(rte_atomic16_read(&shinfo->refcnt_atomic));
+}
+
+/**
+ * Sets the refcnt of an external buffer to a defined value.
+ */
+static inline void
+rte_mbuf_ext_refcnt_set(struct rte_mbuf_ext_shared_info *shinfo,
+	uint16_t new_value)
+{
+	rte_atomic16_set(&shinfo->refcnt_atomic, new_value);
+}
+
+#else /* ! RTE_MBUF_REFCNT_ATOMIC */
+
+/**
+ * Adds given value to the refcnt of an external buffer and returns its
+ * new value.
+ */
+static inline uint16_t
+rte_mbuf_ext_refcnt_update(struct rte_mbuf_ext_shared_info *shinfo,
+	int16_t value)
+{
+	shinfo->refcnt = (uint16_t)(shinfo->refcnt + value);
+	return shinfo->refcnt;
+}
+
+/**
+ * Reads the refcnt of an external buffer.
+ */
+static inline uint16_t
+rte_mbuf_ext_refcnt_read(const struct rte_mbuf_ext_shared_info *shinfo)
+{
+	return shinfo->refcnt;
+}
+
+/**
+ * Sets the refcnt of an external buffer to a defined value.
+ */
+static inline void
+rte_mbuf_ext_refcnt_set(struct rte_mbuf_ext_shared_info *shinfo,
+	uint16_t new_value)
+{
+	shinfo->refcnt = new_value;
+}
+
+#endif /* RTE_MBUF_REFCNT_ATOMIC */
+
 /** Mbuf prefetch */
 #define RTE_MBUF_PREFETCH_TO_FREE(m) do {       \
 	if ((m) != NULL)                        \
@@ -801,11 +927,99 @@ static inline struct rte_mbuf *rte_pktmbuf_alloc(struct rte_mempool *mp)
 	return (m);
 }
 
+/**
+ * @internal Reset the fields of a packet mbuf newly allocated by
+ * rte_pktmbuf_alloc_bulk(), with the value of the 8 bytes starting
+ * at rearm_data computed once for the whole bulk.
+ *
+ * @param m
+ *   The packet mbuf to be resetted.
+ * @param rearm
+ *   The data_off, refcnt, nb_segs and port fields of the mbuf, followed
+ *   by the 2 bytes of padding before ol_flags, which is not overwritten.
+ */
+static inline void __attribute__((always_inline))
+__rte_pktmbuf_reset_rearm(struct rte_mbuf *m, uint64_t rearm)
+{
+	RTE_MBUF_ASSERT(rte_mbuf_refcnt_read(m) == 0);
+
+	/* data_off, refcnt, nb_segs and port with a single store */
+	memcpy(&m->rearm_data, &rearm, sizeof(rearm));
+	m->ol_flags = 0;
+	m->packet_type = 0;
+	m->data_len = 0;
+	m->pkt_len = 0;
+	m->vlan_tci = 0;
+
+	m->next = NULL;
+	m->tx_offload = 0;
+	__rte_mbuf_sanity_check(m, 1);
+}
+
+/**
+ * Allocate a bulk of mbufs from a mempool.
+ *
+ * The mbufs are taken from the mempool with a single
+ * rte_mempool_get_bulk(), and are then initialized like with
+ * rte_pktmbuf_alloc(). The fields shared by the 8 bytes starting at
+ * rearm_data (data_off, refcnt, nb_segs and port) are computed once
+ * for the bulk and written with a single store per mbuf: all the
+ * mbufs of a pool must have the same buffer length.
+ *
+ * @param pool
+ *   The mempool from which the mbufs are allocated.
+ * @param mbufs
+ *   Array of pointers to mbufs, filled on success.
+ * @param count
+ *   Number of mbufs to allocate.
+ * @return
+ *   - 0: Success, count mbufs were allocated.
+ *   - -ENOENT: Not enough entries in the mempool; no mbuf is allocated.
+ */
+static inline int rte_pktmbuf_alloc_bulk(struct rte_mempool *pool,
+	 struct rte_mbuf **mbufs, unsigned count)
+{
+	struct rte_mbuf mb_def;
+	uint64_t rearm;
+	unsigned idx = 0;
+	int rc;
+
+	if (unlikely(count == 0))
+		return 0;
+
+	rc = rte_mempool_get_bulk(pool, (void **)mbufs, count);
+	if (unlikely(rc != 0))
+		return rc;
+
+	/* template of the 8 bytes starting at rearm_data */
+	mb_def.data_off = (RTE_PKTMBUF_HEADROOM <= mbufs[0]->buf_len) ?
+			RTE_PKTMBUF_HEADROOM : mbufs[0]->buf_len;
+	rte_mbuf_refcnt_set(&mb_def, 1);
+	mb_def.nb_segs = 1;
+	mb_def.port = 0xff;
+	mb_def.ol_flags = 0;
+	memcpy(&rearm, &mb_def.rearm_data, sizeof(rearm));
+
+	/* the loop is unrolled to reset four mbufs per iteration */
+	for (; idx + 4 <= count; idx += 4) {
+		__rte_pktmbuf_reset_rearm(mbufs[idx], rearm);
+		__rte_pktmbuf_reset_rearm(mbufs[idx + 1], rearm);
+		__rte_pktmbuf_reset_rearm(mbufs[idx + 2], rearm);
+		__rte_pktmbuf_reset_rearm(mbufs[idx + 3], rearm);
+	}
+	for (; idx < count; idx++)
+		__rte_pktmbuf_reset_rearm(mbufs[idx], rearm);
+
+	return 0;
+}
+
 /**
  * Attach packet mbuf to another packet mbuf.
  *
  * After attachment we refer the mbuf we attached as 'indirect',
  * while mbuf we attached to as 'direct'.
+ * If m is attached to an external buffer, mi is attached to the same
+ * external buffer instead, whose reference counter is incremented.
  * Right now, not supported:
  *  - attachment for already indirect mbuf (e.g. - mi has to be direct).
  *  - mbuf we trying to attach (mi) is used by someone else
@@ -823,14 +1037,23 @@ static inline void rte_pktmbuf_attach(struct rte_mbuf *mi, struct rte_mbuf *m)
 	RTE_MBUF_ASSERT(RTE_MBUF_DIRECT(mi) &&
 	    rte_mbuf_refcnt_read(mi) == 1);
 
-	/* if m is not direct, get the mbuf that embeds the data */
-	if (RTE_MBUF_DIRECT(m))
-		md = m;
-	else
-		md = rte_mbuf_from_indirect(m);
+	if (RTE_MBUF_HAS_EXTBUF(m)) {
+		/* share the external buffer of m */
+		rte_mbuf_ext_refcnt_update(m->shinfo, 1);
+		mi->shinfo = m->shinfo;
+		mi->ol_flags = m->ol_flags;
+	} else {
+		/* if m is not direct, get the mbuf that embeds the data */
+		if (RTE_MBUF_DIRECT(m))
+			md = m;
+		else
+			md = rte_mbuf_from_indirect(m);
+
+		rte_mbuf_refcnt_update(md, 1);
+		mi->priv_size = m->priv_size;
+		mi->ol_flags = m->ol_flags | IND_ATTACHED_MBUF;
+	}
 
-	rte_mbuf_refcnt_update(md, 1);
-	mi->priv_size = m->priv_size;
 	mi->buf_physaddr = m->buf_physaddr;
 	mi->buf_addr = m->buf_addr;
 	mi->buf_len = m->buf_len;
@@ -846,7 +1069,6 @@ static inline void rte_pktmbuf_attach(struct rte_mbuf *mi, struct rte_mbuf *m)
 	mi->next = NULL;
 	mi->pkt_len = mi->data_len;
 	mi->nb_segs = 1;
-	mi->ol_flags = m->ol_flags | IND_ATTACHED_MBUF;
 	mi->packet_type = m->packet_type;
 
 	__rte_mbuf_sanity_check(mi, 1);
@@ -854,8 +1076,99 @@ static inline void rte_pktmbuf_attach(struct rte_mbuf *mi, struct rte_mbuf *m)
 }
 
 /**
- * Detach an indirect packet mbuf.
+ * Initialize the shared data of an external buffer.
+ *
+ * The reference counter is set to 1, which is the reference of the owner
+ * of the buffer. It is released with rte_mbuf_ext_shinfo_release(), so
+ * that the buffer is freed once the owner and all the attached mbufs are
+ * done with it.
+ *
+ * @param shinfo
+ *   The shared data of the external buffer.
+ * @param free_cb
+ *   The function freeing the external buffer, cannot be NULL.
+ * @param fcb_opaque
+ *   The argument of free_cb.
+ */
+static inline void
+rte_mbuf_ext_shinfo_init(struct rte_mbuf_ext_shared_info *shinfo,
+	rte_mbuf_extbuf_free_callback_t free_cb, void *fcb_opaque)
+{
+	RTE_MBUF_ASSERT(free_cb != NULL);
+
+	shinfo->free_cb = free_cb;
+	shinfo->fcb_opaque = fcb_opaque;
+	rte_mbuf_ext_refcnt_set(shinfo, 1);
+}
+
+/**
+ * Release a reference to an external buffer, and free it with its
+ * callback if it was the last one.
+ *
+ * @param shinfo
+ *   The shared data of the external buffer.
+ * @param addr
+ *   The address of the external buffer, given to the free callback.
+ */
+static inline void
+rte_mbuf_ext_shinfo_release(struct rte_mbuf_ext_shared_info *shinfo,
+	void *addr)
+{
+	if (likely(rte_mbuf_ext_refcnt_read(shinfo) == 1) ||
+			likely(rte_mbuf_ext_refcnt_update(shinfo, -1) == 0)) {
+		rte_mbuf_ext_refcnt_set(shinfo, 0);
+		shinfo->free_cb(addr, shinfo->fcb_opaque);
+	}
+}
+
+/**
+ * Attach an external buffer to a packet mbuf.
+ *
+ * The mbuf then points to the external buffer instead of its own data
+ * room, without any copy, and the reference counter of the buffer is
+ * incremented. The same buffer can be attached to several mbufs, for
+ * example to transmit it several times. When an attached mbuf is freed
+ * or detached, the reference is released, and the free callback of the
+ * buffer is called with buf_addr when the last reference is released.
+ *
+ * The data offset and length of the mbuf are reset, the application
+ * must set them to the part of the buffer to use.
+ *
+ * @param m
+ *   The packet mbuf, which must be direct and not shared.
+ * @param buf_addr
+ *   The virtual address of the external buffer.
+ * @param buf_physaddr
+ *   The physical (IO) address of the external buffer.
+ * @param buf_len
+ *   The length of the external buffer.
+ * @param shinfo
+ *   The shared data of the external buffer, initialized with
+ *   rte_mbuf_ext_shinfo_init().
+ */
+static inline void
+rte_pktmbuf_attach_extbuf(struct rte_mbuf *m, void *buf_addr,
+	phys_addr_t buf_physaddr, uint16_t buf_len,
+	struct rte_mbuf_ext_shared_info *shinfo)
+{
+	RTE_MBUF_ASSERT(RTE_MBUF_DIRECT(m) && rte_mbuf_refcnt_read(m) == 1);
+	RTE_MBUF_ASSERT(rte_mbuf_ext_refcnt_read(shinfo) != 0);
+
+	rte_mbuf_ext_refcnt_update(shinfo, 1);
+	m->buf_addr = buf_addr;
+	m->buf_physaddr = buf_physaddr;
+	m->buf_len = buf_len;
+	m->data_off = 0;
+	m->data_len = 0;
+	m->ol_flags |= EXT_ATTACHED_MBUF;
+	m->shinfo = shinfo;
+}
+
+/**
+ * Detach an indirect packet mbuf, or a packet mbuf attached to an
+ * external buffer.
  *
+ *  - release the external buffer, if any.
  *  - restore original mbuf address and length values.
  *  - reset pktmbuf data and data_len to their default values.
  *  All other fields of the given packet mbuf will be left intact.
@@ -868,6 +1181,9 @@ static inline void rte_pktmbuf_detach(struct rte_mbuf *m)
 	struct rte_mempool *mp = m->pool;
 	uint32_t mbuf_size, buf_len, priv_size;
 
+	if (RTE_MBUF_HAS_EXTBUF(m))
+		rte_mbuf_ext_shinfo_release(m->shinfo, m->buf_addr);
+
 	priv_size = rte_pktmbuf_priv_size(mp);
 	mbuf_size = sizeof(struct rte_mbuf) + priv_size;
 	buf_len = rte_pktmbuf_data_room_size(mp);
@@ -904,12 +1220,17 @@ __rte_pktmbuf_prefree_seg(struct rte_mbuf *m)
 		/* if this is an indirect mbuf, then
 		 *  - detach mbuf
 		 *  - free attached mbuf segment
+		 * if it is attached to an external buffer, detach it, which
+		 * frees the buffer on the last reference.
 		 */
-		if (RTE_MBUF_INDIRECT(m)) {
-			struct rte_mbuf *md = rte_mbuf_from_indirect(m);
-			rte_pktmbuf_detach(m);
-			if (rte_mbuf_refcnt_update(md, -1) == 0)
-				__rte_mbuf_raw_free(md);
+		if (unlikely(!RTE_MBUF_DIRECT(m))) {
+			if (RTE_MBUF_INDIRECT(m)) {
+				struct rte_mbuf *md = rte_mbuf_from_indirect(m);
+				rte_pktmbuf_detach(m);
+				if (rte_mbuf_refcnt_update(md, -1) == 0)
+					__rte_mbuf_raw_free(md);
+			} else
+				rte_pktmbuf_detach(m);
 		}
 		return(m);
 	}
@@ -956,6 +1277,64 @@ static inline void rte_pktmbuf_free(struct rte_mbuf *m)
 	}
 }
 
+/** Max number of segments put back in a mempool at once by rte_pktmbuf_free_bulk(). */
+#define RTE_PKTMBUF_FREE_BULK_SZ 64
+
+/**
+ * Free a bulk of packet mbufs back into their original mempools.
+ *
+ * Free each mbuf of the array, and all its segments in case of chained
+ * buffers, like rte_pktmbuf_free(). The freed segments are gathered
+ * and put back in their mempool with rte_mempool_put_bulk(), in groups
+ * of consecutive segments from the same mempool.
+ *
+ * @param mbufs
+ *   Array of pointers to packet mbufs. The array may contain NULL
+ *   pointers, which are ignored.
+ * @param count
+ *   Number of entries in the array.
+ */
+static inline void rte_pktmbuf_free_bulk(struct rte_mbuf **mbufs,
+	unsigned count)
+{
+	void *pending[RTE_PKTMBUF_FREE_BULK_SZ];
+	struct rte_mempool *pool = NULL;
+	struct rte_mbuf *m, *m_next;
+	unsigned idx, nb_pending = 0;
+
+	for (idx = 0; idx < count; idx++) {
+		m = mbufs[idx];
+		if (m == NULL)
+			continue;
+
+		__rte_mbuf_sanity_check(m, 1);
+
+		do {
+			m_next = m->next;
+			m = __rte_pktmbuf_prefree_seg(m);
+			if (likely(m != NULL)) {
+				m->next = NULL;
+				RTE_MBUF_ASSERT(rte_mbuf_refcnt_read(m) == 0);
+
+				/* flush the segments of another pool */
+				if (unlikely(m->pool != pool ||
+				    nb_pending == RTE_PKTMBUF_FREE_BULK_SZ)) {
+					if (nb_pending > 0)
+						rte_mempool_put_bulk(pool,
+							pending, nb_pending);
+					nb_pending = 0;
+					pool = m->pool;
+				}
+				pending[nb_pending++] = m;
+			}
+			m = m_next;
+		} while (m != NULL);
+	}
+
+	if (nb_pending > 0)
+		rte_mempool_put_bulk(pool, pending, nb_pending);
+}
+
 /**
  * Creates a "clone" of the given packet mbuf.
  *
@@ -0,0 +1,370 @@
+/*-
+ *   BSD LICENSE
+ *
+ *   Copyright(c) 2010-2015 Intel Corporation. All rights reserved.
+ *   Copyright 2014 6WIND S.A.
+ *   All rights reserved.
+ *
+ *   Redistribution and use in source and binary forms, with or without
+ *   modification, are permitted provided that the following conditions
+ *   are met:
+ *
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in
+ *       the documentation and/or other materials provided with the
+ *       distribution.
+ *     * Neither the name of Intel Corporation nor the names of its
+ *       contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ *   THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *   "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *   LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ *   A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ *   OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ *   SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ *   LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ *   DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ *   THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ *   (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ *   OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <stdio.h>
+#include <stdint.h>
+#include <string.h>
+#include <errno.h>
+#include <inttypes.h>
+
+#include <rte_common.h>
+#include <rte_log.h>
+#include <rte_eal.h>
+#include <rte_eal_memconfig.h>
+#include <rte_memzone.h>
+#include <rte_rwlock.h>
+#include <rte_mbuf.h>
+
+#include "rte_mbuf_dyn.h"
+
+#define MBUF_DYN_MZ_NAME "rte_mbuf_dyn"
+
+/* mask of the bits of ol_flags available for dynamic flags */
+#define MBUF_DYNFLAG_FREE_MASK \
+	((PKT_LAST_FREE | (PKT_LAST_FREE - 1)) & ~(PKT_FIRST_FREE - 1))
+
+/* registry of the dynamic fields and flags, shared by all processes */
+struct mbuf_dyn_shm {
+	/* non-zero for each byte of the mbuf available for dynamic fields */
+	uint8_t free_space[sizeof(struct rte_mbuf)];
+	uint64_t free_flags; /* bits of ol_flags available for dynamic flags */
+	unsigned nb_fields;
+	unsigned nb_flags;
+	struct {
+		struct rte_mbuf_dynfield params;
+		int offset;
+	} fields[RTE_MBUF_DYN_MAX_FIELDS];
+	struct {
+		struct rte_mbuf_dynflag params;
+		int bitnum;
+	} flags[64];
+};
+
+/* registry of this process, looked up once */
+static struct mbuf_dyn_shm *shm;
+
+/* mark the space reserved for dynamic fields as free */
+static void
+mbuf_dyn_shm_init(struct mbuf_dyn_shm *s)
+{
+	memset(s, 0, sizeof(*s));
+	memset(&s->free_space[offsetof(struct rte_mbuf, dynfield0)], 1,
+		sizeof(((struct rte_mbuf *)0)->dynfield0));
+	memset(&s->free_space[offsetof(struct rte_mbuf, dynfield1)], 1,
+		sizeof(((struct rte_mbuf *)0)->dynfield1));
+	s->free_flags = MBUF_DYNFLAG_FREE_MASK;
+}
+
+/*
+ * Get the registry, creating it if needed. Must be called with the tailq
+ * lock held, which also protects the registry.
+ */
+static struct mbuf_dyn_shm *
+mbuf_dyn_shm_get(int create)
+{
+	const struct rte_memzone *mz;
+
+	if (shm != NULL)
+		return shm;
+
+	mz = rte_memzone_lookup(MBUF_DYN_MZ_NAME);
+	if (mz == NULL && create) {
+		mz = rte_memzone_reserve(MBUF_DYN_MZ_NAME,
+			sizeof(struct mbuf_dyn_shm), SOCKET_ID_ANY, 0);
+		if (mz == NULL) {
+			RTE_LOG(ERR, MBUF, "cannot allocate the registry of "
+				"dynamic fields\n");
+			return NULL;
+		}
+		mbuf_dyn_shm_init(mz->addr);
+	}
+	if (mz != NULL)
+		shm = mz->addr;
+	return shm;
+}
+
+/* check that a name is not empty and fits in a description */
+static int
+mbuf_dyn_name_valid(const char *name)
+{
+	size_t len = strnlen(name, RTE_MBUF_DYN_NAMESIZE);
+
+	return len != 0 && len != RTE_MBUF_DYN_NAMESIZE;
+}
+
+static int
+mbuf_dynfield_find(const struct mbuf_dyn_shm *s, const char *name)
+{
+	unsigned i;
+
+	for (i = 0; i < s->nb_fields; i++)
+		if (strcmp(s->fields[i].params.name, name) == 0)
+			return i;
+	return -1;
+}
+
+static int
+mbuf_dynflag_find(const struct mbuf_dyn_shm *s, const char *name)
+{
+	unsigned i;
+
+	for (i = 0; i < s->nb_flags; i++)
+		if (strcmp(s->flags[i].params.name, name) == 0)
+			return i;
+	return -1;
+}
+
+/* find the first aligned free space large enough for a field */
+static int
+mbuf_dynfield_place(const struct mbuf_dyn_shm *s, size_t size, size_t align)
+{
+	size_t off, i;
+
+	for (off = 0; off + size <= sizeof(struct rte_mbuf); off += align) {
+		for (i = 0; i < size && s->free_space[off + i]; i++)
+			;
+		if (i == size)
+			return off;
+	}
+	return -1;
+}
+
+/* register a dynamic field */
+int
+rte_mbuf_dynfield_register(const struct rte_mbuf_dynfield *params)
+{
+	struct mbuf_dyn_shm *s;
+	int idx, offset;
+
+	if (params == NULL || !mbuf_dyn_name_valid(params->name) ||
+			params->size == 0 ||
+			params->size > sizeof(struct rte_mbuf) ||
+			params->align == 0 ||
+			(params->align & (params->align - 1)) != 0 ||
+			params->flags != 0)
+		return -EINVAL;
+
+	rte_rwlock_write_lock(RTE_EAL_TAILQ_RWLOCK);
+
+	s = mbuf_dyn_shm_get(1);
+	if (s == NULL) {
+		offset = -ENOMEM;
+		goto out;
+	}
+
+	/* an identical registration gets the same field */
+	idx = mbuf_dynfield_find(s, params->name);
+	if (idx >= 0) {
+		if (s->fields[idx].params.size != params->size ||
+				s->fields[idx].params.align != params->align)
+			offset = -EEXIST;
+		else
+			offset = s->fields[idx].offset;
+		goto out;
+	}
+
+	if (s->nb_fields == RTE_MBUF_DYN_MAX_FIELDS) {
+		offset = -ENOSPC;
+		goto out;
+	}
+	offset = mbuf_dynfield_place(s, params->size, params->align);
+	if (offset < 0) {
+		RTE_LOG(ERR, MBUF, "no room for dynamic field %s of %zu "
+			"bytes\n", params->name, params->size);
+		offset = -ENOSPC;
+		goto out;
+	}
+
+	memset(&s->free_space[offset], 0, params->size);
+	s->fields[s->nb_fields].params = *params;
+	s->fields[s->nb_fields].offset = offset;
+	s->nb_fields++;
+
+out:
+	rte_rwlock_write_unlock(RTE_EAL_TAILQ_RWLOCK);
+	return offset;
+}
+
+/* look up a dynamic field */
+int
+rte_mbuf_dynfield_lookup(const char *name, struct rte_mbuf_dynfield *params)
+{
+	struct mbuf_dyn_shm *s;
+	int idx, offset = -ENOENT;
+
+	rte_rwlock_read_lock(RTE_EAL_TAILQ_RWLOCK);
+
+	s = mbuf_dyn_shm_get(0);
+	if (s != NULL) {
+		idx = mbuf_dynfield_find(s, name);
+		if (idx >= 0) {
+			offset = s->fields[idx].offset;
+			if (params != NULL)
+				*params = s->fields[idx].params;
+		}
+	}
+
+	rte_rwlock_read_unlock(RTE_EAL_TAILQ_RWLOCK);
+	return offset;
+}
+
+/* register a dynamic flag */
+int
+rte_mbuf_dynflag_register(const struct rte_mbuf_dynflag *params)
+{
+	struct mbuf_dyn_shm *s;
+	int idx, bitnum;
+
+	if (params == NULL || !mbuf_dyn_name_valid(params->name) ||
+			params->flags != 0)
+		return -EINVAL;
+
+	rte_rwlock_write_lock(RTE_EAL_TAILQ_RWLOCK);
+
+	s = mbuf_dyn_shm_get(1);
+	if (s == NULL) {
+		bitnum = -ENOMEM;
+		goto out;
+	}
+
+	/* an identical registration gets the same flag */
+	idx = mbuf_dynflag_find(s, params->name);
+	if (idx >= 0) {
+		bitnum = s->flags[idx].bitnum;
+		goto out;
+	}
+
+	if (s->free_flags == 0) {
+		RTE_LOG(ERR, MBUF, "no free bit for dynamic flag %s\n",
+			params->name);
+		bitnum = -ENOSPC;
+		goto out;
+	}
+
+	/* take the highest free bit, the static flags grow from the ends */
+	bitnum = 63 - __builtin_clzll(s->free_flags);
+	s->free_flags &= ~(1ULL << bitnum);
+	s->flags[s->nb_flags].params = *params;
+	s->flags[s->nb_flags].bitnum = bitnum;
+	s->nb_flags++;
+
+out:
+	rte_rwlock_write_unlock(RTE_EAL_TAILQ_RWLOCK);
+	return bitnum;
+}
+
+/* look up a dynamic flag */
+int
+rte_mbuf_dynflag_lookup(const char *name, struct rte_mbuf_dynflag *params)
+{
+	struct mbuf_dyn_shm *s;
+	int idx, bitnum = -ENOENT;
+
+	rte_rwlock_read_lock(RTE_EAL_TAILQ_RWLOCK);
+
+	s = mbuf_dyn_shm_get(0);
+	if (s != NULL) {
+		idx = mbuf_dynflag_find(s, name);
+		if (idx >= 0) {
+			bitnum = s->flags[idx].bitnum;
+			if (params != NULL)
+				*params = s->flags[idx].params;
+		}
+	}
+
+	rte_rwlock_read_unlock(RTE_EAL_TAILQ_RWLOCK);
+	return bitnum;
+}
+
+/* dump the registered dynamic fields and flags */
+void
+rte_mbuf_dyn_dump(FILE *f)
+{
+	struct mbuf_dyn_shm *s;
+	unsigned i, nb_free = 0;
+
+	rte_rwlock_read_lock(RTE_EAL_TAILQ_RWLOCK);
+
+	s = mbuf_dyn_shm_get(0);
+	if (s == NULL) {
+		fprintf(f, "no dynamic field or flag registered\n");
+		goto out;
+	}
+
+	for (i = 0; i < s->nb_fields; i++)
+		fprintf(f, "field %s: offset=%d size=%zu align=%zu\n",
+			s->fields[i].params.name, s->fields[i].offset,
+			s->fields[i].params.size, s->fields[i].params.align);
+	for (i = 0; i < s->nb_flags; i++)
+		fprintf(f, "flag %s: bit=%d\n", s->flags[i].params.name,
+			s->flags[i].bitnum);
+	for (i = 0; i < sizeof(s->free_space); i++)
+		nb_free += s->free_space[i] != 0;
+	fprintf(f, "free space: %u bytes, free flags: 0x%"PRIx64"\n",
+		nb_free, s->free_flags);
+
+out:
+	rte_rwlock_read_unlock(RTE_EAL_TAILQ_RWLOCK);
+}
+
+/* register the timestamp field and the RX timestamp flag */
+int
+rte_mbuf_dyn_rx_timestamp_register(int *field_offset, uint64_t *rx_flag)
+{
+	struct rte_mbuf_dynfield field;
+	struct rte_mbuf_dynflag flag;
+	int offset, bitnum;
+
+	memset(&field, 0, sizeof(field));
+	snprintf(field.name, sizeof(field.name), "%s",
+		RTE_MBUF_DYNFIELD_TIMESTAMP_NAME);
+	field.size = sizeof(rte_mbuf_timestamp_t);
+	field.align = __alignof__(rte_mbuf_timestamp_t);
+	offset = rte_mbuf_dynfield_register(&field);
+	if (offset < 0)
+		return offset;
+
+	memset(&flag, 0, sizeof(flag));
+	snprintf(flag.name, sizeof(flag.name), "%s",
+		RTE_MBUF_DYNFLAG_RX_TIMESTAMP_NAME);
+	bitnum = rte_mbuf_dynflag_register(&flag);
+	if (bitnum < 0)
+		return bitnum;
+
+	if (field_offset != NULL)
+		*field_offset = offset;
+	if (rx_flag != NULL)
+		*rx_flag = 1ULL << bitnum;
+	return 0;
+}
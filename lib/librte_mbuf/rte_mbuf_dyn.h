@@ -0,0 +1,190 @@
+/*-
+ *   BSD LICENSE
+ *
+ *   Copyright(c) 2010-2015 Intel Corporation. All rights reserved.
+ *   Copyright 2014 6WIND S.A.
+ *   All rights reserved.
+ *
+ *   Redistribution and use in source and binary forms, with or without
+ *   modification, are permitted provided that the following conditions
+ *   are met:
+ *
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in
+ *       the documentation and/or other materials provided with the
+ *       distribution.
+ *     * Neither the name of Intel Corporation nor the names of its
+ *       contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ *   THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *   "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *   LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ *   A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ *   OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ *   SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ *   LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ *   DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ *   THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ *   (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ *   OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef _RTE_MBUF_DYN_H_
+#define _RTE_MBUF_DYN_H_
+
+/**
+ * @file
+ * RTE Mbuf dynamic fields and flags
+ *
+ * Some bytes of the mbuf structure (dynfield0 and dynfield1) and some bits
+ * of ol_flags are not used by the library. Instead of sharing the userdata
+ * field, the libraries and applications needing per-packet metadata
+ * register named fields and flags in this space at initialization, and
+ * get their offset in the mbuf or their bit number in ol_flags. They then
+ * access them with RTE_MBUF_DYNFIELD() at the cost of a static field.
+ *
+ * The registration is shared by all processes, and registering a field
+ * or a flag again with the same parameters returns the same placement,
+ * so that independent users can agree on a common field. Registered
+ * fields are never released, and are not reset when an mbuf is allocated.
+ */
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** Maximum length of the name of a dynamic field or flag, with the NUL. */
+#define RTE_MBUF_DYN_NAMESIZE 64
+
+/** Maximum number of dynamic fields. */
+#define RTE_MBUF_DYN_MAX_FIELDS 32
+
+/** Description of a dynamic field. */
+struct rte_mbuf_dynfield {
+	char name[RTE_MBUF_DYN_NAMESIZE]; /**< Name of the field. */
+	size_t size;        /**< Size of the field in bytes. */
+	size_t align;       /**< Alignment of the field, a power of 2. */
+	unsigned flags;     /**< Reserved for future use, must be 0. */
+};
+
+/** Description of a dynamic flag. */
+struct rte_mbuf_dynflag {
+	char name[RTE_MBUF_DYN_NAMESIZE]; /**< Name of the flag. */
+	unsigned flags;     /**< Reserved for future use, must be 0. */
+};
+
+/**
+ * Register a dynamic field in the mbuf structure.
+ *
+ * @param params
+ *   The description of the field.
+ * @return
+ *   - The offset of the field in the mbuf structure on success.
+ *   - -EINVAL if the description is invalid.
+ *   - -EEXIST if a field with this name exists with other parameters.
+ *   - -ENOSPC if there is no room left for the field.
+ *   - -ENOMEM if the registry cannot be allocated.
+ */
+int rte_mbuf_dynfield_register(const struct rte_mbuf_dynfield *params);
+
+/**
+ * Look up a dynamic field by name.
+ *
+ * @param name
+ *   The name of the field.
+ * @param params
+ *   If not NULL, filled with the description of the field.
+ * @return
+ *   - The offset of the field in the mbuf structure on success.
+ *   - -ENOENT if no such field is registered.
+ */
+int rte_mbuf_dynfield_lookup(const char *name,
+		struct rte_mbuf_dynfield *params);
+
+/**
+ * Register a dynamic flag in the ol_flags field of the mbuf.
+ *
+ * @param params
+ *   The description of the flag.
+ * @return
+ *   - The bit number of the flag in ol_flags on success.
+ *   - -EINVAL if the description is invalid.
+ *   - -EEXIST if a flag with this name exists with other parameters.
+ *   - -ENOSPC if there is no free bit left.
+ *   - -ENOMEM if the registry cannot be allocated.
+ */
+int rte_mbuf_dynflag_register(const struct rte_mbuf_dynflag *params);
+
+/**
+ * Look up a dynamic flag by name.
+ *
+ * @param name
+ *   The name of the flag.
+ * @param params
+ *   If not NULL, filled with the description of the flag.
+ * @return
+ *   - The bit number of the flag in ol_flags on success.
+ *   - -ENOENT if no such flag is registered.
+ */
+int rte_mbuf_dynflag_lookup(const char *name,
+		struct rte_mbuf_dynflag *params);
+
+/**
+ * Dump the registered dynamic fields and flags, and the free space.
+ *
+ * @param f
+ *   A pointer to a file for output.
+ */
+void rte_mbuf_dyn_dump(FILE *f);
+
+/**
+ * Get a pointer to a dynamic field of an mbuf.
+ *
+ * @param m
+ *   The mbuf.
+ * @param offset
+ *   The offset of the field, returned by its registration or lookup.
+ * @param type
+ *   The pointer type of the field.
+ */
+#define RTE_MBUF_DYNFIELD(m, offset, type) \
+	((type)((uintptr_t)(m) + (offset)))
+
+/** Name of the timestamp dynamic field. */
+#define RTE_MBUF_DYNFIELD_TIMESTAMP_NAME "rte_dynfield_timestamp"
+
+/** Type of the timestamp dynamic field, in nanoseconds. */
+typedef uint64_t rte_mbuf_timestamp_t;
+
+/** Name of the flag telling that the timestamp field was set on RX. */
+#define RTE_MBUF_DYNFLAG_RX_TIMESTAMP_NAME "rte_dynflag_rx_timestamp"
+
+/**
+ * Register the timestamp dynamic field and the RX timestamp flag.
+ *
+ * Drivers able to timestamp the received packets look them up when their
+ * RX queues are set up. If they are registered, the drivers store the
+ * timestamp of each received packet in the field, and set the flag.
+ *
+ * @param field_offset
+ *   If not NULL, filled with the offset of the timestamp field.
+ * @param rx_flag
+ *   If not NULL, filled with the RX timestamp flag mask.
+ * @return
+ *   - 0 on success.
+ *   - A negative errno value of the registration functions on error.
+ */
+int rte_mbuf_dyn_rx_timestamp_register(int *field_offset, uint64_t *rx_flag);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _RTE_MBUF_DYN_H_ */
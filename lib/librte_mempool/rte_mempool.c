@@ -144,8 +144,8 @@ mempool_add_elem(struct rte_mempool *mp, void *obj, uint32_t obj_idx,
 	if (obj_init)
 		obj_init(mp, obj_init_arg, obj, obj_idx);
 
-	/* enqueue in ring */
-	rte_ring_sp_enqueue(mp->ring, obj);
+	/* enqueue in the common pool */
+	rte_mempool_ops_enqueue_bulk(mp, &obj, 1);
 }
 
 uint32_t
@@ -367,6 +367,15 @@ rte_mempool_xmem_usage(void *vaddr, uint32_t elt_num, size_t elt_sz,
 	return (usz);
 }
 
+static struct rte_mempool *
+mempool_xmem_create(const char *name, unsigned n, unsigned elt_size,
+		unsigned cache_size, unsigned private_data_size,
+		rte_mempool_ctor_t *mp_init, void *mp_init_arg,
+		rte_mempool_obj_ctor_t *obj_init, void *obj_init_arg,
+		int socket_id, unsigned flags, void *vaddr,
+		const phys_addr_t paddr[], uint32_t pg_num, uint32_t pg_shift,
+		const char *ops_name);
+
 /* create the mempool */
 struct rte_mempool *
 rte_mempool_create(const char *name, unsigned n, unsigned elt_size,
@@ -391,6 +400,35 @@ rte_mempool_create(const char *name, unsigned n, unsigned elt_size,
 #endif
 }
 
+/* create the mempool with a given handler */
+struct rte_mempool *
+rte_mempool_create_with_ops(const char *name, unsigned n, unsigned elt_size,
+		unsigned cache_size, unsigned private_data_size,
+		rte_mempool_ctor_t *mp_init, void *mp_init_arg,
+		rte_mempool_obj_ctor_t *obj_init, void *obj_init_arg,
+		int socket_id, unsigned flags, const char *ops_name)
+{
+#ifdef RTE_LIBRTE_XEN_DOM0
+	if (ops_name != NULL) {
+		rte_errno = ENOTSUP;
+		return NULL;
+	}
+	return (rte_dom0_mempool_create(name, n, elt_size,
+		cache_size, private_data_size,
+		mp_init, mp_init_arg,
+		obj_init, obj_init_arg,
+		socket_id, flags));
+#else
+	return (mempool_xmem_create(name, n, elt_size,
+		cache_size, private_data_size,
+		mp_init, mp_init_arg,
+		obj_init, obj_init_arg,
+		socket_id, flags,
+		NULL, NULL, MEMPOOL_PG_NUM_DEFAULT, MEMPOOL_PG_SHIFT_MAX,
+		ops_name));
+#endif
+}
+
 /*
  * Create the mempool over already allocated chunk of memory.
  * That external memory buffer can consists of physically disjoint pages.
@@ -405,17 +443,73 @@ rte_mempool_xmem_create(const char *name, unsigned n, unsigned elt_size,
 		rte_mempool_obj_ctor_t *obj_init, void *obj_init_arg,
 		int socket_id, unsigned flags, void *vaddr,
 		const phys_addr_t paddr[], uint32_t pg_num, uint32_t pg_shift)
+{
+	return mempool_xmem_create(name, n, elt_size,
+		cache_size, private_data_size,
+		mp_init, mp_init_arg,
+		obj_init, obj_init_arg,
+		socket_id, flags,
+		vaddr, paddr, pg_num, pg_shift, NULL);
+}
+
+/*
+ * Check that all the pages of a chunk of memory given without their
+ * physical addresses belong to registered external memory.
+ */
+static int
+mempool_extmem_check(void *vaddr, uint32_t pg_num, uint32_t pg_shift)
+{
+	uint32_t i;
+
+	for (i = 0; i != pg_num; i++) {
+		if (rte_extmem_virt2iova(RTE_PTR_ADD(vaddr,
+				(size_t)i << pg_shift)) == RTE_BAD_PHYS_ADDR) {
+			RTE_LOG(ERR, MEMPOOL, "page %u of %p is not registered "
+				"external memory\n", i, vaddr);
+			return -1;
+		}
+	}
+	return 0;
+}
+
+/* get the physical addresses of the pages of registered external memory */
+static void
+mempool_extmem_fill(phys_addr_t paddr[], void *vaddr, uint32_t pg_num,
+	uint32_t pg_shift)
+{
+	uint32_t i;
+
+	for (i = 0; i != pg_num; i++)
+		paddr[i] = rte_extmem_virt2iova(RTE_PTR_ADD(vaddr,
+			(size_t)i << pg_shift));
+}
+
+/* name of the ring handler matching the flags of a mempool */
+static const char *
+mempool_default_ops_name(unsigned flags)
+{
+	if (flags & MEMPOOL_F_SP_PUT)
+		return (flags & MEMPOOL_F_SC_GET) ? "ring_sp_sc" : "ring_sp_mc";
+	return (flags & MEMPOOL_F_SC_GET) ? "ring_mp_sc" : "ring_mp_mc";
+}
+
+static struct rte_mempool *
+mempool_xmem_create(const char *name, unsigned n, unsigned elt_size,
+		unsigned cache_size, unsigned private_data_size,
+		rte_mempool_ctor_t *mp_init, void *mp_init_arg,
+		rte_mempool_obj_ctor_t *obj_init, void *obj_init_arg,
+		int socket_id, unsigned flags, void *vaddr,
+		const phys_addr_t paddr[], uint32_t pg_num, uint32_t pg_shift,
+		const char *ops_name)
 {
 	char mz_name[RTE_MEMZONE_NAMESIZE];
-	char rg_name[RTE_RING_NAMESIZE];
 	struct rte_mempool_list *mempool_list;
 	struct rte_mempool *mp = NULL;
 	struct rte_tailq_entry *te;
-	struct rte_ring *r;
 	const struct rte_memzone *mz;
 	size_t mempool_size;
 	int mz_flags = RTE_MEMZONE_1GB|RTE_MEMZONE_SIZE_HINT_ONLY;
-	int rg_flags = 0;
+	int ops_index;
 	void *obj;
 	struct rte_mempool_objsz objsz;
 	void *startaddr;
@@ -445,14 +539,15 @@ rte_mempool_xmem_create(const char *name, unsigned n, unsigned elt_size,
 		return NULL;
 	}
 
-	/* check that we have both VA and PA */
-	if (vaddr != NULL && paddr == NULL) {
+	/* Check that pg_num and pg_shift parameters are valid. */
+	if (pg_num < RTE_DIM(mp->elt_pa) || pg_shift > MEMPOOL_PG_SHIFT_MAX) {
 		rte_errno = EINVAL;
 		return NULL;
 	}
 
-	/* Check that pg_num and pg_shift parameters are valid. */
-	if (pg_num < RTE_DIM(mp->elt_pa) || pg_shift > MEMPOOL_PG_SHIFT_MAX) {
+	/* check that we have both VA and PA, or that the PA can be found */
+	if (vaddr != NULL && paddr == NULL &&
+			mempool_extmem_check(vaddr, pg_num, pg_shift) < 0) {
 		rte_errno = EINVAL;
 		return NULL;
 	}
@@ -461,11 +556,15 @@ rte_mempool_xmem_create(const char *name, unsigned n, unsigned elt_size,
 	if (flags & MEMPOOL_F_NO_CACHE_ALIGN)
 		flags |= MEMPOOL_F_NO_SPREAD;
 
-	/* ring flags */
-	if (flags & MEMPOOL_F_SP_PUT)
-		rg_flags |= RING_F_SP_ENQ;
-	if (flags & MEMPOOL_F_SC_GET)
-		rg_flags |= RING_F_SC_DEQ;
+	/* handler storing the objects of the common pool */
+	if (ops_name == NULL)
+		ops_name = mempool_default_ops_name(flags);
+	ops_index = rte_mempool_ops_lookup(ops_name);
+	if (ops_index < 0) {
+		RTE_LOG(ERR, MEMPOOL, "Unknown mempool handler %s\n", ops_name);
+		rte_errno = ENOENT;
+		return NULL;
+	}
 
 	/* calculate mempool object sizes. */
 	if (!rte_mempool_calc_obj_size(elt_size, flags, &objsz)) {
@@ -475,15 +574,6 @@ rte_mempool_xmem_create(const char *name, unsigned n, unsigned elt_size,
 
 	rte_rwlock_write_lock(RTE_EAL_MEMPOOL_RWLOCK);
 
-	/* allocate the ring that will be used to store objects */
-	/* Ring functions will return appropriate errors if we are
-	 * running as a secondary process etc., so no checks made
-	 * in this function for that condition */
-	snprintf(rg_name, sizeof(rg_name), RTE_MEMPOOL_MZ_FORMAT, name);
-	r = rte_ring_create(rg_name, rte_align32pow2(n+1), socket_id, rg_flags);
-	if (r == NULL)
-		goto exit;
-
 	/*
 	 * reserve a memory zone for this mempool: private data is
 	 * cache-aligned
@@ -558,7 +648,7 @@ rte_mempool_xmem_create(const char *name, unsigned n, unsigned elt_size,
 	memset(mp, 0, sizeof(*mp));
 	snprintf(mp->name, sizeof(mp->name), "%s", name);
 	mp->phys_addr = mz->phys_addr;
-	mp->ring = r;
+	mp->mz = mz;
 	mp->size = n;
 	mp->flags = flags;
 	mp->elt_size = objsz.elt_size;
@@ -567,7 +657,23 @@ rte_mempool_xmem_create(const char *name, unsigned n, unsigned elt_size,
 	mp->cache_size = cache_size;
 	mp->cache_flushthresh = (uint32_t)
 		(cache_size * CACHE_FLUSHTHRESH_MULTIPLIER);
+	mp->cache_min_size = cache_size;
+	mp->cache_max_size = cache_size;
 	mp->private_data_size = private_data_size;
+	mp->socket_id = mz->socket_id;
+	mp->ops_index = ops_index;
+
+#if RTE_MEMPOOL_CACHE_MAX_SIZE > 0
+	{
+		unsigned lcore_id;
+
+		for (lcore_id = 0; lcore_id < RTE_MAX_LCORE; lcore_id++) {
+			mp->local_cache[lcore_id].size = mp->cache_size;
+			mp->local_cache[lcore_id].flushthresh =
+				mp->cache_flushthresh;
+		}
+	}
+#endif
 
 	/* calculate address of the first element for continuous mempool. */
 	obj = (char *)mp + MEMPOOL_HEADER_SIZE(mp, pg_num) +
@@ -587,11 +693,29 @@ rte_mempool_xmem_create(const char *name, unsigned n, unsigned elt_size,
 	/* mempool elements in a separate chunk of memory. */
 	} else {
 		mp->elt_va_start = (uintptr_t)vaddr;
-		memcpy(mp->elt_pa, paddr, sizeof (mp->elt_pa[0]) * pg_num);
+		if (paddr != NULL)
+			memcpy(mp->elt_pa, paddr,
+				sizeof (mp->elt_pa[0]) * pg_num);
+		else
+			mempool_extmem_fill(mp->elt_pa, vaddr, pg_num,
+				pg_shift);
 	}
 
 	mp->elt_va_end = mp->elt_va_start;
 
+	/*
+	 * Let the handler allocate its private data. Handler functions
+	 * will return appropriate errors if we are running as a secondary
+	 * process etc., so no checks made in this function for that
+	 * condition.
+	 */
+	if (rte_mempool_ops_get(ops_index)->alloc(mp) < 0) {
+		rte_memzone_free(mz);
+		rte_free(te);
+		mp = NULL;
+		goto exit;
+	}
+
 	/* call the initializer */
 	if (mp_init)
 		mp_init(mp, mp_init_arg);
@@ -610,13 +734,48 @@ exit:
 	return mp;
 }
 
+/* free a mempool, its handler data and its memzone */
+void
+rte_mempool_free(struct rte_mempool *mp)
+{
+	struct rte_mempool_list *mempool_list = NULL;
+	struct rte_tailq_entry *te;
+
+	if (mp == NULL)
+		return;
+
+	mempool_list = RTE_TAILQ_CAST(rte_mempool_tailq.head, rte_mempool_list);
+
+	rte_rwlock_write_lock(RTE_EAL_TAILQ_RWLOCK);
+
+	/* find out tailq entry */
+	TAILQ_FOREACH(te, mempool_list, next) {
+		if (te->data == (void *)mp)
+			break;
+	}
+
+	if (te == NULL) {
+		rte_rwlock_write_unlock(RTE_EAL_TAILQ_RWLOCK);
+		return;
+	}
+
+	TAILQ_REMOVE(mempool_list, te, next);
+
+	rte_rwlock_write_unlock(RTE_EAL_TAILQ_RWLOCK);
+
+	rte_free(te);
+
+	rte_mempool_ops_get(mp->ops_index)->free(mp);
+	rte_memzone_free(mp->mz);
+}
+
 /* Return the number of entries in the mempool */
 unsigned
 rte_mempool_count(const struct rte_mempool *mp)
 {
 	unsigned count;
 
-	count = rte_ring_count(mp->ring);
+	count = rte_mempool_ops_get(mp->ops_index)->get_count(mp);
 
 #if RTE_MEMPOOL_CACHE_MAX_SIZE > 0
 	{
@@ -649,9 +808,20 @@ rte_mempool_dump_cache(FILE *f, const struct rte_mempool *mp)
 
 	fprintf(f, "  cache infos:\n");
 	fprintf(f, "    cache_size=%"PRIu32"\n", mp->cache_size);
+	fprintf(f, "    cache_min_size=%"PRIu32"\n", mp->cache_min_size);
+	fprintf(f, "    cache_max_size=%"PRIu32"\n", mp->cache_max_size);
 	for (lcore_id = 0; lcore_id < RTE_MAX_LCORE; lcore_id++) {
-		cache_count = mp->local_cache[lcore_id].len;
-		fprintf(f, "    cache_count[%u]=%u\n", lcore_id, cache_count);
+		const struct rte_mempool_cache *cache =
+			&mp->local_cache[lcore_id];
+
+		cache_count = cache->len;
+		fprintf(f, "    cache_count[%u]=%u", lcore_id, cache_count);
+		/* only show the caches that accessed the common pool */
+		if (cache->refills != 0 || cache->flushes != 0)
+			fprintf(f, " size=%"PRIu32" refills=%"PRIu64
+				" flushes=%"PRIu64, cache->size,
+				cache->refills, cache->flushes);
+		fprintf(f, "\n");
 		count += cache_count;
 	}
 	fprintf(f, "    total_cache_count=%u\n", count);
@@ -733,7 +903,8 @@ mempool_audit_cache(const struct rte_mempool *mp)
 	/* check cache size consistency */
 	unsigned lcore_id;
 	for (lcore_id = 0; lcore_id < RTE_MAX_LCORE; lcore_id++) {
-		if (mp->local_cache[lcore_id].len > mp->cache_flushthresh) {
+		if (mp->local_cache[lcore_id].len >
+				mp->local_cache[lcore_id].flushthresh) {
 			RTE_LOG(CRIT, MEMPOOL, "badness on cache[%u]\n",
 				lcore_id);
 			rte_panic("MEMPOOL: invalid cache len\n");
@@ -745,6 +916,45 @@ mempool_audit_cache(const struct rte_mempool *mp)
 #endif
 
 
+/* set the bounds of the per-lcore cache sizes */
+int
+rte_mempool_cache_set_bounds(struct rte_mempool *mp,
+		unsigned min_size, unsigned max_size)
+{
+	if (mp->cache_size == 0 || min_size == 0 || min_size > max_size ||
+			max_size > RTE_MEMPOOL_CACHE_MAX_SIZE)
+		return -EINVAL;
+
+	mp->cache_min_size = min_size;
+	mp->cache_max_size = max_size;
+	return 0;
+}
+
+/* get the statistics of the cache of an lcore */
+int
+rte_mempool_cache_stats_get(const struct rte_mempool *mp,
+		unsigned lcore_id, struct rte_mempool_cache_stats *stats)
+{
+#if RTE_MEMPOOL_CACHE_MAX_SIZE > 0
+	const struct rte_mempool_cache *cache;
+
+	if (mp->cache_size == 0 || lcore_id >= RTE_MAX_LCORE)
+		return -EINVAL;
+
+	cache = &mp->local_cache[lcore_id];
+	stats->size = cache->size;
+	stats->len = cache->len;
+	stats->refills = cache->refills;
+	stats->flushes = cache->flushes;
+	return 0;
+#else
+	RTE_SET_USED(mp);
+	RTE_SET_USED(lcore_id);
+	RTE_SET_USED(stats);
+	return -EINVAL;
+#endif
+}
+
 /* check the consistency of mempool (size, cookies, ...) */
 void
 rte_mempool_audit(const struct rte_mempool *mp)
@@ -772,7 +982,8 @@ rte_mempool_dump(FILE *f, const struct rte_mempool *mp)
 
 	fprintf(f, "mempool <%s>@%p\n", mp->name, mp);
 	fprintf(f, "  flags=%x\n", mp->flags);
-	fprintf(f, "  ring=<%s>@%p\n", mp->ring->name, mp->ring);
+	fprintf(f, "  ops=<%s>\n", rte_mempool_ops_get(mp->ops_index)->name);
+	fprintf(f, "  pool_data=%p\n", mp->pool_data);
 	fprintf(f, "  phys_addr=0x%" PRIx64 "\n", mp->phys_addr);
 	fprintf(f, "  size=%"PRIu32"\n", mp->size);
 	fprintf(f, "  header_size=%"PRIu32"\n", mp->header_size);
@@ -795,7 +1006,7 @@ rte_mempool_dump(FILE *f, const struct rte_mempool *mp)
 			mp->size);
 
 	cache_count = rte_mempool_dump_cache(f, mp);
-	common_count = rte_ring_count(mp->ring);
+	common_count = rte_mempool_ops_get(mp->ops_index)->get_count(mp);
 	if ((cache_count + common_count) > mp->size)
 		common_count = mp->size - cache_count;
 	fprintf(f, "  common_pool_count=%u\n", common_count);
@@ -39,7 +39,8 @@
  * RTE Mempool.
  *
  * A memory pool is an allocator of fixed-size object. It is
- * identified by its name, and uses a ring to store free objects. It
+ * identified by its name, and uses a handler to store free objects
+ * (a ring by default, see rte_mempool_create_with_ops()). It
  * provides some other optional services, like a per-core object
  * cache, and an alignment helper to ensure that objects are padded
  * to spread them equally on all RAM channels, ranks, and so on.
@@ -71,6 +72,7 @@
 #include <rte_lcore.h>
 #include <rte_memory.h>
 #include <rte_branch_prediction.h>
+#include <rte_spinlock.h>
 #include <rte_ring.h>
 
 #ifdef __cplusplus
@@ -101,6 +103,12 @@ struct rte_mempool_debug_stats {
  */
 struct rte_mempool_cache {
 	unsigned len; /**< Cache len */
+	uint32_t size;        /**< Current size of the cache. */
+	uint32_t flushthresh; /**< Current flush threshold. */
+	uint32_t accesses;    /**< Gets and puts since the last resize check. */
+	uint32_t events;      /**< Common pool accesses since the last check. */
+	uint64_t refills;     /**< Number of refills from the common pool. */
+	uint64_t flushes;     /**< Number of flushes to the common pool. */
 	/*
 	 * Cache is allocated to this size to allow it to overflow in certain
 	 * cases to avoid needless emptying of cache.
@@ -109,6 +117,35 @@ struct rte_mempool_cache {
 } __rte_cache_aligned;
 #endif /* RTE_MEMPOOL_CACHE_MAX_SIZE > 0 */
 
+/**
+ * The statistics of a per-core object cache, see
+ * rte_mempool_cache_stats_get().
+ */
+struct rte_mempool_cache_stats {
+	uint32_t size;    /**< Current size of the cache. */
+	uint32_t len;     /**< Number of objects in the cache. */
+	uint64_t refills; /**< Number of refills from the common pool. */
+	uint64_t flushes; /**< Number of flushes to the common pool. */
+};
+
+/**
+ * Number of accesses to the common pool (refills, flushes, or gets
+ * bypassing the cache) after which a per-lcore cache checks its size.
+ */
+#define RTE_MEMPOOL_CACHE_ADAPT_EVENTS 16
+
+/**
+ * A per-lcore cache doubles its size when it is accessed less than this
+ * number of times per access to the common pool.
+ */
+#define RTE_MEMPOOL_CACHE_ADAPT_GROW 8
+
+/**
+ * A per-lcore cache halves its size when it is accessed more than this
+ * number of times per access to the common pool.
+ */
+#define RTE_MEMPOOL_CACHE_ADAPT_SHRINK 128
+
 struct rte_mempool_objsz {
 	uint32_t elt_size;     /**< Size of an element. */
 	uint32_t header_size;  /**< Size of header (before elt). */
@@ -144,8 +181,12 @@ struct rte_mempool_objsz {
  */
 struct rte_mempool {
 	char name[RTE_MEMPOOL_NAMESIZE]; /**< Name of mempool. */
-	struct rte_ring *ring;           /**< Ring to store objects. */
+	union {
+		void *pool_data;         /**< Handler private data. */
+		struct rte_ring *ring;   /**< Ring of the ring handlers. */
+	};
 	phys_addr_t phys_addr;           /**< Phys. addr. of mempool struct. */
+	const struct rte_memzone *mz;    /**< Memzone holding the mempool. */
 	int flags;                       /**< Flags of the mempool. */
 	uint32_t size;                   /**< Size of the mempool. */
 	uint32_t cache_size;             /**< Size of per-lcore local cache. */
@@ -157,6 +198,11 @@ struct rte_mempool {
 	uint32_t trailer_size;           /**< Size of trailer (after elt). */
 
 	unsigned private_data_size;      /**< Size of private data. */
+	int socket_id;                   /**< Socket of the pool memory. */
+	int32_t ops_index;
+	/**< Index of the handler in rte_mempool_ops_table. */
+	uint32_t cache_min_size;         /**< Min size of per-lcore caches. */
+	uint32_t cache_max_size;         /**< Max size of per-lcore caches. */
 
 #if RTE_MEMPOOL_CACHE_MAX_SIZE > 0
 	/** Per-lcore local cache. */
@@ -188,6 +234,158 @@ struct rte_mempool {
 #define MEMPOOL_F_SP_PUT         0x0004 /**< Default put is "single-producer".*/
 #define MEMPOOL_F_SC_GET         0x0008 /**< Default get is "single-consumer".*/
 
+#define RTE_MEMPOOL_OPS_NAMESIZE 32 /**< Max length of a handler name. */
+
+/**
+ * Prototype of the function allocating the private data of a handler,
+ * stored in mp->pool_data. It is called once the mempool structure is
+ * initialized, before the objects are added to the pool.
+ */
+typedef int (*rte_mempool_alloc_t)(struct rte_mempool *mp);
+
+/** Prototype of the function freeing the private data of a handler. */
+typedef void (*rte_mempool_free_t)(struct rte_mempool *mp);
+
+/**
+ * Prototype of the function adding n objects to the common pool. It
+ * must either add all the objects and return 0, or return a negative
+ * value.
+ */
+typedef int (*rte_mempool_enqueue_t)(struct rte_mempool *mp,
+		void * const *obj_table, unsigned n);
+
+/**
+ * Prototype of the function removing n objects from the common pool.
+ * It must either remove all the objects and return 0, or return a
+ * negative value.
+ */
+typedef int (*rte_mempool_dequeue_t)(struct rte_mempool *mp,
+		void **obj_table, unsigned n);
+
+/** Prototype of the function returning the number of objects in the pool. */
+typedef unsigned (*rte_mempool_get_count_t)(const struct rte_mempool *mp);
+
+/**
+ * Operations of a mempool handler, which stores the free objects of
+ * the common pool (i.e. the objects that are not in a per-lcore cache).
+ */
+struct rte_mempool_ops {
+	char name[RTE_MEMPOOL_OPS_NAMESIZE]; /**< Name of the handler. */
+	rte_mempool_alloc_t alloc;           /**< Allocate private data. */
+	rte_mempool_free_t free;             /**< Free private data. */
+	rte_mempool_enqueue_t enqueue;       /**< Put objects in the pool. */
+	rte_mempool_dequeue_t dequeue;       /**< Get objects from the pool. */
+	rte_mempool_get_count_t get_count;   /**< Number of objects. */
+} __rte_cache_aligned;
+
+#define RTE_MEMPOOL_MAX_OPS_IDX 16 /**< Max number of registered handlers. */
+
+/**
+ * Table of the registered handlers.
+ *
+ * A mempool only stores the index of its handler in this table, so
+ * that it can be shared with secondary processes: they must register
+ * the same handlers in the same order as the primary process, which
+ * is the case when they run the same binary.
+ */
+struct rte_mempool_ops_table {
+	rte_spinlock_t sl;  /**< Protects the registration. */
+	uint32_t num_ops;   /**< Number of registered handlers. */
+	/** Registered handlers. */
+	struct rte_mempool_ops ops[RTE_MEMPOOL_MAX_OPS_IDX];
+} __rte_cache_aligned;
+
+/** Table of the registered handlers. */
+extern struct rte_mempool_ops_table rte_mempool_ops_table;
+
+/**
+ * @internal Get the handler of a mempool.
+ *
+ * @param ops_index
+ *   The index of the handler in rte_mempool_ops_table.
+ * @return
+ *   A pointer to the handler operations.
+ */
+static inline struct rte_mempool_ops *
+rte_mempool_ops_get(int ops_index)
+{
+	return &rte_mempool_ops_table.ops[ops_index];
+}
+
+/**
+ * @internal Put several objects in the common pool of a mempool.
+ *
+ * @param mp
+ *   A pointer to the mempool structure.
+ * @param obj_table
+ *   A pointer to a table of void * pointers (objects).
+ * @param n
+ *   The number of objects to put.
+ * @return
+ *   - 0: Success.
+ *   - <0: Error; code of the handler enqueue function.
+ */
+static inline int
+rte_mempool_ops_enqueue_bulk(struct rte_mempool *mp, void * const *obj_table,
+		unsigned n)
+{
+	return rte_mempool_ops_get(mp->ops_index)->enqueue(mp, obj_table, n);
+}
+
+/**
+ * @internal Get several objects from the common pool of a mempool.
+ *
+ * @param mp
+ *   A pointer to the mempool structure.
+ * @param obj_table
+ *   A pointer to a table of void * pointers (objects).
+ * @param n
+ *   The number of objects to get.
+ * @return
+ *   - 0: Success.
+ *   - <0: Error; code of the handler dequeue function.
+ */
+static inline int
+rte_mempool_ops_dequeue_bulk(struct rte_mempool *mp, void **obj_table,
+		unsigned n)
+{
+	return rte_mempool_ops_get(mp->ops_index)->dequeue(mp, obj_table, n);
+}
+
+/**
+ * Register a mempool handler.
+ *
+ * @param ops
+ *   The handler operations, which are copied in rte_mempool_ops_table.
+ * @return
+ *   - >=0: The index of the handler in rte_mempool_ops_table.
+ *   - -EINVAL: Missing operation or name.
+ *   - -EEXIST: A handler with the same name is already registered.
+ *   - -ENOSPC: The maximum number of handlers is reached.
+ */
+int rte_mempool_ops_register(const struct rte_mempool_ops *ops);
+
+/**
+ * Look up a registered mempool handler.
+ *
+ * @param name
+ *   The name of the handler.
+ * @return
+ *   The index of the handler in rte_mempool_ops_table, or -ENOENT if
+ *   no handler is registered with this name.
+ */
+int rte_mempool_ops_lookup(const char *name);
+
+/**
+ * Macro to register a mempool handler at startup, from a constructor.
+ */
+#define MEMPOOL_REGISTER_OPS(ops)\
+void mp_ops_init_ ##ops(void);\
+void __attribute__((constructor, used)) mp_ops_init_ ##ops(void)\
+{\
+	rte_mempool_ops_register(&ops);\
+}
+
 /**
  * @internal When debug is enabled, store some statistics.
  * @param mp
@@ -515,10 +713,12 @@ typedef void (rte_mempool_ctor_t)(struct rte_mempool *, void *);
  *     MEMPOOL_F_NO_SPREAD.
  *   - MEMPOOL_F_SP_PUT: If this flag is set, the default behavior
  *     when using rte_mempool_put() or rte_mempool_put_bulk() is
- *     "single-producer". Otherwise, it is "multi-producers".
+ *     "single-producer". Otherwise, it is "multi-producers". It also
+ *     selects a single-producer ring handler for the common pool.
  *   - MEMPOOL_F_SC_GET: If this flag is set, the default behavior
  *     when using rte_mempool_get() or rte_mempool_get_bulk() is
- *     "single-consumer". Otherwise, it is "multi-consumers".
+ *     "single-consumer". Otherwise, it is "multi-consumers". It also
+ *     selects a single-consumer ring handler for the common pool.
  * @return
  *   The pointer to the new allocated mempool, on success. NULL on error
  *   with rte_errno set appropriately. Possible rte_errno values include:
@@ -536,6 +736,75 @@ rte_mempool_create(const char *name, unsigned n, unsigned elt_size,
 		   rte_mempool_obj_ctor_t *obj_init, void *obj_init_arg,
 		   int socket_id, unsigned flags);
 
+/**
+ * Creates a new mempool named *name* in memory, using a given handler.
+ *
+ * This function is identical to rte_mempool_create(), except that the
+ * free objects of the common pool are stored by the handler *ops_name*
+ * instead of a ring. The handlers provided by the library are:
+ *
+ *   - "ring_mp_mc", "ring_sp_sc", "ring_mp_sc", "ring_sp_mc": a ring,
+ *     with the given synchronization of producers and consumers. This
+ *     is the default, selected from MEMPOOL_F_SP_PUT and
+ *     MEMPOOL_F_SC_GET.
+ *   - "stack": a LIFO protected by a spinlock. The last freed objects,
+ *     which are likely still in the CPU caches, are returned first.
+ *     It suits pools used by one lcore at a time.
+ *   - "bucket": objects are grouped in buckets of objects that are
+ *     consecutive in memory, and allocations are served from one
+ *     bucket at a time, so that the returned objects are close to
+ *     each other. The bucket metadata is allocated on the socket of
+ *     the pool.
+ *
+ * The synchronization of the common pool is the one of its handler,
+ * whatever the put or get function used. When a handler is given, the
+ * MEMPOOL_F_SP_PUT and MEMPOOL_F_SC_GET flags only disable the
+ * per-lcore cache of the default put and get functions.
+ *
+ * @param name
+ *   The name of the mempool.
+ * @param n
+ *   The number of elements in the mempool.
+ * @param elt_size
+ *   The size of each element.
+ * @param cache_size
+ *   The size of the per-lcore object cache, see rte_mempool_create().
+ * @param private_data_size
+ *   The size of the private data appended after the mempool
+ *   structure.
+ * @param mp_init
+ *   A function pointer that is called for initialization of the pool,
+ *   before object initialization. This parameter can be NULL.
+ * @param mp_init_arg
+ *   An opaque pointer to data that can be used in the mempool
+ *   constructor function.
+ * @param obj_init
+ *   A function pointer that is called for each object at
+ *   initialization of the pool. This parameter can be NULL.
+ * @param obj_init_arg
+ *   An opaque pointer to data that can be used as an argument for
+ *   each call to the object constructor function.
+ * @param socket_id
+ *   The socket identifier in the case of NUMA, or *SOCKET_ID_ANY*.
+ * @param flags
+ *   The flags of the mempool, see rte_mempool_create().
+ * @param ops_name
+ *   The name of a registered handler, or NULL to select a ring
+ *   handler from the flags.
+ * @return
+ *   The pointer to the new allocated mempool, on success. NULL on error
+ *   with rte_errno set appropriately. Possible rte_errno values are the
+ *   ones of rte_mempool_create(), and:
+ *    - ENOENT - no handler is registered with this name
+ *    - ENOTSUP - a handler is given with CONFIG_RTE_LIBRTE_XEN_DOM0
+ */
+struct rte_mempool *
+rte_mempool_create_with_ops(const char *name, unsigned n, unsigned elt_size,
+		unsigned cache_size, unsigned private_data_size,
+		rte_mempool_ctor_t *mp_init, void *mp_init_arg,
+		rte_mempool_obj_ctor_t *obj_init, void *obj_init_arg,
+		int socket_id, unsigned flags, const char *ops_name);
+
 /**
  * Creates a new mempool named *name* in memory.
  *
@@ -605,16 +874,19 @@ rte_mempool_create(const char *name, unsigned n, unsigned elt_size,
  *     MEMPOOL_F_NO_SPREAD.
  *   - MEMPOOL_F_SP_PUT: If this flag is set, the default behavior
  *     when using rte_mempool_put() or rte_mempool_put_bulk() is
- *     "single-producer". Otherwise, it is "multi-producers".
+ *     "single-producer". Otherwise, it is "multi-producers". It also
+ *     selects a single-producer ring handler for the common pool.
  *   - MEMPOOL_F_SC_GET: If this flag is set, the default behavior
  *     when using rte_mempool_get() or rte_mempool_get_bulk() is
- *     "single-consumer". Otherwise, it is "multi-consumers".
+ *     "single-consumer". Otherwise, it is "multi-consumers". It also
+ *     selects a single-consumer ring handler for the common pool.
  * @param vaddr
  *   Virtual address of the externally allocated memory buffer.
  *   Will be used to store mempool objects.
  * @param paddr
  *   Array of phyiscall addresses of the pages that comprises given memory
- *   buffer.
+ *   buffer. It can be NULL if the buffer was registered as external memory
+ *   with rte_extmem_register(), the addresses are then taken from there.
  * @param pg_num
  *   Number of elements in the paddr array.
  * @param pg_shift
@@ -624,7 +896,8 @@ rte_mempool_create(const char *name, unsigned n, unsigned elt_size,
  *   with rte_errno set appropriately. Possible rte_errno values include:
  *    - E_RTE_NO_CONFIG - function could not get pointer to rte_config structure
  *    - E_RTE_SECONDARY - function was called from a secondary process instance
- *    - EINVAL - cache size provided is too large
+ *    - EINVAL - cache size provided is too large, or paddr is NULL and vaddr
+ *      is not registered external memory
  *    - ENOSPC - the maximum number of memzones has already been allocated
  *    - EEXIST - a memzone with the same name already exists
  *    - ENOMEM - no appropriate memory area found in which to create memzone
@@ -705,10 +978,12 @@ rte_mempool_xmem_create(const char *name, unsigned n, unsigned elt_size,
  *     MEMPOOL_F_NO_SPREAD.
  *   - MEMPOOL_F_SP_PUT: If this flag is set, the default behavior
  *     when using rte_mempool_put() or rte_mempool_put_bulk() is
- *     "single-producer". Otherwise, it is "multi-producers".
+ *     "single-producer". Otherwise, it is "multi-producers". It also
+ *     selects a single-producer ring handler for the common pool.
  *   - MEMPOOL_F_SC_GET: If this flag is set, the default behavior
  *     when using rte_mempool_get() or rte_mempool_get_bulk() is
- *     "single-consumer". Otherwise, it is "multi-consumers".
+ *     "single-consumer". Otherwise, it is "multi-consumers". It also
+ *     selects a single-consumer ring handler for the common pool.
  * @return
  *   The pointer to the new allocated mempool, on success. NULL on error
  *   with rte_errno set appropriately. Possible rte_errno values include:
@@ -727,6 +1002,20 @@ rte_dom0_mempool_create(const char *name, unsigned n, unsigned elt_size,
 		int socket_id, unsigned flags);
 #endif
 
+/**
+ * Free a mempool.
+ *
+ * The mempool is removed from the list of mempools, the private data of
+ * its handler is freed and the memzone holding the mempool is freed, so
+ * that its memory can be reserved again. The objects must not be used
+ * anymore by any lcore or process. The memory given to
+ * rte_mempool_xmem_create() is not freed.
+ *
+ * @param mp
+ *   A pointer to the mempool structure. If NULL, the function does nothing.
+ */
+void rte_mempool_free(struct rte_mempool *mp);
+
 /**
  * Dump the status of the mempool to the console.
  *
@@ -737,6 +1026,102 @@ rte_dom0_mempool_create(const char *name, unsigned n, unsigned elt_size,
  */
 void rte_mempool_dump(FILE *f, const struct rte_mempool *mp);
 
+/**
+ * Set the bounds of the per-lcore cache sizes of a mempool.
+ *
+ * The cache of each lcore starts with the cache_size given at creation
+ * time, and is resized by its lcore within [min_size, max_size]
+ * depending on its own refills and flushes: a cache that often
+ * accesses the common pool, like on a core receiving or sending most
+ * of the packets, grows, and a cache that rarely does shrinks. By
+ * default, both bounds are equal to the cache_size of the mempool, so
+ * that the caches are not resized.
+ *
+ * The caches are moved into the new bounds at their next access to
+ * the common pool.
+ *
+ * @param mp
+ *   A pointer to the mempool structure.
+ * @param min_size
+ *   The minimum size of a per-lcore cache, must not be 0.
+ * @param max_size
+ *   The maximum size of a per-lcore cache, must be lower or equal to
+ *   CONFIG_RTE_MEMPOOL_CACHE_MAX_SIZE.
+ * @return
+ *   - 0: Success.
+ *   - -EINVAL: Invalid bounds, or the mempool has no cache.
+ */
+int rte_mempool_cache_set_bounds(struct rte_mempool *mp,
+		unsigned min_size, unsigned max_size);
+
+/**
+ * Get the statistics of the cache of an lcore.
+ *
+ * The statistics are updated by the lcore without synchronization, so
+ * they may be slightly outdated.
+ *
+ * @param mp
+ *   A pointer to the mempool structure.
+ * @param lcore_id
+ *   The lcore of the cache.
+ * @param stats
+ *   A pointer to a structure filled with the statistics.
+ * @return
+ *   - 0: Success.
+ *   - -EINVAL: Invalid lcore, or the mempool has no cache.
+ */
+int rte_mempool_cache_stats_get(const struct rte_mempool *mp,
+		unsigned lcore_id, struct rte_mempool_cache_stats *stats);
+
+#if RTE_MEMPOOL_CACHE_MAX_SIZE > 0
+/**
+ * @internal Account an access to the common pool from a per-lcore
+ * cache and, every RTE_MEMPOOL_CACHE_ADAPT_EVENTS accesses, resize the
+ * cache within the bounds of the mempool, depending on the number of
+ * gets and puts it served per access to the common pool. This is only
+ * called on the slow path of the cache. When the cache is shrunk, the
+ * objects above its new size are flushed to the common pool.
+ * @param mp
+ *   A pointer to the mempool structure.
+ * @param cache
+ *   A pointer to the per-lcore cache of the running lcore.
+ */
+static inline void
+__mempool_cache_adapt(struct rte_mempool *mp,
+		      struct rte_mempool_cache *cache)
+{
+	uint32_t size = cache->size;
+	uint32_t rate;
+
+	if (++cache->events >= RTE_MEMPOOL_CACHE_ADAPT_EVENTS) {
+		rate = cache->accesses / cache->events;
+		if (rate < RTE_MEMPOOL_CACHE_ADAPT_GROW)
+			size *= 2;
+		else if (rate > RTE_MEMPOOL_CACHE_ADAPT_SHRINK)
+			size /= 2;
+		cache->accesses = 0;
+		cache->events = 0;
+	}
+
+	/* the bounds may also have been changed */
+	if (size > mp->cache_max_size)
+		size = mp->cache_max_size;
+	if (size < mp->cache_min_size)
+		size = mp->cache_min_size;
+
+	if (size != cache->size) {
+		if (cache->len > size) {
+			rte_mempool_ops_enqueue_bulk(mp, &cache->objs[size],
+				cache->len - size);
+			cache->len = size;
+			cache->flushes++;
+		}
+		cache->size = size;
+		cache->flushthresh = size + size / 2;
+	}
+}
+#endif /* RTE_MEMPOOL_CACHE_MAX_SIZE > 0 */
+
 /**
  * @internal Put several objects back in the mempool; used internally.
  * @param mp
@@ -747,7 +1132,9 @@ void rte_mempool_dump(FILE *f, const struct rte_mempool *mp);
  *   The number of objects to store back in the mempool, must be strictly
  *   positive.
  * @param is_mp
- *   Mono-producer (0) or multi-producers (1).
+ *   Mono-producer (0) or multi-producers (1). The per-lcore cache is
+ *   only used by multi-producers; the synchronization of the common
+ *   pool is the one of the mempool handler.
  */
 static inline void __attribute__((always_inline))
 __mempool_put_bulk(struct rte_mempool *mp, void * const *obj_table,
@@ -759,7 +1146,6 @@ __mempool_put_bulk(struct rte_mempool *mp, void * const *obj_table,
 	void **cache_objs;
 	unsigned lcore_id = rte_lcore_id();
 	uint32_t cache_size = mp->cache_size;
-	uint32_t flushthresh = mp->cache_flushthresh;
 #endif /* RTE_MEMPOOL_CACHE_MAX_SIZE > 0 */
 
 	/* increment stat now, adding in mempool always success */
@@ -790,11 +1176,17 @@ __mempool_put_bulk(struct rte_mempool *mp, void * const *obj_table,
 		cache_objs[index] = *obj_table;
 
 	cache->len += n;
-
-	if (cache->len >= flushthresh) {
-		rte_ring_mp_enqueue_bulk(mp->ring, &cache->objs[cache_size],
-				cache->len - cache_size);
-		cache->len = cache_size;
+	cache->accesses++;
+
+	if (cache->len >= cache->flushthresh) {
+		__mempool_cache_adapt(mp, cache);
+		if (cache->len > cache->size) {
+			rte_mempool_ops_enqueue_bulk(mp,
+				&cache->objs[cache->size],
+				cache->len - cache->size);
+			cache->len = cache->size;
+			cache->flushes++;
+		}
 	}
 
 	return;
@@ -802,21 +1194,12 @@ __mempool_put_bulk(struct rte_mempool *mp, void * const *obj_table,
 ring_enqueue:
 #endif /* RTE_MEMPOOL_CACHE_MAX_SIZE > 0 */
 
-	/* push remaining objects in ring */
+	/* push remaining objects in the common pool */
 #ifdef RTE_LIBRTE_MEMPOOL_DEBUG
-	if (is_mp) {
-		if (rte_ring_mp_enqueue_bulk(mp->ring, obj_table, n) < 0)
-			rte_panic("cannot put objects in mempool\n");
-	}
-	else {
-		if (rte_ring_sp_enqueue_bulk(mp->ring, obj_table, n) < 0)
-			rte_panic("cannot put objects in mempool\n");
-	}
+	if (rte_mempool_ops_enqueue_bulk(mp, obj_table, n) < 0)
+		rte_panic("cannot put objects in mempool\n");
 #else
-	if (is_mp)
-		rte_ring_mp_enqueue_bulk(mp->ring, obj_table, n);
-	else
-		rte_ring_sp_enqueue_bulk(mp->ring, obj_table, n);
+	rte_mempool_ops_enqueue_bulk(mp, obj_table, n);
 #endif
 }
 
@@ -934,10 +1317,12 @@ rte_mempool_put(struct rte_mempool *mp, void *obj)
  * @param n
  *   The number of objects to get, must be strictly positive.
  * @param is_mc
- *   Mono-consumer (0) or multi-consumers (1).
+ *   Mono-consumer (0) or multi-consumers (1). The per-lcore cache is
+ *   only used by multi-consumers; the synchronization of the common
+ *   pool is the one of the mempool handler.
  * @return
  *   - >=0: Success; number of objects supplied.
- *   - <0: Error; code of ring dequeue function.
+ *   - <0: Error; code of the handler dequeue function.
  */
 static inline int __attribute__((always_inline))
 __mempool_get_bulk(struct rte_mempool *mp, void **obj_table,
@@ -953,19 +1338,31 @@ __mempool_get_bulk(struct rte_mempool *mp, void **obj_table,
 
 	/* cache is not enabled or single consumer */
 	if (unlikely(cache_size == 0 || is_mc == 0 ||
-		     n >= cache_size || lcore_id >= RTE_MAX_LCORE))
+		     lcore_id >= RTE_MAX_LCORE))
 		goto ring_dequeue;
 
 	cache = &mp->local_cache[lcore_id];
 	cache_objs = cache->objs;
 
+	/* request bigger than the cache */
+	if (unlikely(n >= cache->size)) {
+		__mempool_cache_adapt(mp, cache);
+		goto ring_dequeue;
+	}
+
+	cache->accesses++;
+
 	/* Can this be satisfied from the cache? */
 	if (cache->len < n) {
+		uint32_t req;
+
+		__mempool_cache_adapt(mp, cache);
+
 		/* No. Backfill the cache first, and then fill from it */
-		uint32_t req = n + (cache_size - cache->len);
+		req = n + (cache->size - cache->len);
 
 		/* How many do we require i.e. number to fill the cache + the request */
-		ret = rte_ring_mc_dequeue_bulk(mp->ring, &cache->objs[cache->len], req);
+		ret = rte_mempool_ops_dequeue_bulk(mp, &cache->objs[cache->len], req);
 		if (unlikely(ret < 0)) {
 			/*
 			 * In the offchance that we are buffer constrained,
@@ -977,6 +1374,7 @@ __mempool_get_bulk(struct rte_mempool *mp, void **obj_table,
 		}
 
 		cache->len += req;
+		cache->refills++;
 	}
 
 	/* Now fill in the response ... */
@@ -992,11 +1390,8 @@ __mempool_get_bulk(struct rte_mempool *mp, void **obj_table,
 ring_dequeue:
 #endif /* RTE_MEMPOOL_CACHE_MAX_SIZE > 0 */
 
-	/* get remaining objects from ring */
-	if (is_mc)
-		ret = rte_ring_mc_dequeue_bulk(mp->ring, obj_table, n);
-	else
-		ret = rte_ring_sc_dequeue_bulk(mp->ring, obj_table, n);
+	/* get remaining objects from the common pool */
+	ret = rte_mempool_ops_dequeue_bulk(mp, obj_table, n);
 
 	if (ret < 0)
 		__MEMPOOL_STAT_ADD(mp, get_fail, n);
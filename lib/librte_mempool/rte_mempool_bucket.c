@@ -0,0 +1,215 @@
+/*-
+ *   BSD LICENSE
+ *
+ *   Copyright(c) 2015 Intel Corporation. All rights reserved.
+ *   All rights reserved.
+ *
+ *   Redistribution and use in source and binary forms, with or without
+ *   modification, are permitted provided that the following conditions
+ *   are met:
+ *
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in
+ *       the documentation and/or other materials provided with the
+ *       distribution.
+ *     * Neither the name of Intel Corporation nor the names of its
+ *       contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ *   THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *   "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *   LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ *   A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ *   OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ *   SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ *   LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ *   DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ *   THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ *   (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ *   OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include <errno.h>
+
+#include <rte_common.h>
+#include <rte_errno.h>
+#include <rte_malloc.h>
+#include <rte_spinlock.h>
+
+#include "rte_mempool.h"
+
+/*
+ * Bucket handler: the objects of the pool are grouped in buckets of
+ * objects that start in the same aligned window of BUCKET_MEM_SIZE
+ * bytes of the pool memory, and each bucket keeps its
+ * own list of free objects. The buckets holding free objects are
+ * stacked, and objects are always taken from the bucket at the top of
+ * the stack, so that a burst of allocations returns objects which are
+ * close to each other (sharing TLB entries and DRAM pages), and that
+ * the objects that were freed last are reused first.
+ *
+ * The bucket of an object is computed from its address, so the pool
+ * objects must be in one virtual area, which is always the case for a
+ * mempool. The handler data is allocated on the socket of the pool.
+ */
+
+/* amount of memory covered by the objects of one bucket, a power of 2 */
+#define BUCKET_MEM_SHIFT 16
+#define BUCKET_MEM_SIZE (1UL << BUCKET_MEM_SHIFT)
+
+struct rte_mempool_bucket {
+	rte_spinlock_t sl;
+	uintptr_t va_start;       /**< Address of the first object. */
+	uint32_t obj_per_bucket;  /**< Max number of objects per bucket. */
+	uint32_t nb_buckets;      /**< Number of buckets. */
+	uint32_t count;           /**< Number of free objects. */
+	uint32_t nb_avail;        /**< Number of buckets in avail[]. */
+	uint32_t *avail;          /**< Stack of buckets with free objects. */
+	uint32_t *len;            /**< Number of free objects per bucket. */
+	void **objs;              /**< Free objects, obj_per_bucket per bucket. */
+};
+
+static inline uint32_t
+bucket_index(const struct rte_mempool_bucket *bd, const void *obj)
+{
+	return ((uintptr_t)obj - bd->va_start) >> BUCKET_MEM_SHIFT;
+}
+
+static int
+bucket_alloc(struct rte_mempool *mp)
+{
+	struct rte_mempool_bucket *bd;
+	uint32_t total_size, obj_per_bucket, nb_buckets;
+	size_t size;
+	uint64_t span;
+	char *p;
+
+	total_size = mp->header_size + mp->elt_size + mp->trailer_size;
+	obj_per_bucket = BUCKET_MEM_SIZE / total_size + 1;
+
+	/*
+	 * The objects are laid out every total_size bytes from the start
+	 * of the pool, except that an object never crosses the boundary
+	 * between two physically discontiguous pages: this can waste less
+	 * than one object per page.
+	 */
+	span = (uint64_t)(mp->size + mp->pg_num) * total_size;
+	nb_buckets = (span >> BUCKET_MEM_SHIFT) + 1;
+
+	size = RTE_ALIGN_CEIL(sizeof(*bd), sizeof(void *)) +
+		(size_t)nb_buckets * obj_per_bucket * sizeof(void *) +
+		(size_t)nb_buckets * 2 * sizeof(uint32_t);
+
+	bd = rte_zmalloc_socket("mempool-bucket", size, RTE_CACHE_LINE_SIZE,
+		mp->socket_id);
+	if (bd == NULL) {
+		RTE_LOG(ERR, MEMPOOL, "Cannot allocate buckets!\n");
+		rte_errno = ENOMEM;
+		return -ENOMEM;
+	}
+
+	rte_spinlock_init(&bd->sl);
+	bd->va_start = mp->elt_va_start + mp->header_size;
+	bd->obj_per_bucket = obj_per_bucket;
+	bd->nb_buckets = nb_buckets;
+
+	p = (char *)bd + RTE_ALIGN_CEIL(sizeof(*bd), sizeof(void *));
+	bd->objs = (void **)p;
+	p += (size_t)nb_buckets * obj_per_bucket * sizeof(void *);
+	bd->avail = (uint32_t *)p;
+	p += (size_t)nb_buckets * sizeof(uint32_t);
+	bd->len = (uint32_t *)p;
+
+	mp->pool_data = bd;
+
+	return 0;
+}
+
+static void
+bucket_free(struct rte_mempool *mp)
+{
+	rte_free(mp->pool_data);
+	mp->pool_data = NULL;
+}
+
+static int
+bucket_enqueue(struct rte_mempool *mp, void * const *obj_table, unsigned n)
+{
+	struct rte_mempool_bucket *bd = mp->pool_data;
+	uint32_t b;
+	unsigned i;
+
+	rte_spinlock_lock(&bd->sl);
+
+	for (i = 0; i < n; i++) {
+		b = bucket_index(bd, obj_table[i]);
+
+		/* the bucket gets a free object, put it on top of the stack */
+		if (bd->len[b] == 0)
+			bd->avail[bd->nb_avail++] = b;
+
+		bd->objs[b * bd->obj_per_bucket + bd->len[b]++] = obj_table[i];
+	}
+	bd->count += n;
+
+	rte_spinlock_unlock(&bd->sl);
+	return 0;
+}
+
+static int
+bucket_dequeue(struct rte_mempool *mp, void **obj_table, unsigned n)
+{
+	struct rte_mempool_bucket *bd = mp->pool_data;
+	void **objs;
+	uint32_t b, len, nb;
+
+	rte_spinlock_lock(&bd->sl);
+
+	if (unlikely(n > bd->count)) {
+		rte_spinlock_unlock(&bd->sl);
+		return -ENOENT;
+	}
+	bd->count -= n;
+
+	/* take the objects from the buckets at the top of the stack */
+	while (n > 0) {
+		b = bd->avail[bd->nb_avail - 1];
+		len = bd->len[b];
+		nb = RTE_MIN(len, (uint32_t)n);
+
+		objs = &bd->objs[b * bd->obj_per_bucket + len - nb];
+		memcpy(obj_table, objs, nb * sizeof(void *));
+		obj_table += nb;
+		n -= nb;
+
+		bd->len[b] = len - nb;
+		if (len == nb)
+			bd->nb_avail--;
+	}
+
+	rte_spinlock_unlock(&bd->sl);
+	return 0;
+}
+
+static unsigned
+bucket_get_count(const struct rte_mempool *mp)
+{
+	const struct rte_mempool_bucket *bd = mp->pool_data;
+
+	return bd->count;
+}
+
+static struct rte_mempool_ops ops_bucket = {
+	.name = "bucket",
+	.alloc = bucket_alloc,
+	.free = bucket_free,
+	.enqueue = bucket_enqueue,
+	.dequeue = bucket_dequeue,
+	.get_count = bucket_get_count,
+};
+
+MEMPOOL_REGISTER_OPS(ops_bucket);
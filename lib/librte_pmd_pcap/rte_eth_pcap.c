@@ -65,6 +65,8 @@ struct pcap_rx_queue {
 	pcap_t *pcap;
 	uint8_t in_port;
 	struct rte_mempool *mb_pool;
+	int timestamp_offset;    /**< Timestamp dynamic field, or -1. */
+	uint64_t timestamp_flag; /**< RX timestamp dynamic flag. */
 	volatile unsigned long rx_pkts;
 	volatile unsigned long err_pkts;
 	const char *name;
@@ -166,6 +168,15 @@ eth_pcap_rx(void *queue,
 			mbuf->data_len = (uint16_t)header.len;
 			mbuf->pkt_len = mbuf->data_len;
 			mbuf->port = pcap_q->in_port;
+			if (pcap_q->timestamp_offset >= 0) {
+				*RTE_MBUF_DYNFIELD(mbuf,
+					pcap_q->timestamp_offset,
+					rte_mbuf_timestamp_t *) =
+					(uint64_t)header.ts.tv_sec *
+					1000000000 +
+					(uint64_t)header.ts.tv_usec * 1000;
+				mbuf->ol_flags |= pcap_q->timestamp_flag;
+			}
 			bufs[num_rx] = mbuf;
 			num_rx++;
 		} else {
@@ -462,7 +473,20 @@ eth_rx_queue_setup(struct rte_eth_dev *dev,
 {
 	struct pmd_internals *internals = dev->data->dev_private;
 	struct pcap_rx_queue *pcap_q = &internals->rx_queue[rx_queue_id];
+	int bitnum;
+
 	pcap_q->mb_pool = mb_pool;
+
+	/* give the capture time of the packets if the application asks */
+	pcap_q->timestamp_offset = rte_mbuf_dynfield_lookup(
+		RTE_MBUF_DYNFIELD_TIMESTAMP_NAME, NULL);
+	bitnum = rte_mbuf_dynflag_lookup(RTE_MBUF_DYNFLAG_RX_TIMESTAMP_NAME,
+		NULL);
+	if (pcap_q->timestamp_offset < 0 || bitnum < 0)
+		pcap_q->timestamp_offset = -1;
+	else
+		pcap_q->timestamp_flag = 1ULL << bitnum;
+
 	dev->data->rx_queues[rx_queue_id] = pcap_q;
 	pcap_q->in_port = dev->data->port_id;
 	return 0;
@@ -62,7 +62,6 @@
 #include "virtqueue.h"
 
 
-static int eth_virtio_dev_init(struct rte_eth_dev *eth_dev);
 static int  virtio_dev_configure(struct rte_eth_dev *dev);
 static int  virtio_dev_start(struct rte_eth_dev *dev);
 static void virtio_dev_stop(struct rte_eth_dev *dev);
@@ -114,19 +113,20 @@ static int
 virtio_send_command(struct virtqueue *vq, struct virtio_pmd_ctrl *ctrl,
 		int *dlen, int pkt_num)
 {
-	uint16_t head = vq->vq_desc_head_idx, i;
+	uint16_t head, i;
 	int k, sum = 0;
 	virtio_net_ctrl_ack status = ~0;
 	struct virtio_pmd_ctrl result;
 
 	ctrl->status = status;
 
-	if (!vq->hw->cvq) {
+	if (vq == NULL) {
 		PMD_INIT_LOG(ERR,
 			     "%s(): Control queue is not supported.",
 			     __func__);
 		return -1;
 	}
+	head = vq->vq_desc_head_idx;
 
 	PMD_INIT_LOG(DEBUG, "vq->vq_desc_head_idx = %d, status = %d, "
 		"vq->hw->cvq = %p vq = %p",
@@ -253,15 +253,13 @@ int virtio_dev_queue_setup(struct rte_eth_dev *dev,
 	struct virtio_hw *hw = dev->data->dev_private;
 	struct virtqueue  *vq = NULL;
 
-	/* Write the virtqueue index to the Queue Select Field */
-	VIRTIO_WRITE_REG_2(hw, VIRTIO_PCI_QUEUE_SEL, vtpci_queue_idx);
 	PMD_INIT_LOG(DEBUG, "selecting queue: %d", vtpci_queue_idx);
 
 	/*
-	 * Read the virtqueue size from the Queue Size field
+	 * Read the virtqueue size
 	 * Always power of 2 and if 0 virtqueue does not exist
 	 */
-	vq_size = VIRTIO_READ_REG_2(hw, VIRTIO_PCI_QUEUE_NUM);
+	vq_size = VTPCI_OPS(hw)->get_queue_num(hw, vtpci_queue_idx);
 	PMD_INIT_LOG(DEBUG, "vq_size: %d nb_desc:%d", vq_size, nb_desc);
 	if (nb_desc == 0)
 		nb_desc = vq_size;
@@ -324,8 +322,10 @@ int virtio_dev_queue_setup(struct rte_eth_dev *dev,
 	 * Virtio PCI device VIRTIO_PCI_QUEUE_PF register is 32bit,
 	 * and only accepts 32 bit page frame number.
 	 * Check if the allocated physical memory exceeds 16TB.
+	 * A vhost-user backend is given the address of the rings instead.
 	 */
-	if ((mz->phys_addr + vq->vq_ring_size - 1) >> (VIRTIO_PCI_QUEUE_ADDR_SHIFT + 32)) {
+	if (hw->virtio_user_dev == NULL &&
+			(mz->phys_addr + vq->vq_ring_size - 1) >> (VIRTIO_PCI_QUEUE_ADDR_SHIFT + 32)) {
 		PMD_INIT_LOG(ERR, "vring address shouldn't be above 16TB!");
 		rte_free(vq);
 		return -ENOMEM;
@@ -372,12 +372,7 @@ int virtio_dev_queue_setup(struct rte_eth_dev *dev,
 		memset(vq->virtio_net_hdr_mz->addr, 0, PAGE_SIZE);
 	}
 
-	/*
-	 * Set guest physical address of the virtqueue
-	 * in VIRTIO_PCI_QUEUE_PFN config register of device
-	 */
-	VIRTIO_WRITE_REG_4(hw, VIRTIO_PCI_QUEUE_PFN,
-			mz->phys_addr >> VIRTIO_PCI_QUEUE_ADDR_SHIFT);
+	VTPCI_OPS(hw)->setup_queue(hw, vq);
 	*pvq = vq;
 	return 0;
 }
@@ -803,7 +798,7 @@ virtio_negotiate_features(struct virtio_hw *hw)
 		hw->guest_features);
 
 	/* Read device(host) feature bits */
-	host_features = VIRTIO_READ_REG_4(hw, VIRTIO_PCI_HOST_FEATURES);
+	host_features = VTPCI_OPS(hw)->get_features(hw);
 	PMD_INIT_LOG(DEBUG, "host_features before negotiate = %x",
 		host_features);
 
@@ -1111,7 +1106,7 @@ rx_func_get(struct rte_eth_dev *eth_dev)
  * This function is based on probe() function in virtio_pci.c
  * It returns 0 on success.
  */
-static int
+int
 eth_virtio_dev_init(struct rte_eth_dev *eth_dev)
 {
 	struct virtio_hw *hw = eth_dev->data->dev_private;
@@ -1126,6 +1121,13 @@ eth_virtio_dev_init(struct rte_eth_dev *eth_dev)
 	eth_dev->tx_pkt_burst = &virtio_xmit_pkts;
 
 	if (rte_eal_process_type() == RTE_PROC_SECONDARY) {
+		/* the vhost-user socket and eventfds belong to the primary */
+		if (hw->virtio_user_dev != NULL) {
+			PMD_INIT_LOG(ERR, "virtio-user ports cannot be used "
+				"by secondary processes");
+			return -ENOTSUP;
+		}
+		VTPCI_OPS(hw) = &vtpci_legacy_ops;
 		rx_func_get(eth_dev);
 		return 0;
 	}
@@ -1139,12 +1141,17 @@ eth_virtio_dev_init(struct rte_eth_dev *eth_dev)
 		return -ENOMEM;
 	}
 
+	/* a virtio-user device already has its ops, see virtio_user_ethdev.c */
 	pci_dev = eth_dev->pci_dev;
-	if (virtio_resource_init(pci_dev) < 0)
-		return -1;
+	hw->port_id = eth_dev->data->port_id;
+	if (hw->virtio_user_dev == NULL) {
+		if (virtio_resource_init(pci_dev) < 0)
+			return -1;
 
-	hw->use_msix = virtio_has_msix(&pci_dev->addr);
-	hw->io_base = (uint32_t)(uintptr_t)pci_dev->mem_resource[0].addr;
+		hw->use_msix = virtio_has_msix(&pci_dev->addr);
+		hw->io_base = (uint32_t)(uintptr_t)pci_dev->mem_resource[0].addr;
+		VTPCI_OPS(hw) = &vtpci_legacy_ops;
+	}
 
 	/* Reset the device although not necessary at startup */
 	vtpci_reset(hw);
@@ -1346,6 +1353,10 @@ virtio_dev_start(struct rte_eth_dev *dev)
 	/* Do final configuration before rx/tx engine starts */
 	virtio_dev_rxtx_start(dev);
 	vtpci_reinit_complete(hw);
+	if (vtpci_get_status(hw) & VIRTIO_CONFIG_STATUS_FAILED) {
+		PMD_DRV_LOG(ERR, "device cannot be started");
+		return -EIO;
+	}
 
 	hw->started = 1;
 
@@ -75,6 +75,11 @@
 	VIRTIO_NET_F_MRG_RXBUF  | \
 	VIRTIO_RING_F_INDIRECT_DESC)
 
+/*
+ * Initialization of a device, once its ops are set
+ */
+int eth_virtio_dev_init(struct rte_eth_dev *eth_dev);
+
 /*
  * CQ function prototype
  */
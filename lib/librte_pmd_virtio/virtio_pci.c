@@ -34,11 +34,12 @@
 
 #include "virtio_pci.h"
 #include "virtio_logs.h"
+#include "virtqueue.h"
 
-static uint8_t vtpci_get_status(struct virtio_hw *);
+const struct virtio_pci_ops *vtpci_ops[RTE_MAX_ETHPORTS];
 
-void
-vtpci_read_dev_config(struct virtio_hw *hw, uint64_t offset,
+static void
+legacy_read_dev_config(struct virtio_hw *hw, uint64_t offset,
 		void *dst, int length)
 {
 	uint64_t off;
@@ -60,8 +61,8 @@ vtpci_read_dev_config(struct virtio_hw *hw, uint64_t offset,
 	}
 }
 
-void
-vtpci_write_dev_config(struct virtio_hw *hw, uint64_t offset,
+static void
+legacy_write_dev_config(struct virtio_hw *hw, uint64_t offset,
 		void *src, int length)
 {
 	uint64_t off;
@@ -83,6 +84,100 @@ vtpci_write_dev_config(struct virtio_hw *hw, uint64_t offset,
 	}
 }
 
+static uint8_t
+legacy_get_status(struct virtio_hw *hw)
+{
+	return VIRTIO_READ_REG_1(hw, VIRTIO_PCI_STATUS);
+}
+
+static void
+legacy_set_status(struct virtio_hw *hw, uint8_t status)
+{
+	VIRTIO_WRITE_REG_1(hw, VIRTIO_PCI_STATUS, status);
+}
+
+static uint32_t
+legacy_get_features(struct virtio_hw *hw)
+{
+	return VIRTIO_READ_REG_4(hw, VIRTIO_PCI_HOST_FEATURES);
+}
+
+static void
+legacy_set_features(struct virtio_hw *hw, uint32_t features)
+{
+	VIRTIO_WRITE_REG_4(hw, VIRTIO_PCI_GUEST_FEATURES, features);
+}
+
+static uint8_t
+legacy_get_isr(struct virtio_hw *hw)
+{
+	return VIRTIO_READ_REG_1(hw, VIRTIO_PCI_ISR);
+}
+
+static uint16_t
+legacy_set_config_irq(struct virtio_hw *hw, uint16_t vec)
+{
+	VIRTIO_WRITE_REG_2(hw, VIRTIO_MSI_CONFIG_VECTOR, vec);
+	return VIRTIO_READ_REG_2(hw, VIRTIO_MSI_CONFIG_VECTOR);
+}
+
+static uint16_t
+legacy_get_queue_num(struct virtio_hw *hw, uint16_t queue_id)
+{
+	/*
+	 * Write the virtqueue index to the Queue Select Field, and read
+	 * the virtqueue size from the Queue Size field.
+	 */
+	VIRTIO_WRITE_REG_2(hw, VIRTIO_PCI_QUEUE_SEL, queue_id);
+	return VIRTIO_READ_REG_2(hw, VIRTIO_PCI_QUEUE_NUM);
+}
+
+static void
+legacy_setup_queue(struct virtio_hw *hw, struct virtqueue *vq)
+{
+	/*
+	 * Set guest physical address of the virtqueue
+	 * in VIRTIO_PCI_QUEUE_PFN config register of device
+	 */
+	VIRTIO_WRITE_REG_2(hw, VIRTIO_PCI_QUEUE_SEL, vq->vq_queue_index);
+	VIRTIO_WRITE_REG_4(hw, VIRTIO_PCI_QUEUE_PFN,
+		vq->mz->phys_addr >> VIRTIO_PCI_QUEUE_ADDR_SHIFT);
+}
+
+static void
+legacy_notify_queue(struct virtio_hw *hw, struct virtqueue *vq)
+{
+	VIRTIO_WRITE_REG_2(hw, VIRTIO_PCI_QUEUE_NOTIFY, vq->vq_queue_index);
+}
+
+const struct virtio_pci_ops vtpci_legacy_ops = {
+	.read_dev_cfg = legacy_read_dev_config,
+	.write_dev_cfg = legacy_write_dev_config,
+	.get_status = legacy_get_status,
+	.set_status = legacy_set_status,
+	.get_features = legacy_get_features,
+	.set_features = legacy_set_features,
+	.get_isr = legacy_get_isr,
+	.set_config_irq = legacy_set_config_irq,
+	.get_queue_num = legacy_get_queue_num,
+	.setup_queue = legacy_setup_queue,
+	.notify_queue = legacy_notify_queue,
+};
+
+void
+vtpci_read_dev_config(struct virtio_hw *hw, uint64_t offset,
+		void *dst, int length)
+{
+	VTPCI_OPS(hw)->read_dev_cfg(hw, offset, dst, length);
+}
+
+void
+vtpci_write_dev_config(struct virtio_hw *hw, uint64_t offset,
+		void *src, int length)
+{
+	VTPCI_OPS(hw)->write_dev_cfg(hw, offset, src, length);
+}
+
 uint32_t
 vtpci_negotiate_features(struct virtio_hw *hw, uint32_t host_features)
 {
@@ -93,7 +188,7 @@ vtpci_negotiate_features(struct virtio_hw *hw, uint32_t host_features)
 	 */
 	features = host_features & hw->guest_features;
 
-	VIRTIO_WRITE_REG_4(hw, VIRTIO_PCI_GUEST_FEATURES, features);
+	VTPCI_OPS(hw)->set_features(hw, features);
 	return features;
 }
 
@@ -115,10 +210,10 @@ vtpci_reinit_complete(struct virtio_hw *hw)
 	vtpci_set_status(hw, VIRTIO_CONFIG_STATUS_DRIVER_OK);
 }
 
-static uint8_t
+uint8_t
 vtpci_get_status(struct virtio_hw *hw)
 {
-	return VIRTIO_READ_REG_1(hw, VIRTIO_PCI_STATUS);
+	return VTPCI_OPS(hw)->get_status(hw);
 }
 
 void
@@ -127,14 +222,14 @@ vtpci_set_status(struct virtio_hw *hw, uint8_t status)
 	if (status != VIRTIO_CONFIG_STATUS_RESET)
 		status = (uint8_t)(status | vtpci_get_status(hw));
 
-	VIRTIO_WRITE_REG_1(hw, VIRTIO_PCI_STATUS, status);
+	VTPCI_OPS(hw)->set_status(hw, status);
 }
 
 uint8_t
 vtpci_isr(struct virtio_hw *hw)
 {
 
-	return VIRTIO_READ_REG_1(hw, VIRTIO_PCI_ISR);
+	return VTPCI_OPS(hw)->get_isr(hw);
 }
 
 
@@ -142,6 +237,5 @@ vtpci_isr(struct virtio_hw *hw)
 uint16_t
 vtpci_irq_config(struct virtio_hw *hw, uint16_t vec)
 {
-	VIRTIO_WRITE_REG_2(hw, VIRTIO_MSI_CONFIG_VECTOR, vec);
-	return VIRTIO_READ_REG_2(hw, VIRTIO_MSI_CONFIG_VECTOR);
+	return VTPCI_OPS(hw)->set_config_irq(hw, vec);
 }
@@ -46,6 +46,7 @@
 #include <rte_ethdev.h>
 
 struct virtqueue;
+struct virtio_user_dev;
 
 /* VirtIO PCI vendor/device ID. */
 #define VIRTIO_PCI_VENDORID     0x1AF4
@@ -163,6 +164,7 @@ struct virtqueue;
 
 struct virtio_hw {
 	struct virtqueue *cvq;
+	struct virtio_user_dev *virtio_user_dev; /**< NULL for a PCI device */
 	uint32_t    io_base;
 	uint32_t    guest_features;
 	uint32_t    max_tx_queues;
@@ -171,9 +173,39 @@ struct virtio_hw {
 	uint8_t	    vlan_strip;
 	uint8_t	    use_msix;
 	uint8_t     started;
+	uint8_t     port_id;
 	uint8_t     mac_addr[ETHER_ADDR_LEN];
 };
 
+/*
+ * Access to the device, through the I/O ports of a PCI device or through
+ * the messages sent to a vhost-user backend.
+ */
+struct virtio_pci_ops {
+	void (*read_dev_cfg)(struct virtio_hw *hw, uint64_t offset,
+			void *dst, int length);
+	void (*write_dev_cfg)(struct virtio_hw *hw, uint64_t offset,
+			void *src, int length);
+	uint8_t (*get_status)(struct virtio_hw *hw);
+	void (*set_status)(struct virtio_hw *hw, uint8_t status);
+	uint32_t (*get_features)(struct virtio_hw *hw);
+	void (*set_features)(struct virtio_hw *hw, uint32_t features);
+	uint8_t (*get_isr)(struct virtio_hw *hw);
+	uint16_t (*set_config_irq)(struct virtio_hw *hw, uint16_t vec);
+	uint16_t (*get_queue_num)(struct virtio_hw *hw, uint16_t queue_id);
+	void (*setup_queue)(struct virtio_hw *hw, struct virtqueue *vq);
+	void (*notify_queue)(struct virtio_hw *hw, struct virtqueue *vq);
+};
+
+/*
+ * The ops of each port are kept in process local memory, as the function
+ * addresses may differ between a primary and a secondary process.
+ */
+extern const struct virtio_pci_ops *vtpci_ops[RTE_MAX_ETHPORTS];
+#define VTPCI_OPS(hw) (vtpci_ops[(hw)->port_id])
+
+extern const struct virtio_pci_ops vtpci_legacy_ops;
+
 /*
  * This structure is just a reference to read
  * net device specific config space; it just a chodu structure
@@ -257,6 +289,8 @@ void vtpci_reinit_complete(struct virtio_hw *);
 
 void vtpci_set_status(struct virtio_hw *, uint8_t);
 
+uint8_t vtpci_get_status(struct virtio_hw *);
+
 uint32_t vtpci_negotiate_features(struct virtio_hw *, uint32_t);
 
 void vtpci_write_dev_config(struct virtio_hw *, uint64_t, void *, int);
@@ -0,0 +1,567 @@
+/*-
+ *   BSD LICENSE
+ *
+ *   Copyright(c) 2010-2014 Intel Corporation. All rights reserved.
+ *   All rights reserved.
+ *
+ *   Redistribution and use in source and binary forms, with or without
+ *   modification, are permitted provided that the following conditions
+ *   are met:
+ *
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in
+ *       the documentation and/or other materials provided with the
+ *       distribution.
+ *     * Neither the name of Intel Corporation nor the names of its
+ *       contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ *   THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *   "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *   LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ *   A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ *   OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ *   SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ *   LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ *   DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ *   THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ *   (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ *   OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <inttypes.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <sys/eventfd.h>
+
+#include <rte_common.h>
+#include <rte_ether.h>
+#include <rte_log.h>
+#include <rte_malloc.h>
+#include <rte_memory.h>
+
+#include "virtio_logs.h"
+#include "virtio_user.h"
+#include "virtqueue.h"
+
+/* vhost-user protocol, as sent by QEMU (hw/virtio/vhost-user.c) */
+enum vhost_user_request {
+	VHOST_USER_GET_FEATURES = 1,
+	VHOST_USER_SET_FEATURES = 2,
+	VHOST_USER_SET_OWNER = 3,
+	VHOST_USER_SET_MEM_TABLE = 5,
+	VHOST_USER_SET_VRING_NUM = 8,
+	VHOST_USER_SET_VRING_ADDR = 9,
+	VHOST_USER_SET_VRING_BASE = 10,
+	VHOST_USER_GET_VRING_BASE = 11,
+	VHOST_USER_SET_VRING_KICK = 12,
+	VHOST_USER_SET_VRING_CALL = 13,
+};
+
+#define VHOST_USER_VERSION 0x1
+#define VHOST_USER_REPLY_MASK (0x1 << 2)
+#define VHOST_USER_F_PROTOCOL_FEATURES 30
+
+struct vhost_user_vring_state {
+	unsigned int index;
+	unsigned int num;
+};
+
+struct vhost_user_vring_addr {
+	unsigned int index;
+	unsigned int flags;
+	uint64_t desc_user_addr;
+	uint64_t used_user_addr;
+	uint64_t avail_user_addr;
+	uint64_t log_guest_addr;
+};
+
+struct vhost_user_msg {
+	uint32_t request;
+	uint32_t flags;
+	uint32_t size;
+	union {
+		uint64_t u64;
+		struct vhost_user_vring_state state;
+		struct vhost_user_vring_addr addr;
+		struct vhost_user_memory memory;
+	} payload;
+} __attribute__((packed));
+
+#define VHOST_USER_HDR_SIZE offsetof(struct vhost_user_msg, payload.u64)
+
+/*
+ * The features which need the control queue, which is not emulated, and
+ * the bit of the vhost-user protocol features, which is not a virtio one.
+ */
+#define VIRTIO_USER_UNSUPPORTED_FEATURES \
+	(VIRTIO_NET_F_CTRL_VQ | VIRTIO_NET_F_CTRL_RX | \
+	VIRTIO_NET_F_CTRL_VLAN | VIRTIO_NET_F_CTRL_RX_EXTRA | \
+	VIRTIO_NET_F_CTRL_MAC_ADDR | VIRTIO_NET_F_MQ | \
+	(1u << VHOST_USER_F_PROTOCOL_FEATURES))
+
+static int
+vhost_user_send(struct virtio_user_dev *dev, struct vhost_user_msg *msg,
+		int *fds, int fd_num)
+{
+	char control[CMSG_SPACE(VHOST_USER_MEMORY_MAX_NREGIONS * sizeof(int))];
+	struct msghdr msgh;
+	struct iovec iov;
+	struct cmsghdr *cmsg;
+	ssize_t ret;
+
+	msg->flags = VHOST_USER_VERSION;
+
+	memset(&msgh, 0, sizeof(msgh));
+	iov.iov_base = msg;
+	iov.iov_len = VHOST_USER_HDR_SIZE + msg->size;
+	msgh.msg_iov = &iov;
+	msgh.msg_iovlen = 1;
+
+	if (fd_num > 0) {
+		msgh.msg_control = control;
+		msgh.msg_controllen = CMSG_SPACE(fd_num * sizeof(int));
+		cmsg = CMSG_FIRSTHDR(&msgh);
+		cmsg->cmsg_len = CMSG_LEN(fd_num * sizeof(int));
+		cmsg->cmsg_level = SOL_SOCKET;
+		cmsg->cmsg_type = SCM_RIGHTS;
+		memcpy(CMSG_DATA(cmsg), fds, fd_num * sizeof(int));
+	}
+
+	do {
+		ret = sendmsg(dev->vhostfd, &msgh, 0);
+	} while (ret < 0 && errno == EINTR);
+
+	if (ret != (ssize_t)iov.iov_len) {
+		RTE_LOG(ERR, PMD, "virtio_user: cannot send request %u to %s\n",
+			msg->request, dev->path);
+		return -1;
+	}
+	return 0;
+}
+
+/* read the reply to a request, with a payload of size bytes */
+static int
+vhost_user_recv_reply(struct virtio_user_dev *dev, struct vhost_user_msg *msg,
+		uint32_t request, uint32_t size)
+{
+	if (recv(dev->vhostfd, msg, VHOST_USER_HDR_SIZE, MSG_WAITALL) !=
+			(ssize_t)VHOST_USER_HDR_SIZE ||
+			msg->request != request ||
+			(msg->flags & VHOST_USER_REPLY_MASK) == 0 ||
+			msg->size != size ||
+			recv(dev->vhostfd, &msg->payload, size, MSG_WAITALL) !=
+			(ssize_t)size) {
+		RTE_LOG(ERR, PMD, "virtio_user: bad reply to request %u from %s\n",
+			request, dev->path);
+		return -1;
+	}
+	return 0;
+}
+
+static int
+vhost_user_send_u64(struct virtio_user_dev *dev, uint32_t request,
+		uint64_t u64, int fd)
+{
+	struct vhost_user_msg msg;
+
+	memset(&msg, 0, sizeof(msg));
+	msg.request = request;
+	msg.size = sizeof(msg.payload.u64);
+	msg.payload.u64 = u64;
+	return vhost_user_send(dev, &msg, &fd, fd >= 0 ? 1 : 0);
+}
+
+static int
+vhost_user_send_state(struct virtio_user_dev *dev, uint32_t request,
+		unsigned index, unsigned num)
+{
+	struct vhost_user_msg msg;
+
+	memset(&msg, 0, sizeof(msg));
+	msg.request = request;
+	msg.size = sizeof(msg.payload.state);
+	msg.payload.state.index = index;
+	msg.payload.state.num = num;
+	return vhost_user_send(dev, &msg, NULL, 0);
+}
+
+/*
+ * Find the file mapped at addr, and check that the len bytes from addr are
+ * mapped from it. Returns a file descriptor of the file and the offset of
+ * addr in it, or -1.
+ */
+static int
+open_mapped_file(const void *addr, uint64_t len, uint64_t *offset)
+{
+	char line[PATH_MAX + 128];
+	char path[sizeof(line)];
+	uint64_t start, end, off;
+	FILE *f;
+	int fd = -1;
+
+	f = fopen("/proc/self/maps", "r");
+	if (f == NULL)
+		return -1;
+
+	while (fgets(line, sizeof(line), f) != NULL) {
+		if (sscanf(line, "%"SCNx64"-%"SCNx64" %*s %"SCNx64" %*s %*s %s",
+				&start, &end, &off, path) != 4)
+			continue;
+		if ((uintptr_t)addr < start || (uintptr_t)addr >= end)
+			continue;
+		if ((uintptr_t)addr + len <= end && path[0] == '/') {
+			*offset = off + (uintptr_t)addr - start;
+			fd = open(path, O_RDWR);
+		}
+		break;
+	}
+
+	fclose(f);
+	return fd;
+}
+
+/* describe the memory segments of the EAL, and open their files */
+static int
+virtio_user_init_mem(struct virtio_user_dev *dev)
+{
+	const struct rte_memseg *ms = rte_eal_get_physmem_layout();
+	struct vhost_user_memory_region *region;
+	uint64_t offset;
+	unsigned i;
+	int fd;
+
+	for (i = 0; i < RTE_MAX_MEMSEG; i++) {
+		if (ms[i].addr == NULL)
+			continue;
+
+		if (dev->mem.nregions == VHOST_USER_MEMORY_MAX_NREGIONS) {
+			RTE_LOG(ERR, PMD, "virtio_user: more than %d memory "
+				"segments\n", VHOST_USER_MEMORY_MAX_NREGIONS);
+			return -1;
+		}
+
+		fd = open_mapped_file(ms[i].addr, ms[i].len, &offset);
+		if (fd < 0) {
+			RTE_LOG(ERR, PMD, "virtio_user: memory segment %u is not "
+				"mapped from a single file, see "
+				"--single-file-segments\n", i);
+			return -1;
+		}
+
+		/*
+		 * The descriptors hold the physical addresses of the buffers,
+		 * which are the guest physical addresses for the backend.
+		 */
+		region = &dev->mem.regions[dev->mem.nregions];
+		region->guest_phys_addr = ms[i].phys_addr;
+		region->memory_size = ms[i].len;
+		region->userspace_addr = (uintptr_t)ms[i].addr;
+		region->mmap_offset = offset;
+		dev->memfds[dev->mem.nregions++] = fd;
+	}
+
+	return 0;
+}
+
+/* send the memory table and the rings, the backend then starts the device */
+static int
+virtio_user_start_device(struct virtio_user_dev *dev)
+{
+	struct vhost_user_msg msg;
+	struct virtqueue *vq;
+	unsigned q;
+
+	memset(&msg, 0, sizeof(msg));
+	msg.request = VHOST_USER_SET_MEM_TABLE;
+	msg.size = sizeof(msg.payload.memory);
+	msg.payload.memory = dev->mem;
+	if (vhost_user_send(dev, &msg, dev->memfds, dev->mem.nregions) < 0)
+		return -1;
+
+	/* As QEMU does, the call fds of all the queues are sent first. */
+	for (q = 0; q < VIRTIO_USER_NB_VQ; q++) {
+		if (dev->vqs[q] == NULL)
+			continue;
+		if (vhost_user_send_u64(dev, VHOST_USER_SET_VRING_CALL, q,
+				dev->callfds[q]) < 0)
+			return -1;
+	}
+
+	for (q = 0; q < VIRTIO_USER_NB_VQ; q++) {
+		vq = dev->vqs[q];
+		if (vq == NULL)
+			continue;
+
+		if (vhost_user_send_state(dev, VHOST_USER_SET_VRING_NUM, q,
+				vq->vq_nentries) < 0 ||
+				vhost_user_send_state(dev,
+				VHOST_USER_SET_VRING_BASE, q, 0) < 0)
+			return -1;
+
+		memset(&msg, 0, sizeof(msg));
+		msg.request = VHOST_USER_SET_VRING_ADDR;
+		msg.size = sizeof(msg.payload.addr);
+		msg.payload.addr.index = q;
+		msg.payload.addr.desc_user_addr = (uintptr_t)vq->vq_ring.desc;
+		msg.payload.addr.avail_user_addr = (uintptr_t)vq->vq_ring.avail;
+		msg.payload.addr.used_user_addr = (uintptr_t)vq->vq_ring.used;
+		if (vhost_user_send(dev, &msg, NULL, 0) < 0)
+			return -1;
+
+		if (vhost_user_send_u64(dev, VHOST_USER_SET_VRING_KICK, q,
+				dev->kickfds[q]) < 0)
+			return -1;
+	}
+
+	return 0;
+}
+
+/* the backend stops the device when it is asked for the state of a ring */
+static void
+virtio_user_stop_device(struct virtio_user_dev *dev)
+{
+	struct vhost_user_msg msg;
+	unsigned q;
+
+	for (q = 0; q < VIRTIO_USER_NB_VQ; q++) {
+		if (dev->vqs[q] == NULL)
+			continue;
+		if (vhost_user_send_state(dev, VHOST_USER_GET_VRING_BASE,
+				q, 0) < 0 ||
+				vhost_user_recv_reply(dev, &msg,
+				VHOST_USER_GET_VRING_BASE,
+				sizeof(msg.payload.state)) < 0)
+			return;
+	}
+}
+
+static void
+virtio_user_read_dev_config(struct virtio_hw *hw, uint64_t offset,
+		void *dst, int length)
+{
+	struct virtio_user_dev *dev = hw->virtio_user_dev;
+
+	if (offset + length > sizeof(dev->config)) {
+		PMD_DRV_LOG(ERR, "invalid config read at %"PRIu64, offset);
+		return;
+	}
+	memcpy(dst, (uint8_t *)&dev->config + offset, length);
+}
+
+static void
+virtio_user_write_dev_config(struct virtio_hw *hw, uint64_t offset,
+		void *src, int length)
+{
+	struct virtio_user_dev *dev = hw->virtio_user_dev;
+
+	if (offset + length > sizeof(dev->config)) {
+		PMD_DRV_LOG(ERR, "invalid config write at %"PRIu64, offset);
+		return;
+	}
+	memcpy((uint8_t *)&dev->config + offset, src, length);
+}
+
+static uint8_t
+virtio_user_get_status(struct virtio_hw *hw)
+{
+	return hw->virtio_user_dev->status;
+}
+
+static void
+virtio_user_set_status(struct virtio_hw *hw, uint8_t status)
+{
+	struct virtio_user_dev *dev = hw->virtio_user_dev;
+	uint8_t running = VIRTIO_CONFIG_STATUS_DRIVER_OK |
+		VIRTIO_CONFIG_STATUS_FAILED;
+
+	if ((status & VIRTIO_CONFIG_STATUS_DRIVER_OK) &&
+			(dev->status & VIRTIO_CONFIG_STATUS_DRIVER_OK) == 0) {
+		if (virtio_user_start_device(dev) < 0)
+			status |= VIRTIO_CONFIG_STATUS_FAILED;
+	} else if (status == VIRTIO_CONFIG_STATUS_RESET &&
+			(dev->status & running) ==
+			VIRTIO_CONFIG_STATUS_DRIVER_OK) {
+		virtio_user_stop_device(dev);
+	}
+
+	dev->status = status;
+}
+
+static uint32_t
+virtio_user_get_features(struct virtio_hw *hw)
+{
+	return hw->virtio_user_dev->device_features;
+}
+
+static void
+virtio_user_set_features(struct virtio_hw *hw, uint32_t features)
+{
+	struct virtio_user_dev *dev = hw->virtio_user_dev;
+
+	/* The MAC address and the link status are emulated here. */
+	if (vhost_user_send_u64(dev, VHOST_USER_SET_FEATURES,
+			features & dev->vhost_features, -1) < 0)
+		dev->status |= VIRTIO_CONFIG_STATUS_FAILED;
+}
+
+static uint8_t
+virtio_user_get_isr(__rte_unused struct virtio_hw *hw)
+{
+	return 0;
+}
+
+static uint16_t
+virtio_user_set_config_irq(__rte_unused struct virtio_hw *hw,
+		__rte_unused uint16_t vec)
+{
+	return VIRTIO_MSI_NO_VECTOR;
+}
+
+static uint16_t
+virtio_user_get_queue_num(struct virtio_hw *hw, uint16_t queue_id)
+{
+	if (queue_id >= VIRTIO_USER_NB_VQ)
+		return 0;
+	return hw->virtio_user_dev->queue_size;
+}
+
+static void
+virtio_user_setup_queue(struct virtio_hw *hw, struct virtqueue *vq)
+{
+	hw->virtio_user_dev->vqs[vq->vq_queue_index] = vq;
+}
+
+static void
+virtio_user_notify_queue(struct virtio_hw *hw, struct virtqueue *vq)
+{
+	uint64_t buf = 1;
+
+	if (write(hw->virtio_user_dev->kickfds[vq->vq_queue_index],
+			&buf, sizeof(buf)) < 0)
+		PMD_DRV_LOG(ERR, "cannot kick queue %u: %s",
+			vq->vq_queue_index, strerror(errno));
+}
+
+const struct virtio_pci_ops virtio_user_ops = {
+	.read_dev_cfg = virtio_user_read_dev_config,
+	.write_dev_cfg = virtio_user_write_dev_config,
+	.get_status = virtio_user_get_status,
+	.set_status = virtio_user_set_status,
+	.get_features = virtio_user_get_features,
+	.set_features = virtio_user_set_features,
+	.get_isr = virtio_user_get_isr,
+	.set_config_irq = virtio_user_set_config_irq,
+	.get_queue_num = virtio_user_get_queue_num,
+	.setup_queue = virtio_user_setup_queue,
+	.notify_queue = virtio_user_notify_queue,
+};
+
+struct virtio_user_dev *
+virtio_user_dev_create(const char *path, uint16_t queue_size)
+{
+	struct virtio_user_dev *dev;
+	struct vhost_user_msg msg;
+	struct sockaddr_un un;
+	unsigned i;
+
+	dev = rte_zmalloc("virtio_user_dev", sizeof(*dev), 0);
+	if (dev == NULL)
+		return NULL;
+
+	dev->vhostfd = -1;
+	for (i = 0; i < VIRTIO_USER_NB_VQ; i++) {
+		dev->callfds[i] = -1;
+		dev->kickfds[i] = -1;
+	}
+	for (i = 0; i < VHOST_USER_MEMORY_MAX_NREGIONS; i++)
+		dev->memfds[i] = -1;
+	dev->queue_size = queue_size;
+	snprintf(dev->path, sizeof(dev->path), "%s", path);
+
+	if (virtio_user_init_mem(dev) < 0)
+		goto error;
+
+	for (i = 0; i < VIRTIO_USER_NB_VQ; i++) {
+		dev->callfds[i] = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+		dev->kickfds[i] = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+		if (dev->callfds[i] < 0 || dev->kickfds[i] < 0) {
+			RTE_LOG(ERR, PMD, "virtio_user: cannot create "
+				"eventfd: %s\n", strerror(errno));
+			goto error;
+		}
+	}
+
+	dev->vhostfd = socket(AF_UNIX, SOCK_STREAM, 0);
+	if (dev->vhostfd < 0) {
+		RTE_LOG(ERR, PMD, "virtio_user: cannot create socket: %s\n",
+			strerror(errno));
+		goto error;
+	}
+	memset(&un, 0, sizeof(un));
+	un.sun_family = AF_UNIX;
+	snprintf(un.sun_path, sizeof(un.sun_path), "%s", path);
+	if (connect(dev->vhostfd, (struct sockaddr *)&un, sizeof(un)) < 0) {
+		RTE_LOG(ERR, PMD, "virtio_user: cannot connect to %s: %s\n",
+			path, strerror(errno));
+		goto error;
+	}
+
+	memset(&msg, 0, sizeof(msg));
+	msg.request = VHOST_USER_SET_OWNER;
+	if (vhost_user_send(dev, &msg, NULL, 0) < 0)
+		goto error;
+
+	msg.request = VHOST_USER_GET_FEATURES;
+	msg.size = 0;
+	if (vhost_user_send(dev, &msg, NULL, 0) < 0 ||
+			vhost_user_recv_reply(dev, &msg,
+			VHOST_USER_GET_FEATURES, sizeof(msg.payload.u64)) < 0)
+		goto error;
+	dev->vhost_features = msg.payload.u64;
+
+	dev->device_features = ((uint32_t)dev->vhost_features &
+		~VIRTIO_USER_UNSUPPORTED_FEATURES) |
+		VIRTIO_NET_F_MAC | VIRTIO_NET_F_STATUS;
+	eth_random_addr(dev->config.mac);
+	dev->config.status = VIRTIO_NET_S_LINK_UP;
+	dev->config.max_virtqueue_pairs = 1;
+
+	return dev;
+
+error:
+	virtio_user_dev_free(dev);
+	return NULL;
+}
+
+void
+virtio_user_dev_free(struct virtio_user_dev *dev)
+{
+	unsigned i;
+
+	if (dev == NULL)
+		return;
+
+	/* the backend destroys the device when the connection is closed */
+	if (dev->vhostfd >= 0)
+		close(dev->vhostfd);
+	for (i = 0; i < VIRTIO_USER_NB_VQ; i++) {
+		if (dev->callfds[i] >= 0)
+			close(dev->callfds[i]);
+		if (dev->kickfds[i] >= 0)
+			close(dev->kickfds[i]);
+	}
+	for (i = 0; i < VHOST_USER_MEMORY_MAX_NREGIONS; i++) {
+		if (dev->memfds[i] >= 0)
+			close(dev->memfds[i]);
+	}
+	rte_free(dev);
+}
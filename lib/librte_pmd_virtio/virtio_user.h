@@ -0,0 +1,107 @@
+/*-
+ *   BSD LICENSE
+ *
+ *   Copyright(c) 2010-2014 Intel Corporation. All rights reserved.
+ *   All rights reserved.
+ *
+ *   Redistribution and use in source and binary forms, with or without
+ *   modification, are permitted provided that the following conditions
+ *   are met:
+ *
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in
+ *       the documentation and/or other materials provided with the
+ *       distribution.
+ *     * Neither the name of Intel Corporation nor the names of its
+ *       contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ *   THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *   "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *   LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ *   A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ *   OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ *   SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ *   LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ *   DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ *   THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ *   (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ *   OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef _VIRTIO_USER_H_
+#define _VIRTIO_USER_H_
+
+#include <stdint.h>
+#include <limits.h>
+
+#include "virtio_pci.h"
+
+/*
+ * virtio-user: the device is a vhost-user backend, such as the vhost
+ * library, which is driven through a unix socket instead of I/O ports.
+ * The memory segments of the EAL are shared with the backend through their
+ * file descriptors, so that the rings and the mbufs are used in place.
+ */
+
+/* Only one queue pair, as the control queue is not emulated. */
+#define VIRTIO_USER_NB_VQ 2
+
+#define VIRTIO_USER_DEFAULT_QUEUE_SIZE 256
+
+#define VHOST_USER_MEMORY_MAX_NREGIONS 8
+
+struct vhost_user_memory_region {
+	uint64_t guest_phys_addr;
+	uint64_t memory_size;
+	uint64_t userspace_addr;
+	uint64_t mmap_offset;
+};
+
+struct vhost_user_memory {
+	uint32_t nregions;
+	uint32_t padding;
+	struct vhost_user_memory_region regions[VHOST_USER_MEMORY_MAX_NREGIONS];
+};
+
+struct virtio_user_dev {
+	int vhostfd;                      /**< connected vhost-user socket */
+	int callfds[VIRTIO_USER_NB_VQ];
+	int kickfds[VIRTIO_USER_NB_VQ];
+	struct virtqueue *vqs[VIRTIO_USER_NB_VQ];
+	uint64_t vhost_features;          /**< features of the backend */
+	uint32_t device_features;         /**< features offered to the driver */
+	uint16_t queue_size;
+	uint8_t status;
+	struct virtio_net_config config;
+	/** memory segments and their files, sent with SET_MEM_TABLE */
+	struct vhost_user_memory mem;
+	int memfds[VHOST_USER_MEMORY_MAX_NREGIONS];
+	char path[PATH_MAX];
+};
+
+extern const struct virtio_pci_ops virtio_user_ops;
+
+/**
+ * Connect to a vhost-user socket and get the features of the backend.
+ * Each memory segment of the EAL must be mapped from a single file, which
+ * is the case with --single-file-segments.
+ *
+ * @param path
+ *   Path of the unix socket of the vhost-user backend.
+ * @param queue_size
+ *   Number of descriptors of each virtqueue, a power of 2.
+ * @return
+ *   The device, or NULL on error.
+ */
+struct virtio_user_dev *virtio_user_dev_create(const char *path,
+		uint16_t queue_size);
+
+/**
+ * Close the connection to the backend and free the device.
+ */
+void virtio_user_dev_free(struct virtio_user_dev *dev);
+
+#endif /* _VIRTIO_USER_H_ */
@@ -0,0 +1,227 @@
+/*-
+ *   BSD LICENSE
+ *
+ *   Copyright(c) 2010-2014 Intel Corporation. All rights reserved.
+ *   All rights reserved.
+ *
+ *   Redistribution and use in source and binary forms, with or without
+ *   modification, are permitted provided that the following conditions
+ *   are met:
+ *
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in
+ *       the documentation and/or other materials provided with the
+ *       distribution.
+ *     * Neither the name of Intel Corporation nor the names of its
+ *       contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ *   THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *   "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *   LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ *   A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ *   OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ *   SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ *   LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ *   DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ *   THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ *   (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ *   OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <errno.h>
+#include <limits.h>
+
+#include <rte_common.h>
+#include <rte_dev.h>
+#include <rte_eal.h>
+#include <rte_ethdev.h>
+#include <rte_kvargs.h>
+#include <rte_lcore.h>
+#include <rte_log.h>
+#include <rte_malloc.h>
+
+#include "virtio_ethdev.h"
+#include "virtio_pci.h"
+#include "virtio_user.h"
+
+/*
+ * Virtual device driving a vhost-user backend with the virtio PMD, e.g.:
+ *   --vdev 'eth_virtio_user0,path=/tmp/vhost-net,queue_size=256'
+ */
+
+#define VIRTIO_USER_ARG_PATH       "path"
+#define VIRTIO_USER_ARG_QUEUE_SIZE "queue_size"
+
+static const char *valid_arguments[] = {
+	VIRTIO_USER_ARG_PATH,
+	VIRTIO_USER_ARG_QUEUE_SIZE,
+	NULL
+};
+
+static struct eth_driver rte_virtio_user_pmd = {
+	.pci_drv = {
+		.name = "rte_virtio_user_pmd",
+		.drv_flags = RTE_PCI_DRV_DETACHABLE,
+	},
+};
+
+static int
+get_path_arg(const char *key __rte_unused, const char *value,
+		void *extra_args)
+{
+	char *path = extra_args;
+
+	if (value == NULL || extra_args == NULL)
+		return -EINVAL;
+
+	snprintf(path, PATH_MAX, "%s", value);
+	return 0;
+}
+
+static int
+get_queue_size_arg(const char *key __rte_unused, const char *value,
+		void *extra_args)
+{
+	uint16_t *queue_size = extra_args;
+	unsigned long size;
+	char *end = NULL;
+
+	if (value == NULL || extra_args == NULL)
+		return -EINVAL;
+
+	size = strtoul(value, &end, 0);
+	if (*end != '\0' || size == 0 || size > UINT16_MAX ||
+			!rte_is_power_of_2(size))
+		return -EINVAL;
+
+	*queue_size = (uint16_t)size;
+	return 0;
+}
+
+static int
+virtio_user_devinit(const char *name, const char *params)
+{
+	struct rte_kvargs *kvlist = NULL;
+	struct rte_eth_dev *eth_dev = NULL;
+	struct rte_pci_device *pci_dev = NULL;
+	struct virtio_hw *hw = NULL;
+	uint16_t queue_size = VIRTIO_USER_DEFAULT_QUEUE_SIZE;
+	char path[PATH_MAX];
+	int ret = -1;
+
+	if (name == NULL)
+		return -EINVAL;
+
+	RTE_LOG(INFO, PMD, "Initializing virtio_user for %s\n", name);
+
+	/* the vhost-user socket and eventfds cannot be shared */
+	if (rte_eal_process_type() == RTE_PROC_SECONDARY) {
+		RTE_LOG(ERR, PMD, "virtio_user: not supported by secondary "
+			"processes\n");
+		return -ENOTSUP;
+	}
+
+	if (params != NULL)
+		kvlist = rte_kvargs_parse(params, valid_arguments);
+	if (kvlist == NULL ||
+			rte_kvargs_count(kvlist, VIRTIO_USER_ARG_PATH) != 1 ||
+			rte_kvargs_process(kvlist, VIRTIO_USER_ARG_PATH,
+				&get_path_arg, path) < 0) {
+		RTE_LOG(ERR, PMD, "virtio_user: the %s of the vhost-user "
+			"socket is required\n", VIRTIO_USER_ARG_PATH);
+		goto end;
+	}
+	if (rte_kvargs_count(kvlist, VIRTIO_USER_ARG_QUEUE_SIZE) == 1 &&
+			rte_kvargs_process(kvlist, VIRTIO_USER_ARG_QUEUE_SIZE,
+				&get_queue_size_arg, &queue_size) < 0) {
+		RTE_LOG(ERR, PMD, "virtio_user: %s must be a power of 2\n",
+			VIRTIO_USER_ARG_QUEUE_SIZE);
+		goto end;
+	}
+
+	pci_dev = rte_zmalloc(name, sizeof(*pci_dev), 0);
+	hw = rte_zmalloc(name, sizeof(*hw), 0);
+	if (pci_dev == NULL || hw == NULL)
+		goto error;
+
+	eth_dev = rte_eth_dev_allocate(name, RTE_ETH_DEV_VIRTUAL);
+	if (eth_dev == NULL)
+		goto error;
+
+	hw->virtio_user_dev = virtio_user_dev_create(path, queue_size);
+	if (hw->virtio_user_dev == NULL)
+		goto error;
+	hw->port_id = eth_dev->data->port_id;
+	VTPCI_OPS(hw) = &virtio_user_ops;
+
+	/* the PCI device only holds the driver flags, without interrupt */
+	pci_dev->numa_node = rte_socket_id();
+	pci_dev->driver = &rte_virtio_user_pmd.pci_drv;
+
+	eth_dev->pci_dev = pci_dev;
+	eth_dev->driver = &rte_virtio_user_pmd;
+	eth_dev->data->dev_private = hw;
+
+	if (eth_virtio_dev_init(eth_dev) < 0)
+		goto error;
+
+	ret = 0;
+	goto end;
+
+error:
+	if (eth_dev != NULL) {
+		rte_free(eth_dev->data->mac_addrs);
+		eth_dev->data->mac_addrs = NULL;
+		rte_eth_dev_release_port(eth_dev);
+	}
+	if (hw != NULL)
+		virtio_user_dev_free(hw->virtio_user_dev);
+	rte_free(hw);
+	rte_free(pci_dev);
+end:
+	if (kvlist != NULL)
+		rte_kvargs_free(kvlist);
+	return ret;
+}
+
+static int
+virtio_user_devuninit(const char *name)
+{
+	struct rte_eth_dev *eth_dev;
+	struct virtio_hw *hw;
+
+	if (name == NULL)
+		return -EINVAL;
+
+	RTE_LOG(INFO, PMD, "Closing virtio_user %s\n", name);
+
+	eth_dev = rte_eth_dev_allocated(name);
+	if (eth_dev == NULL)
+		return -1;
+
+	hw = eth_dev->data->dev_private;
+	virtio_user_dev_free(hw->virtio_user_dev);
+	rte_free(eth_dev->data->mac_addrs);
+	eth_dev->data->mac_addrs = NULL;
+	rte_free(hw);
+	rte_free(eth_dev->pci_dev);
+
+	rte_eth_dev_release_port(eth_dev);
+
+	return 0;
+}
+
+static struct rte_driver virtio_user_driver = {
+	.name = "eth_virtio_user",
+	.type = PMD_VDEV,
+	.init = virtio_user_devinit,
+	.uninit = virtio_user_devuninit,
+};
+
+PMD_REGISTER_DRIVER(virtio_user_driver);
@@ -298,9 +298,10 @@ virtqueue_notify(struct virtqueue *vq)
 	/*
 	 * Ensure updated avail->idx is visible to host.
 	 * For virtio on IA, the notificaiton is through io port operation
-	 * which is a serialization instruction itself.
+	 * which is a serialization instruction itself, or through a write
+	 * to the kick eventfd of a vhost-user backend, which is a syscall.
 	 */
-	VIRTIO_WRITE_REG_2(vq->hw, VIRTIO_PCI_QUEUE_NOTIFY, vq->vq_queue_index);
+	VTPCI_OPS(vq->hw)->notify_queue(vq->hw, vq);
 }
 
 #ifdef RTE_LIBRTE_VIRTIO_DEBUG_DUMP
@@ -81,9 +81,15 @@
  * - Multi- or single-producer enqueue.
  * - Bulk dequeue.
  * - Bulk enqueue.
+ * - Zero-copy dequeue, processing the objects in place.
+ * - Fixed-size objects other than pointers, see rte_ring_elem.h.
+ * - Optional relaxed tail synchronization of multiple producers or
+ *   consumers, for lcores that may be preempted.
  *
- * Note: the ring implementation is not preemptable. A lcore must not
- * be interrupted by another task that uses the same ring.
+ * Note: by default, the ring implementation is not preemptable. A lcore
+ * must not be interrupted by another task that uses the same ring,
+ * unless the ring uses relaxed tail synchronization (see RING_F_MP_RTS_ENQ
+ * and RING_F_MC_RTS_DEQ).
  *
  */
 
@@ -93,10 +99,12 @@ extern "C" {
 
 #include <stdio.h>
 #include <stdint.h>
+#include <string.h>
 #include <sys/queue.h>
 #include <errno.h>
 #include <rte_common.h>
 #include <rte_memory.h>
+#include <rte_memzone.h>
 #include <rte_lcore.h>
 #include <rte_atomic.h>
 #include <rte_branch_prediction.h>
@@ -134,6 +142,19 @@ struct rte_ring_debug_stats {
                                     *   if RTE_RING_PAUSE_REP not defined. */
 #endif
 
+/**
+ * A head or a tail of a ring, with the number of operations that moved
+ * it, as used by the relaxed tail synchronization mode. Both are updated
+ * by a single 64-bit "compare and set".
+ */
+union rte_ring_poscnt {
+	uint64_t raw;
+	struct {
+		uint32_t pos;  /**< Index of the head or tail. */
+		uint32_t cnt;  /**< Number of enqueues or dequeues. */
+	} val;
+} __attribute__((__aligned__(8)));
+
 /**
  * An RTE ring structure.
  *
@@ -147,6 +168,10 @@ struct rte_ring_debug_stats {
 struct rte_ring {
 	char name[RTE_RING_NAMESIZE];    /**< Name of the ring. */
 	int flags;                       /**< Flags supplied at creation. */
+	const struct rte_memzone *memzone;
+	/**< Memzone, if any, containing the rte_ring */
+	uint32_t htd_max;                /**< Maximum distance of a head from
+	                                  * its tail, in relaxed tail mode. */
 
 	/** Ring producer status. */
 	struct prod {
@@ -154,8 +179,16 @@ struct rte_ring {
 		uint32_t sp_enqueue;     /**< True, if single producer. */
 		uint32_t size;           /**< Size of ring. */
 		uint32_t mask;           /**< Mask (size-1) of ring. */
-		volatile uint32_t head;  /**< Producer head. */
-		volatile uint32_t tail;  /**< Producer tail. */
+		union {
+			volatile uint32_t head;  /**< Producer head. */
+			/** Producer head and count, relaxed tail mode. */
+			volatile union rte_ring_poscnt rts_head;
+		};
+		union {
+			volatile uint32_t tail;  /**< Producer tail. */
+			/** Producer tail and count, relaxed tail mode. */
+			volatile union rte_ring_poscnt rts_tail;
+		};
 	} prod __rte_cache_aligned;
 
 	/** Ring consumer status. */
@@ -163,8 +196,16 @@ struct rte_ring {
 		uint32_t sc_dequeue;     /**< True, if single consumer. */
 		uint32_t size;           /**< Size of the ring. */
 		uint32_t mask;           /**< Mask (size-1) of ring. */
-		volatile uint32_t head;  /**< Consumer head. */
-		volatile uint32_t tail;  /**< Consumer tail. */
+		union {
+			volatile uint32_t head;  /**< Consumer head. */
+			/** Consumer head and count, relaxed tail mode. */
+			volatile union rte_ring_poscnt rts_head;
+		};
+		union {
+			volatile uint32_t tail;  /**< Consumer tail. */
+			/** Consumer tail and count, relaxed tail mode. */
+			volatile union rte_ring_poscnt rts_tail;
+		};
 #ifdef RTE_RING_SPLIT_PROD_CONS
 	} cons __rte_cache_aligned;
 #else
@@ -180,8 +221,20 @@ struct rte_ring {
 	                                     * about compiler re-ordering */
 };
 
+/**
+ * Objects reserved by a zero-copy dequeue, in place in the ring. They are
+ * split in two ranges when they wrap around the end of the ring.
+ */
+struct rte_ring_zc_data {
+	void **ptr1;   /**< First range of objects. */
+	void **ptr2;   /**< Second range, at the start of the ring, or NULL. */
+	unsigned n1;   /**< Number of objects in the first range. */
+};
+
 #define RING_F_SP_ENQ 0x0001 /**< The default enqueue is "single-producer". */
 #define RING_F_SC_DEQ 0x0002 /**< The default dequeue is "single-consumer". */
+#define RING_F_MP_RTS_ENQ 0x0004 /**< Multi-producers use relaxed tail sync. */
+#define RING_F_MC_RTS_DEQ 0x0008 /**< Multi-consumers use relaxed tail sync. */
 #define RTE_RING_QUOT_EXCEED (1 << 31)  /**< Quota exceed for burst ops */
 #define RTE_RING_SZ_MASK  (unsigned)(0x0fffffff) /**< Ring size mask */
 
@@ -253,6 +306,11 @@ ssize_t rte_ring_get_memsize(unsigned count);
  *    - RING_F_SC_DEQ: If this flag is set, the default behavior when
  *      using ``rte_ring_dequeue()`` or ``rte_ring_dequeue_bulk()``
  *      is "single-consumer". Otherwise, it is "multi-consumers".
+ *    - RING_F_MP_RTS_ENQ: If this flag is set, the multi-producers
+ *      enqueues use the relaxed tail synchronization: a producer does not
+ *      wait for the enqueues that started before it to complete.
+ *    - RING_F_MC_RTS_DEQ: If this flag is set, the multi-consumers
+ *      dequeues use the relaxed tail synchronization.
  * @return
  *   0 on success, or a negative value on error.
  */
@@ -288,6 +346,11 @@ int rte_ring_init(struct rte_ring *r, const char *name, unsigned count,
  *    - RING_F_SC_DEQ: If this flag is set, the default behavior when
  *      using ``rte_ring_dequeue()`` or ``rte_ring_dequeue_bulk()``
  *      is "single-consumer". Otherwise, it is "multi-consumers".
+ *    - RING_F_MP_RTS_ENQ: If this flag is set, the multi-producers
+ *      enqueues use the relaxed tail synchronization: a producer does not
+ *      wait for the enqueues that started before it to complete.
+ *    - RING_F_MC_RTS_DEQ: If this flag is set, the multi-consumers
+ *      dequeues use the relaxed tail synchronization.
  * @return
  *   On success, the pointer to the new allocated ring. NULL on error with
  *    rte_errno set appropriately. Possible errno values include:
@@ -301,6 +364,19 @@ int rte_ring_init(struct rte_ring *r, const char *name, unsigned count,
 struct rte_ring *rte_ring_create(const char *name, unsigned count,
 				 int socket_id, unsigned flags);
 
+/**
+ * De-allocate all memory used by the ring.
+ *
+ * The ring must have been created with rte_ring_create() or
+ * rte_ring_create_elem(): its memzone is freed and its memory can be
+ * reserved again. The ring must not be used anymore by any lcore or
+ * process.
+ *
+ * @param r
+ *   Ring to free. If NULL, the function does nothing.
+ */
+void rte_ring_free(struct rte_ring *r);
+
 /**
  * Change the high water mark.
  *
@@ -331,107 +407,372 @@ int rte_ring_set_water_mark(struct rte_ring *r, unsigned count);
  */
 void rte_ring_dump(FILE *f, const struct rte_ring *r);
 
-/* the actual enqueue of pointers on the ring.
- * Placed here since identical code needed in both
- * single and multi producer enqueue functions */
-#define ENQUEUE_PTRS() do { \
-	const uint32_t size = r->prod.size; \
-	uint32_t idx = prod_head & mask; \
-	if (likely(idx + n < size)) { \
-		for (i = 0; i < (n & ((~(unsigned)0x3))); i+=4, idx+=4) { \
-			r->ring[idx] = obj_table[i]; \
-			r->ring[idx+1] = obj_table[i+1]; \
-			r->ring[idx+2] = obj_table[i+2]; \
-			r->ring[idx+3] = obj_table[i+3]; \
-		} \
-		switch (n & 0x3) { \
-			case 3: r->ring[idx++] = obj_table[i++]; \
-			case 2: r->ring[idx++] = obj_table[i++]; \
-			case 1: r->ring[idx++] = obj_table[i++]; \
-		} \
-	} else { \
-		for (i = 0; idx < size; i++, idx++)\
-			r->ring[idx] = obj_table[i]; \
-		for (idx = 0; i < n; i++, idx++) \
-			r->ring[idx] = obj_table[i]; \
-	} \
-} while(0)
-
-/* the actual copy of pointers on the ring to obj_table.
- * Placed here since identical code needed in both
- * single and multi consumer dequeue functions */
-#define DEQUEUE_PTRS() do { \
-	uint32_t idx = cons_head & mask; \
-	const uint32_t size = r->cons.size; \
-	if (likely(idx + n < size)) { \
-		for (i = 0; i < (n & (~(unsigned)0x3)); i+=4, idx+=4) {\
-			obj_table[i] = r->ring[idx]; \
-			obj_table[i+1] = r->ring[idx+1]; \
-			obj_table[i+2] = r->ring[idx+2]; \
-			obj_table[i+3] = r->ring[idx+3]; \
-		} \
-		switch (n & 0x3) { \
-			case 3: obj_table[i++] = r->ring[idx++]; \
-			case 2: obj_table[i++] = r->ring[idx++]; \
-			case 1: obj_table[i++] = r->ring[idx++]; \
-		} \
-	} else { \
-		for (i = 0; idx < size; i++, idx++) \
-			obj_table[i] = r->ring[idx]; \
-		for (idx = 0; i < n; i++, idx++) \
-			obj_table[i] = r->ring[idx]; \
-	} \
-} while (0)
+/**
+ * @internal Copy n 32-bit elements from obj_table to the ring, starting at
+ * index idx of a ring of size elements.
+ */
+static inline void __attribute__((always_inline))
+__rte_ring_enqueue_elems_32(struct rte_ring *r, const uint32_t size,
+		uint32_t idx, const void *obj_table, uint32_t n)
+{
+	unsigned i;
+	uint32_t *ring = (uint32_t *)&r->ring[0];
+	const uint32_t *obj = (const uint32_t *)obj_table;
+
+	if (likely(idx + n < size)) {
+		for (i = 0; i < (n & (~(unsigned)0x7)); i += 8, idx += 8) {
+			ring[idx] = obj[i];
+			ring[idx+1] = obj[i+1];
+			ring[idx+2] = obj[i+2];
+			ring[idx+3] = obj[i+3];
+			ring[idx+4] = obj[i+4];
+			ring[idx+5] = obj[i+5];
+			ring[idx+6] = obj[i+6];
+			ring[idx+7] = obj[i+7];
+		}
+		switch (n & 0x7) {
+			case 7: ring[idx++] = obj[i++];
+			case 6: ring[idx++] = obj[i++];
+			case 5: ring[idx++] = obj[i++];
+			case 4: ring[idx++] = obj[i++];
+			case 3: ring[idx++] = obj[i++];
+			case 2: ring[idx++] = obj[i++];
+			case 1: ring[idx++] = obj[i++];
+		}
+	} else {
+		for (i = 0; idx < size; i++, idx++)
+			ring[idx] = obj[i];
+		for (idx = 0; i < n; i++, idx++)
+			ring[idx] = obj[i];
+	}
+}
 
 /**
- * @internal Enqueue several objects on the ring (multi-producers safe).
+ * @internal Copy n 64-bit elements from obj_table to the ring, starting at
+ * index idx of a ring of size elements.
+ */
+static inline void __attribute__((always_inline))
+__rte_ring_enqueue_elems_64(struct rte_ring *r, const uint32_t size,
+		uint32_t idx, const void *obj_table, uint32_t n)
+{
+	unsigned i;
+	uint64_t *ring = (uint64_t *)&r->ring[0];
+	const uint64_t *obj = (const uint64_t *)obj_table;
+
+	if (likely(idx + n < size)) {
+		for (i = 0; i < (n & (~(unsigned)0x3)); i += 4, idx += 4) {
+			ring[idx] = obj[i];
+			ring[idx+1] = obj[i+1];
+			ring[idx+2] = obj[i+2];
+			ring[idx+3] = obj[i+3];
+		}
+		switch (n & 0x3) {
+			case 3: ring[idx++] = obj[i++];
+			case 2: ring[idx++] = obj[i++];
+			case 1: ring[idx++] = obj[i++];
+		}
+	} else {
+		for (i = 0; idx < size; i++, idx++)
+			ring[idx] = obj[i];
+		for (idx = 0; i < n; i++, idx++)
+			ring[idx] = obj[i];
+	}
+}
+
+/**
+ * @internal Copy n 128-bit elements from obj_table to the ring, starting at
+ * index idx of a ring of size elements. The fixed-size copies are done
+ * with vector loads and stores.
+ */
+static inline void __attribute__((always_inline))
+__rte_ring_enqueue_elems_128(struct rte_ring *r, const uint32_t size,
+		uint32_t idx, const void *obj_table, uint32_t n)
+{
+	unsigned i;
+	uint8_t *ring = (uint8_t *)&r->ring[0];
+	const uint8_t *obj = (const uint8_t *)obj_table;
+
+	if (likely(idx + n < size)) {
+		for (i = 0; i < (n & (~(unsigned)0x1)); i += 2, idx += 2)
+			memcpy(ring + idx * 16, obj + i * 16, 32);
+		if (n & 0x1)
+			memcpy(ring + idx * 16, obj + i * 16, 16);
+	} else {
+		for (i = 0; idx < size; i++, idx++)
+			memcpy(ring + idx * 16, obj + i * 16, 16);
+		for (idx = 0; i < n; i++, idx++)
+			memcpy(ring + idx * 16, obj + i * 16, 16);
+	}
+}
+
+/**
+ * @internal Copy n elements of esize bytes from obj_table to the ring,
+ * starting at the position of prod_head.
+ */
+static inline void __attribute__((always_inline))
+__rte_ring_enqueue_elems(struct rte_ring *r, uint32_t prod_head,
+		const void *obj_table, unsigned esize, uint32_t n)
+{
+	const uint32_t size = r->prod.size;
+	const uint32_t idx = prod_head & r->prod.mask;
+	uint8_t *ring = (uint8_t *)&r->ring[0];
+	uint32_t n1;
+
+	if (esize == 4)
+		__rte_ring_enqueue_elems_32(r, size, idx, obj_table, n);
+	else if (esize == 8)
+		__rte_ring_enqueue_elems_64(r, size, idx, obj_table, n);
+	else if (esize == 16)
+		__rte_ring_enqueue_elems_128(r, size, idx, obj_table, n);
+	else {
+		/* other sizes: the elements are contiguous in the table and
+		 * in the ring, copy them in one or two blocks */
+		n1 = (idx + n <= size) ? n : size - idx;
+		memcpy(ring + (size_t)idx * esize, obj_table,
+		       (size_t)n1 * esize);
+		if (n1 != n)
+			memcpy(ring, (const uint8_t *)obj_table +
+			       (size_t)n1 * esize, (size_t)(n - n1) * esize);
+	}
+}
+
+/**
+ * @internal Copy n 32-bit elements from the ring to obj_table, starting at
+ * index idx of a ring of size elements.
+ */
+static inline void __attribute__((always_inline))
+__rte_ring_dequeue_elems_32(struct rte_ring *r, const uint32_t size,
+		uint32_t idx, void *obj_table, uint32_t n)
+{
+	unsigned i;
+	const uint32_t *ring = (const uint32_t *)&r->ring[0];
+	uint32_t *obj = (uint32_t *)obj_table;
+
+	if (likely(idx + n < size)) {
+		for (i = 0; i < (n & (~(unsigned)0x7)); i += 8, idx += 8) {
+			obj[i] = ring[idx];
+			obj[i+1] = ring[idx+1];
+			obj[i+2] = ring[idx+2];
+			obj[i+3] = ring[idx+3];
+			obj[i+4] = ring[idx+4];
+			obj[i+5] = ring[idx+5];
+			obj[i+6] = ring[idx+6];
+			obj[i+7] = ring[idx+7];
+		}
+		switch (n & 0x7) {
+			case 7: obj[i++] = ring[idx++];
+			case 6: obj[i++] = ring[idx++];
+			case 5: obj[i++] = ring[idx++];
+			case 4: obj[i++] = ring[idx++];
+			case 3: obj[i++] = ring[idx++];
+			case 2: obj[i++] = ring[idx++];
+			case 1: obj[i++] = ring[idx++];
+		}
+	} else {
+		for (i = 0; idx < size; i++, idx++)
+			obj[i] = ring[idx];
+		for (idx = 0; i < n; i++, idx++)
+			obj[i] = ring[idx];
+	}
+}
+
+/**
+ * @internal Copy n 64-bit elements from the ring to obj_table, starting at
+ * index idx of a ring of size elements.
+ */
+static inline void __attribute__((always_inline))
+__rte_ring_dequeue_elems_64(struct rte_ring *r, const uint32_t size,
+		uint32_t idx, void *obj_table, uint32_t n)
+{
+	unsigned i;
+	const uint64_t *ring = (const uint64_t *)&r->ring[0];
+	uint64_t *obj = (uint64_t *)obj_table;
+
+	if (likely(idx + n < size)) {
+		for (i = 0; i < (n & (~(unsigned)0x3)); i += 4, idx += 4) {
+			obj[i] = ring[idx];
+			obj[i+1] = ring[idx+1];
+			obj[i+2] = ring[idx+2];
+			obj[i+3] = ring[idx+3];
+		}
+		switch (n & 0x3) {
+			case 3: obj[i++] = ring[idx++];
+			case 2: obj[i++] = ring[idx++];
+			case 1: obj[i++] = ring[idx++];
+		}
+	} else {
+		for (i = 0; idx < size; i++, idx++)
+			obj[i] = ring[idx];
+		for (idx = 0; i < n; i++, idx++)
+			obj[i] = ring[idx];
+	}
+}
+
+/**
+ * @internal Copy n 128-bit elements from the ring to obj_table, starting at
+ * index idx of a ring of size elements.
+ */
+static inline void __attribute__((always_inline))
+__rte_ring_dequeue_elems_128(struct rte_ring *r, const uint32_t size,
+		uint32_t idx, void *obj_table, uint32_t n)
+{
+	unsigned i;
+	const uint8_t *ring = (const uint8_t *)&r->ring[0];
+	uint8_t *obj = (uint8_t *)obj_table;
+
+	if (likely(idx + n < size)) {
+		for (i = 0; i < (n & (~(unsigned)0x1)); i += 2, idx += 2)
+			memcpy(obj + i * 16, ring + idx * 16, 32);
+		if (n & 0x1)
+			memcpy(obj + i * 16, ring + idx * 16, 16);
+	} else {
+		for (i = 0; idx < size; i++, idx++)
+			memcpy(obj + i * 16, ring + idx * 16, 16);
+		for (idx = 0; i < n; i++, idx++)
+			memcpy(obj + i * 16, ring + idx * 16, 16);
+	}
+}
+
+/**
+ * @internal Copy n elements of esize bytes from the ring to obj_table,
+ * starting at the position of cons_head.
+ */
+static inline void __attribute__((always_inline))
+__rte_ring_dequeue_elems(struct rte_ring *r, uint32_t cons_head,
+		void *obj_table, unsigned esize, uint32_t n)
+{
+	const uint32_t size = r->cons.size;
+	const uint32_t idx = cons_head & r->cons.mask;
+	const uint8_t *ring = (const uint8_t *)&r->ring[0];
+	uint32_t n1;
+
+	if (esize == 4)
+		__rte_ring_dequeue_elems_32(r, size, idx, obj_table, n);
+	else if (esize == 8)
+		__rte_ring_dequeue_elems_64(r, size, idx, obj_table, n);
+	else if (esize == 16)
+		__rte_ring_dequeue_elems_128(r, size, idx, obj_table, n);
+	else {
+		n1 = (idx + n <= size) ? n : size - idx;
+		memcpy(obj_table, ring + (size_t)idx * esize,
+		       (size_t)n1 * esize);
+		if (n1 != n)
+			memcpy((uint8_t *)obj_table + (size_t)n1 * esize,
+			       ring, (size_t)(n - n1) * esize);
+	}
+}
+
+/**
+ * @internal Read a head or a tail of a ring in relaxed tail mode, as a
+ * single 64-bit value.
+ */
+static inline uint64_t __attribute__((always_inline))
+__rte_ring_rts_read(volatile union rte_ring_poscnt *v)
+{
+#ifdef RTE_ARCH_64
+	return v->raw;
+#else
+	uint64_t raw;
+
+	/* a 64-bit load may be split, a "compare and set" is not */
+	do {
+		raw = v->raw;
+	} while (unlikely(rte_atomic64_cmpset(&v->raw, raw, raw) == 0));
+	return raw;
+#endif
+}
+
+/**
+ * @internal Move the tail of a ring in relaxed tail mode, at the end of an
+ * enqueue or a dequeue.
  *
- * This function uses a "compare and set" instruction to move the
- * producer index atomically.
+ * The operation only increments the count of the tail, unless it is the
+ * last one in progress: the tail then moves to the head, releasing the
+ * objects of all the operations that completed in the meantime. Nobody
+ * waits for the operations that started earlier to complete.
+ */
+static inline void __attribute__((always_inline))
+__rte_ring_rts_update_tail(volatile union rte_ring_poscnt *head,
+		volatile union rte_ring_poscnt *tail)
+{
+	union rte_ring_poscnt h, ot, nt;
+
+	do {
+		/* a torn read of the tail makes the "compare and set" fail */
+		ot.raw = tail->raw;
+		h.raw = __rte_ring_rts_read(head);
+
+		nt.raw = ot.raw;
+		if (++nt.val.cnt == h.val.cnt)
+			nt.val.pos = h.val.pos;
+	} while (unlikely(rte_atomic64_cmpset(&tail->raw, ot.raw,
+					      nt.raw) == 0));
+}
+
+/**
+ * @internal Read the head of a ring in relaxed tail mode, waiting while it
+ * is more than htd_max entries ahead of its tail. This bounds the number
+ * of objects that the operations in progress can hold back.
+ */
+static inline uint64_t __attribute__((always_inline))
+__rte_ring_rts_head_wait(const struct rte_ring *r,
+		volatile union rte_ring_poscnt *head,
+		const volatile uint32_t *tail)
+{
+	union rte_ring_poscnt h;
+
+	h.raw = __rte_ring_rts_read(head);
+	while (unlikely(h.val.pos - *tail > r->htd_max)) {
+		rte_pause();
+		h.raw = __rte_ring_rts_read(head);
+	}
+	return h.raw;
+}
+
+/**
+ * @internal Enqueue several objects on a ring, with relaxed tail
+ * synchronization between the producers.
+ *
+ * The producers reserve room by moving the head and its count with a
+ * "compare and set". Once it has copied its objects, a producer does not
+ * wait for the producers that reserved room before it: the last one to
+ * complete moves the tail for all of them.
  *
  * @param r
  *   A pointer to the ring structure.
  * @param obj_table
- *   A pointer to a table of void * pointers (objects).
+ *   A pointer to a table of objects of esize bytes.
+ * @param esize
+ *   The size of the objects, in bytes: a multiple of 4, equal to the
+ *   element size the ring was created with.
  * @param n
  *   The number of objects to add in the ring from the obj_table.
  * @param behavior
  *   RTE_RING_QUEUE_FIXED:    Enqueue a fixed number of items from a ring
  *   RTE_RING_QUEUE_VARIABLE: Enqueue as many items a possible from ring
  * @return
- *   Depend on the behavior value
- *   if behavior = RTE_RING_QUEUE_FIXED
- *   - 0: Success; objects enqueue.
- *   - -EDQUOT: Quota exceeded. The objects have been enqueued, but the
- *     high water mark is exceeded.
- *   - -ENOBUFS: Not enough room in the ring to enqueue, no object is enqueued.
- *   if behavior = RTE_RING_QUEUE_VARIABLE
- *   - n: Actual number of objects enqueued.
+ *   Same as __rte_ring_do_enqueue_elem().
  */
 static inline int __attribute__((always_inline))
-__rte_ring_mp_do_enqueue(struct rte_ring *r, void * const *obj_table,
-			 unsigned n, enum rte_ring_queue_behavior behavior)
+__rte_ring_rts_do_enqueue_elem(struct rte_ring *r, const void *obj_table,
+		unsigned esize, unsigned n,
+		enum rte_ring_queue_behavior behavior)
 {
-	uint32_t prod_head, prod_next;
+	union rte_ring_poscnt oh, nh;
 	uint32_t cons_tail, free_entries;
 	const unsigned max = n;
-	int success;
-	unsigned i, rep = 0;
 	uint32_t mask = r->prod.mask;
 	int ret;
 
-	/* move prod.head atomically */
+	/* move prod.head and its count atomically */
 	do {
 		/* Reset n to the initial burst count */
 		n = max;
 
-		prod_head = r->prod.head;
+		oh.raw = __rte_ring_rts_head_wait(r, &r->prod.rts_head,
+				&r->prod.tail);
 		cons_tail = r->cons.tail;
-		/* The subtraction is done between two unsigned 32bits value
-		 * (the result is always modulo 32 bits even if we have
-		 * prod_head > cons_tail). So 'free_entries' is always between 0
-		 * and size(ring)-1. */
-		free_entries = (mask + cons_tail - prod_head);
+		free_entries = (mask + cons_tail - oh.val.pos);
 
 		/* check that we have enough room in ring */
 		if (unlikely(n > free_entries)) {
@@ -450,13 +791,13 @@ __rte_ring_mp_do_enqueue(struct rte_ring *r, void * const *obj_table,
 			}
 		}
 
-		prod_next = prod_head + n;
-		success = rte_atomic32_cmpset(&r->prod.head, prod_head,
-					      prod_next);
-	} while (unlikely(success == 0));
+		nh.val.pos = oh.val.pos + n;
+		nh.val.cnt = oh.val.cnt + 1;
+	} while (unlikely(rte_atomic64_cmpset(&r->prod.rts_head.raw, oh.raw,
+					      nh.raw) == 0));
 
 	/* write entries in ring */
-	ENQUEUE_PTRS();
+	__rte_ring_enqueue_elems(r, oh.val.pos, obj_table, esize, n);
 	rte_compiler_barrier();
 
 	/* if we exceed the watermark */
@@ -470,38 +811,101 @@ __rte_ring_mp_do_enqueue(struct rte_ring *r, void * const *obj_table,
 		__RING_STAT_ADD(r, enq_success, n);
 	}
 
-	/*
-	 * If there are other enqueues in progress that preceded us,
-	 * we need to wait for them to complete
-	 */
-	while (unlikely(r->prod.tail != prod_head)) {
-		rte_pause();
+	__rte_ring_rts_update_tail(&r->prod.rts_head, &r->prod.rts_tail);
+	return ret;
+}
 
-		/* Set RTE_RING_PAUSE_REP_COUNT to avoid spin too long waiting
-		 * for other thread finish. It gives pre-empted thread a chance
-		 * to proceed and finish with ring dequeue operation. */
-		if (RTE_RING_PAUSE_REP_COUNT &&
-		    ++rep == RTE_RING_PAUSE_REP_COUNT) {
-			rep = 0;
-			sched_yield();
+/**
+ * @internal Dequeue several objects from a ring, with relaxed tail
+ * synchronization between the consumers.
+ *
+ * @param r
+ *   A pointer to the ring structure.
+ * @param obj_table
+ *   A pointer to a table of objects of esize bytes that will be filled.
+ * @param esize
+ *   The size of the objects, in bytes: a multiple of 4, equal to the
+ *   element size the ring was created with.
+ * @param n
+ *   The number of objects to dequeue from the ring to the obj_table.
+ * @param behavior
+ *   RTE_RING_QUEUE_FIXED:    Dequeue a fixed number of items from a ring
+ *   RTE_RING_QUEUE_VARIABLE: Dequeue as many items a possible from ring
+ * @return
+ *   Same as __rte_ring_do_dequeue_elem().
+ */
+static inline int __attribute__((always_inline))
+__rte_ring_rts_do_dequeue_elem(struct rte_ring *r, void *obj_table,
+		unsigned esize, unsigned n,
+		enum rte_ring_queue_behavior behavior)
+{
+	union rte_ring_poscnt oh, nh;
+	uint32_t prod_tail, entries;
+	const unsigned max = n;
+
+	/* move cons.head and its count atomically */
+	do {
+		/* Restore n as it may change every loop */
+		n = max;
+
+		oh.raw = __rte_ring_rts_head_wait(r, &r->cons.rts_head,
+				&r->cons.tail);
+		prod_tail = r->prod.tail;
+		entries = (prod_tail - oh.val.pos);
+
+		/* Set the actual entries for dequeue */
+		if (n > entries) {
+			if (behavior == RTE_RING_QUEUE_FIXED) {
+				__RING_STAT_ADD(r, deq_fail, n);
+				return -ENOENT;
+			}
+			else {
+				if (unlikely(entries == 0)){
+					__RING_STAT_ADD(r, deq_fail, n);
+					return 0;
+				}
+
+				n = entries;
+			}
 		}
-	}
-	r->prod.tail = prod_next;
-	return ret;
+
+		nh.val.pos = oh.val.pos + n;
+		nh.val.cnt = oh.val.cnt + 1;
+	} while (unlikely(rte_atomic64_cmpset(&r->cons.rts_head.raw, oh.raw,
+					      nh.raw) == 0));
+
+	/* copy in table */
+	__rte_ring_dequeue_elems(r, oh.val.pos, obj_table, esize, n);
+	rte_compiler_barrier();
+
+	__RING_STAT_ADD(r, deq_success, n);
+	__rte_ring_rts_update_tail(&r->cons.rts_head, &r->cons.rts_tail);
+
+	return behavior == RTE_RING_QUEUE_FIXED ? 0 : n;
 }
 
 /**
- * @internal Enqueue several objects on a ring (NOT multi-producers safe).
+ * @internal Enqueue several objects of any size on the ring.
+ *
+ * With several producers, this function uses a "compare and set"
+ * instruction to move the producer index atomically, and the relaxed tail
+ * synchronization if the ring was created with RING_F_MP_RTS_ENQ.
  *
  * @param r
  *   A pointer to the ring structure.
  * @param obj_table
- *   A pointer to a table of void * pointers (objects).
+ *   A pointer to a table of objects of esize bytes.
+ * @param esize
+ *   The size of the objects, in bytes: a multiple of 4, equal to the
+ *   element size the ring was created with.
  * @param n
  *   The number of objects to add in the ring from the obj_table.
  * @param behavior
  *   RTE_RING_QUEUE_FIXED:    Enqueue a fixed number of items from a ring
  *   RTE_RING_QUEUE_VARIABLE: Enqueue as many items a possible from ring
+ * @param is_sp
+ *   Non-zero if there is a single producer, zero if the enqueue must be
+ *   multi-producers safe.
  * @return
  *   Depend on the behavior value
  *   if behavior = RTE_RING_QUEUE_FIXED
@@ -513,51 +917,69 @@ __rte_ring_mp_do_enqueue(struct rte_ring *r, void * const *obj_table,
  *   - n: Actual number of objects enqueued.
  */
 static inline int __attribute__((always_inline))
-__rte_ring_sp_do_enqueue(struct rte_ring *r, void * const *obj_table,
-			 unsigned n, enum rte_ring_queue_behavior behavior)
+__rte_ring_do_enqueue_elem(struct rte_ring *r, const void *obj_table,
+		unsigned esize, unsigned n,
+		enum rte_ring_queue_behavior behavior, int is_sp)
 {
-	uint32_t prod_head, cons_tail;
-	uint32_t prod_next, free_entries;
-	unsigned i;
+	uint32_t prod_head, prod_next;
+	uint32_t cons_tail, free_entries;
+	const unsigned max = n;
+	int success;
+	unsigned rep = 0;
 	uint32_t mask = r->prod.mask;
 	int ret;
 
-	prod_head = r->prod.head;
-	cons_tail = r->cons.tail;
-	/* The subtraction is done between two unsigned 32bits value
-	 * (the result is always modulo 32 bits even if we have
-	 * prod_head > cons_tail). So 'free_entries' is always between 0
-	 * and size(ring)-1. */
-	free_entries = mask + cons_tail - prod_head;
-
-	/* check that we have enough room in ring */
-	if (unlikely(n > free_entries)) {
-		if (behavior == RTE_RING_QUEUE_FIXED) {
-			__RING_STAT_ADD(r, enq_fail, n);
-			return -ENOBUFS;
-		}
-		else {
-			/* No free entry available */
-			if (unlikely(free_entries == 0)) {
+	if (!is_sp && (r->flags & RING_F_MP_RTS_ENQ))
+		return __rte_ring_rts_do_enqueue_elem(r, obj_table, esize, n,
+				behavior);
+
+	/* move prod.head, atomically if there are several producers */
+	do {
+		/* Reset n to the initial burst count */
+		n = max;
+
+		prod_head = r->prod.head;
+		cons_tail = r->cons.tail;
+		/* The subtraction is done between two unsigned 32bits value
+		 * (the result is always modulo 32 bits even if we have
+		 * prod_head > cons_tail). So 'free_entries' is always between 0
+		 * and size(ring)-1. */
+		free_entries = (mask + cons_tail - prod_head);
+
+		/* check that we have enough room in ring */
+		if (unlikely(n > free_entries)) {
+			if (behavior == RTE_RING_QUEUE_FIXED) {
 				__RING_STAT_ADD(r, enq_fail, n);
-				return 0;
+				return -ENOBUFS;
 			}
+			else {
+				/* No free entry available */
+				if (unlikely(free_entries == 0)) {
+					__RING_STAT_ADD(r, enq_fail, n);
+					return 0;
+				}
 
-			n = free_entries;
+				n = free_entries;
+			}
 		}
-	}
 
-	prod_next = prod_head + n;
-	r->prod.head = prod_next;
+		prod_next = prod_head + n;
+		if (is_sp) {
+			r->prod.head = prod_next;
+			success = 1;
+		} else
+			success = rte_atomic32_cmpset(&r->prod.head, prod_head,
+						      prod_next);
+	} while (unlikely(success == 0));
 
 	/* write entries in ring */
-	ENQUEUE_PTRS();
+	__rte_ring_enqueue_elems(r, prod_head, obj_table, esize, n);
 	rte_compiler_barrier();
 
 	/* if we exceed the watermark */
 	if (unlikely(((mask + 1) - free_entries + n) > r->prod.watermark)) {
 		ret = (behavior == RTE_RING_QUEUE_FIXED) ? -EDQUOT :
-			(int)(n | RTE_RING_QUOT_EXCEED);
+				(int)(n | RTE_RING_QUOT_EXCEED);
 		__RING_STAT_ADD(r, enq_quota, n);
 	}
 	else {
@@ -565,27 +987,48 @@ __rte_ring_sp_do_enqueue(struct rte_ring *r, void * const *obj_table,
 		__RING_STAT_ADD(r, enq_success, n);
 	}
 
+	/*
+	 * If there are other enqueues in progress that preceded us,
+	 * we need to wait for them to complete
+	 */
+	while (!is_sp && unlikely(r->prod.tail != prod_head)) {
+		rte_pause();
+
+		/* Set RTE_RING_PAUSE_REP_COUNT to avoid spin too long waiting
+		 * for other thread finish. It gives pre-empted thread a chance
+		 * to proceed and finish with ring dequeue operation. */
+		if (RTE_RING_PAUSE_REP_COUNT &&
+		    ++rep == RTE_RING_PAUSE_REP_COUNT) {
+			rep = 0;
+			sched_yield();
+		}
+	}
 	r->prod.tail = prod_next;
 	return ret;
 }
 
 /**
- * @internal Dequeue several objects from a ring (multi-consumers safe). When
- * the request objects are more than the available objects, only dequeue the
- * actual number of objects
+ * @internal Dequeue several objects of any size from the ring.
  *
- * This function uses a "compare and set" instruction to move the
- * consumer index atomically.
+ * With several consumers, this function uses a "compare and set"
+ * instruction to move the consumer index atomically, and the relaxed tail
+ * synchronization if the ring was created with RING_F_MC_RTS_DEQ.
  *
  * @param r
  *   A pointer to the ring structure.
  * @param obj_table
- *   A pointer to a table of void * pointers (objects) that will be filled.
+ *   A pointer to a table of objects of esize bytes that will be filled.
+ * @param esize
+ *   The size of the objects, in bytes: a multiple of 4, equal to the
+ *   element size the ring was created with.
  * @param n
  *   The number of objects to dequeue from the ring to the obj_table.
  * @param behavior
  *   RTE_RING_QUEUE_FIXED:    Dequeue a fixed number of items from a ring
  *   RTE_RING_QUEUE_VARIABLE: Dequeue as many items a possible from ring
+ * @param is_sc
+ *   Non-zero if there is a single consumer, zero if the dequeue must be
+ *   multi-consumers safe.
  * @return
  *   Depend on the behavior value
  *   if behavior = RTE_RING_QUEUE_FIXED
@@ -595,19 +1038,22 @@ __rte_ring_sp_do_enqueue(struct rte_ring *r, void * const *obj_table,
  *   if behavior = RTE_RING_QUEUE_VARIABLE
  *   - n: Actual number of objects dequeued.
  */
-
 static inline int __attribute__((always_inline))
-__rte_ring_mc_do_dequeue(struct rte_ring *r, void **obj_table,
-		 unsigned n, enum rte_ring_queue_behavior behavior)
+__rte_ring_do_dequeue_elem(struct rte_ring *r, void *obj_table,
+		unsigned esize, unsigned n,
+		enum rte_ring_queue_behavior behavior, int is_sc)
 {
 	uint32_t cons_head, prod_tail;
 	uint32_t cons_next, entries;
 	const unsigned max = n;
 	int success;
-	unsigned i, rep = 0;
-	uint32_t mask = r->prod.mask;
+	unsigned rep = 0;
+
+	if (!is_sc && (r->flags & RING_F_MC_RTS_DEQ))
+		return __rte_ring_rts_do_dequeue_elem(r, obj_table, esize, n,
+				behavior);
 
-	/* move cons.head atomically */
+	/* move cons.head, atomically if there are several consumers */
 	do {
 		/* Restore n as it may change every loop */
 		n = max;
@@ -637,19 +1083,23 @@ __rte_ring_mc_do_dequeue(struct rte_ring *r, void **obj_table,
 		}
 
 		cons_next = cons_head + n;
-		success = rte_atomic32_cmpset(&r->cons.head, cons_head,
-					      cons_next);
+		if (is_sc) {
+			r->cons.head = cons_next;
+			success = 1;
+		} else
+			success = rte_atomic32_cmpset(&r->cons.head, cons_head,
+						      cons_next);
 	} while (unlikely(success == 0));
 
 	/* copy in table */
-	DEQUEUE_PTRS();
+	__rte_ring_dequeue_elems(r, cons_head, obj_table, esize, n);
 	rte_compiler_barrier();
 
 	/*
 	 * If there are other dequeues in progress that preceded us,
 	 * we need to wait for them to complete
 	 */
-	while (unlikely(r->cons.tail != cons_head)) {
+	while (!is_sc && unlikely(r->cons.tail != cons_head)) {
 		rte_pause();
 
 		/* Set RTE_RING_PAUSE_REP_COUNT to avoid spin too long waiting
@@ -667,6 +1117,103 @@ __rte_ring_mc_do_dequeue(struct rte_ring *r, void **obj_table,
 	return behavior == RTE_RING_QUEUE_FIXED ? 0 : n;
 }
 
+/**
+ * @internal Enqueue several objects on the ring (multi-producers safe).
+ *
+ * This function uses a "compare and set" instruction to move the
+ * producer index atomically.
+ *
+ * @param r
+ *   A pointer to the ring structure.
+ * @param obj_table
+ *   A pointer to a table of void * pointers (objects).
+ * @param n
+ *   The number of objects to add in the ring from the obj_table.
+ * @param behavior
+ *   RTE_RING_QUEUE_FIXED:    Enqueue a fixed number of items from a ring
+ *   RTE_RING_QUEUE_VARIABLE: Enqueue as many items a possible from ring
+ * @return
+ *   Depend on the behavior value
+ *   if behavior = RTE_RING_QUEUE_FIXED
+ *   - 0: Success; objects enqueue.
+ *   - -EDQUOT: Quota exceeded. The objects have been enqueued, but the
+ *     high water mark is exceeded.
+ *   - -ENOBUFS: Not enough room in the ring to enqueue, no object is enqueued.
+ *   if behavior = RTE_RING_QUEUE_VARIABLE
+ *   - n: Actual number of objects enqueued.
+ */
+static inline int __attribute__((always_inline))
+__rte_ring_mp_do_enqueue(struct rte_ring *r, void * const *obj_table,
+			 unsigned n, enum rte_ring_queue_behavior behavior)
+{
+	return __rte_ring_do_enqueue_elem(r, obj_table, sizeof(void *), n,
+			behavior, 0);
+}
+
+/**
+ * @internal Enqueue several objects on a ring (NOT multi-producers safe).
+ *
+ * @param r
+ *   A pointer to the ring structure.
+ * @param obj_table
+ *   A pointer to a table of void * pointers (objects).
+ * @param n
+ *   The number of objects to add in the ring from the obj_table.
+ * @param behavior
+ *   RTE_RING_QUEUE_FIXED:    Enqueue a fixed number of items from a ring
+ *   RTE_RING_QUEUE_VARIABLE: Enqueue as many items a possible from ring
+ * @return
+ *   Depend on the behavior value
+ *   if behavior = RTE_RING_QUEUE_FIXED
+ *   - 0: Success; objects enqueue.
+ *   - -EDQUOT: Quota exceeded. The objects have been enqueued, but the
+ *     high water mark is exceeded.
+ *   - -ENOBUFS: Not enough room in the ring to enqueue, no object is enqueued.
+ *   if behavior = RTE_RING_QUEUE_VARIABLE
+ *   - n: Actual number of objects enqueued.
+ */
+static inline int __attribute__((always_inline))
+__rte_ring_sp_do_enqueue(struct rte_ring *r, void * const *obj_table,
+			 unsigned n, enum rte_ring_queue_behavior behavior)
+{
+	return __rte_ring_do_enqueue_elem(r, obj_table, sizeof(void *), n,
+			behavior, 1);
+}
+
+/**
+ * @internal Dequeue several objects from a ring (multi-consumers safe). When
+ * the request objects are more than the available objects, only dequeue the
+ * actual number of objects
+ *
+ * This function uses a "compare and set" instruction to move the
+ * consumer index atomically.
+ *
+ * @param r
+ *   A pointer to the ring structure.
+ * @param obj_table
+ *   A pointer to a table of void * pointers (objects) that will be filled.
+ * @param n
+ *   The number of objects to dequeue from the ring to the obj_table.
+ * @param behavior
+ *   RTE_RING_QUEUE_FIXED:    Dequeue a fixed number of items from a ring
+ *   RTE_RING_QUEUE_VARIABLE: Dequeue as many items a possible from ring
+ * @return
+ *   Depend on the behavior value
+ *   if behavior = RTE_RING_QUEUE_FIXED
+ *   - 0: Success; objects dequeued.
+ *   - -ENOENT: Not enough entries in the ring to dequeue; no object is
+ *     dequeued.
+ *   if behavior = RTE_RING_QUEUE_VARIABLE
+ *   - n: Actual number of objects dequeued.
+ */
+static inline int __attribute__((always_inline))
+__rte_ring_mc_do_dequeue(struct rte_ring *r, void **obj_table,
+		 unsigned n, enum rte_ring_queue_behavior behavior)
+{
+	return __rte_ring_do_dequeue_elem(r, obj_table, sizeof(void *), n,
+			behavior, 0);
+}
+
 /**
  * @internal Dequeue several objects from a ring (NOT multi-consumers safe).
  * When the request objects are more than the available objects, only dequeue
@@ -694,44 +1241,8 @@ static inline int __attribute__((always_inline))
 __rte_ring_sc_do_dequeue(struct rte_ring *r, void **obj_table,
 		 unsigned n, enum rte_ring_queue_behavior behavior)
 {
-	uint32_t cons_head, prod_tail;
-	uint32_t cons_next, entries;
-	unsigned i;
-	uint32_t mask = r->prod.mask;
-
-	cons_head = r->cons.head;
-	prod_tail = r->prod.tail;
-	/* The subtraction is done between two unsigned 32bits value
-	 * (the result is always modulo 32 bits even if we have
-	 * cons_head > prod_tail). So 'entries' is always between 0
-	 * and size(ring)-1. */
-	entries = prod_tail - cons_head;
-
-	if (n > entries) {
-		if (behavior == RTE_RING_QUEUE_FIXED) {
-			__RING_STAT_ADD(r, deq_fail, n);
-			return -ENOENT;
-		}
-		else {
-			if (unlikely(entries == 0)){
-				__RING_STAT_ADD(r, deq_fail, n);
-				return 0;
-			}
-
-			n = entries;
-		}
-	}
-
-	cons_next = cons_head + n;
-	r->cons.head = cons_next;
-
-	/* copy in table */
-	DEQUEUE_PTRS();
-	rte_compiler_barrier();
-
-	__RING_STAT_ADD(r, deq_success, n);
-	r->cons.tail = cons_next;
-	return behavior == RTE_RING_QUEUE_FIXED ? 0 : n;
+	return __rte_ring_do_dequeue_elem(r, obj_table, sizeof(void *), n,
+			behavior, 1);
 }
 
 /**
@@ -1233,6 +1744,186 @@ rte_ring_dequeue_burst(struct rte_ring *r, void **obj_table, unsigned n)
 		return rte_ring_mc_dequeue_burst(r, obj_table, n);
 }
 
+/**
+ * @internal Reserve objects at the head of a ring, without copying them.
+ *
+ * The consumer head is moved, but not the consumer tail, so the objects
+ * stay in the ring until rte_ring_dequeue_commit() is called. In the
+ * multi-consumers case, the reservation only succeeds if no other one is
+ * waiting for its commit, which serializes the zero-copy dequeues.
+ *
+ * @param r
+ *   A pointer to the ring structure.
+ * @param n
+ *   The maximum number of objects to reserve.
+ * @param zcd
+ *   Filled with the location of the reserved objects in the ring.
+ * @param is_sc
+ *   True for a single consumer.
+ * @return
+ *   - n: Actual number of objects reserved, 0 if the ring is empty or
+ *     another consumer has not committed its dequeue yet.
+ */
+static inline unsigned __attribute__((always_inline))
+__rte_ring_do_dequeue_peek(struct rte_ring *r, unsigned n,
+		struct rte_ring_zc_data *zcd, int is_sc)
+{
+	uint32_t cons_head, prod_tail;
+	uint32_t entries, idx;
+	const unsigned max = n;
+	const uint32_t size = r->cons.size;
+	int success;
+
+	do {
+		/* Restore n as it may change every loop */
+		n = max;
+
+		cons_head = r->cons.head;
+		/* a reservation of another consumer is not committed yet */
+		if (!is_sc && unlikely(r->cons.tail != cons_head)) {
+			__RING_STAT_ADD(r, deq_fail, n);
+			return 0;
+		}
+
+		prod_tail = r->prod.tail;
+		/* The subtraction is done between two unsigned 32bits value
+		 * (the result is always modulo 32 bits even if we have
+		 * cons_head > prod_tail). So 'entries' is always between 0
+		 * and size(ring)-1. */
+		entries = prod_tail - cons_head;
+
+		if (n > entries) {
+			if (unlikely(entries == 0)) {
+				__RING_STAT_ADD(r, deq_fail, n);
+				return 0;
+			}
+
+			n = entries;
+		}
+
+		if (is_sc) {
+			r->cons.head = cons_head + n;
+			success = 1;
+		} else
+			success = rte_atomic32_cmpset(&r->cons.head, cons_head,
+						      cons_head + n);
+	} while (unlikely(success == 0));
+
+	/* the objects must not be read before the producer tail */
+	rte_compiler_barrier();
+
+	idx = cons_head & r->cons.mask;
+	zcd->ptr1 = &r->ring[idx];
+	if (likely(idx + n <= size)) {
+		zcd->n1 = n;
+		zcd->ptr2 = NULL;
+	} else {
+		zcd->n1 = size - idx;
+		zcd->ptr2 = &r->ring[0];
+	}
+
+	return n;
+}
+
+/**
+ * Reserve objects at the head of a ring for a zero-copy dequeue
+ * (NOT multi-consumers safe).
+ *
+ * The objects can be read, or replaced, in place in the ring, as described
+ * by *zcd*, until rte_ring_dequeue_commit() is called. The next call to
+ * this function must follow that commit.
+ *
+ * @param r
+ *   A pointer to the ring structure.
+ * @param n
+ *   The maximum number of objects to reserve.
+ * @param zcd
+ *   Filled with the location of the reserved objects in the ring.
+ * @return
+ *   - n: Actual number of objects reserved, 0 if ring is empty
+ */
+static inline unsigned __attribute__((always_inline))
+rte_ring_sc_dequeue_peek_burst(struct rte_ring *r, unsigned n,
+		struct rte_ring_zc_data *zcd)
+{
+	return __rte_ring_do_dequeue_peek(r, n, zcd, 1);
+}
+
+/**
+ * Reserve objects at the head of a ring for a zero-copy dequeue
+ * (multi-consumers safe).
+ *
+ * This function uses a "compare and set" instruction to move the
+ * consumer head atomically. Only one consumer at a time can hold a
+ * reservation, the others get 0 until it is committed, and all the
+ * consumers of the ring must use the zero-copy dequeue.
+ *
+ * @param r
+ *   A pointer to the ring structure.
+ * @param n
+ *   The maximum number of objects to reserve.
+ * @param zcd
+ *   Filled with the location of the reserved objects in the ring.
+ * @return
+ *   - n: Actual number of objects reserved, 0 if ring is empty or another
+ *     consumer holds a reservation
+ */
+static inline unsigned __attribute__((always_inline))
+rte_ring_mc_dequeue_peek_burst(struct rte_ring *r, unsigned n,
+		struct rte_ring_zc_data *zcd)
+{
+	return __rte_ring_do_dequeue_peek(r, n, zcd, 0);
+}
+
+/**
+ * Reserve objects at the head of a ring for a zero-copy dequeue.
+ *
+ * This function calls the multi-consumers or the single-consumer
+ * version, depending on the default behaviour that was specified at
+ * ring creation time (see flags).
+ *
+ * @param r
+ *   A pointer to the ring structure.
+ * @param n
+ *   The maximum number of objects to reserve.
+ * @param zcd
+ *   Filled with the location of the reserved objects in the ring.
+ * @return
+ *   - Number of objects reserved
+ */
+static inline unsigned __attribute__((always_inline))
+rte_ring_dequeue_peek_burst(struct rte_ring *r, unsigned n,
+		struct rte_ring_zc_data *zcd)
+{
+	return __rte_ring_do_dequeue_peek(r, n, zcd, r->cons.sc_dequeue);
+}
+
+/**
+ * Complete a zero-copy dequeue.
+ *
+ * The first *n* objects reserved by the last call to one of the
+ * rte_ring_*dequeue_peek_burst() functions are removed from the ring, and
+ * their slots given back to the producers. The other reserved objects stay
+ * at the head of the ring, so *n* can be 0 to only inspect the ring.
+ *
+ * @param r
+ *   A pointer to the ring structure.
+ * @param n
+ *   The number of objects to dequeue, at most the number reserved.
+ */
+static inline void __attribute__((always_inline))
+rte_ring_dequeue_commit(struct rte_ring *r, unsigned n)
+{
+	uint32_t cons_next = r->cons.tail + n;
+
+	/* the objects are read before their slots are released */
+	rte_compiler_barrier();
+
+	__RING_STAT_ADD(r, deq_success, n);
+	r->cons.head = cons_next;
+	r->cons.tail = cons_next;
+}
+
 #ifdef __cplusplus
 }
 #endif
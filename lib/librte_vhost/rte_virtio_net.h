@@ -62,6 +62,13 @@
 /* Enum for virtqueue management. */
 enum {VIRTIO_RXQ, VIRTIO_TXQ, VIRTIO_QNUM};
 
+/**
+ * Maximum number of queue pairs of a device. The RX and TX virtqueues of
+ * the queue pair n have the indexes n * VIRTIO_QNUM + VIRTIO_RXQ and
+ * n * VIRTIO_QNUM + VIRTIO_TXQ.
+ */
+#define VHOST_MAX_QUEUE_PAIRS 8
+
 #define BUF_VECTOR_MAX 256
 
 /**
@@ -74,6 +81,34 @@ struct buf_vector {
 	uint32_t desc_idx;
 };
 
+/** Number of blocks of the guest address translation cache of a virtqueue. */
+#define VHOST_GPA_CACHE_SIZE 128
+/** Size of the guest memory blocks of the translation cache, as a power of 2. */
+#define VHOST_GPA_CACHE_SHIFT 21
+
+/**
+ * Cache of the memory regions of the guest physical addresses translated
+ * on a virtqueue: the region of the last address, then a direct-mapped
+ * cache of the region of the last address of each block of
+ * VHOST_GPA_CACHE_SHIFT bits. The regions are stored as their index plus
+ * one, 0 if unknown. They are only hints, checked against the region bounds,
+ * so that several cores can update the cache of a queue. The cache is
+ * emptied by zeroing it.
+ */
+struct vhost_gpa_cache {
+	uint16_t	last_region;	/**< Region of the last address. */
+	uint16_t	regions[VHOST_GPA_CACHE_SIZE];	/**< Region of the last address of each block. */
+};
+
+/**
+ * Guest TX buffer dequeued without copy. It stays in flight, and its
+ * descriptor out of the used ring, until the mbuf attached to it is freed.
+ */
+struct vhost_zcopy_buf {
+	struct rte_mbuf_ext_shared_info shinfo;	/**< Shared data of the attached guest buffer. */
+	volatile uint8_t	done;		/**< Set when the mbuf is freed. */
+};
+
 /**
  * Structure contains variables relevant to RX/TX virtqueues.
  */
@@ -88,16 +123,38 @@ struct vhost_virtqueue {
 	volatile uint16_t	last_used_idx_res;	/**< Used for multiple devices reserving buffers. */
 	eventfd_t		callfd;			/**< Used to notify the guest (trigger interrupt). */
 	eventfd_t		kickfd;			/**< Currently unused as polling mode is enabled. */
+	volatile int		enabled;		/**< Queue is enabled by the guest. */
+	struct vhost_zcopy_buf	*zbufs;			/**< Zero copy buffers, indexed by head descriptor. */
+	uint16_t		*zbufs_inflight;	/**< Head descriptors of the zero copy buffers in flight. */
+	uint16_t		nr_zbufs_inflight;	/**< Number of zero copy buffers in flight. */
+	struct vhost_gpa_cache	gpa_cache;		/**< Guest address translation cache. */
+	uint16_t		signalled_used;		/**< Used index at the last notification of the guest. */
+	uint64_t		last_notify;		/**< TSC of the last notification of the guest. */
 	struct buf_vector	buf_vec[BUF_VECTOR_MAX];	/**< for scatter RX. */
 } __rte_cache_aligned;
 
+/**
+ * Part of the guest memory that is physically contiguous in the host.
+ */
+struct vhost_guest_page {
+	uint64_t	guest_phys_addr;	/**< Base guest physical address of the page. */
+	uint64_t	host_phys_addr;		/**< Base host physical address of the page. */
+	uint64_t	size;			/**< Size of the page. */
+};
+
 /**
  * Device structure contains all configuration information relating to the device.
  */
 struct virtio_net {
-	struct vhost_virtqueue	*virtqueue[VIRTIO_QNUM];	/**< Contains all virtqueue information. */
+	struct vhost_virtqueue	*virtqueue[VHOST_MAX_QUEUE_PAIRS * VIRTIO_QNUM];	/**< Contains all virtqueue information. */
+	uint32_t		virt_qp_nb;	/**< Number of queue pairs set up by the guest. */
+	uint32_t		dequeue_zcopy_len;	/**< Minimum length of the packets dequeued without copy, 0 if disabled. */
 	struct virtio_memory	*mem;		/**< QEMU memory and memory region information. */
+	struct vhost_guest_page	*guest_pages;	/**< Host physical pages of the guest memory, sorted by guest address. */
+	uint32_t		nr_guest_pages;	/**< Number of host physical pages of the guest memory. */
+	uint64_t		notify_window;	/**< Minimum TSC cycles between two notifications of the guest on a queue. */
 	uint64_t		features;	/**< Negotiated feature set. */
+	uint64_t		protocol_features;	/**< Negotiated vhost-user protocol features. */
 	uint64_t		device_fh;	/**< device identifier. */
 	uint32_t		flags;		/**< Device flags. Only used to check if device is running on data core. */
 #define IF_NAME_SZ (PATH_MAX > IFNAMSIZ ? PATH_MAX : IFNAMSIZ)
@@ -118,7 +175,8 @@ struct virtio_memory_regions {
 
 
 /**
- * Memory structure includes region and mapping information.
+ * Memory structure includes region and mapping information. The regions are
+ * sorted by guest physical address.
  */
 struct virtio_memory {
 	uint64_t	base_address;	/**< Base QEMU userspace address of the memory file. */
@@ -138,6 +196,9 @@ struct virtio_memory {
 struct virtio_net_device_ops {
 	int (*new_device)(struct virtio_net *);	/**< Add device. */
 	void (*destroy_device)(volatile struct virtio_net *);	/**< Remove device. */
+	/** Queue enabled or disabled by the guest, optional. */
+	int (*vring_state_changed)(struct virtio_net *dev, uint16_t queue_id,
+		int enable);
 };
 
 static inline uint16_t __attribute__((always_inline))
@@ -147,6 +208,30 @@ rte_vring_available_entries(struct virtio_net *dev, uint16_t queue_id)
 	return *(volatile uint16_t *)&vq->avail->idx - vq->last_used_idx_res;
 }
 
+/**
+ * Function to find the memory region of a guest physical address, with a
+ * binary search of the sorted regions. Returns NULL if it is in none.
+ */
+static inline struct virtio_memory_regions * __attribute__((always_inline))
+gpa_to_region(struct virtio_net *dev, uint64_t guest_pa)
+{
+	struct virtio_memory_regions *region;
+	uint32_t low = 0, high = dev->mem->nregions;
+	uint32_t mid;
+
+	while (low < high) {
+		mid = (low + high) / 2;
+		region = &dev->mem->regions[mid];
+		if (guest_pa < region->guest_phys_address)
+			high = mid;
+		else if (guest_pa >= region->guest_phys_address_end)
+			low = mid + 1;
+		else
+			return region;
+	}
+	return NULL;
+}
+
 /**
  * Function to convert guest physical addresses to vhost virtual addresses.
  * This is used to convert guest virtio buffer addresses.
@@ -155,18 +240,11 @@ static inline uint64_t __attribute__((always_inline))
 gpa_to_vva(struct virtio_net *dev, uint64_t guest_pa)
 {
 	struct virtio_memory_regions *region;
-	uint32_t regionidx;
-	uint64_t vhost_va = 0;
-
-	for (regionidx = 0; regionidx < dev->mem->nregions; regionidx++) {
-		region = &dev->mem->regions[regionidx];
-		if ((guest_pa >= region->guest_phys_address) &&
-			(guest_pa <= region->guest_phys_address_end)) {
-			vhost_va = region->address_offset + guest_pa;
-			break;
-		}
-	}
-	return vhost_va;
+
+	region = gpa_to_region(dev, guest_pa);
+	if (region == NULL)
+		return 0;
+	return region->address_offset + guest_pa;
 }
 
 /**
@@ -182,8 +260,55 @@ int rte_vhost_feature_enable(uint64_t feature_mask);
 /* Returns currently supported vhost features */
 uint64_t rte_vhost_feature_get(void);
 
+/**
+ * Set the minimum length of the guest packets that rte_vhost_dequeue_burst()
+ * returns without copying them, for the vhost-user devices connected after
+ * the call. Zero copy is disabled by default.
+ *
+ * Such a packet is returned in an mbuf attached to the guest buffer, which
+ * is given back to the guest when the mbuf is freed, on a later call to
+ * rte_vhost_dequeue_burst() on the same queue. Smaller packets, packets in
+ * several guest buffers and buffers that are not physically contiguous in
+ * the host are still copied. The guest buffers are only available to the
+ * guest once their mbufs are freed, so the application must not hold them
+ * for long, and must free them before its destroy_device callback returns.
+ *
+ * Finding the host physical addresses of the guest memory needs to read
+ * /proc/self/pagemap, it is done for each guest memory page when the memory
+ * is set, so guests should use hugepages.
+ *
+ * @param min_len
+ *  Minimum length of the packets dequeued without copy, 0 to disable zero
+ *  copy.
+ * @return
+ *  0 on success.
+ */
+int rte_vhost_dequeue_zero_copy_set(uint32_t min_len);
+
 int rte_vhost_enable_guest_notification(struct virtio_net *dev, uint16_t queue_id, int enable);
 
+/**
+ * Set the coalescing window of the notifications sent to the guest when
+ * buffers are added to the used rings of a device. A queue notifies the
+ * guest at most once per window; a notification that comes too early is
+ * sent by the next rte_vhost_enqueue_burst() or rte_vhost_dequeue_burst()
+ * on the queue, which may be called with no packets for that purpose. The
+ * window is reset when the device is created, it is usually set from the
+ * new_device callback.
+ *
+ * The guest can also ask to be notified only after a given used index,
+ * with the VIRTIO_RING_F_EVENT_IDX feature.
+ *
+ * @param dev
+ *  vhost device.
+ * @param usecs
+ *  Minimum time between two notifications of a queue in microseconds,
+ *  0 to notify the guest as soon as possible.
+ * @return
+ *  0 on success.
+ */
+int rte_vhost_notify_window_set(struct virtio_net *dev, uint32_t usecs);
+
 /* Register vhost driver. dev_name could be different for multiple instance support. */
 int rte_vhost_driver_register(const char *dev_name);
 
@@ -192,13 +317,39 @@ int rte_vhost_driver_callback_register(struct virtio_net_device_ops const * cons
 /* Start vhost driver session blocking loop. */
 int rte_vhost_driver_session_start(void);
 
+/**
+ * Unregister a vhost driver registered with rte_vhost_driver_register().
+ * The socket is closed and removed, the devices that are connected to it
+ * stay until their connection is closed.
+ *
+ * @param dev_name
+ *  The path of the socket.
+ * @return
+ *  0 on success, -1 if no driver is registered with this path.
+ */
+int rte_vhost_driver_unregister(const char *dev_name);
+
+/**
+ * Get the number of queue pairs of a device, which is the number of
+ * queue pairs set up by the guest. It is 1 unless VIRTIO_NET_F_MQ was
+ * negotiated.
+ *
+ * @param dev
+ *  The virtio device.
+ * @return
+ *  The number of queue pairs.
+ */
+uint32_t rte_vhost_get_queue_num(struct virtio_net *dev);
+
 /**
  * This function adds buffers to the virtio devices RX virtqueue. Buffers can
  * be received from the physical port or from another virtual device. A packet
  * count is returned to indicate the number of packets that were succesfully
  * added to the RX queue.
+ * Different lcores can serve different queue pairs of a device at the
+ * same time.
  * @param queue_id
- *  virtio queue index in mq case
+ *  virtio queue index: queue_pair * VIRTIO_QNUM + VIRTIO_RXQ
  * @return
  *  num of packets enqueued
  */
@@ -211,8 +362,9 @@ uint16_t rte_vhost_enqueue_burst(struct virtio_net *dev, uint16_t queue_id,
  * store them in pkts to be processed.
  * @param mbuf_pool
  *  mbuf_pool where host mbuf is allocated.
+ * Only one lcore may dequeue from a queue at a time.
  * @param queue_id
- *  virtio queue index in mq case.
+ *  virtio queue index: queue_pair * VIRTIO_QNUM + VIRTIO_TXQ
  * @return
  *  num of packets dequeued
  */
@@ -45,6 +45,13 @@
 
 extern struct vhost_net_device_ops const *ops;
 
+#ifndef VIRTIO_NET_F_MQ
+#define VIRTIO_NET_F_MQ 22
+#endif
+
+/* Feature bit of vhost-user telling that protocol features are supported. */
+#define VHOST_USER_F_PROTOCOL_FEATURES 30
+
 /* Macros for printing using RTE_LOG */
 #define RTE_LOGTYPE_VHOST_CONFIG RTE_LOGTYPE_USER1
 #define RTE_LOGTYPE_VHOST_DATA   RTE_LOGTYPE_USER1
@@ -419,3 +419,15 @@ rte_vhost_driver_session_start(void)
 
 	return 0;
 }
+
+/**
+ * The character device of vhost-cuse lives as long as the CUSE session,
+ * it can't be unregistered.
+ */
+int
+rte_vhost_driver_unregister(const char *dev_name)
+{
+	RTE_LOG(ERR, VHOST_CONFIG,
+		"vhost-cuse device %s can't be unregistered\n", dev_name);
+	return -1;
+}
@@ -262,6 +262,17 @@ host_memory_map(pid_t pid, uint64_t addr,
 	return 0;
 }
 
+static int
+mem_region_cmp(const void *p1, const void *p2)
+{
+	const struct virtio_memory_regions *region1 = p1;
+	const struct virtio_memory_regions *region2 = p2;
+
+	if (region1->guest_phys_address < region2->guest_phys_address)
+		return -1;
+	return region1->guest_phys_address > region2->guest_phys_address;
+}
+
 int
 cuse_set_mem_table(struct vhost_device_ctx ctx,
 	const struct vhost_memory *mem_regions_addr, uint32_t nregions)
@@ -371,6 +382,11 @@ cuse_set_mem_table(struct vhost_device_ctx ctx,
 	}
 	dev->mem->nregions = valid_regions;
 
+	/* The regions are sorted for the address translation. */
+	qsort(pregion, valid_regions, sizeof(struct virtio_memory_regions),
+		mem_region_cmp);
+	reset_gpa_cache(dev);
+
 	return 0;
 }
 
@@ -34,6 +34,7 @@
 #include <stdint.h>
 #include <linux/virtio_net.h>
 
+#include <rte_cycles.h>
 #include <rte_mbuf.h>
 #include <rte_memcpy.h>
 #include <rte_virtio_net.h>
@@ -42,6 +43,115 @@
 
 #define MAX_PKT_BURST 32
 
+/*
+ * Check that a queue index is the RX (is_tx == 0) or TX (is_tx == 1)
+ * virtqueue of one of the queue pairs of the device.
+ */
+static inline int __attribute__((always_inline))
+is_valid_virt_queue_idx(uint32_t idx, int is_tx, uint32_t virtq_num)
+{
+	return (is_tx ^ (idx & 1)) == 0 && idx < virtq_num * VIRTIO_QNUM;
+}
+
+/*
+ * Used event index of a virtqueue: with VIRTIO_RING_F_EVENT_IDX, the guest
+ * is notified once the used index passes it.
+ */
+static inline uint16_t __attribute__((always_inline))
+vq_used_event(struct vhost_virtqueue *vq)
+{
+	return *(volatile uint16_t *)&vq->avail->ring[vq->size];
+}
+
+/*
+ * Notify the guest of the buffers added to the used ring of a virtqueue,
+ * if it asked for it: with VIRTIO_RING_F_EVENT_IDX when the used index
+ * passes its used event index, otherwise unless it set
+ * VRING_AVAIL_F_NO_INTERRUPT. Within the coalescing window of the last
+ * notification, the notification is left pending for a next call.
+ */
+static inline void __attribute__((always_inline))
+vhost_notify_guest(struct virtio_net *dev, struct vhost_virtqueue *vq)
+{
+	uint16_t new_idx, old_idx;
+
+	new_idx = *(volatile uint16_t *)&vq->used->idx;
+	old_idx = vq->signalled_used;
+	if (new_idx == old_idx)
+		return;
+
+	if (dev->notify_window != 0 &&
+			rte_rdtsc() - vq->last_notify < dev->notify_window)
+		return;
+
+	vq->signalled_used = new_idx;
+	if (dev->features & (1ULL << VIRTIO_RING_F_EVENT_IDX)) {
+		/* The guest must see the used index before it is compared. */
+		rte_mb();
+		if (!vring_need_event(vq_used_event(vq), new_idx, old_idx))
+			return;
+	} else if (vq->avail->flags & VRING_AVAIL_F_NO_INTERRUPT)
+		return;
+
+	vq->last_notify = rte_rdtsc();
+	eventfd_write((int)vq->callfd, 1);
+}
+
+/*
+ * Send the notification left pending by the coalescing window, if any,
+ * when there is nothing to enqueue or dequeue.
+ */
+static inline void __attribute__((always_inline))
+vhost_notify_pending(struct virtio_net *dev, struct vhost_virtqueue *vq)
+{
+	if (unlikely(dev->notify_window != 0))
+		vhost_notify_guest(dev, vq);
+}
+
+/*
+ * Convert a guest physical address to a vhost virtual address, with the
+ * translation cache of the virtqueue. Returns 0 if it is in no region.
+ */
+static inline uint64_t __attribute__((always_inline))
+vq_gpa_to_vva(struct virtio_net *dev, struct vhost_virtqueue *vq,
+	uint64_t guest_pa)
+{
+	struct vhost_gpa_cache *cache = &vq->gpa_cache;
+	struct virtio_memory_regions *region;
+	uint16_t *block_region;
+	uint16_t idx;
+
+	/* Most buffers are in the region of the previous one. */
+	idx = cache->last_region;
+	if (likely(idx != 0)) {
+		region = &dev->mem->regions[idx - 1];
+		if (likely(guest_pa - region->guest_phys_address <
+				region->memory_size))
+			return region->address_offset + guest_pa;
+	}
+
+	block_region = &cache->regions[(guest_pa >> VHOST_GPA_CACHE_SHIFT) &
+		(VHOST_GPA_CACHE_SIZE - 1)];
+	idx = *block_region;
+	if (idx != 0) {
+		region = &dev->mem->regions[idx - 1];
+		if (likely(guest_pa - region->guest_phys_address <
+				region->memory_size)) {
+			cache->last_region = idx;
+			return region->address_offset + guest_pa;
+		}
+	}
+
+	region = gpa_to_region(dev, guest_pa);
+	if (unlikely(region == NULL))
+		return 0;
+
+	idx = (uint16_t)(region - dev->mem->regions + 1);
+	cache->last_region = idx;
+	*block_region = idx;
+	return region->address_offset + guest_pa;
+}
+
 /**
  * This function adds buffers to the virtio devices RX virtqueue. Buffers can
  * be received from the physical port or from another virtio device. A packet
@@ -67,12 +177,16 @@ virtio_dev_rx(struct virtio_net *dev, uint16_t queue_id,
 	uint8_t success = 0;
 
 	LOG_DEBUG(VHOST_DATA, "(%"PRIu64") virtio_dev_rx()\n", dev->device_fh);
-	if (unlikely(queue_id != VIRTIO_RXQ)) {
-		LOG_DEBUG(VHOST_DATA, "mq isn't supported in this version.\n");
+	if (unlikely(!is_valid_virt_queue_idx(queue_id, 0, dev->virt_qp_nb))) {
+		RTE_LOG(ERR, VHOST_DATA, "%s (%"PRIu64"): invalid virtqueue idx:%d\n",
+			__func__, dev->device_fh, queue_id);
 		return 0;
 	}
 
-	vq = dev->virtqueue[VIRTIO_RXQ];
+	vq = dev->virtqueue[queue_id];
+	if (unlikely(vq->enabled == 0))
+		return 0;
+
 	count = (count > MAX_PKT_BURST) ? MAX_PKT_BURST : count;
 
 	/*
@@ -88,8 +202,10 @@ virtio_dev_rx(struct virtio_net *dev, uint16_t queue_id,
 		if (unlikely(count > free_entries))
 			count = free_entries;
 
-		if (count == 0)
+		if (count == 0) {
+			vhost_notify_pending(dev, vq);
 			return 0;
+		}
 
 		res_end_idx = res_base_idx + count;
 		/* vq->last_used_idx_res is atomically updated. */
@@ -119,7 +235,7 @@ virtio_dev_rx(struct virtio_net *dev, uint16_t queue_id,
 		buff = pkts[packet_success];
 
 		/* Convert from gpa to vva (guest physical addr -> vhost virtual addr) */
-		buff_addr = gpa_to_vva(dev, desc->addr);
+		buff_addr = vq_gpa_to_vva(dev, vq, desc->addr);
 		/* Prefetch buffer address. */
 		rte_prefetch0((void *)(uintptr_t)buff_addr);
 
@@ -135,7 +251,7 @@ virtio_dev_rx(struct virtio_net *dev, uint16_t queue_id,
 			desc->len = vq->vhost_hlen;
 			desc = &vq->desc[desc->next];
 			/* Buffer address translation. */
-			buff_addr = gpa_to_vva(dev, desc->addr);
+			buff_addr = vq_gpa_to_vva(dev, vq, desc->addr);
 			desc->len = rte_pktmbuf_data_len(buff);
 		} else {
 			buff_addr += vq->vhost_hlen;
@@ -178,15 +294,13 @@ virtio_dev_rx(struct virtio_net *dev, uint16_t queue_id,
 	*(volatile uint16_t *)&vq->used->idx += count;
 	vq->last_used_idx = res_end_idx;
 
-	/* Kick the guest if necessary. */
-	if (!(vq->avail->flags & VRING_AVAIL_F_NO_INTERRUPT))
-		eventfd_write((int)vq->callfd, 1);
+	vhost_notify_guest(dev, vq);
 	return count;
 }
 
 static inline uint32_t __attribute__((always_inline))
-copy_from_mbuf_to_vring(struct virtio_net *dev, uint16_t res_base_idx,
-	uint16_t res_end_idx, struct rte_mbuf *pkt)
+copy_from_mbuf_to_vring(struct virtio_net *dev, uint16_t queue_id,
+	uint16_t res_base_idx, uint16_t res_end_idx, struct rte_mbuf *pkt)
 {
 	uint32_t vec_idx = 0;
 	uint32_t entry_success = 0;
@@ -214,9 +328,9 @@ copy_from_mbuf_to_vring(struct virtio_net *dev, uint16_t res_base_idx,
 	 * Convert from gpa to vva
 	 * (guest physical addr -> vhost virtual addr)
 	 */
-	vq = dev->virtqueue[VIRTIO_RXQ];
+	vq = dev->virtqueue[queue_id];
 	vb_addr =
-		gpa_to_vva(dev, vq->buf_vec[vec_idx].buf_addr);
+		vq_gpa_to_vva(dev, vq, vq->buf_vec[vec_idx].buf_addr);
 	vb_hdr_addr = vb_addr;
 
 	/* Prefetch buffer address. */
@@ -259,7 +373,7 @@ copy_from_mbuf_to_vring(struct virtio_net *dev, uint16_t res_base_idx,
 
 		vec_idx++;
 		vb_addr =
-			gpa_to_vva(dev, vq->buf_vec[vec_idx].buf_addr);
+			vq_gpa_to_vva(dev, vq, vq->buf_vec[vec_idx].buf_addr);
 
 		/* Prefetch buffer address. */
 		rte_prefetch0((void *)(uintptr_t)vb_addr);
@@ -304,7 +418,7 @@ copy_from_mbuf_to_vring(struct virtio_net *dev, uint16_t res_base_idx,
 			}
 
 			vec_idx++;
-			vb_addr = gpa_to_vva(dev,
+			vb_addr = vq_gpa_to_vva(dev, vq,
 				vq->buf_vec[vec_idx].buf_addr);
 			vb_offset = 0;
 			vb_avail = vq->buf_vec[vec_idx].buf_len;
@@ -348,7 +462,7 @@ copy_from_mbuf_to_vring(struct virtio_net *dev, uint16_t res_base_idx,
 
 					/* Get next buffer from buf_vec. */
 					vec_idx++;
-					vb_addr = gpa_to_vva(dev,
+					vb_addr = vq_gpa_to_vva(dev, vq,
 						vq->buf_vec[vec_idx].buf_addr);
 					vb_avail =
 						vq->buf_vec[vec_idx].buf_len;
@@ -390,7 +504,9 @@ copy_from_mbuf_to_vring(struct virtio_net *dev, uint16_t res_base_idx,
 }
 
 /*
- * This function works for mergeable RX.
+ * This function works for mergeable RX. The buffers of all the packets are
+ * reserved at once, and they are added to the used ring with a single
+ * update of its index.
  */
 static inline uint32_t __attribute__((always_inline))
 virtio_dev_merge_rx(struct virtio_net *dev, uint16_t queue_id,
@@ -400,73 +516,89 @@ virtio_dev_merge_rx(struct virtio_net *dev, uint16_t queue_id,
 	uint32_t pkt_idx = 0, entry_success = 0;
 	uint16_t avail_idx, res_cur_idx;
 	uint16_t res_base_idx, res_end_idx;
+	uint16_t pkt_end_idx[MAX_PKT_BURST];
 	uint8_t success = 0;
 
 	LOG_DEBUG(VHOST_DATA, "(%"PRIu64") virtio_dev_merge_rx()\n",
 		dev->device_fh);
-	if (unlikely(queue_id != VIRTIO_RXQ)) {
-		LOG_DEBUG(VHOST_DATA, "mq isn't supported in this version.\n");
+	if (unlikely(!is_valid_virt_queue_idx(queue_id, 0, dev->virt_qp_nb))) {
+		RTE_LOG(ERR, VHOST_DATA, "%s (%"PRIu64"): invalid virtqueue idx:%d\n",
+			__func__, dev->device_fh, queue_id);
+		return 0;
 	}
 
-	vq = dev->virtqueue[VIRTIO_RXQ];
-	count = RTE_MIN((uint32_t)MAX_PKT_BURST, count);
-
-	if (count == 0)
+	vq = dev->virtqueue[queue_id];
+	if (unlikely(vq->enabled == 0))
 		return 0;
 
-	for (pkt_idx = 0; pkt_idx < count; pkt_idx++) {
-		uint32_t secure_len = 0;
-		uint16_t need_cnt;
-		uint32_t vec_idx = 0;
-		uint32_t pkt_len = pkts[pkt_idx]->pkt_len + vq->vhost_hlen;
-		uint16_t i, id;
+	count = RTE_MIN((uint32_t)MAX_PKT_BURST, count);
 
-		do {
-			/*
-			 * As many data cores may want access to available
-			 * buffers, they need to be reserved.
-			 */
-			res_base_idx = vq->last_used_idx_res;
-			res_cur_idx = res_base_idx;
+	do {
+		/*
+		 * As many data cores may want access to available
+		 * buffers, they need to be reserved.
+		 */
+		res_base_idx = vq->last_used_idx_res;
+		res_cur_idx = res_base_idx;
+		avail_idx = *((volatile uint16_t *)&vq->avail->idx);
+
+		for (pkt_idx = 0; pkt_idx < count; pkt_idx++) {
+			uint32_t secure_len = 0;
+			uint32_t pkt_len = pkts[pkt_idx]->pkt_len +
+				vq->vhost_hlen;
 
 			do {
-				avail_idx = *((volatile uint16_t *)&vq->avail->idx);
-				if (unlikely(res_cur_idx == avail_idx)) {
-					LOG_DEBUG(VHOST_DATA,
-						"(%"PRIu64") Failed "
-						"to get enough desc from "
-						"vring\n",
-						dev->device_fh);
-					return pkt_idx;
-				} else {
-					uint16_t wrapped_idx =
-						(res_cur_idx) & (vq->size - 1);
-					uint32_t idx =
-						vq->avail->ring[wrapped_idx];
-					uint8_t next_desc;
-
-					do {
-						next_desc = 0;
-						secure_len += vq->desc[idx].len;
-						if (vq->desc[idx].flags &
-							VRING_DESC_F_NEXT) {
-							idx = vq->desc[idx].next;
-							next_desc = 1;
-						}
-					} while (next_desc);
+				uint16_t wrapped_idx;
+				uint32_t idx;
+				uint8_t next_desc;
 
-					res_cur_idx++;
-				}
+				if (unlikely(res_cur_idx == avail_idx))
+					break;
+
+				wrapped_idx = res_cur_idx & (vq->size - 1);
+				idx = vq->avail->ring[wrapped_idx];
+				do {
+					next_desc = 0;
+					secure_len += vq->desc[idx].len;
+					if (vq->desc[idx].flags &
+						VRING_DESC_F_NEXT) {
+						idx = vq->desc[idx].next;
+						next_desc = 1;
+					}
+				} while (next_desc);
+
+				res_cur_idx++;
 			} while (pkt_len > secure_len);
 
-			/* vq->last_used_idx_res is atomically updated. */
-			success = rte_atomic16_cmpset(&vq->last_used_idx_res,
-							res_base_idx,
-							res_cur_idx);
-		} while (success == 0);
+			if (pkt_len > secure_len) {
+				LOG_DEBUG(VHOST_DATA,
+					"(%"PRIu64") Failed "
+					"to get enough desc from "
+					"vring\n",
+					dev->device_fh);
+				break;
+			}
+			pkt_end_idx[pkt_idx] = res_cur_idx;
+		}
+
+		/* Only the buffers of whole packets are reserved. */
+		if (pkt_idx == 0) {
+			vhost_notify_pending(dev, vq);
+			return 0;
+		}
+		res_end_idx = pkt_end_idx[pkt_idx - 1];
+
+		/* vq->last_used_idx_res is atomically updated. */
+		success = rte_atomic16_cmpset(&vq->last_used_idx_res,
+						res_base_idx, res_end_idx);
+	} while (success == 0);
 
-		id = res_base_idx;
-		need_cnt = res_cur_idx - res_base_idx;
+	count = pkt_idx;
+	res_cur_idx = res_base_idx;
+	for (pkt_idx = 0; pkt_idx < count; pkt_idx++) {
+		uint16_t need_cnt = pkt_end_idx[pkt_idx] - res_cur_idx;
+		uint32_t vec_idx = 0;
+		uint16_t i, id = res_cur_idx;
 
 		for (i = 0; i < need_cnt; i++, id++) {
 			uint16_t wrapped_idx = id & (vq->size - 1);
@@ -488,27 +620,24 @@ virtio_dev_merge_rx(struct virtio_net *dev, uint16_t queue_id,
 			} while (next_desc);
 		}
 
-		res_end_idx = res_cur_idx;
-
-		entry_success = copy_from_mbuf_to_vring(dev, res_base_idx,
-			res_end_idx, pkts[pkt_idx]);
+		entry_success += copy_from_mbuf_to_vring(dev, queue_id,
+			res_cur_idx, pkt_end_idx[pkt_idx], pkts[pkt_idx]);
+		res_cur_idx = pkt_end_idx[pkt_idx];
+	}
 
-		rte_compiler_barrier();
+	rte_compiler_barrier();
 
-		/*
-		 * Wait until it's our turn to add our buffer
-		 * to the used ring.
-		 */
-		while (unlikely(vq->last_used_idx != res_base_idx))
-			rte_pause();
+	/*
+	 * Wait until it's our turn to add our buffers
+	 * to the used ring.
+	 */
+	while (unlikely(vq->last_used_idx != res_base_idx))
+		rte_pause();
 
-		*(volatile uint16_t *)&vq->used->idx += entry_success;
-		vq->last_used_idx = res_end_idx;
+	*(volatile uint16_t *)&vq->used->idx += entry_success;
+	vq->last_used_idx = res_end_idx;
 
-		/* Kick the guest if necessary. */
-		if (!(vq->avail->flags & VRING_AVAIL_F_NO_INTERRUPT))
-			eventfd_write((int)vq->callfd, 1);
-	}
+	vhost_notify_guest(dev, vq);
 
 	return count;
 }
@@ -523,6 +652,100 @@ rte_vhost_enqueue_burst(struct virtio_net *dev, uint16_t queue_id,
 		return virtio_dev_rx(dev, queue_id, pkts, count);
 }
 
+/*
+ * Translate a guest physical address to a host physical address, if the
+ * len bytes from it are physically contiguous in the host. Returns 0
+ * otherwise.
+ */
+static inline uint64_t __attribute__((always_inline))
+gpa_to_hpa(struct virtio_net *dev, uint64_t guest_pa, uint64_t len)
+{
+	struct vhost_guest_page *page;
+	uint32_t low = 0, high = dev->nr_guest_pages;
+	uint32_t mid;
+
+	/* The guest pages are sorted by guest physical address. */
+	while (low < high) {
+		mid = (low + high) / 2;
+		page = &dev->guest_pages[mid];
+		if (guest_pa < page->guest_phys_addr)
+			high = mid;
+		else if (guest_pa >= page->guest_phys_addr + page->size)
+			low = mid + 1;
+		else if (guest_pa + len <= page->guest_phys_addr + page->size)
+			return guest_pa - page->guest_phys_addr +
+				page->host_phys_addr;
+		else
+			return 0;
+	}
+	return 0;
+}
+
+/* Called when the last mbuf attached to a zero copy buffer is freed. */
+static void
+zcopy_buf_free(__rte_unused void *addr, void *opaque)
+{
+	struct vhost_zcopy_buf *zbuf = opaque;
+
+	zbuf->done = 1;
+}
+
+/*
+ * Add the zero copy buffers whose mbufs were freed to the used ring, from
+ * the index used_idx. Returns the number of used ring entries added.
+ */
+static inline uint16_t __attribute__((always_inline))
+zcopy_bufs_reclaim(struct vhost_virtqueue *vq, uint16_t used_idx)
+{
+	uint16_t i = 0, nr_used = 0;
+	uint16_t head;
+
+	while (i < vq->nr_zbufs_inflight) {
+		head = vq->zbufs_inflight[i];
+		if (vq->zbufs[head].done == 0) {
+			i++;
+			continue;
+		}
+
+		vq->used->ring[(used_idx + nr_used) & (vq->size - 1)].id = head;
+		vq->used->ring[(used_idx + nr_used) & (vq->size - 1)].len = 0;
+		nr_used++;
+
+		/* The buffers may be freed in any order. */
+		vq->zbufs_inflight[i] =
+			vq->zbufs_inflight[--vq->nr_zbufs_inflight];
+	}
+	return nr_used;
+}
+
+/*
+ * Attach an mbuf to the guest buffer of a TX descriptor, instead of copying
+ * it. The head descriptor is given back to the guest once the mbuf is freed.
+ */
+static inline struct rte_mbuf * __attribute__((always_inline))
+zcopy_dequeue(struct vhost_virtqueue *vq, struct rte_mempool *mbuf_pool,
+	uint16_t head, uint64_t vb_addr, uint64_t vb_hpa, uint32_t len)
+{
+	struct vhost_zcopy_buf *zbuf = &vq->zbufs[head];
+	struct rte_mbuf *m;
+
+	m = rte_pktmbuf_alloc(mbuf_pool);
+	if (unlikely(m == NULL))
+		return NULL;
+
+	/* The vhost library keeps no reference, the buffer is the mbuf's. */
+	zbuf->done = 0;
+	rte_mbuf_ext_shinfo_init(&zbuf->shinfo, zcopy_buf_free, zbuf);
+	rte_pktmbuf_attach_extbuf(m, (void *)(uintptr_t)vb_addr, vb_hpa,
+		(uint16_t)len, &zbuf->shinfo);
+	rte_mbuf_ext_shinfo_release(&zbuf->shinfo, (void *)(uintptr_t)vb_addr);
+	m->data_len = (uint16_t)len;
+	m->pkt_len = len;
+
+	vq->zbufs_inflight[vq->nr_zbufs_inflight++] = head;
+	return m;
+}
+
 uint16_t
 rte_vhost_dequeue_burst(struct virtio_net *dev, uint16_t queue_id,
 	struct rte_mempool *mbuf_pool, struct rte_mbuf **pkts, uint16_t count)
@@ -531,23 +754,39 @@ rte_vhost_dequeue_burst(struct virtio_net *dev, uint16_t queue_id,
 	struct vhost_virtqueue *vq;
 	struct vring_desc *desc;
 	uint64_t vb_addr = 0;
+	uint64_t vb_hpa;
 	uint32_t head[MAX_PKT_BURST];
 	uint32_t used_idx;
 	uint32_t i;
 	uint16_t free_entries, entry_success = 0;
 	uint16_t avail_idx;
+	uint16_t used_base, nr_used = 0;
+	int zcopy;
 
-	if (unlikely(queue_id != VIRTIO_TXQ)) {
-		LOG_DEBUG(VHOST_DATA, "mq isn't supported in this version.\n");
+	if (unlikely(!is_valid_virt_queue_idx(queue_id, 1, dev->virt_qp_nb))) {
+		RTE_LOG(ERR, VHOST_DATA, "%s (%"PRIu64"): invalid virtqueue idx:%d\n",
+			__func__, dev->device_fh, queue_id);
 		return 0;
 	}
 
-	vq = dev->virtqueue[VIRTIO_TXQ];
+	vq = dev->virtqueue[queue_id];
+	if (unlikely(vq->enabled == 0))
+		return 0;
+
+	/*
+	 * The used ring is filled from its own index, as the zero copy
+	 * buffers are given back after the buffers that follow them.
+	 */
+	used_base = vq->used->idx;
+	zcopy = dev->dequeue_zcopy_len != 0 && vq->zbufs != NULL;
+	if (zcopy && vq->nr_zbufs_inflight != 0)
+		nr_used = zcopy_bufs_reclaim(vq, used_base);
+
 	avail_idx =  *((volatile uint16_t *)&vq->avail->idx);
 
 	/* If there are no available buffers then return. */
 	if (vq->last_used_idx == avail_idx)
-		return 0;
+		goto out;
 
 	LOG_DEBUG(VHOST_DATA, "%s (%"PRIu64")\n", __func__,
 		dev->device_fh);
@@ -570,7 +809,7 @@ rte_vhost_dequeue_burst(struct virtio_net *dev, uint16_t queue_id,
 
 	/* Prefetch descriptor index. */
 	rte_prefetch0(&vq->desc[head[entry_success]]);
-	rte_prefetch0(&vq->used->ring[vq->last_used_idx & (vq->size - 1)]);
+	rte_prefetch0(&vq->used->ring[(used_base + nr_used) & (vq->size - 1)]);
 
 	while (entry_success < free_entries) {
 		uint32_t vb_avail, vb_offset;
@@ -586,11 +825,36 @@ rte_vhost_dequeue_burst(struct virtio_net *dev, uint16_t queue_id,
 		desc = &vq->desc[desc->next];
 
 		/* Buffer address translation. */
-		vb_addr = gpa_to_vva(dev, desc->addr);
+		vb_addr = vq_gpa_to_vva(dev, vq, desc->addr);
+
+		/*
+		 * Large packets in a single physically contiguous guest
+		 * buffer are not copied.
+		 */
+		if (zcopy && desc->len >= dev->dequeue_zcopy_len &&
+				desc->len <= UINT16_MAX &&
+				(desc->flags & VRING_DESC_F_NEXT) == 0) {
+			vb_hpa = gpa_to_hpa(dev, desc->addr, desc->len);
+			if (vb_hpa != 0) {
+				m = zcopy_dequeue(vq, mbuf_pool,
+					head[entry_success], vb_addr, vb_hpa,
+					desc->len);
+				if (unlikely(m == NULL)) {
+					RTE_LOG(ERR, VHOST_DATA,
+						"Failed to allocate memory for mbuf.\n");
+					break;
+				}
+				pkts[entry_success] = m;
+				vq->last_used_idx++;
+				entry_success++;
+				continue;
+			}
+		}
+
 		/* Prefetch buffer address. */
 		rte_prefetch0((void *)(uintptr_t)vb_addr);
 
-		used_idx = vq->last_used_idx & (vq->size - 1);
+		used_idx = (used_base + nr_used) & (vq->size - 1);
 
 		if (entry_success < (free_entries - 1)) {
 			/* Prefetch descriptor index. */
@@ -692,7 +956,8 @@ rte_vhost_dequeue_burst(struct virtio_net *dev, uint16_t queue_id,
 					desc = &vq->desc[desc->next];
 
 					/* Buffer address translation. */
-					vb_addr = gpa_to_vva(dev, desc->addr);
+					vb_addr = vq_gpa_to_vva(dev, vq,
+						desc->addr);
 					/* Prefetch buffer address. */
 					rte_prefetch0((void *)(uintptr_t)vb_addr);
 					vb_offset = 0;
@@ -719,12 +984,17 @@ rte_vhost_dequeue_burst(struct virtio_net *dev, uint16_t queue_id,
 		pkts[entry_success] = m;
 		vq->last_used_idx++;
 		entry_success++;
+		nr_used++;
+	}
+
+out:
+	if (nr_used == 0) {
+		vhost_notify_pending(dev, vq);
+		return entry_success;
 	}
 
 	rte_compiler_barrier();
-	vq->used->idx += entry_success;
-	/* Kick guest if required. */
-	if (!(vq->avail->flags & VRING_AVAIL_F_NO_INTERRUPT))
-		eventfd_write((int)vq->callfd, 1);
+	vq->used->idx = used_base + nr_used;
+	vhost_notify_guest(dev, vq);
 	return entry_success;
 }
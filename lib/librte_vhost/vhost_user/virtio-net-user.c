@@ -42,6 +42,7 @@
 
 #include <rte_common.h>
 #include <rte_log.h>
+#include <rte_memory.h>
 
 #include "virtio-net.h"
 #include "virtio-net-user.h"
@@ -93,6 +94,111 @@ free_mem_region(struct virtio_net *dev)
 	}
 }
 
+static void
+free_guest_pages(struct virtio_net *dev)
+{
+	free(dev->guest_pages);
+	dev->guest_pages = NULL;
+	dev->nr_guest_pages = 0;
+}
+
+static int
+add_guest_page(struct virtio_net *dev, uint32_t *max_pages,
+	uint64_t guest_phys_addr, uint64_t host_phys_addr, uint64_t size)
+{
+	struct vhost_guest_page *page;
+
+	/* Merge the page with the previous one if they are contiguous. */
+	if (dev->nr_guest_pages > 0) {
+		page = &dev->guest_pages[dev->nr_guest_pages - 1];
+		if (page->guest_phys_addr + page->size == guest_phys_addr &&
+			page->host_phys_addr + page->size == host_phys_addr) {
+			page->size += size;
+			return 0;
+		}
+	}
+
+	if (dev->nr_guest_pages == *max_pages) {
+		*max_pages = *max_pages ? *max_pages * 2 : 8;
+		page = realloc(dev->guest_pages, *max_pages * sizeof(*page));
+		if (page == NULL)
+			return -1;
+		dev->guest_pages = page;
+	}
+
+	page = &dev->guest_pages[dev->nr_guest_pages++];
+	page->guest_phys_addr = guest_phys_addr;
+	page->host_phys_addr = host_phys_addr;
+	page->size = size;
+	return 0;
+}
+
+/*
+ * Find the host physical address of each page of a memory region. The
+ * pages without a physical address are left out, so the buffers in them
+ * are not dequeued without copy.
+ */
+static int
+add_region_guest_pages(struct virtio_net *dev, uint32_t *max_pages,
+	uint64_t guest_phys_addr, uint64_t vhost_va, uint64_t size,
+	uint64_t page_size)
+{
+	uint64_t host_phys_addr, len;
+
+	while (size > 0) {
+		len = RTE_MIN(size, page_size - (vhost_va & (page_size - 1)));
+
+		/* Fault the page in, so that it has a physical address. */
+		*(volatile uint8_t *)(uintptr_t)vhost_va;
+		host_phys_addr = rte_mem_virt2phy((void *)(uintptr_t)vhost_va);
+		if (host_phys_addr != RTE_BAD_PHYS_ADDR &&
+			host_phys_addr >= (uint64_t)getpagesize() &&
+			add_guest_page(dev, max_pages, guest_phys_addr,
+				host_phys_addr, len) < 0)
+			return -1;
+
+		guest_phys_addr += len;
+		vhost_va += len;
+		size -= len;
+	}
+	return 0;
+}
+
+static int
+guest_page_cmp(const void *p1, const void *p2)
+{
+	const struct vhost_guest_page *page1 = p1;
+	const struct vhost_guest_page *page2 = p2;
+
+	if (page1->guest_phys_addr < page2->guest_phys_addr)
+		return -1;
+	return page1->guest_phys_addr > page2->guest_phys_addr;
+}
+
+/*
+ * Sort the regions of a memory table by guest physical address, along with
+ * their file descriptors. There are at most VHOST_MEMORY_MAX_NREGIONS.
+ */
+static void
+sort_mem_regions(VhostUserMemory *memory, int *fds)
+{
+	VhostUserMemoryRegion region;
+	uint32_t i, j;
+	int fd;
+
+	for (i = 1; i < memory->nregions; i++) {
+		region = memory->regions[i];
+		fd = fds[i];
+		for (j = i; j > 0 && memory->regions[j - 1].guest_phys_addr >
+				region.guest_phys_addr; j--) {
+			memory->regions[j] = memory->regions[j - 1];
+			fds[j] = fds[j - 1];
+		}
+		memory->regions[j] = region;
+		fds[j] = fd;
+	}
+}
+
 int
 user_set_mem_table(struct vhost_device_ctx ctx, struct VhostUserMsg *pmsg)
 {
@@ -103,6 +209,7 @@ user_set_mem_table(struct vhost_device_ctx ctx, struct VhostUserMsg *pmsg)
 	unsigned int idx = 0;
 	struct orig_region_map *pregion_orig;
 	uint64_t alignment;
+	uint32_t max_guest_pages = 0;
 
 	/* unmap old memory regions one by one*/
 	dev = get_device(ctx);
@@ -118,6 +225,7 @@ user_set_mem_table(struct vhost_device_ctx ctx, struct VhostUserMsg *pmsg)
 		free(dev->mem);
 		dev->mem = NULL;
 	}
+	free_guest_pages(dev);
 
 	dev->mem = calloc(1,
 		sizeof(struct virtio_memory) +
@@ -131,6 +239,9 @@ user_set_mem_table(struct vhost_device_ctx ctx, struct VhostUserMsg *pmsg)
 	}
 	dev->mem->nregions = memory.nregions;
 
+	/* The regions are sorted for the address translation. */
+	sort_mem_regions(&memory, pmsg->fds);
+
 	pregion_orig = orig_region(dev->mem, memory.nregions);
 	for (idx = 0; idx < memory.nregions; idx++) {
 		pregion = &dev->mem->regions[idx];
@@ -187,8 +298,32 @@ user_set_mem_table(struct vhost_device_ctx ctx, struct VhostUserMsg *pmsg)
 			(void *)(uintptr_t)pregion->guest_phys_address,
 			(void *)(uintptr_t)pregion->userspace_address,
 			 pregion->memory_size);
+
+		/* The zero copy dequeue needs the host physical addresses. */
+		if (dev->dequeue_zcopy_len != 0 &&
+			add_region_guest_pages(dev, &max_guest_pages,
+				pregion->guest_phys_address, mapped_address,
+				pregion->memory_size,
+				pregion_orig[idx].blksz) < 0) {
+			RTE_LOG(ERR, VHOST_CONFIG,
+				"(%"PRIu64") Failed to allocate memory for "
+				"the guest pages, zero copy is disabled.\n",
+				dev->device_fh);
+			free_guest_pages(dev);
+			dev->dequeue_zcopy_len = 0;
+		}
 	}
 
+	if (dev->nr_guest_pages > 0) {
+		qsort(dev->guest_pages, dev->nr_guest_pages,
+			sizeof(struct vhost_guest_page), guest_page_cmp);
+		RTE_LOG(INFO, VHOST_CONFIG,
+			"(%"PRIu64") %u physically contiguous guest pages "
+			"for zero copy\n", dev->device_fh, dev->nr_guest_pages);
+	}
+
+	reset_gpa_cache(dev);
+
 	return 0;
 
 err_mmap:
@@ -202,29 +337,35 @@ err_mmap:
 	}
 	free(dev->mem);
 	dev->mem = NULL;
+	free_guest_pages(dev);
 	return -1;
 }
 
+/*
+ * The device is ready once all its queue pairs are. The call fds of all
+ * the queues are sent first, so all the queue pairs of a multiqueue
+ * device exist when the rings are started.
+ */
 static int
 virtio_is_ready(struct virtio_net *dev)
 {
-	struct vhost_virtqueue *rvq, *tvq;
-
-	/* mq support in future.*/
-	rvq = dev->virtqueue[VIRTIO_RXQ];
-	tvq = dev->virtqueue[VIRTIO_TXQ];
-	if (rvq && tvq && rvq->desc && tvq->desc &&
-		(rvq->kickfd != (eventfd_t)-1) &&
-		(rvq->callfd != (eventfd_t)-1) &&
-		(tvq->kickfd != (eventfd_t)-1) &&
-		(tvq->callfd != (eventfd_t)-1)) {
-		RTE_LOG(INFO, VHOST_CONFIG,
-			"virtio is now ready for processing.\n");
-		return 1;
+	struct vhost_virtqueue *vq;
+	uint32_t i;
+
+	for (i = 0; i < dev->virt_qp_nb * VIRTIO_QNUM; i++) {
+		vq = dev->virtqueue[i];
+		if (vq->desc == NULL ||
+			(vq->kickfd == (eventfd_t)-1) ||
+			(vq->callfd == (eventfd_t)-1)) {
+			RTE_LOG(INFO, VHOST_CONFIG,
+				"virtio isn't ready for processing.\n");
+			return 0;
+		}
 	}
 	RTE_LOG(INFO, VHOST_CONFIG,
-		"virtio isn't ready for processing.\n");
-	return 0;
+		"virtio is now ready for processing with %u queue pair(s).\n",
+		dev->virt_qp_nb);
+	return 1;
 }
 
 void
@@ -253,6 +394,9 @@ user_set_vring_kick(struct vhost_device_ctx ctx, struct VhostUserMsg *pmsg)
 	struct vhost_vring_file file;
 	struct virtio_net *dev = get_device(ctx);
 
+	if (dev == NULL)
+		return;
+
 	file.index = pmsg->payload.u64 & VHOST_USER_VRING_IDX_MASK;
 	if (pmsg->payload.u64 & VHOST_USER_VRING_NOFD_MASK)
 		file.fd = -1;
@@ -260,7 +404,8 @@ user_set_vring_kick(struct vhost_device_ctx ctx, struct VhostUserMsg *pmsg)
 		file.fd = pmsg->fds[0];
 	RTE_LOG(INFO, VHOST_CONFIG,
 		"vring kick idx:%d file:%d\n", file.index, file.fd);
-	ops->set_vring_kick(ctx, &file);
+	if (ops->set_vring_kick(ctx, &file) < 0)
+		return;
 
 	if (virtio_is_ready(dev) &&
 		!(dev->flags & VIRTIO_DEV_RUNNING))
@@ -275,33 +420,74 @@ user_get_vring_base(struct vhost_device_ctx ctx,
 	struct vhost_vring_state *state)
 {
 	struct virtio_net *dev = get_device(ctx);
+	struct vhost_virtqueue *vq;
+
+	if (dev == NULL)
+		return -1;
 
 	/* We have to stop the queue (virtio) if it is running. */
 	if (dev->flags & VIRTIO_DEV_RUNNING)
 		notify_ops->destroy_device(dev);
 
 	/* Here we are safe to get the last used index */
-	ops->get_vring_base(ctx, state->index, state);
+	if (ops->get_vring_base(ctx, state->index, state) < 0)
+		return -1;
 
 	RTE_LOG(INFO, VHOST_CONFIG,
 		"vring base idx:%d file:%d\n", state->index, state->num);
 	/*
 	 * Based on current qemu vhost-user implementation, this message is
-	 * sent and only sent in vhost_vring_stop.
+	 * sent and only sent in vhost_vring_stop, once per queue.
 	 * TODO: cleanup the vring, it isn't usable since here.
 	 */
-	if (((int)dev->virtqueue[VIRTIO_RXQ]->kickfd) >= 0) {
-		close(dev->virtqueue[VIRTIO_RXQ]->kickfd);
-		dev->virtqueue[VIRTIO_RXQ]->kickfd = (eventfd_t)-1;
-	}
-	if (((int)dev->virtqueue[VIRTIO_TXQ]->kickfd) >= 0) {
-		close(dev->virtqueue[VIRTIO_TXQ]->kickfd);
-		dev->virtqueue[VIRTIO_TXQ]->kickfd = (eventfd_t)-1;
+	vq = dev->virtqueue[state->index];
+	if (((int)vq->kickfd) >= 0) {
+		close(vq->kickfd);
+		vq->kickfd = (eventfd_t)-1;
 	}
 
 	return 0;
 }
 
+int
+user_set_protocol_features(struct vhost_device_ctx ctx,
+	uint64_t protocol_features)
+{
+	struct virtio_net *dev = get_device(ctx);
+
+	if (dev == NULL || (protocol_features & ~VHOST_USER_PROTOCOL_FEATURES))
+		return -1;
+
+	dev->protocol_features = protocol_features;
+	return 0;
+}
+
+/*
+ * The guest enables or disables a queue pair, when it changes the number
+ * of queue pairs it uses. The application is notified so it can stop
+ * polling the queue.
+ */
+int
+user_set_vring_enable(struct vhost_device_ctx ctx,
+	struct vhost_vring_state *state)
+{
+	struct virtio_net *dev = get_device(ctx);
+	int enable = (int)state->num;
+
+	if (dev == NULL || state->index >= dev->virt_qp_nb * VIRTIO_QNUM)
+		return -1;
+
+	RTE_LOG(INFO, VHOST_CONFIG,
+		"set queue enable: %d to qp idx: %d\n",
+		enable, state->index);
+
+	dev->virtqueue[state->index]->enabled = enable;
+	if (notify_ops->vring_state_changed)
+		notify_ops->vring_state_changed(dev, state->index, enable);
+
+	return 0;
+}
+
 void
 user_destroy_device(struct vhost_device_ctx ctx)
 {
@@ -315,4 +501,6 @@ user_destroy_device(struct vhost_device_ctx ctx)
 		free(dev->mem);
 		dev->mem = NULL;
 	}
+	if (dev)
+		free_guest_pages(dev);
 }
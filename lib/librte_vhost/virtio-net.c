@@ -41,6 +41,7 @@
 
 #include <sys/socket.h>
 
+#include <rte_cycles.h>
 #include <rte_ethdev.h>
 #include <rte_log.h>
 #include <rte_string_fns.h>
@@ -66,8 +67,13 @@ static struct virtio_net_config_ll *ll_root;
 /* Features supported by this lib. */
 #define VHOST_SUPPORTED_FEATURES ((1ULL << VIRTIO_NET_F_MRG_RXBUF) | \
 				(1ULL << VIRTIO_NET_F_CTRL_VQ) | \
-				(1ULL << VIRTIO_NET_F_CTRL_RX))
+				(1ULL << VIRTIO_NET_F_CTRL_RX) | \
+				(1ULL << VIRTIO_NET_F_MQ) | \
+				(1ULL << VIRTIO_RING_F_EVENT_IDX) | \
+				(1ULL << VHOST_USER_F_PROTOCOL_FEATURES))
 static uint64_t VHOST_FEATURES = VHOST_SUPPORTED_FEATURES;
+/* Minimum length of the packets dequeued without copy, 0 if disabled. */
+static uint32_t dequeue_zcopy_len;
 
 
 /*
@@ -134,6 +140,20 @@ get_device(struct vhost_device_ctx ctx)
 	return NULL;
 }
 
+/*
+ * Empty the address translation caches of the virtqueues of a device, when
+ * its memory table changes.
+ */
+void
+reset_gpa_cache(struct virtio_net *dev)
+{
+	uint32_t i;
+
+	for (i = 0; i < dev->virt_qp_nb * VIRTIO_QNUM; i++)
+		memset(&dev->virtqueue[i]->gpa_cache, 0,
+			sizeof(struct vhost_gpa_cache));
+}
+
 /*
  * Add entry containing a device to the device configuration linked list.
  */
@@ -177,6 +197,8 @@ add_config_ll_entry(struct virtio_net_config_ll *new_ll_dev)
 static void
 cleanup_device(struct virtio_net *dev)
 {
+	uint32_t i;
+
 	/* Unmap QEMU memory file if mapped. */
 	if (dev->mem) {
 		munmap((void *)(uintptr_t)dev->mem->mapped_address,
@@ -184,15 +206,19 @@ cleanup_device(struct virtio_net *dev)
 		free(dev->mem);
 	}
 
+	free(dev->guest_pages);
+	dev->guest_pages = NULL;
+	dev->nr_guest_pages = 0;
+
 	/* Close any event notifiers opened by device. */
-	if ((int)dev->virtqueue[VIRTIO_RXQ]->callfd >= 0)
-		close((int)dev->virtqueue[VIRTIO_RXQ]->callfd);
-	if ((int)dev->virtqueue[VIRTIO_RXQ]->kickfd >= 0)
-		close((int)dev->virtqueue[VIRTIO_RXQ]->kickfd);
-	if ((int)dev->virtqueue[VIRTIO_TXQ]->callfd >= 0)
-		close((int)dev->virtqueue[VIRTIO_TXQ]->callfd);
-	if ((int)dev->virtqueue[VIRTIO_TXQ]->kickfd >= 0)
-		close((int)dev->virtqueue[VIRTIO_TXQ]->kickfd);
+	for (i = 0; i < dev->virt_qp_nb * VIRTIO_QNUM; i++) {
+		if ((int)dev->virtqueue[i]->callfd >= 0)
+			close((int)dev->virtqueue[i]->callfd);
+		if ((int)dev->virtqueue[i]->kickfd >= 0)
+			close((int)dev->virtqueue[i]->kickfd);
+		free(dev->virtqueue[i]->zbufs);
+		dev->virtqueue[i]->zbufs = NULL;
+	}
 }
 
 /*
@@ -201,9 +227,11 @@ cleanup_device(struct virtio_net *dev)
 static void
 free_device(struct virtio_net_config_ll *ll_dev)
 {
-	/* Free any malloc'd memory */
-	free(ll_dev->dev.virtqueue[VIRTIO_RXQ]);
-	free(ll_dev->dev.virtqueue[VIRTIO_TXQ]);
+	uint32_t i;
+
+	/* Free any malloc'd memory, the queues of a pair are allocated at once */
+	for (i = 0; i < ll_dev->dev.virt_qp_nb; i++)
+		free(ll_dev->dev.virtqueue[i * VIRTIO_QNUM + VIRTIO_RXQ]);
 	free(ll_dev);
 }
 
@@ -236,6 +264,24 @@ rm_config_ll_entry(struct virtio_net_config_ll *ll_dev,
 	}
 }
 
+/*
+ * Initialise all variables in a virtqueue.
+ */
+static void
+init_vring_queue(struct vhost_virtqueue *vq)
+{
+	memset(vq, 0, sizeof(struct vhost_virtqueue));
+
+	vq->kickfd = (eventfd_t)-1;
+	vq->callfd = (eventfd_t)-1;
+
+	/* Backends are set to -1 indicating an inactive device. */
+	vq->backend = VIRTIO_DEV_STOPPED;
+
+	/* The queues are enabled until the guest disables them. */
+	vq->enabled = 1;
+}
+
 /*
  *  Initialise all variables in device structure.
  */
@@ -243,6 +289,7 @@ static void
 init_device(struct virtio_net *dev)
 {
 	uint64_t vq_offset;
+	uint32_t i;
 
 	/*
 	 * Virtqueues have already been malloced so
@@ -253,17 +300,64 @@ init_device(struct virtio_net *dev)
 	/* Set everything to 0. */
 	memset((void *)(uintptr_t)((uint64_t)(uintptr_t)dev + vq_offset), 0,
 		(sizeof(struct virtio_net) - (size_t)vq_offset));
-	memset(dev->virtqueue[VIRTIO_RXQ], 0, sizeof(struct vhost_virtqueue));
-	memset(dev->virtqueue[VIRTIO_TXQ], 0, sizeof(struct vhost_virtqueue));
 
-	dev->virtqueue[VIRTIO_RXQ]->kickfd = (eventfd_t)-1;
-	dev->virtqueue[VIRTIO_RXQ]->callfd = (eventfd_t)-1;
-	dev->virtqueue[VIRTIO_TXQ]->kickfd = (eventfd_t)-1;
-	dev->virtqueue[VIRTIO_TXQ]->callfd = (eventfd_t)-1;
+	for (i = 0; i < dev->virt_qp_nb * VIRTIO_QNUM; i++)
+		init_vring_queue(dev->virtqueue[i]);
+}
 
-	/* Backends are set to -1 indicating an inactive device. */
-	dev->virtqueue[VIRTIO_RXQ]->backend = VIRTIO_DEV_STOPPED;
-	dev->virtqueue[VIRTIO_TXQ]->backend = VIRTIO_DEV_STOPPED;
+/*
+ * Allocate and initialise the queue pairs of a device, up to the pair of
+ * the virtqueue qidx. The guest sets up the queue pairs one by one, with
+ * VIRTIO_NET_F_MQ.
+ */
+static int
+alloc_vring_queue_pairs(struct virtio_net *dev, uint32_t qidx)
+{
+	struct vhost_virtqueue *vq;
+	uint32_t qp_idx = qidx / VIRTIO_QNUM;
+
+	if (qp_idx >= VHOST_MAX_QUEUE_PAIRS) {
+		RTE_LOG(ERR, VHOST_CONFIG,
+			"(%"PRIu64") Invalid virtqueue index %u.\n",
+			dev->device_fh, qidx);
+		return -1;
+	}
+
+	while (dev->virt_qp_nb <= qp_idx) {
+		vq = malloc(sizeof(struct vhost_virtqueue) * VIRTIO_QNUM);
+		if (vq == NULL) {
+			RTE_LOG(ERR, VHOST_CONFIG,
+				"(%"PRIu64") Failed to allocate memory for "
+				"queue pair %u.\n",
+				dev->device_fh, dev->virt_qp_nb);
+			return -1;
+		}
+		init_vring_queue(&vq[VIRTIO_RXQ]);
+		init_vring_queue(&vq[VIRTIO_TXQ]);
+		vq[VIRTIO_RXQ].vhost_hlen = dev->virtqueue[VIRTIO_RXQ] ?
+			dev->virtqueue[VIRTIO_RXQ]->vhost_hlen : 0;
+		vq[VIRTIO_TXQ].vhost_hlen = vq[VIRTIO_RXQ].vhost_hlen;
+
+		dev->virtqueue[dev->virt_qp_nb * VIRTIO_QNUM + VIRTIO_RXQ] =
+			&vq[VIRTIO_RXQ];
+		dev->virtqueue[dev->virt_qp_nb * VIRTIO_QNUM + VIRTIO_TXQ] =
+			&vq[VIRTIO_TXQ];
+		dev->virt_qp_nb++;
+	}
+
+	return 0;
+}
+
+/*
+ * Get the virtqueue of a device with an index given by the guest,
+ * allocating its queue pair if needed.
+ */
+static struct vhost_virtqueue *
+get_vring_queue(struct virtio_net *dev, uint32_t qidx)
+{
+	if (alloc_vring_queue_pairs(dev, qidx) < 0)
+		return NULL;
+	return dev->virtqueue[qidx];
 }
 
 /*
@@ -275,10 +369,9 @@ static int
 new_device(struct vhost_device_ctx ctx)
 {
 	struct virtio_net_config_ll *new_ll_dev;
-	struct vhost_virtqueue *virtqueue_rx, *virtqueue_tx;
 
 	/* Setup device and virtqueues. */
-	new_ll_dev = malloc(sizeof(struct virtio_net_config_ll));
+	new_ll_dev = calloc(1, sizeof(struct virtio_net_config_ll));
 	if (new_ll_dev == NULL) {
 		RTE_LOG(ERR, VHOST_CONFIG,
 			"(%"PRIu64") Failed to allocate memory for dev.\n",
@@ -286,30 +379,15 @@ new_device(struct vhost_device_ctx ctx)
 		return -1;
 	}
 
-	virtqueue_rx = malloc(sizeof(struct vhost_virtqueue));
-	if (virtqueue_rx == NULL) {
-		free(new_ll_dev);
-		RTE_LOG(ERR, VHOST_CONFIG,
-			"(%"PRIu64") Failed to allocate memory for rxq.\n",
-			ctx.fh);
-		return -1;
-	}
-
-	virtqueue_tx = malloc(sizeof(struct vhost_virtqueue));
-	if (virtqueue_tx == NULL) {
-		free(virtqueue_rx);
+	/* The first queue pair always exists, the others are added later. */
+	if (alloc_vring_queue_pairs(&new_ll_dev->dev, VIRTIO_RXQ) < 0) {
 		free(new_ll_dev);
-		RTE_LOG(ERR, VHOST_CONFIG,
-			"(%"PRIu64") Failed to allocate memory for txq.\n",
-			ctx.fh);
 		return -1;
 	}
 
-	new_ll_dev->dev.virtqueue[VIRTIO_RXQ] = virtqueue_rx;
-	new_ll_dev->dev.virtqueue[VIRTIO_TXQ] = virtqueue_tx;
-
 	/* Initialise device and virtqueues. */
 	init_device(&new_ll_dev->dev);
+	new_ll_dev->dev.dequeue_zcopy_len = dequeue_zcopy_len;
 
 	new_ll_dev->next = NULL;
 
@@ -396,6 +474,8 @@ reset_owner(struct vhost_device_ctx ctx)
 	struct virtio_net_config_ll *ll_dev;
 
 	ll_dev = get_config_ll_entry(ctx);
+	if (ll_dev == NULL)
+		return -1;
 
 	cleanup_device(&ll_dev->dev);
 	init_device(&ll_dev->dev);
@@ -429,6 +509,8 @@ static int
 set_features(struct vhost_device_ctx ctx, uint64_t *pu)
 {
 	struct virtio_net *dev;
+	uint16_t vhost_hlen;
+	uint32_t i;
 
 	dev = get_device(ctx);
 	if (dev == NULL)
@@ -444,19 +526,15 @@ set_features(struct vhost_device_ctx ctx, uint64_t *pu)
 		LOG_DEBUG(VHOST_CONFIG,
 			"(%"PRIu64") Mergeable RX buffers enabled\n",
 			dev->device_fh);
-		dev->virtqueue[VIRTIO_RXQ]->vhost_hlen =
-			sizeof(struct virtio_net_hdr_mrg_rxbuf);
-		dev->virtqueue[VIRTIO_TXQ]->vhost_hlen =
-			sizeof(struct virtio_net_hdr_mrg_rxbuf);
+		vhost_hlen = sizeof(struct virtio_net_hdr_mrg_rxbuf);
 	} else {
 		LOG_DEBUG(VHOST_CONFIG,
 			"(%"PRIu64") Mergeable RX buffers disabled\n",
 			dev->device_fh);
-		dev->virtqueue[VIRTIO_RXQ]->vhost_hlen =
-			sizeof(struct virtio_net_hdr);
-		dev->virtqueue[VIRTIO_TXQ]->vhost_hlen =
-			sizeof(struct virtio_net_hdr);
+		vhost_hlen = sizeof(struct virtio_net_hdr);
 	}
+	for (i = 0; i < dev->virt_qp_nb * VIRTIO_QNUM; i++)
+		dev->virtqueue[i]->vhost_hlen = vhost_hlen;
 	return 0;
 }
 
@@ -468,13 +546,38 @@ static int
 set_vring_num(struct vhost_device_ctx ctx, struct vhost_vring_state *state)
 {
 	struct virtio_net *dev;
+	struct vhost_virtqueue *vq;
 
 	dev = get_device(ctx);
 	if (dev == NULL)
 		return -1;
 
 	/* State->index refers to the queue index. The txq is 1, rxq is 0. */
-	dev->virtqueue[state->index]->size = state->num;
+	vq = get_vring_queue(dev, state->index);
+	if (vq == NULL)
+		return -1;
+
+	vq->size = state->num;
+
+	/*
+	 * The zero copy buffers of a TX queue are indexed by the head
+	 * descriptor of the guest buffer, the array of the buffers in flight
+	 * follows them.
+	 */
+	if (dev->dequeue_zcopy_len != 0 && (state->index & 1) == VIRTIO_TXQ) {
+		free(vq->zbufs);
+		vq->nr_zbufs_inflight = 0;
+		vq->zbufs = malloc((sizeof(struct vhost_zcopy_buf) +
+			sizeof(uint16_t)) * vq->size);
+		if (vq->zbufs == NULL) {
+			RTE_LOG(ERR, VHOST_CONFIG,
+				"(%"PRIu64") Failed to allocate memory for "
+				"zero copy buffers, they are disabled.\n",
+				dev->device_fh);
+			return 0;
+		}
+		vq->zbufs_inflight = (uint16_t *)&vq->zbufs[vq->size];
+	}
 
 	return 0;
 }
@@ -495,7 +598,9 @@ set_vring_addr(struct vhost_device_ctx ctx, struct vhost_vring_addr *addr)
 		return -1;
 
 	/* addr->index refers to the queue index. The txq 1, rxq is 0. */
-	vq = dev->virtqueue[addr->index];
+	vq = get_vring_queue(dev, addr->index);
+	if (vq == NULL)
+		return -1;
 
 	/* The addresses are converted from QEMU virtual to Vhost virtual. */
 	vq->desc = (struct vring_desc *)(uintptr_t)qva_to_vva(dev,
@@ -543,14 +648,20 @@ static int
 set_vring_base(struct vhost_device_ctx ctx, struct vhost_vring_state *state)
 {
 	struct virtio_net *dev;
+	struct vhost_virtqueue *vq;
 
 	dev = get_device(ctx);
 	if (dev == NULL)
 		return -1;
 
 	/* State->index refers to the queue index. The txq is 1, rxq is 0. */
-	dev->virtqueue[state->index]->last_used_idx = state->num;
-	dev->virtqueue[state->index]->last_used_idx_res = state->num;
+	vq = get_vring_queue(dev, state->index);
+	if (vq == NULL)
+		return -1;
+
+	vq->last_used_idx = state->num;
+	vq->last_used_idx_res = state->num;
+	vq->signalled_used = state->num;
 
 	return 0;
 }
@@ -569,6 +680,9 @@ get_vring_base(struct vhost_device_ctx ctx, uint32_t index,
 	if (dev == NULL)
 		return -1;
 
+	if (index >= dev->virt_qp_nb * VIRTIO_QNUM)
+		return -1;
+
 	state->index = index;
 	/* State->index refers to the queue index. The txq is 1, rxq is 0. */
 	state->num = dev->virtqueue[state->index]->last_used_idx;
@@ -592,8 +706,14 @@ set_vring_call(struct vhost_device_ctx ctx, struct vhost_vring_file *file)
 	if (dev == NULL)
 		return -1;
 
-	/* file->index refers to the queue index. The txq is 1, rxq is 0. */
-	vq = dev->virtqueue[file->index];
+	/*
+	 * file->index refers to the queue index. The txq is 1, rxq is 0.
+	 * The call fds of all the queues are sent before the rings are
+	 * started, so this allocates the queue pairs of a multiqueue device.
+	 */
+	vq = get_vring_queue(dev, file->index);
+	if (vq == NULL)
+		return -1;
 
 	if ((int)vq->callfd >= 0)
 		close((int)vq->callfd);
@@ -619,7 +739,9 @@ set_vring_kick(struct vhost_device_ctx ctx, struct vhost_vring_file *file)
 		return -1;
 
 	/* file->index refers to the queue index. The txq is 1, rxq is 0. */
-	vq = dev->virtqueue[file->index];
+	vq = get_vring_queue(dev, file->index);
+	if (vq == NULL)
+		return -1;
 
 	if ((int)vq->kickfd >= 0)
 		close((int)vq->kickfd);
@@ -648,6 +770,8 @@ set_backend(struct vhost_device_ctx ctx, struct vhost_vring_file *file)
 		return -1;
 
 	/* file->index refers to the queue index. The txq is 1, rxq is 0. */
+	if (file->index >= VIRTIO_QNUM)
+		return -1;
 	dev->virtqueue[file->index]->backend = file->fd;
 
 	/*
@@ -705,6 +829,9 @@ get_virtio_net_callbacks(void)
 int rte_vhost_enable_guest_notification(struct virtio_net *dev,
 	uint16_t queue_id, int enable)
 {
+	if (queue_id >= dev->virt_qp_nb * VIRTIO_QNUM)
+		return -1;
+
 	if (enable) {
 		RTE_LOG(ERR, VHOST_CONFIG,
 			"guest notification isn't supported.\n");
@@ -716,6 +843,17 @@ int rte_vhost_enable_guest_notification(struct virtio_net *dev,
 	return 0;
 }
 
+int rte_vhost_notify_window_set(struct virtio_net *dev, uint32_t usecs)
+{
+	dev->notify_window = rte_get_tsc_hz() * usecs / 1000000;
+	return 0;
+}
+
+uint32_t rte_vhost_get_queue_num(struct virtio_net *dev)
+{
+	return dev->virt_qp_nb;
+}
+
 uint64_t rte_vhost_feature_get(void)
 {
 	return VHOST_FEATURES;
@@ -736,6 +874,12 @@ int rte_vhost_feature_enable(uint64_t feature_mask)
 	return -1;
 }
 
+int rte_vhost_dequeue_zero_copy_set(uint32_t min_len)
+{
+	dequeue_zcopy_len = min_len;
+	return 0;
+}
+
 /*
  * Register ops so that we can add/remove device to data core.
  */
@@ -39,5 +39,6 @@
 
 struct virtio_net_device_ops const *notify_ops;
 struct virtio_net *get_device(struct vhost_device_ctx ctx);
+void reset_gpa_cache(struct virtio_net *dev);
 
 #endif